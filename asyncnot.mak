@@ -3,10 +3,11 @@
 #
 # The actions included in this make file are:
 #  Compile::C++ Compiler
+#  Assemble::Assembler
 #  Link::Linker
 #  Lib::Import Lib
 
-.SUFFIXES: .LIB .cpp .dll .obj 
+.SUFFIXES: .LIB .asm .cpp .dll .obj 
 
 .all: \
     .\asyncnot.LIB
@@ -15,6 +16,10 @@
     @echo " Compile::C++ Compiler "
     icc.exe /Gm /Gd /Ge- /C %s
 
+.asm.obj:
+    @echo " Assemble::Assembler "
+    alp.exe %s
+
 .dll.LIB:
     @echo " Lib::Import Lib "
     implib.exe %|dpfF.LIB %s
@@ -25,6 +30,16 @@
     .\iasynbkg.obj \
     .\iasyngui.obj \
     .\iasyntfy.obj \
+    .\iasynque.obj \
+    .\iasynpol.obj \
+    .\iatomic.obj \
+    .\iatomadd.obj \
+    .\iasynmem.obj \
+    .\iasyntmr.obj \
+    .\iasynstr.obj \
+    .\iasynmtr.obj \
+    .\iasynobs.obj \
+    .\iasynipc.obj \
     {$(LIB)}asyncnot.def
     @echo " Link::Linker "
     icc.exe @<<
@@ -38,6 +53,16 @@
      .\iasynbkg.obj
      .\iasyngui.obj
      .\iasyntfy.obj
+     .\iasynque.obj
+     .\iasynpol.obj
+     .\iatomic.obj
+     .\iatomadd.obj
+     .\iasynmem.obj
+     .\iasyntmr.obj
+     .\iasynstr.obj
+     .\iasynmtr.obj
+     .\iasynobs.obj
+     .\iasynipc.obj
 <<
 
 .\iasynthr.obj: \
@@ -55,5 +80,35 @@
 .\ievntsem.obj: \
     F:\threads\ievntsem.cpp
 
+.\iasynque.obj: \
+    F:\threads\iasynque.cpp
+
+.\iasynpol.obj: \
+    F:\threads\iasynpol.cpp
+
+.\iatomic.obj: \
+    F:\threads\iatomic.cpp
+
+.\iatomadd.obj: \
+    F:\threads\iatomadd.asm
+
+.\iasynmem.obj: \
+    F:\threads\iasynmem.cpp
+
+.\iasyntmr.obj: \
+    F:\threads\iasyntmr.cpp
+
+.\iasynstr.obj: \
+    F:\threads\iasynstr.cpp
+
+.\iasynmtr.obj: \
+    F:\threads\iasynmtr.cpp
+
+.\iasynobs.obj: \
+    F:\threads\iasynobs.cpp
+
+.\iasynipc.obj: \
+    F:\threads\iasynipc.cpp
+
 .\asyncnot.LIB: \
     .\asyncnot.dll
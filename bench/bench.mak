@@ -0,0 +1,140 @@
+# bench.mak
+# Benchmarks for asyncnot.dll.  Build asyncnot.LIB in the parent directory
+# first.  Each benchmark writes its results to standard output in the form
+# described in benchutl.hpp.
+#
+# The actions included in this make file are:
+#  Compile::C++ Compiler
+#  Link::Linker
+
+.SUFFIXES: .cpp .exe .obj 
+
+.all: \
+    .\ctorbnch.exe \
+    .\fanbnch.exe \
+    .\pingbnch.exe \
+    .\delbnch.exe \
+    .\membnch.exe \
+    .\coalbnch.exe
+
+.cpp.obj:
+    @echo " Compile::C++ Compiler "
+    icc.exe /I.. /Gm /Gd /C %s
+
+.\ctorbnch.exe: \
+    .\ctorbnch.obj \
+    .\benchutl.obj \
+    {..;$(LIB)}asyncnot.LIB
+    @echo " Link::Linker "
+    icc.exe @<<
+    /Tdp 
+     /Gm /Gd 
+     /B" /pmtype:vio"
+     /Fectorbnch.exe 
+     ..\asyncnot.LIB
+     .\ctorbnch.obj
+     .\benchutl.obj
+<<
+
+.\fanbnch.exe: \
+    .\fanbnch.obj \
+    .\benchutl.obj \
+    {..;$(LIB)}asyncnot.LIB
+    @echo " Link::Linker "
+    icc.exe @<<
+    /Tdp 
+     /Gm /Gd 
+     /B" /pmtype:vio"
+     /Fefanbnch.exe 
+     ..\asyncnot.LIB
+     .\fanbnch.obj
+     .\benchutl.obj
+<<
+
+.\pingbnch.exe: \
+    .\pingbnch.obj \
+    .\benchutl.obj \
+    {..;$(LIB)}asyncnot.LIB
+    @echo " Link::Linker "
+    icc.exe @<<
+    /Tdp 
+     /Gm /Gd 
+     /B" /pmtype:vio"
+     /Fepingbnch.exe 
+     ..\asyncnot.LIB
+     .\pingbnch.obj
+     .\benchutl.obj
+<<
+
+.\delbnch.exe: \
+    .\delbnch.obj \
+    .\benchutl.obj \
+    {..;$(LIB)}asyncnot.LIB
+    @echo " Link::Linker "
+    icc.exe @<<
+    /Tdp 
+     /Gm /Gd 
+     /B" /pmtype:vio"
+     /Fedelbnch.exe 
+     ..\asyncnot.LIB
+     .\delbnch.obj
+     .\benchutl.obj
+<<
+
+.\membnch.exe: \
+    .\membnch.obj \
+    .\benchutl.obj \
+    {..;$(LIB)}asyncnot.LIB
+    @echo " Link::Linker "
+    icc.exe @<<
+    /Tdp 
+     /Gm /Gd 
+     /B" /pmtype:vio"
+     /Femembnch.exe 
+     ..\asyncnot.LIB
+     .\membnch.obj
+     .\benchutl.obj
+<<
+
+.\coalbnch.exe: \
+    .\coalbnch.obj \
+    .\benchutl.obj \
+    {..;$(LIB)}asyncnot.LIB
+    @echo " Link::Linker "
+    icc.exe @<<
+    /Tdp 
+     /Gm /Gd 
+     /B" /pmtype:vio"
+     /Fecoalbnch.exe 
+     ..\asyncnot.LIB
+     .\coalbnch.obj
+     .\benchutl.obj
+<<
+
+.\benchutl.obj: \
+    .\benchutl.cpp \
+    .\benchutl.hpp
+
+.\ctorbnch.obj: \
+    .\ctorbnch.cpp \
+    .\benchutl.hpp
+
+.\fanbnch.obj: \
+    .\fanbnch.cpp \
+    .\benchutl.hpp
+
+.\pingbnch.obj: \
+    .\pingbnch.cpp \
+    .\benchutl.hpp
+
+.\delbnch.obj: \
+    .\delbnch.cpp \
+    .\benchutl.hpp
+
+.\membnch.obj: \
+    .\membnch.cpp \
+    .\benchutl.hpp
+
+.\coalbnch.obj: \
+    .\coalbnch.cpp \
+    .\benchutl.hpp
@@ -0,0 +1,295 @@
+/*******************************************************************************
+* FILE NAME: benchutl.cpp
+*
+* DESCRIPTION:
+*   Definition of the class(es) shared by the benchmarks:
+*     BenchNotifier - An IAsyncNotifier with nothing added.
+*     BenchSamples  - Times measured by a benchmark and their percentiles.
+*     BenchResult   - One line of results in a form a program can read.
+*
+* COPYRIGHT:
+*   Licensed Materials - Property of IBM
+*   (C) Copyright IBM Corporation 1995
+*   All Rights Reserved
+*   US Government Users Restricted Rights - Use, duplication, or disclosure
+*   restricted by GSA ADP Schedule Contract with IBM Corp.
+*
+*******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#ifdef __linux__
+  #include <time.h>
+  #include <malloc.h>
+#else
+  #define INCL_DOSPROFILE
+  #include <os2.h>
+  #include <malloc.h>
+#endif
+
+#ifndef _BENCHUTL_
+  #include "benchutl.hpp"
+#endif
+
+INotificationId const BenchNotifier::benchId = "BenchNotifier::benchId";
+
+
+/*------------------------------------------------------------------------------
+| Function Name: BenchSamples :: BenchSamples
+|
+| Implementation:
+|   Allocate room for the passed number of samples.
+|-----------------------------------------------------------------------------*/
+BenchSamples :: BenchSamples ( unsigned long capacity ) :
+                samples ( new double [capacity ? capacity : 1] ),
+                size ( capacity ),
+                used ( 0 ),
+                sorted ( 0 )
+{ }
+
+/*------------------------------------------------------------------------------
+| Function Name: BenchSamples :: ~BenchSamples
+|-----------------------------------------------------------------------------*/
+BenchSamples :: ~BenchSamples ( )
+{
+  delete [] samples;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: BenchSamples :: add
+|
+| Implementation:
+|   Keep the sample if there is room.
+|-----------------------------------------------------------------------------*/
+void BenchSamples :: add ( double microseconds )
+{
+  if ( used < size )
+    samples[used++] = microseconds;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: BenchSamples :: add
+|
+| Implementation:
+|   Add all the samples of another object, as far as there is room.
+|-----------------------------------------------------------------------------*/
+void BenchSamples :: add ( const BenchSamples & other )
+{
+  for ( unsigned long i = 0; i < other.used; i++ )
+    add ( other.samples[i] );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: BenchSamples :: clear
+|-----------------------------------------------------------------------------*/
+void BenchSamples :: clear ( )
+{
+  used = 0;
+  sorted = 0;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: compareSamples
+|
+| Implementation:
+|   Order samples from smallest to largest for qsort.
+|-----------------------------------------------------------------------------*/
+static int compareSamples ( const void * left, const void * right )
+{
+  double difference = *(const double *)left - *(const double *)right;
+
+  if ( difference < 0 )
+    return -1;
+  if ( difference > 0 )
+    return 1;
+  return 0;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: BenchSamples :: percentile
+|
+| Implementation:
+|   Sort the samples if any were added since the last sort, then return the
+|   smallest sample that at least the passed percent of them do not exceed.
+|   That is the sample at the nearest rank, the passed percent of the count
+|   rounded up, counting from one.  Return zero if there are no samples.
+|-----------------------------------------------------------------------------*/
+double BenchSamples :: percentile ( double percent )
+{
+  if ( used == 0 )
+    return 0;
+
+  if ( sorted != used )
+  {
+    qsort ( samples, used, sizeof ( double ), compareSamples );
+    sorted = used;
+  }
+
+  double rank = ceil ( percent * used / 100.0 );
+  if ( rank < 1.0 )
+    rank = 1.0;
+  if ( rank > (double)used )
+    rank = (double)used;
+
+  return samples[(unsigned long)rank - 1];
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: BenchSamples :: now
+|
+| Implementation:
+|   Return a count of microseconds that only matters relative to other
+|   calls.  On OS/2 the millisecond count is too coarse, so use the high
+|   resolution timer.
+|-----------------------------------------------------------------------------*/
+double BenchSamples :: now ( )
+{
+#ifdef __linux__
+  struct timespec time;
+  clock_gettime ( CLOCK_MONOTONIC, &time );
+  return ( (double)time.tv_sec * 1000000.0 + (double)time.tv_nsec / 1000.0 );
+#else
+  static ULONG frequency = 0;
+  if ( frequency == 0 )
+    DosTmrQueryFreq ( &frequency );
+
+  QWORD ticks;
+  DosTmrQueryTime ( &ticks );
+
+  return ( ( (double)ticks.ulHi * 4294967296.0 + (double)ticks.ulLo ) *
+           1000000.0 / (double)frequency );
+#endif
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: BenchResult :: BenchResult
+|
+| Implementation:
+|   Start the line with the name of the benchmark.
+|-----------------------------------------------------------------------------*/
+BenchResult :: BenchResult ( const char * benchmark )
+{
+  length = sprintf ( line, "bench=%s", benchmark );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: BenchResult :: field
+|-----------------------------------------------------------------------------*/
+BenchResult & BenchResult :: field ( const char * name, unsigned long value )
+{
+  if ( length + strlen ( name ) + 13 < sizeof ( line ) )
+    length += sprintf ( line + length, " %s=%lu", name, value );
+
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: BenchResult :: field
+|-----------------------------------------------------------------------------*/
+BenchResult & BenchResult :: field ( const char * name, double value )
+{
+  if ( length + strlen ( name ) + 40 < sizeof ( line ) )
+    length += sprintf ( line + length, " %s=%.3f", name, value );
+
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: BenchResult :: rate
+|
+| Implementation:
+|   Add ops_per_sec for the passed number of operations done in the passed
+|   time.
+|-----------------------------------------------------------------------------*/
+BenchResult & BenchResult :: rate ( double operations, double microseconds )
+{
+  if ( microseconds <= 0 )
+    microseconds = 1;
+
+  return ( field ( "ops_per_sec", operations * 1000000.0 / microseconds ) );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: BenchResult :: percentiles
+|
+| Implementation:
+|   Add the 50th, 99th and 99.9th percentiles of the samples.
+|-----------------------------------------------------------------------------*/
+BenchResult & BenchResult :: percentiles ( BenchSamples & samples )
+{
+  field ( "p50_us",  samples.percentile ( 50.0 ) );
+  field ( "p99_us",  samples.percentile ( 99.0 ) );
+  field ( "p999_us", samples.percentile ( 99.9 ) );
+
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: BenchResult :: write
+|
+| Implementation:
+|   Write the line to standard output right away, so that lines are not lost
+|   if a later benchmark fails.
+|-----------------------------------------------------------------------------*/
+void BenchResult :: write ( )
+{
+  printf ( "%s\n", line );
+  fflush ( stdout );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: benchArgument
+|-----------------------------------------------------------------------------*/
+unsigned long benchArgument ( int argc, char ** argv, int number,
+                              unsigned long defaultValue )
+{
+  if ( argc > number )
+    return ( strtoul ( argv[number], NULL, 10 ) );
+
+  return defaultValue;
+}
+
+#ifndef __linux__
+static unsigned long heapBytes = 0;
+
+/*------------------------------------------------------------------------------
+| Function Name: countHeapEntry
+|
+| Implementation:
+|   Add the size of a used heap object to the total.  Called by _heap_walk.
+|-----------------------------------------------------------------------------*/
+static int _LNK_CONV countHeapEntry ( const void * object, size_t size,
+                                      int use, int status,
+                                      const char * file, size_t line )
+{
+  if ( use == _USEDENTRY )
+    heapBytes += size;
+
+  return 0;
+}
+#endif
+
+/*------------------------------------------------------------------------------
+| Function Name: benchHeapInUse
+|
+| Implementation:
+|   On Linux ask the allocator.  On OS/2 walk the heap, which the DLL and
+|   the benchmark share because both use the run time library DLL.
+|-----------------------------------------------------------------------------*/
+unsigned long benchHeapInUse ( )
+{
+#if defined ( __GLIBC__ ) && ( __GLIBC__ * 100 + __GLIBC_MINOR__ >= 233 )
+  struct mallinfo2 info = mallinfo2();
+  return ( (unsigned long)info.uordblks );
+#elif defined ( __linux__ )
+  struct mallinfo info = mallinfo();
+  return ( (unsigned long)(unsigned int)info.uordblks );
+#else
+  heapBytes = 0;
+  _heap_walk ( countHeapEntry );
+  return heapBytes;
+#endif
+}
+
\ No newline at end of file
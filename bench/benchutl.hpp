@@ -0,0 +1,105 @@
+#ifndef _BENCHUTL_
+#define _BENCHUTL_
+/*******************************************************************************
+* FILE NAME: benchutl.hpp
+*
+* DESCRIPTION:
+*   Declaration of the class(es) shared by the benchmarks:
+*     BenchNotifier - An IAsyncNotifier with nothing added.
+*     BenchSamples  - Times measured by a benchmark and their percentiles.
+*     BenchResult   - One line of results in a form a program can read.
+*
+*   Every benchmark writes one line to standard output for each thing it
+*   measures.  A line is a list of name=value fields separated by blanks,
+*   always starting with bench=<name> and always including ops_per_sec.
+*   Benchmarks that time single operations add p50_us, p99_us and p999_us,
+*   the 50th, 99th and 99.9th percentiles in microseconds.  Lines from
+*   different runs can be compared field by field to track regressions.
+*
+* COPYRIGHT:
+*   Licensed Materials - Property of IBM
+*   (C) Copyright IBM Corporation 1995
+*   All Rights Reserved
+*   US Government Users Restricted Rights - Use, duplication, or disclosure
+*   restricted by GSA ADP Schedule Contract with IBM Corp.
+*
+*******************************************************************************/
+#ifndef _IASYNTFY_
+  #include <iasyntfy.hpp>
+#endif
+
+#ifndef _INOTIFEV_
+  #include <inotifev.hpp>
+#endif
+
+
+//------------------------------------------------------------------------------
+// IAsyncNotifier is abstract, so the benchmarks use this trivial subclass.
+// It is enabled for notification so that notifyObservers queues events.
+//------------------------------------------------------------------------------
+class BenchNotifier : public IAsyncNotifier
+{
+public:
+  BenchNotifier ( ) { enableNotification(); }
+  virtual ~BenchNotifier ( ) { }
+
+  static INotificationId const benchId;
+};
+
+//------------------------------------------------------------------------------
+// Times, in microseconds, measured by one thread.  Storage for all of them
+// is allocated up front so that recording does not use the heap.  Samples
+// past the capacity are not kept.
+//------------------------------------------------------------------------------
+class BenchSamples
+{
+public:
+  BenchSamples ( unsigned long capacity );
+  ~BenchSamples ( );
+
+  void          add        ( double microseconds );
+  void          add        ( const BenchSamples & samples );
+  void          clear      ( );
+  unsigned long count      ( ) const { return used; }
+  double        percentile ( double percent );
+
+  static double now ( );
+
+private:
+  double      * samples;
+  unsigned long size;
+  unsigned long used;
+  unsigned long sorted;
+};
+
+//------------------------------------------------------------------------------
+// Builds and writes one line of results.  Fields are written in the order
+// they are added.
+//------------------------------------------------------------------------------
+class BenchResult
+{
+public:
+  BenchResult ( const char * benchmark );
+
+  BenchResult & field       ( const char * name, unsigned long value );
+  BenchResult & field       ( const char * name, double value );
+  BenchResult & rate        ( double operations, double microseconds );
+  BenchResult & percentiles ( BenchSamples & samples );
+  void          write       ( );
+
+private:
+  char          line[512];
+  unsigned long length;
+};
+
+//------------------------------------------------------------------------------
+// benchArgument returns the numbered command line argument, or the default
+// if it was not passed.  benchHeapInUse returns the number of bytes of the
+// heap the process is using.
+//------------------------------------------------------------------------------
+unsigned long benchArgument  ( int argc, char ** argv, int number,
+                               unsigned long defaultValue );
+unsigned long benchHeapInUse ( );
+
+#endif // _BENCHUTL_
+
\ No newline at end of file
@@ -0,0 +1,167 @@
+/*******************************************************************************
+* FILE NAME: coalbnch.cpp
+*
+* DESCRIPTION:
+*   Benchmark for coalescing notifications.  A background thread creates an
+*   IAsyncNotifier and an observer and then calls IAsyncNotifier::run.  The
+*   main thread sends a burst of notifications with one id, each carrying
+*   its sequence number, as an attribute that changes quickly would, and
+*   then one with another id to mark the end.  This is done once with
+*   coalescing off and once with it enabled for the first id.  The observer
+*   counts what is dispatched and keeps the last sequence number, which is
+*   the last one sent either way.  A line of results is written for each
+*   run.  See benchutl.hpp.
+*
+*   Usage: coalbnch [notifications]
+*          The default is 1000000 notifications.
+*
+* COPYRIGHT:
+*   Licensed Materials - Property of IBM
+*   (C) Copyright IBM Corporation 1995
+*   All Rights Reserved
+*   US Government Users Restricted Rights - Use, duplication, or disclosure
+*   restricted by GSA ADP Schedule Contract with IBM Corp.
+*
+*******************************************************************************/
+#ifndef _BENCHUTL_
+  #include "benchutl.hpp"
+#endif
+
+#ifndef _IOBSERVR_
+  #include <iobservr.hpp>
+#endif
+
+#ifndef _ITHREAD_
+  #include <ithread.hpp>
+#endif
+
+#ifndef _IEVNTSEM_
+  #include <ievntsem.hpp>
+#endif
+
+
+//------------------------------------------------------------------------------
+// Observes the notifier on the dispatch thread.  It counts the events with
+// the bench id and keeps the sequence number of the last one.  The
+// semaphore is posted when the end marker is dispatched.
+//------------------------------------------------------------------------------
+class CoalesceObserver : public IObserver
+{
+public:
+  CoalesceObserver ( IEventSem & doneSem ) :
+                     received ( 0 ),
+                     last ( 0 ),
+                     done ( doneSem )
+  { }
+
+  virtual IObserver & dispatchNotificationEvent (
+                        const INotificationEvent & anEvent );
+
+  static INotificationId const endId;
+
+  unsigned long received;
+  unsigned long last;
+  IEventSem   & done;
+};
+
+INotificationId const CoalesceObserver::endId = "CoalesceObserver::end";
+
+IObserver & CoalesceObserver :: dispatchNotificationEvent (
+                                  const INotificationEvent & anEvent )
+{
+  if ( anEvent.notificationId() == BenchNotifier::benchId )
+  {
+    received++;
+    last = anEvent.eventData().asUnsignedLong();
+  }
+  else if ( anEvent.notificationId() == endId )
+    done.post();
+
+  return *this;
+}
+
+//------------------------------------------------------------------------------
+// The dispatch thread.  It posts the ready semaphore once the notifier and
+// observer exist, then dispatches until the notifier is deleted.
+//------------------------------------------------------------------------------
+class CoalesceDispatcher : public IThreadFn
+{
+public:
+  CoalesceDispatcher ( CoalesceObserver & anObserver, IEventSem & readySem,
+                       IEventSem & endedSem ) :
+                       notifier ( NULL ),
+                       observer ( anObserver ),
+                       ready ( readySem ),
+                       ended ( endedSem )
+  { }
+
+  virtual void run ( );
+
+  BenchNotifier    * notifier;
+  CoalesceObserver & observer;
+  IEventSem        & ready;
+  IEventSem        & ended;
+};
+
+void CoalesceDispatcher :: run ( )
+{
+  notifier = new BenchNotifier;
+  observer.handleNotificationsFor ( *notifier );
+  ready.post();
+
+  IAsyncNotifier::run();
+  ended.post();
+}
+
+int main ( int argc, char ** argv )
+{
+  unsigned long notifications = benchArgument ( argc, argv, 1, 1000000 );
+  if ( notifications == 0 )
+    notifications = 1;
+
+  IEventSem readySem, endedSem, doneSem;
+  CoalesceObserver observer ( doneSem );
+  CoalesceDispatcher * dispatcher = new CoalesceDispatcher ( observer,
+                                                             readySem,
+                                                             endedSem );
+  IThread dispatchThread ( dispatcher );
+  readySem.wait();
+
+  BenchNotifier & notifier = *dispatcher->notifier;
+
+  for ( int coalescing = 0; coalescing < 2; coalescing++ )
+  {
+    notifier.enableCoalescingFor ( BenchNotifier::benchId,
+                                   coalescing != 0 );
+    doneSem.reset();
+    observer.received = 0;
+    observer.last = 0;
+
+    double begin = BenchSamples::now();
+    for ( unsigned long i = 0; i < notifications; i++ )
+      notifier.notifyObservers ( INotificationEvent (
+                                   BenchNotifier::benchId,
+                                   notifier,
+                                   true,
+                                   IEventData ( i ) ) );
+    notifier.notifyObservers ( INotificationEvent ( CoalesceObserver::endId,
+                                                    notifier ) );
+    doneSem.wait();
+    double elapsed = BenchSamples::now() - begin;
+
+    BenchResult ( "coalesce" )
+      .field ( "coalescing", (unsigned long)coalescing )
+      .field ( "notifications", notifications )
+      .field ( "dispatched", observer.received )
+      .field ( "last", observer.last )
+      .rate ( (double)notifications, elapsed )
+      .write();
+  }
+
+  notifier.deleteThis();
+  endedSem.wait();
+  IThread::current().waitFor ( dispatchThread );
+
+  return 0;
+}
+
\ No newline at end of file
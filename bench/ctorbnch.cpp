@@ -0,0 +1,125 @@
+/*******************************************************************************
+* FILE NAME: ctorbnch.cpp
+*
+* DESCRIPTION:
+*   Benchmark for IAsyncNotifier construction.  A number of threads each
+*   create one IAsyncNotifier, so the thread has a dispatch thread, and then
+*   construct and destruct many more, each pair timed.  A line of results
+*   is written to standard output.  See benchutl.hpp.
+*
+*   Usage: ctorbnch [threads [notifiersPerThread]]
+*          The defaults are 32 threads and 100000 notifiers per thread.
+*
+* COPYRIGHT:
+*   Licensed Materials - Property of IBM
+*   (C) Copyright IBM Corporation 1995
+*   All Rights Reserved
+*   US Government Users Restricted Rights - Use, duplication, or disclosure
+*   restricted by GSA ADP Schedule Contract with IBM Corp.
+*
+*******************************************************************************/
+#ifndef _BENCHUTL_
+  #include "benchutl.hpp"
+#endif
+
+#ifndef _ITHREAD_
+  #include <ithread.hpp>
+#endif
+
+#ifndef _IEVNTSEM_
+  #include <ievntsem.hpp>
+#endif
+
+
+//------------------------------------------------------------------------------
+// Work done on each benchmark thread.  The semaphore is posted when done.
+// The samples belong to the main thread, which reads them after the post.
+//------------------------------------------------------------------------------
+class ConstructorWorker : public IThreadFn
+{
+public:
+  ConstructorWorker ( unsigned long count, BenchSamples & timeSamples,
+                      IEventSem & doneSem ) :
+                     notifiers ( count ),
+                     samples ( timeSamples ),
+                     done ( doneSem )
+  { }
+
+  virtual void run ( );
+
+private:
+  unsigned long  notifiers;
+  BenchSamples & samples;
+  IEventSem    & done;
+};
+
+void ConstructorWorker :: run ( )
+{
+  BenchNotifier * anchor = new BenchNotifier;
+
+  for ( unsigned long i = 0; i < notifiers; i++ )
+  {
+    double begin = BenchSamples::now();
+    {
+      BenchNotifier aNotifier;
+    }
+    samples.add ( BenchSamples::now() - begin );
+  }
+
+  delete anchor;
+  done.post();
+}
+
+int main ( int argc, char ** argv )
+{
+  unsigned long threadCount = benchArgument ( argc, argv, 1, 32 );
+  unsigned long perThread   = benchArgument ( argc, argv, 2, 100000 );
+
+  IEventSem    ** doneSems = new IEventSem * [threadCount];
+  BenchSamples ** samples  = new BenchSamples * [threadCount];
+  IThread      ** threads  = new IThread * [threadCount];
+
+  unsigned long i;
+  for ( i = 0; i < threadCount; i++ )
+  {
+    doneSems[i] = new IEventSem;
+    samples[i]  = new BenchSamples ( perThread );
+  }
+
+  double start = BenchSamples::now();
+
+  for ( i = 0; i < threadCount; i++ )
+    threads[i] = new IThread ( new ConstructorWorker ( perThread,
+                                                       *samples[i],
+                                                       *doneSems[i] ) );
+
+  for ( i = 0; i < threadCount; i++ )
+    doneSems[i]->wait();
+
+  double elapsed = BenchSamples::now() - start;
+
+  BenchSamples all ( threadCount * perThread );
+  for ( i = 0; i < threadCount; i++ )
+    all.add ( *samples[i] );
+
+  BenchResult ( "construct" )
+    .field ( "threads", threadCount )
+    .field ( "notifiers", threadCount * perThread )
+    .rate ( (double)threadCount * (double)perThread, elapsed )
+    .percentiles ( all )
+    .write();
+
+  for ( i = 0; i < threadCount; i++ )
+  {
+    IThread::current().waitFor ( *threads[i] );
+    delete threads[i];
+    delete samples[i];
+    delete doneSems[i];
+  }
+  delete [] threads;
+  delete [] samples;
+  delete [] doneSems;
+
+  return 0;
+}
+
\ No newline at end of file
@@ -0,0 +1,91 @@
+/*******************************************************************************
+* FILE NAME: delbnch.cpp
+*
+* DESCRIPTION:
+*   Benchmark for deleting an IAsyncNotifier that still has notifications
+*   queued, which makes its dispatch thread's deleteNotificationsFor throw
+*   them away.  The main thread is the dispatch thread and never dispatches,
+*   so notifications stay queued.  For each queue depth, a bystander
+*   notifier queues that many notifications, then notifiers that queue as
+*   many again are created and deleted, each deletion timed.  The depth is
+*   multiplied by ten until it passes the maximum.  See benchutl.hpp.
+*
+*   Usage: delbnch [maxDepth [notificationsPerDepth]]
+*          The defaults are a depth of 100000 and 1000000 notifications
+*          deleted at each depth, with at least 10 deletions.
+*
+* COPYRIGHT:
+*   Licensed Materials - Property of IBM
+*   (C) Copyright IBM Corporation 1995
+*   All Rights Reserved
+*   US Government Users Restricted Rights - Use, duplication, or disclosure
+*   restricted by GSA ADP Schedule Contract with IBM Corp.
+*
+*******************************************************************************/
+#ifndef _BENCHUTL_
+  #include "benchutl.hpp"
+#endif
+
+
+/*------------------------------------------------------------------------------
+| Function Name: queueNotifications
+|
+| Implementation:
+|   Queue the passed number of notifications from the notifier.
+|-----------------------------------------------------------------------------*/
+static void queueNotifications ( BenchNotifier & notifier,
+                                 unsigned long count )
+{
+  for ( unsigned long i = 0; i < count; i++ )
+    notifier.notifyObservers ( INotificationEvent ( BenchNotifier::benchId,
+                                                    notifier ) );
+}
+
+int main ( int argc, char ** argv )
+{
+  unsigned long maxDepth = benchArgument ( argc, argv, 1, 100000 );
+  unsigned long perDepth = benchArgument ( argc, argv, 2, 1000000 );
+
+  BenchNotifier * anchor = new BenchNotifier;
+
+  for ( unsigned long depth = 1; depth <= maxDepth; depth *= 10 )
+  {
+    unsigned long deletions = perDepth / depth;
+    if ( deletions < 10 )
+      deletions = 10;
+
+    BenchSamples samples ( deletions );
+    BenchNotifier * bystander = new BenchNotifier;
+    queueNotifications ( *bystander, depth );
+
+    double total = 0;
+    for ( unsigned long i = 0; i < deletions; i++ )
+    {
+      BenchNotifier * notifier = new BenchNotifier;
+      queueNotifications ( *notifier, depth );
+
+      double begin = BenchSamples::now();
+      delete notifier;
+      double elapsed = BenchSamples::now() - begin;
+
+      samples.add ( elapsed );
+      total += elapsed;
+    }
+
+    delete bystander;
+
+    BenchResult ( "delete" )
+      .field ( "depth", depth )
+      .field ( "deletions", deletions )
+      .rate ( (double)deletions, total )
+      .field ( "notifications_per_sec", (double)deletions * depth *
+                                        1000000.0 / ( total > 0 ? total : 1 ) )
+      .percentiles ( samples )
+      .write();
+  }
+
+  delete anchor;
+
+  return 0;
+}
+
\ No newline at end of file
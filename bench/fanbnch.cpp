@@ -0,0 +1,214 @@
+/*******************************************************************************
+* FILE NAME: fanbnch.cpp
+*
+* DESCRIPTION:
+*   Benchmark for many threads sending notifications to one dispatch thread.
+*   A background thread creates an IAsyncNotifier and an observer and then
+*   calls IAsyncNotifier::run.  One producer thread, then two, four and so
+*   on up to the maximum, each send the same number of notifications to the
+*   notifier.  Each notification carries the time it was sent, so the
+*   observer measures how long it took to be dispatched.  A line of results
+*   is written for each number of producers.  See benchutl.hpp.
+*
+*   Usage: fanbnch [maxProducers [notificationsPerProducer]]
+*          The defaults are 8 producers and 100000 notifications each.
+*
+* COPYRIGHT:
+*   Licensed Materials - Property of IBM
+*   (C) Copyright IBM Corporation 1995
+*   All Rights Reserved
+*   US Government Users Restricted Rights - Use, duplication, or disclosure
+*   restricted by GSA ADP Schedule Contract with IBM Corp.
+*
+*******************************************************************************/
+#ifndef _BENCHUTL_
+  #include "benchutl.hpp"
+#endif
+
+#ifndef _IOBSERVR_
+  #include <iobservr.hpp>
+#endif
+
+#ifndef _ITHREAD_
+  #include <ithread.hpp>
+#endif
+
+#ifndef _IEVNTSEM_
+  #include <ievntsem.hpp>
+#endif
+
+
+//------------------------------------------------------------------------------
+// Observes the notifier on the dispatch thread.  Each event's data points at
+// the time it was sent.  The semaphore is posted when the expected number of
+// events has been dispatched.
+//------------------------------------------------------------------------------
+class FanInObserver : public IObserver
+{
+public:
+  FanInObserver ( unsigned long capacity, IEventSem & doneSem ) :
+                  latencies ( capacity ),
+                  expected ( 0 ),
+                  received ( 0 ),
+                  done ( doneSem )
+  { }
+
+  virtual IObserver & dispatchNotificationEvent (
+                        const INotificationEvent & anEvent );
+
+  BenchSamples  latencies;
+  unsigned long expected;
+  unsigned long received;
+  IEventSem   & done;
+};
+
+IObserver & FanInObserver :: dispatchNotificationEvent (
+                               const INotificationEvent & anEvent )
+{
+  if ( anEvent.notificationId() == BenchNotifier::benchId )
+  {
+    double sent = *(double *)( anEvent.eventData().asCharPtr() );
+    latencies.add ( BenchSamples::now() - sent );
+
+    if ( ++received == expected )
+      done.post();
+  }
+
+  return *this;
+}
+
+//------------------------------------------------------------------------------
+// The dispatch thread.  It posts the ready semaphore once the notifier and
+// observer exist, then dispatches until the notifier is deleted.
+//------------------------------------------------------------------------------
+class FanInDispatcher : public IThreadFn
+{
+public:
+  FanInDispatcher ( FanInObserver & anObserver, IEventSem & readySem,
+                    IEventSem & endedSem ) :
+                    notifier ( NULL ),
+                    observer ( anObserver ),
+                    ready ( readySem ),
+                    ended ( endedSem )
+  { }
+
+  virtual void run ( );
+
+  BenchNotifier * notifier;
+  FanInObserver & observer;
+  IEventSem     & ready;
+  IEventSem     & ended;
+};
+
+void FanInDispatcher :: run ( )
+{
+  notifier = new BenchNotifier;
+  observer.handleNotificationsFor ( *notifier );
+  ready.post();
+
+  IAsyncNotifier::run();
+  ended.post();
+}
+
+//------------------------------------------------------------------------------
+// A producer thread.  It waits for the start semaphore so all producers
+// begin together, then sends its notifications as fast as it can.  The
+// send times are kept in an array so that the events only carry pointers.
+//------------------------------------------------------------------------------
+class FanInProducer : public IThreadFn
+{
+public:
+  FanInProducer ( BenchNotifier & aNotifier, unsigned long count,
+                  IEventSem & startSem ) :
+                  notifier ( aNotifier ),
+                  notifications ( count ),
+                  sendTimes ( new double [count] ),
+                  start ( startSem )
+  { }
+
+  ~FanInProducer ( ) { delete [] sendTimes; }
+
+  virtual void run ( );
+
+private:
+  BenchNotifier & notifier;
+  unsigned long   notifications;
+  double        * sendTimes;
+  IEventSem     & start;
+};
+
+void FanInProducer :: run ( )
+{
+  start.wait();
+
+  for ( unsigned long i = 0; i < notifications; i++ )
+  {
+    sendTimes[i] = BenchSamples::now();
+    notifier.notifyObservers ( INotificationEvent (
+                                 BenchNotifier::benchId,
+                                 notifier,
+                                 false,
+                                 IEventData ( (void *)( sendTimes + i ) ) ) );
+  }
+}
+
+int main ( int argc, char ** argv )
+{
+  unsigned long maxProducers = benchArgument ( argc, argv, 1, 8 );
+  unsigned long perProducer  = benchArgument ( argc, argv, 2, 100000 );
+
+  IEventSem readySem, endedSem, doneSem;
+  FanInObserver observer ( maxProducers * perProducer, doneSem );
+  FanInDispatcher * dispatcher = new FanInDispatcher ( observer, readySem,
+                                                       endedSem );
+  IThread dispatchThread ( dispatcher );
+  readySem.wait();
+
+  for ( unsigned long producers = 1; producers <= maxProducers;
+        producers *= 2 )
+  {
+    IEventSem startSem;
+    FanInProducer ** workers = new FanInProducer * [producers];
+    IThread       ** threads = new IThread * [producers];
+
+    doneSem.reset();
+    observer.latencies.clear();
+    observer.received = 0;
+    observer.expected = producers * perProducer;
+
+    unsigned long i;
+    for ( i = 0; i < producers; i++ )
+    {
+      workers[i] = new FanInProducer ( *dispatcher->notifier, perProducer,
+                                       startSem );
+      threads[i] = new IThread ( workers[i], false );
+    }
+
+    double begin = BenchSamples::now();
+    startSem.post();
+    doneSem.wait();
+    double elapsed = BenchSamples::now() - begin;
+
+    BenchResult ( "fanin" )
+      .field ( "producers", producers )
+      .field ( "notifications", observer.expected )
+      .rate ( (double)observer.expected, elapsed )
+      .percentiles ( observer.latencies )
+      .write();
+
+    for ( i = 0; i < producers; i++ )
+    {
+      IThread::current().waitFor ( *threads[i] );
+      delete threads[i];
+    }
+    delete [] threads;
+    delete [] workers;
+  }
+
+  dispatcher->notifier->deleteThis();
+  endedSem.wait();
+  IThread::current().waitFor ( dispatchThread );
+
+  return 0;
+}
+
\ No newline at end of file
@@ -0,0 +1,74 @@
+/*******************************************************************************
+* FILE NAME: membnch.cpp
+*
+* DESCRIPTION:
+*   Benchmark for the storage used by queued notifications and the time
+*   taken to queue them.  The main thread is the dispatch thread and never
+*   dispatches, so notifications stay queued.  For each queue depth, the
+*   heap in use is measured before and after a notifier queues that many
+*   notifications, and each notifyObservers call is timed.  The depth is
+*   multiplied by ten, starting at 10000, until it passes the maximum.
+*
+*   Freed notifications are kept for reuse, up to a limit, so the storage
+*   of the first ones queued may already be counted as in use.  That is
+*   why the smallest depth is well above the limit.  See benchutl.hpp.
+*
+*   Usage: membnch [maxDepth]
+*          The default is a depth of 1000000.
+*
+* COPYRIGHT:
+*   Licensed Materials - Property of IBM
+*   (C) Copyright IBM Corporation 1995
+*   All Rights Reserved
+*   US Government Users Restricted Rights - Use, duplication, or disclosure
+*   restricted by GSA ADP Schedule Contract with IBM Corp.
+*
+*******************************************************************************/
+#ifndef _BENCHUTL_
+  #include "benchutl.hpp"
+#endif
+
+
+int main ( int argc, char ** argv )
+{
+  unsigned long maxDepth = benchArgument ( argc, argv, 1, 1000000 );
+
+  BenchNotifier * anchor = new BenchNotifier;
+
+  for ( unsigned long depth = 10000; depth <= maxDepth; depth *= 10 )
+  {
+    BenchSamples samples ( depth );
+    BenchNotifier * notifier = new BenchNotifier;
+    INotificationEvent anEvent ( BenchNotifier::benchId, *notifier );
+
+    unsigned long heapBefore = benchHeapInUse();
+    double total = 0;
+
+    for ( unsigned long i = 0; i < depth; i++ )
+    {
+      double begin = BenchSamples::now();
+      notifier->notifyObservers ( anEvent );
+      double elapsed = BenchSamples::now() - begin;
+
+      samples.add ( elapsed );
+      total += elapsed;
+    }
+
+    unsigned long heapAfter = benchHeapInUse();
+
+    BenchResult ( "memory" )
+      .field ( "depth", depth )
+      .field ( "bytes_per_notification",
+               ( (double)heapAfter - (double)heapBefore ) / depth )
+      .rate ( (double)depth, total )
+      .percentiles ( samples )
+      .write();
+
+    delete notifier;
+  }
+
+  delete anchor;
+
+  return 0;
+}
+
\ No newline at end of file
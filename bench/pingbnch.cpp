@@ -0,0 +1,207 @@
+/*******************************************************************************
+* FILE NAME: pingbnch.cpp
+*
+* DESCRIPTION:
+*   Benchmark for the latency between two dispatch threads.  Two background
+*   threads each create an IAsyncNotifier, the ping and the pong, and call
+*   IAsyncNotifier::run.  The observer of the ping, on the first thread,
+*   notifies the pong.  The observer of the pong, on the second thread,
+*   measures the round trip and notifies the ping again.  The first tenth
+*   of the round trips warm up and are not measured.  See benchutl.hpp.
+*
+*   Usage: pingbnch [roundTrips [spinTime [processor]]]
+*          The default is 100000 round trips.  The spin time, in
+*          microseconds, is passed to IAsyncNotifier::setDispatchSpinTime on
+*          both threads.  The default is zero, no spinning.  If a processor
+*          is passed, both threads run only on it.  The sender could not run
+*          while the other thread polled, so the notifier leaves spinning
+*          off; the spin time actually used is reported as spin_used_us.
+*
+* COPYRIGHT:
+*   Licensed Materials - Property of IBM
+*   (C) Copyright IBM Corporation 1995
+*   All Rights Reserved
+*   US Government Users Restricted Rights - Use, duplication, or disclosure
+*   restricted by GSA ADP Schedule Contract with IBM Corp.
+*
+*******************************************************************************/
+#ifndef _BENCHUTL_
+  #include "benchutl.hpp"
+#endif
+
+#ifndef _IOBSERVR_
+  #include <iobservr.hpp>
+#endif
+
+#ifndef _ITHREAD_
+  #include <ithread.hpp>
+#endif
+
+#ifndef _IEVNTSEM_
+  #include <ievntsem.hpp>
+#endif
+
+
+//------------------------------------------------------------------------------
+// Observes one notifier and notifies the other.  The pong side, which has
+// samples, times each round trip and stops after the last one.  Round trips
+// are only counted and timed on the pong thread.
+//------------------------------------------------------------------------------
+class PingPongObserver : public IObserver
+{
+public:
+  PingPongObserver ( BenchSamples * roundTrips, IEventSem & doneSem ) :
+                     other ( NULL ),
+                     samples ( roundTrips ),
+                     warmUp ( 0 ),
+                     remaining ( 0 ),
+                     sent ( 0 ),
+                     done ( doneSem )
+  { }
+
+  virtual IObserver & dispatchNotificationEvent (
+                        const INotificationEvent & anEvent );
+
+  BenchNotifier * other;
+  BenchSamples  * samples;
+  unsigned long   warmUp;
+  unsigned long   remaining;
+  double          sent;
+  IEventSem     & done;
+};
+
+IObserver & PingPongObserver :: dispatchNotificationEvent (
+                                  const INotificationEvent & anEvent )
+{
+  if ( anEvent.notificationId() != BenchNotifier::benchId )
+    return *this;
+
+  if ( samples != NULL )
+  {
+    double now = BenchSamples::now();
+
+    if ( warmUp > 0 )
+      warmUp--;
+    else
+      samples->add ( now - sent );
+
+    if ( --remaining == 0 )
+    {
+      done.post();
+      return *this;
+    }
+    sent = BenchSamples::now();
+  }
+
+  other->notifyObservers ( INotificationEvent ( BenchNotifier::benchId,
+                                                *other ) );
+
+  return *this;
+}
+
+//------------------------------------------------------------------------------
+// One of the two dispatch threads.
+//------------------------------------------------------------------------------
+class PingPongDispatcher : public IThreadFn
+{
+public:
+  PingPongDispatcher ( PingPongObserver & anObserver, IEventSem & readySem,
+                       IEventSem & endedSem, unsigned long spinTime,
+                       unsigned long onProcessor ) :
+                       notifier ( NULL ),
+                       observer ( anObserver ),
+                       ready ( readySem ),
+                       ended ( endedSem ),
+                       spin ( spinTime ),
+                       spinUsed ( 0 ),
+                       processor ( onProcessor )
+  { }
+
+  virtual void run ( );
+
+  static const unsigned long anyProcessor;
+
+  BenchNotifier    * notifier;
+  PingPongObserver & observer;
+  IEventSem        & ready;
+  IEventSem        & ended;
+  unsigned long      spin;
+  unsigned long      spinUsed;
+  unsigned long      processor;
+};
+
+const unsigned long PingPongDispatcher::anyProcessor = 0xFFFFFFFFUL;
+
+void PingPongDispatcher :: run ( )
+{
+  notifier = new BenchNotifier;
+  observer.handleNotificationsFor ( *notifier );
+  if ( processor != anyProcessor )
+    IAsyncNotifier::setDispatchProcessors ( processor );
+  IAsyncNotifier::setDispatchSpinTime ( spin );
+  spinUsed = IAsyncNotifier::dispatchSpinTime();
+  ready.post();
+
+  IAsyncNotifier::run();
+  ended.post();
+}
+
+int main ( int argc, char ** argv )
+{
+  unsigned long roundTrips = benchArgument ( argc, argv, 1, 100000 );
+  if ( roundTrips == 0 )
+    roundTrips = 1;
+  unsigned long spin = benchArgument ( argc, argv, 2, 0 );
+  unsigned long processor = benchArgument ( argc, argv, 3,
+                                            PingPongDispatcher::anyProcessor );
+
+  IEventSem pingReady, pongReady, pingEnded, pongEnded, doneSem;
+  BenchSamples samples ( roundTrips );
+
+  PingPongObserver pingObserver ( NULL, doneSem );
+  PingPongObserver pongObserver ( &samples, doneSem );
+  pongObserver.warmUp    = roundTrips / 10;
+  pongObserver.remaining = roundTrips + pongObserver.warmUp;
+
+  PingPongDispatcher * ping = new PingPongDispatcher ( pingObserver,
+                                                       pingReady, pingEnded,
+                                                       spin, processor );
+  PingPongDispatcher * pong = new PingPongDispatcher ( pongObserver,
+                                                       pongReady, pongEnded,
+                                                       spin, processor );
+  IThread pingThread ( ping );
+  IThread pongThread ( pong );
+  pingReady.wait();
+  pongReady.wait();
+
+  pingObserver.other = pong->notifier;
+  pongObserver.other = ping->notifier;
+
+  double begin = BenchSamples::now();
+  pongObserver.sent = begin;
+  ping->notifier->notifyObservers ( INotificationEvent (
+                                      BenchNotifier::benchId,
+                                      *ping->notifier ) );
+  doneSem.wait();
+  double elapsed = BenchSamples::now() - begin;
+
+  BenchResult result ( "pingpong" );
+  result.field ( "round_trips", roundTrips )
+        .field ( "spin_us", spin )
+        .field ( "spin_used_us", ping->spinUsed );
+  if ( processor != PingPongDispatcher::anyProcessor )
+    result.field ( "processor", processor );
+  result.rate ( (double)( roundTrips + roundTrips / 10 ), elapsed )
+        .percentiles ( samples )
+        .write();
+
+  ping->notifier->deleteThis();
+  pong->notifier->deleteThis();
+  pingEnded.wait();
+  pongEnded.wait();
+  IThread::current().waitFor ( pingThread );
+  IThread::current().waitFor ( pongThread );
+
+  return 0;
+}
+
\ No newline at end of file
@@ -35,42 +35,65 @@
   #include <iexcept.hpp>
 #endif
 
-#ifndef _ISEQ_H
-  #include <iseq.h>
+#ifndef _IASYNQUE_
+  #include <iasynque.hpp>
 #endif
 
+#ifndef _IATOMIC_
+  #include <iatomic.hpp>
+#endif
+
+#ifndef _IASYNMTR_
+  #include <iasynmtr.hpp>
+#endif
+
+#ifndef _IASYNSTR_
+  #include <iasynstr.hpp>
+#endif
+
+// The shortest spin budget, in microseconds, and the longest gap between
+// notifications that counts fully in the average.
+static const unsigned long minimumSpin = 10;
+static const unsigned long longestGap = 0x10000000UL;
+
 
 /*------------------------------------------------------------------------------
-| Function Name: removeFor
+| Function Name: IAsyncNotifierBackgroundThread :: IAsyncNotifierBackgroundThread
 |
 | Implementation:
-|   Used by IAsyncNotifierBackgroundThread::deleteNotificationsFor as a
-|   parameter to ISequence<INotificationEvent>::removeAll.
+|   Initialize the base class and create our queue with a lane for each
+|   priority.  The event sem is auto reset, so processMsgs never resets it.
 |-----------------------------------------------------------------------------*/
-IBoolean removeFor ( const INotificationEvent & anEvent, void * asyncNotifier )
+IAsyncNotifierBackgroundThread :: IAsyncNotifierBackgroundThread ( ) :
+                   IAsyncNotifierThread ( ),
+                   dispatcherWaiting ( 0 ),
+                   queue ( new IAsyncNotificationQueue ( numberOfPriorities ) ),
+                   queueEventSem ( IEventSem::autoReset ),
+                   maxBatch ( 64 ),
+                   maxSpin ( 0 ),
+                   requestedSpin ( 0 ),
+                   spinBudget ( 0 ),
+                   idleGap ( 0 )
 {
-  IBoolean remove = false;
-
-  if ( (&(anEvent.notifier())) == ((INotifier *)asyncNotifier) )
-  {
-    remove = true;
-    ((const IAsyncNotifier *)asyncNotifier)->notificationCleanUp ( anEvent );
-  }
-
-  return remove;
 }
 
 /*------------------------------------------------------------------------------
 | Function Name: IAsyncNotifierBackgroundThread :: IAsyncNotifierBackgroundThread
 |
 | Implementation:
-|   Initialize the base class and create our queue.
+|   As above, but with the event sem in the reset mode passed.
 |-----------------------------------------------------------------------------*/
-IAsyncNotifierBackgroundThread :: IAsyncNotifierBackgroundThread ( ) :
+IAsyncNotifierBackgroundThread :: IAsyncNotifierBackgroundThread (
+                                    IEventSem::ResetMode readyMode ) :
                    IAsyncNotifierThread ( ),
-                   queue ( new ISequence<INotificationEvent> ),
-                   queueKey ( ),
-                   queueEventSem ( )
+                   dispatcherWaiting ( 0 ),
+                   queue ( new IAsyncNotificationQueue ( numberOfPriorities ) ),
+                   queueEventSem ( readyMode ),
+                   maxBatch ( 64 ),
+                   maxSpin ( 0 ),
+                   requestedSpin ( 0 ),
+                   spinBudget ( 0 ),
+                   idleGap ( 0 )
 {
 }
 
@@ -89,16 +112,16 @@ IAsyncNotifierBackgroundThread :: ~IAsyncNotifierBackgroundThread ( )
 | Function Name: IAsyncNotifierBackgroundThread :: removeRef
 |
 | Implementation:
-|   If the count is now zero and the queue is empty let processMsgs know it
-|     is time to exit.
+|   If the count is now zero let processMsgs know it is time to exit.
+|   The decrement comes before the signal, and the signal stays until a wait
+|   takes it.  processMsgs reads the count after every wait, so it either
+|   sees a zero count or is woken by the signal.
 |-----------------------------------------------------------------------------*/
 unsigned long IAsyncNotifierBackgroundThread :: removeRef ( )
 {
-  IResourceLock queueLock ( queueKey );
-
   unsigned long count = IAsyncNotifierThread::removeRef();
-  if ( ( count == 0 ) && ( queue->isEmpty() ) )
-    queueEventSem.post();
+  if ( count == 0 )
+    signalReady();
 
   return count;
 }
@@ -107,19 +130,42 @@ unsigned long IAsyncNotifierBackgroundThread :: removeRef ( )
 | Function Name: IAsyncNotifierBackgroundThread :: enqueueNotification
 |
 | Implementation:
-|   Enqueue the notification.  The queue will make a copy of the event.
-|   If the dispatch thread may be waiting, post the semaphore.
+|   Enqueue the notification in the lane for its priority.  The queue will
+|     make a copy of the event and of the payload value.
+|   If the dispatch thread may be waiting, signal it.  Clearing the
+|     waiting flag makes sure only one producer signals for each wait.
 |-----------------------------------------------------------------------------*/
 IAsyncNotifierBackgroundThread & IAsyncNotifierBackgroundThread
                                    :: enqueueNotification (
-                                        const INotificationEvent & anEvent )
+                            const INotificationEvent & anEvent,
+                            IAsyncNotifier::Priority priority,
+                            const IAsyncNotificationPayload * payload )
 {
-  IResourceLock queueLock ( queueKey );
+  queue->addAsLast ( anEvent, priority, payload );
 
-  queue->addAsLast ( anEvent );
+  if ( IAtomic::exchange ( dispatcherWaiting, 0 ) != 0 )
+    signalReady();
+
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierBackgroundThread :: enqueueNotification
+|
+| Implementation:
+|   As above, but the queue constructs the event in place.
+|-----------------------------------------------------------------------------*/
+IAsyncNotifierBackgroundThread & IAsyncNotifierBackgroundThread
+                                   :: enqueueNotification (
+                            const INotificationId & nId,
+                            IAsyncNotifier & notifier,
+                            IAsyncNotifier::Priority priority,
+                            const IAsyncNotificationPayload * payload )
+{
+  queue->addAsLast ( nId, notifier, priority, payload );
 
-  if ( queue->numberOfElements() == 1 )
-    queueEventSem.post();
+  if ( IAtomic::exchange ( dispatcherWaiting, 0 ) != 0 )
+    signalReady();
 
   return *this;
 }
@@ -128,19 +174,22 @@ IAsyncNotifierBackgroundThread & IAsyncNotifierBackgroundThread
 | Function Name: IAsyncNotifierBackgroundThread :: processMsgs
 |
 | Implementation:
-|   Lock the queue
 |   While there are async notifiers on this thread:
-|     If queue is empty:
-|       Reset event sem
-|       Unlock the queue
-|       Wait on the event sem
-|       Lock the queue
-|     If the queue is not empty
-|       Dequeue the next event
-|       Unlock the queue
-|       Check for deleteThisId and notify observers
-|       Lock the queue
-|   Unlock the queue
+|     If no events were dispatched by dispatchBatch:
+|       If a timed notification is due now, go round again
+|       If spinning is on, poll the queue for the spin budget and go round
+|         again if a notification came
+|       Set the waiting flag
+|       If the queue is still empty, wait on the event sem until the next
+|         timed notification may be due.  The wait resets the event sem.
+|         timedWait returns when that time comes, without an exception.
+|       Clear the waiting flag
+|       Count the wait, and if spinning is on and a notification came, note
+|         how long the queue was empty
+|   The queue is checked again after the waiting flag is set because a
+|   producer that added an event before seeing the flag will not signal.
+|   A timed notification added on another thread gets here through the
+|   queue, so the timeout is always worked out again after a wait.
 |-----------------------------------------------------------------------------*/
 IAsyncNotifierBackgroundThread & IAsyncNotifierBackgroundThread
                                    :: processMsgs ( )
@@ -149,85 +198,409 @@ IAsyncNotifierBackgroundThread & IAsyncNotifierBackgroundThread
 
   setIsRunning ( true );
 
-  // Lock the queue
-  queueKey.lock();
-  IBoolean lockedHere = true;
-
-  try
+  // While there are async notifiers on this thread:
+  while ( refCount() != 0 )
   {
-    // While there are async notifiers on this thread:
-    while ( refCount() != 0 )
+    // If no events were dispatched by dispatchBatch:
+    if ( dispatchBatch() == 0 )
     {
-      // If queue is empty:
-      if ( queue->isEmpty() )
+      // If a timed notification is due now, go round again
+      long timeout = timeUntilTimer();
+      if ( timeout == 0 )
+        continue;
+
+      // If spinning is on, poll the queue for the spin budget
+      unsigned long idleStart = 0;
+      if ( maxSpin != 0 )
       {
-        // Reset event sem
-        queueEventSem.reset();
-
-        // Unlock the queue
-        queueKey.unlock();
-        lockedHere = false;
-
-        // Wait on the event sem
-        queueEventSem.wait();
-
-        // Lock the queue
-        queueKey.lock();
-        lockedHere = true;
+        idleStart = IAsyncNotificationMetrics::clock();
+        if ( spinForWork ( idleStart, timeout ) )
+          continue;
       }
 
-      // If the queue is not empty
-      if ( ! (queue->isEmpty()) )
+      // Set the waiting flag
+      // If the queue is still empty, wait on the event sem
+      IBoolean blocked = false;
+      if ( ( prepareToWait() ) && ( refCount() != 0 ) )
       {
-        // Dequeue the next event
-        INotificationEvent nextEvent ( queue->firstElement() );
-        queue->removeFirst();
-
-        // Unlock the queue
-        queueKey.unlock();
-        lockedHere = false;
-
-        // Check for deleteThisId and notify observers
-        IAsyncNotifier * theNotifier
-                           = (IAsyncNotifier *)(&(nextEvent.notifier()));
-        if ( nextEvent.notificationId() == deleteThisId )
-        {
-          delete theNotifier;
-        }
-        else
-        {
-          if ( theNotifier->isEnabledForNotification() )
-            theNotifier->IStandardNotifier::notifyObservers ( nextEvent );
-          theNotifier->notificationCleanUp ( nextEvent );
-        }
-
-        // Lock the queue
-        queueKey.lock();
-        lockedHere = true;
+        blocked = true;
+        queueEventSem.timedWait ( timeout );
       }
+
+      // Clear the waiting flag
+      stopWaiting();
+
+      // Count the wait and note how long the queue was empty
+      if ( blocked )
+        recordedMetrics().recordWait ( false );
+      if ( ( maxSpin != 0 ) && ( ! ( queue->isEmpty() ) ) )
+        noteIdleGap ( IAsyncNotificationMetrics::elapsed (
+                        idleStart, IAsyncNotificationMetrics::clock() ) );
     }
   }
-  catch ( IException & exc )
+
+  setIsRunning ( false );
+
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierBackgroundThread :: dispatchBatch
+|
+| Implementation:
+|   Queue the timed notifications that are due.
+|   If the overflow policy is dropOldest, throw away the events over the
+|     capacity and count them.
+|   Count the events queued now, up to the batch size.
+|   Dequeue, dispatch and record that many events.  The queue always
+|     removes from the highest lane, so an urgent event queued during the
+|     batch is dispatched next.
+|   The batch is counted up front so a steady stream of new events cannot
+|   keep the caller from checking for other work.  Events can only leave the
+|   batch early if an observer deletes their notifier.
+|-----------------------------------------------------------------------------*/
+unsigned long IAsyncNotifierBackgroundThread :: dispatchBatch ( )
+{
+  unsigned long dispatched = 0;
+
+  expireTimers();
+
+  if ( ! ( queue->isEmpty() ) )
   {
-    // Unlock the queue and rethrow.
-    if ( lockedHere )
-      queueKey.unlock();
-    throw;
+    if ( overflowPolicy() == IAsyncNotifier::dropOldest )
+      noteDropped ( queue->removeExcess() );
+
+    unsigned long eventsInBatch = queue->numberOfElements ( maxBatch );
+
+    while ( ( dispatched < eventsInBatch ) && ( ! ( queue->isEmpty() ) ) )
+    {
+      dispatchNext ( *queue, recordedMetrics() );
+      dispatched++;
+    }
   }
 
-  // Unlock the queue
-  queueKey.unlock();
+  return dispatched;
+}
 
-  setIsRunning ( false );
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierBackgroundThread :: prepareToWait
+|
+| Implementation:
+|   Reset the ready signal before setting the waiting flag, so a producer
+|   that clears the flag always signals after the reset.  For an auto reset
+|   event sem there is nothing to reset; a signal left over from a producer
+|   that saw the flag after the last wait ended just ends the next wait early.
+|   Return whether the queue is still empty.
+|-----------------------------------------------------------------------------*/
+IBoolean IAsyncNotifierBackgroundThread :: prepareToWait ( )
+{
+  resetReady();
+
+  IAtomic::exchange ( dispatcherWaiting, 1 );
+
+  return ( queue->isEmpty() );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierBackgroundThread :: stopWaiting
+|
+| Implementation:
+|   Clear the waiting flag.
+|-----------------------------------------------------------------------------*/
+IAsyncNotifierBackgroundThread & IAsyncNotifierBackgroundThread
+                                   :: stopWaiting ( )
+{
+  IAtomic::exchange ( dispatcherWaiting, 0 );
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierBackgroundThread :: signalReady
+|
+| Implementation:
+|   Post the event sem.
+|-----------------------------------------------------------------------------*/
+IAsyncNotifierBackgroundThread & IAsyncNotifierBackgroundThread
+                                   :: signalReady ( )
+{
+  queueEventSem.post();
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierBackgroundThread :: resetReady
+|
+| Implementation:
+|   Reset the event sem if it is manual reset.  An auto reset event sem was
+|   reset by the wait that the signal ended.
+|-----------------------------------------------------------------------------*/
+IAsyncNotifierBackgroundThread & IAsyncNotifierBackgroundThread
+                                   :: resetReady ( )
+{
+  if ( queueEventSem.resetMode() == IEventSem::manualReset )
+    queueEventSem.reset();
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierBackgroundThread :: readySemaphore
+|
+| Implementation:
+|   Return the event sem.
+|-----------------------------------------------------------------------------*/
+IEventSem & IAsyncNotifierBackgroundThread :: readySemaphore ( )
+{
+  return queueEventSem;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierBackgroundThread :: localizeStorage
+|
+| Implementation:
+|   This is called on this thread, the only one that releases the queue's
+|   storage, so the queue can refill it.  The new processors may change
+|   whether spinning pays, so apply the spin time again.
+|-----------------------------------------------------------------------------*/
+IAsyncNotifierBackgroundThread & IAsyncNotifierBackgroundThread
+                                   :: localizeStorage ( )
+{
+  queue->refillStorage();
+  applySpinTime();
+
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierBackgroundThread :: setBatchSize
+|
+| Implementation:
+|   Save the new batch size.  processMsgs uses it for the next batch.
+|-----------------------------------------------------------------------------*/
+IAsyncNotifierBackgroundThread & IAsyncNotifierBackgroundThread
+                                   :: setBatchSize ( unsigned long maxEvents )
+{
+  maxBatch = maxEvents;
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierBackgroundThread :: batchSize
+|
+| Implementation:
+|   Return the batch size.
+|-----------------------------------------------------------------------------*/
+unsigned long IAsyncNotifierBackgroundThread :: batchSize ( ) const
+{
+  return maxBatch;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierBackgroundThread :: setSpinTime
+|
+| Implementation:
+|   Save the requested spin time and apply it.
+|-----------------------------------------------------------------------------*/
+IAsyncNotifierBackgroundThread & IAsyncNotifierBackgroundThread
+                                   :: setSpinTime ( unsigned long microseconds )
+{
+  requestedSpin = microseconds;
+  return applySpinTime();
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierBackgroundThread :: applySpinTime
+|
+| Implementation:
+|   Start with a full budget, forgetting the gaps seen so far.  If this
+|   thread may run on only one processor the sender can not run on it while
+|   this thread spins, so leave spinning off.  localizeStorage calls this
+|   again, since moving the thread can change the answer.
+|-----------------------------------------------------------------------------*/
+IAsyncNotifierBackgroundThread & IAsyncNotifierBackgroundThread
+                                   :: applySpinTime ( )
+{
+  unsigned long microseconds = requestedSpin;
+  if ( ( microseconds != 0 ) && ( runnableProcessors() < 2 ) )
+    microseconds = 0;
+
+  idleGap = 0;
+  spinBudget = microseconds;
+  maxSpin = microseconds;
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierBackgroundThread :: spinTime
+|
+| Implementation:
+|   Return the spin time.
+|-----------------------------------------------------------------------------*/
+unsigned long IAsyncNotifierBackgroundThread :: spinTime ( ) const
+{
+  return maxSpin;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierBackgroundThread :: spinForWork
+|
+| Implementation:
+|   Spin for the budget, or until the next timed notification may be due if
+|     that is sooner.
+|   While spinning:
+|     If this thread is done, the wait is over.
+|     If the queue is not empty, count a win, note how long it was empty
+|       and end the wait.
+|     Otherwise let a hyperthread sibling run and read the clock.
+|   Nothing is signaled while spinning, since the waiting flag is not set.
+|-----------------------------------------------------------------------------*/
+IBoolean IAsyncNotifierBackgroundThread :: spinForWork (
+                                             unsigned long idleStart,
+                                             long timeout )
+{
+  unsigned long budget = spinBudget;
+  if ( ( timeout > 0 ) && ( (unsigned long)timeout < budget / 1000 ) )
+    budget = (unsigned long)timeout * 1000;
+
+  unsigned long spun = 0;
+  while ( spun < budget )
+  {
+    if ( refCount() == 0 )
+      return true;
+
+    if ( ! ( queue->isEmpty() ) )
+    {
+      recordedMetrics().recordWait ( true );
+      noteIdleGap ( spun );
+      return true;
+    }
+
+#if defined(__GNUC__) && ( defined(__i386__) || defined(__x86_64__) )
+    __builtin_ia32_pause();
+#endif
+    spun = IAsyncNotificationMetrics::elapsed (
+                         idleStart, IAsyncNotificationMetrics::clock() );
+  }
+
+  return false;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierBackgroundThread :: noteIdleGap
+|
+| Implementation:
+|   Keep a running average of the gaps, weighting the latest by an eighth.
+|   Spin for twice the average, so most gaps end while spinning, but not
+|     for less than the minimum or more than the spin time.
+|   While the average is longer than the spin time, most gaps would not end
+|     while spinning, so block at once.  Gaps are still measured from the
+|     waits that block, so spinning starts again when they get shorter.
+|-----------------------------------------------------------------------------*/
+IAsyncNotifierBackgroundThread & IAsyncNotifierBackgroundThread
+                                   :: noteIdleGap ( unsigned long gap )
+{
+  if ( gap > longestGap )
+    gap = longestGap;
+
+  idleGap = ( idleGap * 7 + gap ) / 8;
+
+  if ( idleGap > maxSpin )
+    spinBudget = 0;
+  else if ( idleGap * 2 + minimumSpin < maxSpin )
+    spinBudget = idleGap * 2 + minimumSpin;
+  else
+    spinBudget = maxSpin;
+
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierBackgroundThread :: setCapacity
+|
+| Implementation:
+|   Save the policy and set the capacity of the queue.
+|-----------------------------------------------------------------------------*/
+IAsyncNotifierBackgroundThread & IAsyncNotifierBackgroundThread
+                                   :: setCapacity (
+                                        unsigned long maxEvents,
+                                        IAsyncNotifier::OverflowPolicy policy )
+{
+  IAsyncNotifierThread::setCapacity ( maxEvents, policy );
+  queue->setCapacity ( maxEvents );
 
   return *this;
 }
 
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierBackgroundThread :: capacity
+|
+| Implementation:
+|   Return the capacity of the queue.
+|-----------------------------------------------------------------------------*/
+unsigned long IAsyncNotifierBackgroundThread :: capacity ( ) const
+{
+  return ( queue->capacity() );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierBackgroundThread :: isFull
+|
+| Implementation:
+|   Ask the queue.
+|-----------------------------------------------------------------------------*/
+IBoolean IAsyncNotifierBackgroundThread :: isFull ( ) const
+{
+  return ( queue->isFull() );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierBackgroundThread :: queueDepth
+|
+| Implementation:
+|   Ask the queue.
+|-----------------------------------------------------------------------------*/
+unsigned long IAsyncNotifierBackgroundThread :: queueDepth ( ) const
+{
+  return ( queue->length() );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierBackgroundThread :: waitForRoom
+|
+| Implementation:
+|   Wait for the queue to have room.
+|-----------------------------------------------------------------------------*/
+IAsyncNotifierBackgroundThread & IAsyncNotifierBackgroundThread
+                                   :: waitForRoom ( )
+{
+  queue->waitForRoom();
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierBackgroundThread :: canDispatchInline
+|
+| Implementation:
+|   Only this thread removes from the queue, so if it is running on this
+|   thread and has nothing queued for the notifier, nothing can be queued
+|   for it ahead of a notification sent now.  While it is running, this
+|   object is not deleted.
+|-----------------------------------------------------------------------------*/
+IBoolean IAsyncNotifierBackgroundThread :: canDispatchInline (
+                                   const IAsyncNotifier & asyncNotifier )
+{
+  return ( ( threadId() == IThread::currentId() ) &&
+           ( isRunning() ) &&
+           ( ! ( queue->hasPendingFor ( asyncNotifier ) ) ) );
+}
+
 /*------------------------------------------------------------------------------
 | Function Name: IAsyncNotifierBackgroundThread :: deleteNotificationsFor
 |
 | Implementation:
-|   Remove all pending notifications for the passed async notifier.
+|   Remove all pending notifications for the passed async notifier.  Only
+|   this thread removes from the queue, so no lock is needed.  The queue
+|   keeps an index of each notifier's notifications, so only the ones for
+|   this notifier are visited.
 |-----------------------------------------------------------------------------*/
 IAsyncNotifierBackgroundThread & IAsyncNotifierBackgroundThread
                                    :: deleteNotificationsFor (
@@ -235,10 +608,9 @@ IAsyncNotifierBackgroundThread & IAsyncNotifierBackgroundThread
 {
   IASSERTSTATE ( threadId() == IThread::currentId() );
 
-  IResourceLock queueLock ( queueKey );
-
-  queue->removeAll ( removeFor, (void *)(&asyncNotifier) );
+  queue->removeAllFor ( asyncNotifier );
 
   return *this;
 }
+
 
\ No newline at end of file
@@ -22,19 +22,18 @@
 #endif
 
 // Other dependency classes:
-#ifndef _IRESLOCK_
-  #include <ireslock.hpp>
-#endif
-
 #ifndef _IEVNTSEM_
   #include <ievntsem.hpp>
 #endif
 
 class INotificationEvent;
-template <class Element> class ISequence;
+class IAsyncNotificationQueue;
+class IAsyncNotificationPayload;
 
-// Align classes on four byte boundary.
-#pragma pack(4)
+// Align classes on four byte boundary, except on Linux (see iatomic.hpp).
+#ifndef __linux__
+  #pragma pack(4)
+#endif
 
 class IAsyncNotifierBackgroundThread : public IAsyncNotifierThread {
 /*******************************************************************************
@@ -47,7 +46,8 @@ class IAsyncNotifierBackgroundThread : public IAsyncNotifierThread {
 public:
 /*------------------------------ Constructors ----------------------------------
 | You can construct an object of this class as follows:                        |
-|   - With the default constructor.                                            |
+|   - With the default constructor.  processMsgs waits on an auto reset event  |
+|     semaphore, so the wait that a signal ends also resets it.                |
 |-----------------------------------------------------------------------------*/
 IAsyncNotifierBackgroundThread ( );
 
@@ -56,17 +56,30 @@ virtual ~IAsyncNotifierBackgroundThread ( );
 /*--------------------------- Reference Counting -------------------------------
 | Used by IAsyncNotifier objects to remove references to this object.          |
 |   removeRef - Calls base class implementation.  Then if the count is zero    |
-|               and the queue is empty, the queueEventSem is posted so that    |
-|               processMsgs will see that it is time to exit.                  |
+|               signalReady is called so that processMsgs will see that it is  |
+|               time to exit.  No semaphore is requested.  The signal stays    |
+|               until a wait takes it, and processMsgs checks the count after  |
+|               every wait, so the signal is never lost.                       |
 |-----------------------------------------------------------------------------*/
 virtual unsigned long removeRef ( );
 
 /*-------------------------- Enqueue Notification ------------------------------
 | Used by IAsyncNotifier objects to enque notifications.                       |
-|   enqueueNotification - Places the notification on this thread's queue.      |
+|   enqueueNotification - Places the notification at the end of the lane for   |
+|                         the priority in this thread's queue.  No semaphore   |
+|                         is requested, so any number of threads can enqueue   |
+|                         at the same time.  A notification passed as an id    |
+|                         and a notifier is constructed right in the queue.    |
 |-----------------------------------------------------------------------------*/
 virtual IAsyncNotifierBackgroundThread & enqueueNotification (
-                                           const INotificationEvent & anEvent );
+                           const INotificationEvent & anEvent,
+                           IAsyncNotifier::Priority priority,
+                           const IAsyncNotificationPayload * payload = 0 );
+virtual IAsyncNotifierBackgroundThread & enqueueNotification (
+                           const INotificationId & nId,
+                           IAsyncNotifier & notifier,
+                           IAsyncNotifier::Priority priority,
+                           const IAsyncNotificationPayload * payload = 0 );
 
 /*---------------------------- Process Messages --------------------------------
 | Use this to start dispatching notifications for this thread.                 |
@@ -78,9 +91,67 @@ virtual IAsyncNotifierBackgroundThread & enqueueNotification (
 |-----------------------------------------------------------------------------*/
 virtual IAsyncNotifierBackgroundThread & processMsgs ( );
 
+/*---------------------------- Dispatch Batching -------------------------------
+| Use these functions to control how many queued notifications are             |
+| dispatched at a time.                                                        |
+|   setBatchSize - Sets the maximum number of notifications dispatched as one  |
+|                  batch.  processMsgs takes the notifications that are queued |
+|                  when a batch starts, up to this number, and dispatches them |
+|                  without looking for new ones.  Zero means no limit.         |
+|   batchSize    - Returns the maximum batch size.  The default is 64.         |
+|-----------------------------------------------------------------------------*/
+virtual IAsyncNotifierBackgroundThread & setBatchSize (
+                                           unsigned long maxEvents );
+virtual unsigned long batchSize ( ) const;
+
+/*------------------------------- Spin Polling ---------------------------------
+| Use these functions to trade processor time for a faster response to a       |
+| notification that follows soon after the queue becomes empty.                |
+|   setSpinTime - Sets the longest time, in microseconds, that processMsgs     |
+|                 polls the empty queue before it blocks.  The time actually   |
+|                 spent follows the recent gaps between notifications: about   |
+|                 twice their average, or none while they are longer than the  |
+|                 spin time.  Zero, the default, means it blocks at once.      |
+|                 If this thread may run on only one processor, because of     |
+|                 its affinity or because only one is online, the spin time    |
+|                 stays zero.                                                  |
+|   spinTime    - Returns the longest spin time.                               |
+|-----------------------------------------------------------------------------*/
+virtual IAsyncNotifierBackgroundThread & setSpinTime (
+                                           unsigned long microseconds );
+virtual unsigned long spinTime ( ) const;
+
+/*------------------------------ Queue Capacity --------------------------------
+| Used by IAsyncNotifier to bound the number of queued notifications.  All of  |
+| these functions may be called on any thread.                                 |
+|   setCapacity - Sets the capacity of the queue and saves the policy.  Zero   |
+|                 means no limit.  When the policy is dropOldest, the excess   |
+|                 is thrown away before each batch is dispatched.              |
+|   capacity    - Returns the capacity of the queue.                           |
+|   isFull      - Returns true if the queue is full.                           |
+|   waitForRoom - Returns when the queue is not full.  It must not be called   |
+|                 on this thread.                                              |
+|   queueDepth  - Returns the number of notifications in the queue.            |
+|-----------------------------------------------------------------------------*/
+virtual IAsyncNotifierBackgroundThread & setCapacity (
+                                   unsigned long maxEvents,
+                                   IAsyncNotifier::OverflowPolicy policy );
+virtual unsigned long capacity ( ) const;
+virtual IBoolean      isFull   ( ) const;
+virtual IAsyncNotifierBackgroundThread & waitForRoom ( );
+virtual unsigned long queueDepth ( ) const;
+
+/*--------------------------- Inline Dispatching -------------------------------
+| Used by IAsyncNotifier to dispatch a notification without queuing it.        |
+|   canDispatchInline - Returns true if the current thread is this thread,     |
+|                       isRunning returns true and no notifications of the     |
+|                       passed object are queued.                              |
+|-----------------------------------------------------------------------------*/
+virtual IBoolean canDispatchInline ( const IAsyncNotifier & asyncNotifier );
+
 /*-------------------------- Delete Notifications ------------------------------
-| IAsyncNotifier calls this from its destructor to have all pending            |
-| notifications deleted.                                                       |
+| IAsyncNotifier calls this from close to have all pending notifications       |
+| deleted.                                                                     |
 |   deleteNotificationsFor - Ensures that all notifications for the passed     |
 |                            object are never dispatched.  Throws an invalid   |
 |                            request exception if the current thread is not    |
@@ -90,16 +161,86 @@ virtual IAsyncNotifierBackgroundThread & deleteNotificationsFor (
                                          const IAsyncNotifier & asyncNotifier );
 
 
+protected:
+/*------------------------------ Constructors ----------------------------------
+| Subclasses can construct an object of this class as follows:                 |
+|   - With the reset mode of the event semaphore that carries the ready        |
+|     signal.  A subclass whose ready signal is waited on outside this class   |
+|     may need it to stay posted until resetReady is called.                   |
+|-----------------------------------------------------------------------------*/
+IAsyncNotifierBackgroundThread ( IEventSem::ResetMode readyMode );
+
+/*------------------------------ Implementation --------------------------------
+| These functions are used by processMsgs and by subclasses that dispatch in   |
+| some other way.  Only this thread may call them.                             |
+|   dispatchBatch  - Dispatches one batch of the queued notifications and      |
+|                    returns the number dispatched.  Each one is taken from    |
+|                    the highest priority lane that has any, including lanes   |
+|                    that were empty when the batch started.  Returns zero     |
+|                    without blocking if the queue is empty.                   |
+|   prepareToWait  - Calls resetReady and sets the waiting flag, so the        |
+|                    next enqueueNotification signals that the queue is ready. |
+|                    Returns true if the queue is still empty.  If false is    |
+|                    returned, a notification was queued before the flag was   |
+|                    set and may never be signaled.                            |
+|   stopWaiting    - Clears the waiting flag.                                  |
+|   signalReady    - Used to tell this thread that there are notifications to  |
+|                    dispatch or that it is time to exit.  This implementation |
+|                    posts the event semaphore processMsgs waits on.  It can   |
+|                    be called from any thread.                                |
+|   resetReady     - Resets the ready signal.  This implementation resets the  |
+|                    event semaphore if it is manual reset.  An auto reset one |
+|                    is reset by the wait that the signal ends.                |
+|   readySemaphore - Returns the event semaphore processMsgs waits on.         |
+|-----------------------------------------------------------------------------*/
+unsigned long dispatchBatch  ( );
+IBoolean      prepareToWait  ( );
+IAsyncNotifierBackgroundThread & stopWaiting ( );
+
+virtual IAsyncNotifierBackgroundThread & signalReady ( );
+virtual IAsyncNotifierBackgroundThread & resetReady  ( );
+
+IEventSem & readySemaphore ( );
+
+/*------------------------------ Local Storage ---------------------------------
+| Called by setProcessors once this thread runs on its new processors.         |
+|   localizeStorage - Refills the free storage of the queue and applies the    |
+|                     spin time again for the new processors.                  |
+|-----------------------------------------------------------------------------*/
+virtual IAsyncNotifierBackgroundThread & localizeStorage ( );
+
+
 private:
+/*------------------------------- Spin Polling ---------------------------------
+|   spinForWork   - Polls the queue until it is not empty, the spin budget is  |
+|                   used up, or the timeout in milliseconds passes, counting   |
+|                   from idleStart.  Returns true if the wait is over.         |
+|   noteIdleGap   - Adds the time the queue stayed empty to the running        |
+|                   average and works out the next spin budget from it.        |
+|   applySpinTime - Sets the spin time from the requested one, or to zero if   |
+|                   this thread may run on only one processor.                 |
+|-----------------------------------------------------------------------------*/
+IBoolean spinForWork ( unsigned long idleStart, long timeout );
+IAsyncNotifierBackgroundThread & noteIdleGap   ( unsigned long gap );
+IAsyncNotifierBackgroundThread & applySpinTime ( );
+
 // The private copy constructor and assignment operator are not implemented.
 IAsyncNotifierBackgroundThread ( const IAsyncNotifierBackgroundThread & rhs );
 IAsyncNotifierBackgroundThread & operator = (
                                    const IAsyncNotifierBackgroundThread & rhs );
 
 /*--------------------------- Private State Data -----------------------------*/
-ISequence<INotificationEvent> * queue;
-IPrivateResource                queueKey;
-IEventSem                       queueEventSem;
+// Every enqueueNotification exchanges dispatcherWaiting.  It comes first so
+// that, where four byte packing leaves eight byte longs unaligned, it does
+// not straddle a cache line and make the exchange lock the bus.
+volatile long             dispatcherWaiting;
+IAsyncNotificationQueue * queue;
+IEventSem                 queueEventSem;
+unsigned long             maxBatch;
+unsigned long             maxSpin;
+unsigned long             requestedSpin;
+unsigned long             spinBudget;
+unsigned long             idleGap;
 
 }; // IAsyncNotifierBackgroundThread
 
@@ -43,13 +43,22 @@
   #include <iobjwin.hpp>
 #endif
 
-#ifndef _ISEQ_H
-  #include <iseq.h>
+#ifndef _IASYNQUE_
+  #include <iasynque.hpp>
+#endif
+
+#ifndef _IATOMIC_
+  #include <iatomic.hpp>
 #endif
 
 #define INCL_WINMESSAGEMGR
+#define INCL_WINTIMER
 #include <os2.h>
 
+// The id of the PM timer that wakes the object window for timed
+// notifications.
+static const ULONG asyncTimerId = 1;
+
 
 //------------------------------------------------------------------------------
 // Declare the event notification handler for the object window.
@@ -57,7 +66,7 @@
 class IAsyncNotificationHandler : public IHandler
 {
 public:
-  IAsyncNotificationHandler ( );
+  IAsyncNotificationHandler ( IAsyncNotifierGUIThread & thread );
   virtual ~IAsyncNotificationHandler ( );
 
   virtual IBoolean dispatchHandlerEvent ( IEvent & event );
@@ -66,6 +75,8 @@ private:
   // Private copy constructor and assignment operator are not implemented.
   IAsyncNotificationHandler ( const IAsyncNotificationHandler & );
   IAsyncNotificationHandler & operator = ( const IAsyncNotificationHandler & );
+
+  IAsyncNotifierGUIThread & asyncNotifierThread;
 };
 
 
@@ -73,14 +84,21 @@ private:
 | Function Name: IAsyncNotifierGUIThread :: IAsyncNotifierGUIThread
 |
 | Implementation:
-|   Initialize the base class then create our object window and handler.
+|   Initialize the base class then create our object window, handler and
+|   queue.  No message has been posted, so the first notification must post
+|   one.
 |-----------------------------------------------------------------------------*/
 IAsyncNotifierGUIThread :: IAsyncNotifierGUIThread ( ) :
                    IAsyncNotifierThread ( ),
                    objectWindow ( new IObjectWindow ),
-                   asyncNotificationHandler ( new IAsyncNotificationHandler ),
-                   objectWindowKey ( )
+                   asyncNotificationHandler ( 0 ),
+                   objectWindowKey ( ),
+                   queue ( new IAsyncNotificationQueue ( numberOfPriorities ) ),
+                   wakeUpNeeded ( 1 ),
+                   maxBatch ( 64 )
 {
+  asyncNotificationHandler = new IAsyncNotificationHandler ( *this );
+
   objectWindow->setAutoDeleteObject ( true );
   asyncNotificationHandler->handleEventsFor ( objectWindow );
 }
@@ -91,7 +109,7 @@ IAsyncNotifierGUIThread :: IAsyncNotifierGUIThread ( ) :
 | Implementation:
 |   If the object window is still around, close the object window (it is
 |     auto deleted).
-|   Delete the handler.
+|   Delete the handler and the queue.
 |-----------------------------------------------------------------------------*/
 IAsyncNotifierGUIThread :: ~IAsyncNotifierGUIThread ( )
 {
@@ -102,6 +120,7 @@ IAsyncNotifierGUIThread :: ~IAsyncNotifierGUIThread ( )
   }
 
   delete asyncNotificationHandler;
+  delete queue;
 }
 
 /*------------------------------------------------------------------------------
@@ -118,6 +137,8 @@ unsigned long IAsyncNotifierGUIThread :: removeRef ( )
   unsigned long count = IAsyncNotifierThread::removeRef();
   if ( count == 0 )
   {
+    IResourceLock objectWindowLock ( objectWindowKey );
+
     asyncNotificationHandler->stopHandlingEventsFor ( objectWindow );
     objectWindow->close();
     objectWindow = NULL;
@@ -130,15 +151,40 @@ unsigned long IAsyncNotifierGUIThread :: removeRef ( )
 | Function Name: IAsyncNotifierGUIThread :: enqueueNotification
 |
 | Implementation:
-|   Copy and enqueue the notification.
+|   Enqueue the notification in the lane for its priority.  The queue will
+|     make a copy of the event and of the payload value.
+|   If no message is outstanding, post one.  Clearing the flag makes sure
+|     only one producer posts.
 |-----------------------------------------------------------------------------*/
 IAsyncNotifierGUIThread & IAsyncNotifierGUIThread :: enqueueNotification (
-                            const INotificationEvent & anEvent )
+                            const INotificationEvent & anEvent,
+                            IAsyncNotifier::Priority priority,
+                            const IAsyncNotificationPayload * payload )
 {
-  IResourceLock objectWindowLock ( objectWindowKey );
+  queue->addAsLast ( anEvent, priority, payload );
 
-  INotificationEvent * copiedEvent = new INotificationEvent ( anEvent );
-  objectWindow->postEvent ( WM_USER, IEventData ( copiedEvent ) );
+  if ( IAtomic::exchange ( wakeUpNeeded, 0 ) != 0 )
+    postWakeUp();
+
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierGUIThread :: enqueueNotification
+|
+| Implementation:
+|   As above, but the queue constructs the event in place.
+|-----------------------------------------------------------------------------*/
+IAsyncNotifierGUIThread & IAsyncNotifierGUIThread :: enqueueNotification (
+                            const INotificationId & nId,
+                            IAsyncNotifier & notifier,
+                            IAsyncNotifier::Priority priority,
+                            const IAsyncNotificationPayload * payload )
+{
+  queue->addAsLast ( nId, notifier, priority, payload );
+
+  if ( IAtomic::exchange ( wakeUpNeeded, 0 ) != 0 )
+    postWakeUp();
 
   return *this;
 }
@@ -160,13 +206,115 @@ IAsyncNotifierGUIThread & IAsyncNotifierGUIThread :: processMsgs ( )
   return *this;
 }
 
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierGUIThread :: setBatchSize
+|
+| Implementation:
+|   Save the new batch size.  It is used for the next message.
+|-----------------------------------------------------------------------------*/
+IAsyncNotifierGUIThread & IAsyncNotifierGUIThread :: setBatchSize (
+                                                    unsigned long maxEvents )
+{
+  maxBatch = maxEvents;
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierGUIThread :: batchSize
+|
+| Implementation:
+|   Return the batch size.
+|-----------------------------------------------------------------------------*/
+unsigned long IAsyncNotifierGUIThread :: batchSize ( ) const
+{
+  return maxBatch;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierGUIThread :: setCapacity
+|
+| Implementation:
+|   Save the policy and set the capacity of the queue.
+|-----------------------------------------------------------------------------*/
+IAsyncNotifierGUIThread & IAsyncNotifierGUIThread :: setCapacity (
+                            unsigned long maxEvents,
+                            IAsyncNotifier::OverflowPolicy policy )
+{
+  IAsyncNotifierThread::setCapacity ( maxEvents, policy );
+  queue->setCapacity ( maxEvents );
+
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierGUIThread :: capacity
+|
+| Implementation:
+|   Return the capacity of the queue.
+|-----------------------------------------------------------------------------*/
+unsigned long IAsyncNotifierGUIThread :: capacity ( ) const
+{
+  return ( queue->capacity() );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierGUIThread :: isFull
+|
+| Implementation:
+|   Ask the queue.
+|-----------------------------------------------------------------------------*/
+IBoolean IAsyncNotifierGUIThread :: isFull ( ) const
+{
+  return ( queue->isFull() );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierGUIThread :: queueDepth
+|
+| Implementation:
+|   Ask the queue.
+|-----------------------------------------------------------------------------*/
+unsigned long IAsyncNotifierGUIThread :: queueDepth ( ) const
+{
+  return ( queue->length() );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierGUIThread :: waitForRoom
+|
+| Implementation:
+|   Wait for the queue to have room.
+|-----------------------------------------------------------------------------*/
+IAsyncNotifierGUIThread & IAsyncNotifierGUIThread :: waitForRoom ( )
+{
+  queue->waitForRoom();
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierGUIThread :: canDispatchInline
+|
+| Implementation:
+|   Only this thread removes from the queue, so if it is running on this
+|   thread and has nothing queued for the notifier, nothing can be queued
+|   for it ahead of a notification sent now.  While it is running, this
+|   object is not deleted.
+|-----------------------------------------------------------------------------*/
+IBoolean IAsyncNotifierGUIThread :: canDispatchInline (
+                            const IAsyncNotifier & asyncNotifier )
+{
+  return ( ( threadId() == IThread::currentId() ) &&
+           ( isRunning() ) &&
+           ( ! ( queue->hasPendingFor ( asyncNotifier ) ) ) );
+}
+
 /*------------------------------------------------------------------------------
 | Function Name: IAsyncNotifierGUIThread :: deleteNotificationsFor
 |
 | Implementation:
-|   Peek at all notifcation events coming to our object window.
-|   If it is for the passed async notifier, delete it.
-|   Else, save it and requeue it at the end.
+|   Remove all pending notifications for the passed async notifier.  Only
+|   this thread removes from the queue, so no lock is needed.  A message
+|   that was posted for them finds nothing to do.
 |-----------------------------------------------------------------------------*/
 IAsyncNotifierGUIThread & IAsyncNotifierGUIThread
                                    :: deleteNotificationsFor (
@@ -174,45 +322,101 @@ IAsyncNotifierGUIThread & IAsyncNotifierGUIThread
 {
   IASSERTSTATE ( threadId() == IThread::currentId() );
 
+  queue->removeAllFor ( asyncNotifier );
+
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierGUIThread :: localizeStorage
+|
+| Implementation:
+|   This is called on this thread, the only one that releases the queue's
+|   storage, so the queue can refill it.
+|-----------------------------------------------------------------------------*/
+IAsyncNotifierGUIThread & IAsyncNotifierGUIThread :: localizeStorage ( )
+{
+  queue->refillStorage();
+
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierGUIThread :: postWakeUp
+|
+| Implementation:
+|   Post a message to the object window, unless it has been closed.
+|-----------------------------------------------------------------------------*/
+IAsyncNotifierGUIThread & IAsyncNotifierGUIThread :: postWakeUp ( )
+{
   IResourceLock objectWindowLock ( objectWindowKey );
 
-  ISequence<INotificationEvent *> savedEvents;
+  if ( objectWindow != NULL )
+    objectWindow->postEvent ( WM_USER );
 
-  HAB hab = IThread::current().anchorBlock();
-  QMSG msg;
-  HWND handle = objectWindow->handle();
+  return *this;
+}
 
-  INotificationEvent * nextEvent = NULL;
-  const IAsyncNotifier * nextNotifier = NULL;
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierGUIThread :: dispatchQueued
+|
+| Implementation:
+|   Called by the handler for our message and our timer.
+|   Mark this thread running so it is not deleted by an observer that deletes
+|     the last notifier.
+|   Queue the timed notifications that are due.
+|   If the overflow policy is dropOldest, throw away the events over the
+|     capacity and count them.
+|   Count the events queued now, up to the batch size.
+|   Dequeue, dispatch and record that many events.  The queue always
+|     removes from the highest lane.
+|   If there are still notifiers, set the flag so the next producer posts a
+|     message.  If events were queued before the flag was set, nobody will
+|     post for them, so try to post ourselves.  Then set the timer for the
+|     next timed notification, or stop it if there are none.
+|   If IAsyncNotifier::run is not running this thread and the last notifier
+|     was deleted, it was only removed from the collection.  Delete it.
+|-----------------------------------------------------------------------------*/
+IAsyncNotifierGUIThread & IAsyncNotifierGUIThread :: dispatchQueued ( )
+{
+  IBoolean wasRunning = isRunning();
+  setIsRunning ( true );
 
-  IBoolean msgFound = true;
-  while ( msgFound )
+  expireTimers();
+
+  if ( overflowPolicy() == IAsyncNotifier::dropOldest )
+    noteDropped ( queue->removeExcess() );
+
+  unsigned long eventsInBatch = queue->numberOfElements ( maxBatch );
+  while ( ( eventsInBatch != 0 ) && ( ! ( queue->isEmpty() ) ) )
   {
-    msgFound = WinPeekMsg ( hab, &msg, handle, WM_USER, WM_USER, PM_REMOVE );
-
-    if ( msgFound )
-    {
-      nextEvent = (INotificationEvent *)(msg.mp1);
-      nextNotifier = (const IAsyncNotifier *)(&(nextEvent->notifier()));
-      if ( nextNotifier == &asyncNotifier )
-      {
-        nextNotifier->notificationCleanUp ( *nextEvent );
-        delete nextEvent;
-      }
-      else
-      {
-        savedEvents.addAsLast ( nextEvent );
-      }
-    }
+    dispatchNext ( *queue, recordedMetrics() );
+    eventsInBatch--;
   }
 
-  while ( ! ( savedEvents.isEmpty() ) )
+  if ( refCount() != 0 )
   {
-    nextEvent = savedEvents.firstElement();
-    savedEvents.removeFirst();
-    objectWindow->postEvent ( WM_USER, IEventData ( nextEvent ) );
+    IAtomic::exchange ( wakeUpNeeded, 1 );
+
+    if ( ( ! ( queue->isEmpty() ) ) &&
+         ( IAtomic::exchange ( wakeUpNeeded, 0 ) != 0 ) )
+      postWakeUp();
+
+    long timeout = timeUntilTimer();
+    if ( timeout < 0 )
+      WinStopTimer ( IThread::current().anchorBlock(),
+                     objectWindow->handle(), asyncTimerId );
+    else
+      WinStartTimer ( IThread::current().anchorBlock(),
+                      objectWindow->handle(), asyncTimerId,
+                      (ULONG)( ( timeout == 0 ) ? 1 : timeout ) );
   }
 
+  setIsRunning ( wasRunning );
+
+  if ( ( ! wasRunning ) && ( refCount() == 0 ) )
+    delete this;
+
   return *this;
 }
 
@@ -220,10 +424,12 @@ IAsyncNotifierGUIThread & IAsyncNotifierGUIThread
 | Function Name: IAsyncNotificationHandler :: IAsyncNotificationHandler
 |
 | Implementation:
-|   Initialize the base class.
+|   Initialize the base class and save the thread whose queue we dispatch.
 |-----------------------------------------------------------------------------*/
-IAsyncNotificationHandler :: IAsyncNotificationHandler ( ) :
-                   IHandler ( )
+IAsyncNotificationHandler :: IAsyncNotificationHandler (
+                               IAsyncNotifierGUIThread & thread ) :
+                   IHandler ( ),
+                   asyncNotifierThread ( thread )
 {
 }
 
@@ -241,31 +447,19 @@ IAsyncNotificationHandler :: ~IAsyncNotificationHandler ( )
 | Function Name: IAsyncNotificationHandler :: dispatchHandlerEvent
 |
 | Implementation:
-|   If the event is one of our notifications, notify the observers of the
-|   notifier on this thread and delete the event.
+|   If the event is our message or our timer, have the thread dispatch a
+|   batch of its queued notifications.  That may delete the thread and this
+|   handler, so nothing else may be used afterwards.
 |-----------------------------------------------------------------------------*/
 IBoolean IAsyncNotificationHandler :: dispatchHandlerEvent ( IEvent & event )
 {
   IBoolean handledEvent = false;
 
-  if ( event.eventId() == WM_USER )
+  if ( ( event.eventId() == WM_USER ) ||
+       ( ( event.eventId() == WM_TIMER ) &&
+         ( event.parameter1().asUnsignedLong() == asyncTimerId ) ) )
   {
-    INotificationEvent * theEvent = (INotificationEvent *)
-                                       ((char *)(event.parameter1()));
-
-    IAsyncNotifier * theNotifier = (IAsyncNotifier *)(&(theEvent->notifier()));
-    if ( theEvent->notificationId() == IAsyncNotifierThread::deleteThisId )
-    {
-      delete theNotifier;
-    }
-    else
-    {
-      theNotifier->IStandardNotifier::notifyObservers ( *theEvent );
-      theNotifier->notificationCleanUp ( *theEvent );
-    }
-
-    delete theEvent;
-
+    asyncNotifierThread.dispatchQueued();
     handledEvent = true;
   }
 
@@ -28,15 +28,24 @@
 class INotificationEvent;
 class IObjectWindow;
 class IAsyncNotificationHandler;
+class IAsyncNotificationQueue;
+class IAsyncNotificationPayload;
 
-// Align classes on four byte boundary.
-#pragma pack(4)
+// Align classes on four byte boundary, except on Linux (see iatomic.hpp).
+#ifndef __linux__
+  #pragma pack(4)
+#endif
 
 class IAsyncNotifierGUIThread : public IAsyncNotifierThread {
 /*******************************************************************************
 *
 * This class implements the interface for asynchronous notifier GUI thread
-* objects.
+* objects.  Notifications are kept in a queue with a lane for each priority.
+* When notifications are added to an empty queue, a message is posted to an
+* object window, and its handler dispatches a batch of notifications.  If
+* more are left, it posts the message again, so other messages are processed
+* in between.  Only one such message is outstanding at a time.  A PM timer on
+* the object window dispatches timed notifications when they are due.
 *
 *******************************************************************************/
 
@@ -58,10 +67,22 @@ virtual unsigned long removeRef ( );
 
 /*-------------------------- Enqueue Notification ------------------------------
 | Used by IAsyncNotifier objects to enque notifications.                       |
-|   enqueueNotification - Places the notification on this thread's queue.      |
+|   enqueueNotification - Places the notification at the end of the lane for   |
+|                         the priority in this thread's queue.  If the object  |
+|                         window has not been told about queued                |
+|                         notifications yet, a message is posted to it.  A     |
+|                         notification passed as an id and a notifier is       |
+|                         constructed right in the queue.                      |
 |-----------------------------------------------------------------------------*/
 virtual IAsyncNotifierGUIThread & enqueueNotification (
-                                    const INotificationEvent & anEvent );
+                           const INotificationEvent & anEvent,
+                           IAsyncNotifier::Priority priority,
+                           const IAsyncNotificationPayload * payload = 0 );
+virtual IAsyncNotifierGUIThread & enqueueNotification (
+                           const INotificationId & nId,
+                           IAsyncNotifier & notifier,
+                           IAsyncNotifier::Priority priority,
+                           const IAsyncNotificationPayload * payload = 0 );
 
 /*---------------------------- Process Messages --------------------------------
 | Use this to start dispatching notifications for this thread.                 |
@@ -73,9 +94,47 @@ virtual IAsyncNotifierGUIThread & enqueueNotification (
 |-----------------------------------------------------------------------------*/
 virtual IAsyncNotifierGUIThread & processMsgs ( );
 
+/*---------------------------- Dispatch Batching -------------------------------
+| Use these functions to control how many queued notifications are             |
+| dispatched for each message.                                                 |
+|   setBatchSize - Sets the maximum number of notifications dispatched for one |
+|                  message.  Zero means no limit.                              |
+|   batchSize    - Returns the maximum batch size.  The default is 64.         |
+|-----------------------------------------------------------------------------*/
+virtual IAsyncNotifierGUIThread & setBatchSize ( unsigned long maxEvents );
+virtual unsigned long batchSize ( ) const;
+
+/*------------------------------ Queue Capacity --------------------------------
+| Used by IAsyncNotifier to bound the number of queued notifications.  All of  |
+| these functions may be called on any thread.                                 |
+|   setCapacity - Sets the capacity of the queue and saves the policy.  Zero   |
+|                 means no limit.  When the policy is dropOldest, the excess   |
+|                 is thrown away before each batch is dispatched.              |
+|   capacity    - Returns the capacity of the queue.                           |
+|   isFull      - Returns true if the queue is full.                           |
+|   waitForRoom - Returns when the queue is not full.  It must not be called   |
+|                 on this thread.                                              |
+|   queueDepth  - Returns the number of notifications in the queue.            |
+|-----------------------------------------------------------------------------*/
+virtual IAsyncNotifierGUIThread & setCapacity (
+                                   unsigned long maxEvents,
+                                   IAsyncNotifier::OverflowPolicy policy );
+virtual unsigned long capacity ( ) const;
+virtual IBoolean      isFull   ( ) const;
+virtual IAsyncNotifierGUIThread & waitForRoom ( );
+virtual unsigned long queueDepth ( ) const;
+
+/*--------------------------- Inline Dispatching -------------------------------
+| Used by IAsyncNotifier to dispatch a notification without queuing it.        |
+|   canDispatchInline - Returns true if the current thread is this thread,     |
+|                       isRunning returns true and no notifications of the     |
+|                       passed object are queued.                              |
+|-----------------------------------------------------------------------------*/
+virtual IBoolean canDispatchInline ( const IAsyncNotifier & asyncNotifier );
+
 /*-------------------------- Delete Notifications ------------------------------
-| IAsyncNotifier calls this from its destructor to have all pending            |
-| notifications deleted.                                                       |
+| IAsyncNotifier calls this from close to have all pending notifications       |
+| deleted.                                                                     |
 |   deleteNotificationsFor - Ensures that all notifications for the passed     |
 |                            object are never dispatched.  Throws an invalid   |
 |                            request exception if the current thread is not    |
@@ -85,15 +144,31 @@ virtual IAsyncNotifierGUIThread & deleteNotificationsFor (
                                     const IAsyncNotifier & asyncNotifier );
 
 
+protected:
+/*------------------------------ Local Storage ---------------------------------
+| Called by setProcessors once this thread runs on its new processors.         |
+|   localizeStorage - Refills the free storage of the queue.                   |
+|-----------------------------------------------------------------------------*/
+virtual IAsyncNotifierGUIThread & localizeStorage ( );
+
+
 private:
 // The private copy constructor and assignment operator are not implemented.
 IAsyncNotifierGUIThread ( const IAsyncNotifierGUIThread & rhs );
 IAsyncNotifierGUIThread & operator = ( const IAsyncNotifierGUIThread & rhs );
 
+friend class IAsyncNotificationHandler;
+
+IAsyncNotifierGUIThread & postWakeUp     ( );
+IAsyncNotifierGUIThread & dispatchQueued ( );
+
 /*--------------------------- Private State Data -----------------------------*/
 IObjectWindow             * objectWindow;
 IAsyncNotificationHandler * asyncNotificationHandler;
 IPrivateResource            objectWindowKey;
+IAsyncNotificationQueue   * queue;
+volatile long               wakeUpNeeded;
+unsigned long               maxBatch;
 
 }; // IAsyncNotifierGUIThread
 
@@ -0,0 +1,837 @@
+/*******************************************************************************
+* FILE NAME: iasynipc.cpp
+*
+* DESCRIPTION:
+*   Functions to implement the class(es):
+*     IAsyncNotificationChannel
+*     IAsyncRemoteNotifier
+*
+* COPYRIGHT:
+*   Licensed Materials - Property of IBM
+*   (C) Copyright IBM Corporation 1995
+*   All Rights Reserved
+*   US Government Users Restricted Rights - Use, duplication, or disclosure
+*   restricted by GSA ADP Schedule Contract with IBM Corp.
+*
+*******************************************************************************/
+#ifdef __linux__
+  #include <errno.h>
+  #include <fcntl.h>
+  #include <pthread.h>
+  #include <signal.h>
+  #include <unistd.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+#else
+  #define INCL_DOSERRORS
+  #define INCL_DOSMEMMGR
+  #define INCL_DOSSEMAPHORES
+  #include <os2.h>
+#endif
+
+#include <string.h>
+
+#include <iasynipc.hpp>
+
+#ifndef _INOTIFEV_
+  #include <inotifev.hpp>
+#endif
+
+#ifndef _ITHREAD_
+  #include <ithread.hpp>
+#endif
+
+#ifndef _IEXCEPT_
+  #include <iexcept.hpp>
+#endif
+
+#ifndef _IATOMIC_
+  #include <iatomic.hpp>
+#endif
+
+// Define the functions and static data members to be exported.
+// Ordinals 250 through 299 are reserved for use by IAsyncNotificationChannel
+// and IAsyncRemoteNotifier.
+#pragma export(IAsyncNotificationChannel::IAsyncNotificationChannel(   \
+                 const IString&,IEventSem::SemOperation,unsigned long),, 250)
+#pragma export(IAsyncNotificationChannel::~IAsyncNotificationChannel(),, 251)
+#pragma export(IAsyncNotificationChannel::send(                        \
+                 const INotificationId&,const void*,unsigned long),, 252)
+#pragma export(IAsyncNotificationChannel::receive(                     \
+                 IAsyncNotificationChannel::Message&),, 253)
+#pragma export(IAsyncNotificationChannel::waitForMessage(),, 254)
+#pragma export(IAsyncNotificationChannel::interrupt(),, 255)
+#pragma export(IAsyncNotificationChannel::name() const,, 256)
+#pragma export(IAsyncNotificationChannel::capacity() const,, 257)
+#pragma export(IAsyncNotificationChannel::length() const,, 258)
+#pragma export(IAsyncRemoteNotifier::IAsyncRemoteNotifier(             \
+                 const IString&,unsigned long),, 259)
+#pragma export(IAsyncRemoteNotifier::~IAsyncRemoteNotifier(),, 260)
+#pragma export(IAsyncRemoteNotifier::addNotificationId(                \
+                 const INotificationId&),, 261)
+#pragma export(IAsyncRemoteNotifier::unknownIdCount() const,, 262)
+#pragma export(IAsyncRemoteNotifier::channel(),, 263)
+#pragma export(IAsyncRemoteNotifier::messageOf(                        \
+                 const INotificationEvent&),, 264)
+
+// It's possible for the caller of the external entry points to have a
+// different C library environment.  Make sure the exception handler for
+// our library environment is registered on entry and deregistered on exit.
+#pragma handler(IAsyncNotificationChannel::IAsyncNotificationChannel(  \
+                  const IString&,IEventSem::SemOperation,unsigned long))
+#pragma handler(IAsyncNotificationChannel::~IAsyncNotificationChannel())
+#pragma handler(IAsyncNotificationChannel::send(                       \
+                  const INotificationId&,const void*,unsigned long))
+#pragma handler(IAsyncNotificationChannel::receive(                    \
+                  IAsyncNotificationChannel::Message&))
+#pragma handler(IAsyncNotificationChannel::waitForMessage())
+#pragma handler(IAsyncNotificationChannel::interrupt())
+#pragma handler(IAsyncNotificationChannel::name() const)
+#pragma handler(IAsyncNotificationChannel::capacity() const)
+#pragma handler(IAsyncNotificationChannel::length() const)
+#pragma handler(IAsyncRemoteNotifier::IAsyncRemoteNotifier(            \
+                  const IString&,unsigned long))
+#pragma handler(IAsyncRemoteNotifier::~IAsyncRemoteNotifier())
+#pragma handler(IAsyncRemoteNotifier::addNotificationId(               \
+                  const INotificationId&))
+#pragma handler(IAsyncRemoteNotifier::unknownIdCount() const)
+#pragma handler(IAsyncRemoteNotifier::channel())
+#pragma handler(IAsyncRemoteNotifier::messageOf(                       \
+                  const INotificationEvent&))
+
+
+//------------------------------------------------------------------------------
+// The shared memory of a channel: this header followed by the slots.  The
+// notifications are numbered as they are sent, and notification n is kept in
+// slot n % capacity.  The numbers wrap at limit, a multiple of the capacity,
+// so that number follows number through the slots.  A slot's sequence is
+// n + 1 once notification n has been copied into it.  Senders count the
+// notifications sent while they hold the send mutex.  Only the receiver
+// counts the notifications received, after it has copied one out.  The
+// waiting and interrupted flags tell senders and interrupt to post the event
+// semaphore.  Shared memory starts out zero filled, so no slot has a
+// sequence yet.  On Linux, creator is the process id of the receiver, stored
+// once the rest of the header is set, so a sender does not use the channel
+// while it is zero, and a later receiver can tell whether the name was left
+// behind by a process that ended.
+//------------------------------------------------------------------------------
+class IAsyncNotificationChannelSlot {
+public:
+  volatile long                      sequence;
+  IAsyncNotificationChannel::Message message;
+};
+
+class IAsyncNotificationChannelHeader {
+public:
+#ifdef __linux__
+  pthread_mutex_t               sendMutex;
+  volatile long                 creator;
+#endif
+  volatile long                 receiverWaiting;
+  volatile long                 interrupted;
+  unsigned long                 capacity;
+  unsigned long                 limit;
+  volatile long                 sent;
+  volatile long                 received;
+  IAsyncNotificationChannelSlot slots [ 1 ];
+};
+
+
+// A received message with data is sent to observers as this payload.
+typedef IAsyncTypedPayload<IAsyncNotificationChannel::Message>
+                                                       IAsyncRemotePayload;
+
+
+//------------------------------------------------------------------------------
+// An id added to an IAsyncRemoteNotifier.  The ids are kept in a list that
+// only grows until the notifier is deleted.
+//------------------------------------------------------------------------------
+class IAsyncRemoteId
+{
+public:
+  IAsyncRemoteId ( const INotificationId & nId,
+                   IAsyncRemoteId * nextId ) :
+                   notificationId ( nId ),
+                   next ( nextId )
+  { }
+
+  INotificationId  notificationId;
+  IAsyncRemoteId * next;
+};
+
+/*------------------------------------------------------------------------------
+| Function Name: findId
+|
+| Implementation:
+|   Return the id with the passed text or NULL if there is none.
+|-----------------------------------------------------------------------------*/
+static IAsyncRemoteId * findId ( IAsyncRemoteId * remoteId,
+                                 const char * idText )
+{
+  while ( ( remoteId != NULL ) &&
+          ( strcmp ( remoteId->notificationId, idText ) != 0 ) )
+    remoteId = remoteId->next;
+
+  return remoteId;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: sharedMemoryName
+|
+| Implementation:
+|   OS/2 names shared memory like "\SHAREMEM\CS\SIGNAL".  On Linux that
+|   becomes "/SHAREMEM.CS.SIGNAL", as IEventSem names its semaphores.
+|-----------------------------------------------------------------------------*/
+static IString sharedMemoryName ( const IString & channelName )
+{
+  IString memName ( "\\SHAREMEM\\" + channelName );
+
+#ifdef __linux__
+  char * name = (char *)memName;
+  for ( unsigned i = 0; i < memName.length(); i++ )
+    if ( ( name[i] == '\\' ) || ( name[i] == '/' ) )
+      name[i] = ( i == 0 ) ? '/' : '.';
+#endif
+
+  return memName;
+}
+
+#ifdef __linux__
+/*------------------------------------------------------------------------------
+| Function Name: isStale
+|
+| Implementation:
+|   The named shared memory is stale if the receiver that created it has
+|   ended.  One that is still being created has no process id yet, and is
+|   not stale.
+|-----------------------------------------------------------------------------*/
+static IBoolean isStale ( const IString & memName )
+{
+  IBoolean stale = false;
+  struct stat status;
+
+  int fd = shm_open ( (char *)memName, O_RDONLY, 0 );
+  if ( fd == -1 )
+    return false;
+
+  if ( ( fstat ( fd, &status ) == 0 ) &&
+       ( status.st_size >= (off_t)sizeof ( IAsyncNotificationChannelHeader ) ) )
+  {
+    void * memory = mmap ( 0, sizeof ( IAsyncNotificationChannelHeader ),
+                           PROT_READ, MAP_SHARED, fd, 0 );
+    if ( memory != MAP_FAILED )
+    {
+      long pid = IAtomic::value (
+                   ((IAsyncNotificationChannelHeader *)memory)->creator );
+      stale = ( pid != 0 ) && ( kill ( (pid_t)pid, 0 ) == -1 ) &&
+              ( errno == ESRCH );
+      munmap ( memory, sizeof ( IAsyncNotificationChannelHeader ) );
+    }
+  }
+  close ( fd );
+
+  return stale;
+}
+#else
+/*------------------------------------------------------------------------------
+| Function Name: sendMutexName
+|
+| Implementation:
+|   The send mutex semaphore can not have the name of the event semaphore,
+|   so it is named like "\SEM32\SEND\CS\SIGNAL".
+|-----------------------------------------------------------------------------*/
+static IString sendMutexName ( const IString & channelName )
+{
+  return ( "\\SEM32\\SEND\\" + channelName );
+}
+#endif
+
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationChannel :: IAsyncNotificationChannel
+|
+| Implementation:
+|   To create the channel, allocate the named shared memory, set the
+|     capacity and create the send mutex, then create the event semaphore.
+|     On Linux, if the name exists but was left behind by a receiver that
+|     ended without deleting its channel, remove it and try again; a name in
+|     use fails as on OS/2.  Store our process id last.  Senders open the
+|     event semaphore first, so they can not see the memory before it is
+|     ready.  If anything can not be created, free what was.
+|   To open the channel, open the event semaphore, then get the named
+|     shared memory and open the send mutex.  On Linux the memory may belong
+|     to a receiver that is still creating the channel after taking over a
+|     stale name, so fail unless it has its process id.  The size of the
+|     memory follows from the capacity.
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationChannel :: IAsyncNotificationChannel (
+                               const IString &         aName,
+                               IEventSem::SemOperation semOp,
+                               unsigned long           capacity ) :
+                   IBase ( ),
+                   channelName ( aName ),
+                   creator ( semOp == IEventSem::createSem ),
+                   readyEventSem ( NULL ),
+                   header ( NULL ),
+                   size ( 0 ),
+                   sendMutex ( 0 )
+{
+  IString memName ( sharedMemoryName ( channelName ) );
+
+  if ( creator )
+  {
+    IASSERTPARM ( capacity != 0 );
+    size = sizeof ( IAsyncNotificationChannelHeader ) +
+           ( capacity - 1 ) * sizeof ( IAsyncNotificationChannelSlot );
+
+#ifdef __linux__
+    int fd = shm_open ( (char *)memName, O_RDWR | O_CREAT | O_EXCL, 0600 );
+    if ( ( fd == -1 ) && ( errno == EEXIST ) && ( isStale ( memName ) ) )
+    {
+      shm_unlink ( (char *)memName );
+      fd = shm_open ( (char *)memName, O_RDWR | O_CREAT | O_EXCL, 0600 );
+    }
+    if ( fd == -1 )
+    {
+      ITHROWSYSTEMERROR ( errno, "shm_open", IErrorInfo::accessError,
+                          IException::recoverable );
+    }
+
+    void * memory = MAP_FAILED;
+    if ( ftruncate ( fd, size ) == 0 )
+      memory = mmap ( 0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+    close ( fd );
+
+    if ( memory == MAP_FAILED )
+    {
+      int rc = errno;
+      shm_unlink ( (char *)memName );
+      ITHROWSYSTEMERROR ( rc, "mmap", IErrorInfo::accessError,
+                          IException::recoverable );
+    }
+
+    header = (IAsyncNotificationChannelHeader *)memory;
+
+    pthread_mutexattr_t attributes;
+    pthread_mutexattr_init ( &attributes );
+    pthread_mutexattr_setpshared ( &attributes, PTHREAD_PROCESS_SHARED );
+    pthread_mutexattr_setrobust ( &attributes, PTHREAD_MUTEX_ROBUST );
+    int rc = pthread_mutex_init ( &header->sendMutex, &attributes );
+    pthread_mutexattr_destroy ( &attributes );
+
+    if ( rc != 0 )
+    {
+      munmap ( memory, size );
+      shm_unlink ( (char *)memName );
+      ITHROWSYSTEMERROR ( rc, "pthread_mutex_init", IErrorInfo::accessError,
+                          IException::recoverable );
+    }
+#else
+    PVOID memory = NULL;
+    APIRET rc = DosAllocSharedMem ( &memory, (PSZ)memName, size,
+                                    PAG_COMMIT | PAG_READ | PAG_WRITE );
+    if ( rc != 0 )
+    {
+      ITHROWSYSTEMERROR ( rc, "DosAllocSharedMem", IErrorInfo::accessError,
+                          IException::recoverable );
+    }
+
+    header = (IAsyncNotificationChannelHeader *)memory;
+
+    HMTX mutex = 0;
+    rc = DosCreateMutexSem ( (PSZ)sendMutexName ( channelName ), &mutex,
+                             0, FALSE );
+    if ( rc != 0 )
+    {
+      DosFreeMem ( memory );
+      ITHROWSYSTEMERROR ( rc, "DosCreateMutexSem", IErrorInfo::accessError,
+                          IException::recoverable );
+    }
+    sendMutex = mutex;
+#endif
+
+    header->capacity = capacity;
+    header->limit = capacity * ( 0x7FFFFFFFUL / capacity );
+
+    try
+    {
+      readyEventSem = new IEventSem ( channelName, IEventSem::createSem );
+    }
+    catch ( IException & exc )
+    {
+#ifdef __linux__
+      munmap ( memory, size );
+      shm_unlink ( (char *)memName );
+#else
+      DosCloseMutexSem ( sendMutex );
+      DosFreeMem ( memory );
+#endif
+      IRETHROW ( exc );
+    }
+
+#ifdef __linux__
+    IAtomic::exchange ( header->creator, (long)getpid() );
+#endif
+  }
+  else
+  {
+    readyEventSem = new IEventSem ( channelName, IEventSem::openSem );
+
+#ifdef __linux__
+    void * memory = MAP_FAILED;
+    struct stat status;
+    int fd = shm_open ( (char *)memName, O_RDWR, 0 );
+    if ( ( fd != -1 ) && ( fstat ( fd, &status ) == 0 ) )
+    {
+      size = (unsigned long)status.st_size;
+      if ( size >= sizeof ( IAsyncNotificationChannelHeader ) )
+        memory = mmap ( 0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+      else
+        errno = ENOENT;
+    }
+    int rc = errno;
+    if ( fd != -1 )
+      close ( fd );
+
+    if ( ( memory != MAP_FAILED ) &&
+         ( IAtomic::value (
+             ((IAsyncNotificationChannelHeader *)memory)->creator ) == 0 ) )
+    {
+      munmap ( memory, size );
+      memory = MAP_FAILED;
+      rc = ENOENT;
+    }
+
+    if ( memory == MAP_FAILED )
+    {
+      delete readyEventSem;
+      ITHROWSYSTEMERROR ( rc, "shm_open", IErrorInfo::accessError,
+                          IException::recoverable );
+    }
+#else
+    PVOID memory = NULL;
+    APIRET rc = DosGetNamedSharedMem ( &memory, (PSZ)memName,
+                                       PAG_READ | PAG_WRITE );
+    if ( rc != 0 )
+    {
+      delete readyEventSem;
+      ITHROWSYSTEMERROR ( rc, "DosGetNamedSharedMem",
+                          IErrorInfo::accessError, IException::recoverable );
+    }
+
+    HMTX mutex = 0;
+    rc = DosOpenMutexSem ( (PSZ)sendMutexName ( channelName ), &mutex );
+    if ( rc != 0 )
+    {
+      DosFreeMem ( memory );
+      delete readyEventSem;
+      ITHROWSYSTEMERROR ( rc, "DosOpenMutexSem", IErrorInfo::accessError,
+                          IException::recoverable );
+    }
+    sendMutex = mutex;
+#endif
+
+    header = (IAsyncNotificationChannelHeader *)memory;
+    size = sizeof ( IAsyncNotificationChannelHeader ) +
+           ( header->capacity - 1 ) * sizeof ( IAsyncNotificationChannelSlot );
+  }
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationChannel :: ~IAsyncNotificationChannel
+|
+| Implementation:
+|   Close the semaphores and free this process's view of the memory.  The
+|   creator removes the name, so no new sender can open the channel.  The
+|   Linux send mutex is not destroyed, since senders may still hold it; it
+|   goes with the memory.
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationChannel :: ~IAsyncNotificationChannel ( )
+{
+  delete readyEventSem;
+
+#ifdef __linux__
+  munmap ( (void *)header, size );
+  if ( creator )
+    shm_unlink ( (char *)sharedMemoryName ( channelName ) );
+#else
+  DosCloseMutexSem ( sendMutex );
+  DosFreeMem ( (PVOID)header );
+#endif
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationChannel :: lockForSend
+|
+| Implementation:
+|   Request the send mutex.  If its owner ended while holding it, the mutex
+|   is given to this thread anyway.  On Linux it must then be marked
+|   consistent, or no one can lock it again.  send repairs the count the
+|   owner may have left behind.
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationChannel & IAsyncNotificationChannel :: lockForSend ( )
+{
+#ifdef __linux__
+  int rc = pthread_mutex_lock ( &header->sendMutex );
+  if ( rc == EOWNERDEAD )
+    rc = pthread_mutex_consistent ( &header->sendMutex );
+  if ( rc != 0 )
+  {
+    ITHROWSYSTEMERROR ( rc, "pthread_mutex_lock", IErrorInfo::accessError,
+                        IException::recoverable );
+  }
+#else
+  APIRET rc = DosRequestMutexSem ( sendMutex, SEM_INDEFINITE_WAIT );
+  if ( ( rc != 0 ) && ( rc != ERROR_SEM_OWNER_DIED ) )
+  {
+    ITHROWSYSTEMERROR ( rc, "DosRequestMutexSem", IErrorInfo::accessError,
+                        IException::recoverable );
+  }
+#endif
+
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationChannel :: unlockForSend
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationChannel & IAsyncNotificationChannel :: unlockForSend ( )
+{
+#ifdef __linux__
+  pthread_mutex_unlock ( &header->sendMutex );
+#else
+  DosReleaseMutexSem ( sendMutex );
+#endif
+
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationChannel :: send
+|
+| Implementation:
+|   Under the send mutex, first count a notification that a sender which
+|     ended holding the mutex had copied but not counted: its slot already
+|     has the next sequence.  Then, unless capacity notifications are
+|     waiting to be received, copy the notification into the next slot,
+|     set its sequence and count it sent.  Setting the sequence is an
+|     interlocked operation, so the receiver sees the copy once it sees the
+|     sequence.
+|   If the receiver may be waiting, post the event semaphore.  Clearing
+|     the waiting flag makes sure only one sender posts for each wait.
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationChannel & IAsyncNotificationChannel :: send (
+                                        const INotificationId & nId,
+                                        const void *            data,
+                                        unsigned long           length )
+{
+  IASSERTPARM ( strlen ( nId ) <= maxIdLength );
+  IASSERTPARM ( ( length <= maxDataLength ) &&
+                ( ( length == 0 ) || ( data != 0 ) ) );
+
+  lockForSend();
+
+  unsigned long capacity = header->capacity;
+  unsigned long limit = header->limit;
+  unsigned long sent = (unsigned long)header->sent;
+  if ( (unsigned long)IAtomic::value (
+                     header->slots[sent % capacity].sequence ) == sent + 1 )
+  {
+    sent = ( sent + 1 ) % limit;
+    IAtomic::exchange ( header->sent, (long)sent );
+  }
+
+  unsigned long received = (unsigned long)IAtomic::value ( header->received );
+  if ( ( sent + limit - received ) % limit >= capacity )
+  {
+    unlockForSend();
+
+    IResourceExhausted exc ( "The notification channel is full.",
+                             0, IException::recoverable );
+    ITHROW ( exc );
+  }
+
+  IAsyncNotificationChannelSlot & slot = header->slots[sent % capacity];
+  strcpy ( slot.message.id, nId );
+  slot.message.length = (Length)length;
+  if ( length != 0 )
+    memcpy ( slot.message.data.bytes, data, length );
+
+  IAtomic::exchange ( slot.sequence, (long)( sent + 1 ) );
+  IAtomic::exchange ( header->sent, (long)( ( sent + 1 ) % limit ) );
+
+  unlockForSend();
+
+  if ( IAtomic::exchange ( header->receiverWaiting, 0 ) != 0 )
+    readyEventSem->post();
+
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: isReady
+|
+| Implementation:
+|   The next notification to receive is in its slot once the slot has its
+|   sequence.
+|-----------------------------------------------------------------------------*/
+static IBoolean isReady ( IAsyncNotificationChannelHeader * header )
+{
+  unsigned long received = (unsigned long)header->received;
+  IAsyncNotificationChannelSlot & slot =
+                                header->slots[received % header->capacity];
+
+  return ( (unsigned long)IAtomic::value ( slot.sequence ) == received + 1 );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationChannel :: receive
+|
+| Implementation:
+|   If the next notification is in its slot, copy it out, then count it
+|   received, which frees the slot for senders.
+|-----------------------------------------------------------------------------*/
+IBoolean IAsyncNotificationChannel :: receive ( Message & message )
+{
+  if ( ! isReady ( header ) )
+    return false;
+
+  unsigned long received = (unsigned long)header->received;
+  message = header->slots[received % header->capacity].message;
+
+  IAtomic::exchange ( header->received,
+                      (long)( ( received + 1 ) % header->limit ) );
+
+  return true;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationChannel :: waitForMessage
+|
+| Implementation:
+|   Reset the event semaphore and set the waiting flag, then look for the
+|   next notification again: a sender that copied it before seeing the flag
+|   will not post.  Wait only if it is still not there and the channel was
+|   not interrupted.  An interrupt after the reset leaves the semaphore
+|   posted, so the wait returns.
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationChannel & IAsyncNotificationChannel :: waitForMessage ( )
+{
+  readyEventSem->reset();
+  IAtomic::exchange ( header->receiverWaiting, 1 );
+
+  if ( ( ! isReady ( header ) ) &&
+       ( IAtomic::exchange ( header->interrupted, 0 ) == 0 ) )
+    readyEventSem->wait();
+
+  IAtomic::exchange ( header->receiverWaiting, 0 );
+
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationChannel :: interrupt
+|
+| Implementation:
+|   Set the interrupted flag for a receiver that has not reset the event
+|   semaphore yet, and post it for one that has.
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationChannel & IAsyncNotificationChannel :: interrupt ( )
+{
+  IAtomic::exchange ( header->interrupted, 1 );
+  readyEventSem->post();
+
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationChannel :: name
+|-----------------------------------------------------------------------------*/
+const IString & IAsyncNotificationChannel :: name ( ) const
+{
+  return channelName;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationChannel :: capacity
+|-----------------------------------------------------------------------------*/
+unsigned long IAsyncNotificationChannel :: capacity ( ) const
+{
+  return header->capacity;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationChannel :: length
+|
+| Implementation:
+|   The notifications sent and not yet received.  Senders and the receiver
+|   may count more meanwhile, so the result is only a snapshot.
+|-----------------------------------------------------------------------------*/
+unsigned long IAsyncNotificationChannel :: length ( ) const
+{
+  unsigned long limit = header->limit;
+  unsigned long sent = (unsigned long)IAtomic::value ( header->sent );
+  unsigned long received = (unsigned long)IAtomic::value ( header->received );
+
+  return ( ( sent + limit - received ) % limit );
+}
+
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncRemoteNotifier :: IAsyncRemoteNotifier
+|
+| Implementation:
+|   Create the channel, then start the thread that receives from it.
+|-----------------------------------------------------------------------------*/
+IAsyncRemoteNotifier :: IAsyncRemoteNotifier ( const IString & channelName,
+                                               unsigned long   capacity ) :
+                   IAsyncNotifier ( ),
+                   theChannel ( channelName, IEventSem::createSem, capacity ),
+                   receiver ( NULL ),
+                   ids ( NULL ),
+                   idsKey ( ),
+                   unknownIds ( 0 ),
+                   stopping ( 0 ),
+                   stoppedEventSem ( )
+{
+  receiver = new IThread ( new IThreadMemberFn<IAsyncRemoteNotifier> (
+                            *this, &IAsyncRemoteNotifier::receiveMessages ),
+                           false );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncRemoteNotifier :: ~IAsyncRemoteNotifier
+|
+| Implementation:
+|   Tell the receiving thread to stop, interrupt its wait and wait until it
+|   has stopped, so it can not notify while this object is destroyed.
+|   Close the base class before anything an observer may use is destroyed:
+|   messageOf reads the channel.  Then delete the thread object and the ids.
+|-----------------------------------------------------------------------------*/
+IAsyncRemoteNotifier :: ~IAsyncRemoteNotifier ( )
+{
+  IAtomic::exchange ( stopping, 1 );
+  theChannel.interrupt();
+  stoppedEventSem.wait();
+
+  close();
+
+  delete receiver;
+
+  while ( ids != NULL )
+  {
+    IAsyncRemoteId * nextId = ids->next;
+    delete ids;
+    ids = nextId;
+  }
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncRemoteNotifier :: addNotificationId
+|
+| Implementation:
+|   Add the id to the front of the list, unless its text is there already.
+|-----------------------------------------------------------------------------*/
+IAsyncRemoteNotifier & IAsyncRemoteNotifier :: addNotificationId (
+                                                const INotificationId & nId )
+{
+  IASSERTPARM ( strlen ( nId ) <= IAsyncNotificationChannel::maxIdLength );
+
+  IResourceLock idsLock ( idsKey );
+
+  if ( findId ( ids, nId ) == NULL )
+    ids = new IAsyncRemoteId ( nId, ids );
+
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncRemoteNotifier :: unknownIdCount
+|-----------------------------------------------------------------------------*/
+unsigned long IAsyncRemoteNotifier :: unknownIdCount ( ) const
+{
+  return ( (unsigned long)IAtomic::value ( unknownIds ) );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncRemoteNotifier :: channel
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationChannel & IAsyncRemoteNotifier :: channel ( )
+{
+  return theChannel;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncRemoteNotifier :: messageOf
+|
+| Implementation:
+|   The received message was sent as the payload of the notification.
+|-----------------------------------------------------------------------------*/
+const IAsyncNotificationChannel::Message & IAsyncRemoteNotifier :: messageOf (
+                                          const INotificationEvent & anEvent )
+{
+  return ( IAsyncRemotePayload::valueOf ( anEvent ) );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncRemoteNotifier :: receiveMessages
+|
+| Implementation:
+|   Runs on the receiving thread.  Until told to stop, receive each message
+|   and notify with the added id of the same text, with the message as the
+|   payload if it has data.  Count the message if its id was not added.
+|   Wait when the channel is empty.  If the dispatch queue is full and
+|   throws, the notification is lost, as it would be for any sender.
+|   Any other exception ends the thread and is rethrown, so the thread
+|   reports it.  Either way, post the stopped semaphore as the very last
+|   use of the object, or the destructor would wait forever.
+|-----------------------------------------------------------------------------*/
+void IAsyncRemoteNotifier :: receiveMessages ( )
+{
+  IAsyncNotificationChannel::Message message;
+
+  try
+  {
+    while ( IAtomic::value ( stopping ) == 0 )
+    {
+      if ( ! ( theChannel.receive ( message ) ) )
+      {
+        theChannel.waitForMessage();
+        continue;
+      }
+
+      IAsyncRemoteId * remoteId = NULL;
+      {
+        IResourceLock idsLock ( idsKey );
+        remoteId = findId ( ids, message.id );
+      }
+
+      if ( remoteId == NULL )
+      {
+        IAtomic::increment ( unknownIds );
+        continue;
+      }
+
+      try
+      {
+        if ( message.length == 0 )
+          notifyObservers ( remoteId->notificationId );
+        else
+          notifyObservers ( remoteId->notificationId,
+                            IAsyncRemotePayload ( message ) );
+      }
+      catch ( IResourceExhausted & )
+      {
+        // The dispatch queue is full.
+      }
+    }
+  }
+  catch ( ... )
+  {
+    stoppedEventSem.post();
+    throw;
+  }
+
+  stoppedEventSem.post();
+}
+
\ No newline at end of file
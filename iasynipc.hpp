@@ -0,0 +1,251 @@
+#ifndef _IASYNIPC_
+#define _IASYNIPC_
+/*******************************************************************************
+* FILE NAME: iasynipc.hpp
+*
+* DESCRIPTION:
+*   Declaration of the class(es):
+*     IAsyncNotificationChannel - A queue of notifications in shared memory
+*                                 that carries them from one process to
+*                                 another.
+*     IAsyncRemoteNotifier      - An asynchronous notifier that sends the
+*                                 notifications received from other
+*                                 processes over a channel.
+*
+* COPYRIGHT:
+*   Licensed Materials - Property of IBM
+*   (C) Copyright IBM Corporation 1995
+*   All Rights Reserved
+*   US Government Users Restricted Rights - Use, duplication, or disclosure
+*   restricted by GSA ADP Schedule Contract with IBM Corp.
+*
+*******************************************************************************/
+#ifndef _IASYNTFY_
+  #include <iasyntfy.hpp>
+#endif
+
+// Other dependency classes.
+#ifndef _IEVNTSEM_
+  #include <ievntsem.hpp>
+#endif
+
+#ifndef _ISTRING_
+  #include <istring.hpp>
+#endif
+
+class IAsyncNotificationChannelHeader;
+class IAsyncRemoteId;
+class IThread;
+
+// Align classes on four byte boundary, except on Linux (see iatomic.hpp).
+#ifndef __linux__
+  #pragma pack(4)
+#endif
+
+class IAsyncNotificationChannel : public IBase {
+/*******************************************************************************
+*
+* This class implements a fixed size queue of notifications kept in named
+* shared memory, so that any number of processes can send notifications to
+* the one process that receives them.  A named IEventSem with the same name
+* wakes the receiving thread when a notification is sent while it waits, so
+* neither process has to poll the other.
+*
+* Since the processes do not share addresses, a notification is sent as the
+* text of its id, with up to maxDataLength bytes of data copied into the
+* queue.  Only data that can be copied byte for byte, with no pointers in
+* it, can be sent.
+*
+* The receiving process creates the channel.  The sending processes open it
+* by name afterwards.  Senders take turns through a mutex semaphore, held
+* only while one notification is copied into the queue.  The system gives
+* it to the next sender if its owner ends while holding it, and a
+* notification that sender had finished copying is not lost.  On Linux the
+* semaphore is a robust pthread mutex in the shared memory, so the sending
+* and receiving processes of a channel must use the same pthread library
+* (all 32 or all 64 bit).  Only one thread may receive.
+*
+* Most applications receive with IAsyncRemoteNotifier rather than using
+* this class directly.
+*
+*******************************************************************************/
+
+public:
+/*--------------------------------- Messages -----------------------------------
+| The form in which a notification is kept in the queue.                       |
+|   maxIdLength   - The longest notification id text that can be sent.         |
+|   maxDataLength - The most bytes of data that can be sent.                   |
+|   Length        - An unsigned number 32 bits wide in every process, so the   |
+|                   layout of a message does not depend on the size of long.   |
+|   Message       - A notification as it was sent: the text of its id, and     |
+|                   length bytes of data.  The reserved field puts the data at |
+|                   the same offset whatever the packing.                      |
+|-----------------------------------------------------------------------------*/
+enum { maxIdLength = 63, maxDataLength = 64 };
+
+typedef unsigned int Length;
+
+class Message {
+public:
+  char          id [ maxIdLength + 1 ];
+  Length        length;
+  Length        reserved;
+  union {
+    double      alignment;
+    char        bytes [ maxDataLength ];
+  } data;
+};
+
+/*------------------------------ Constructors ----------------------------------
+| You can construct an object of this class as follows:                        |
+|   - With the name of the channel and IEventSem::createSem, to create the     |
+|     channel for this process to receive on.  The capacity is the number of   |
+|     notifications the queue holds.  The name is removed when this object     |
+|     is destroyed.                                                            |
+|   - With the name of the channel and IEventSem::openSem, to open a channel   |
+|     created by another process, to send on.  The capacity is ignored.        |
+| An access error exception is thrown if the channel can not be created or     |
+| opened.                                                                      |
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationChannel (
+                    const IString &         channelName,
+                    IEventSem::SemOperation semOp = IEventSem::createSem,
+                    unsigned long           capacity = 256 );
+
+virtual ~IAsyncNotificationChannel ( );
+
+/*--------------------------------- Sending ------------------------------------
+| This function may be called on any thread of any process that has opened or  |
+| created the channel.                                                         |
+|   send - Copies the notification id text and the data into the queue and     |
+|          wakes the receiving thread if it is waiting.  An invalid parameter  |
+|          exception is thrown if the id or the data are too long.  A          |
+|          recoverable resource exhausted exception is thrown if the queue is  |
+|          full.                                                               |
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationChannel & send ( const INotificationId & nId,
+                                   const void *            data = 0,
+                                   unsigned long           length = 0 );
+
+/*-------------------------------- Receiving -----------------------------------
+| These functions may only be called on one thread, the receiving thread.      |
+|   receive        - Copies the oldest notification in the queue into the      |
+|                    message and removes it.  Returns false if the queue is    |
+|                    empty.                                                    |
+|   waitForMessage - Waits until there is a notification in the queue or the   |
+|                    channel is interrupted.  Returns at once if there is one. |
+|   interrupt      - Makes the next or current waitForMessage return, whether  |
+|                    or not there is a notification.  This function may be     |
+|                    called on any thread.                                     |
+|-----------------------------------------------------------------------------*/
+IBoolean                    receive        ( Message & message );
+IAsyncNotificationChannel & waitForMessage ( );
+IAsyncNotificationChannel & interrupt      ( );
+
+/*-------------------------------- Accessors -----------------------------------
+|   name     - Returns the name of the channel.                                |
+|   capacity - Returns the number of notifications the queue holds.            |
+|   length   - Returns the number of notifications in the queue.               |
+|-----------------------------------------------------------------------------*/
+const IString & name     ( ) const;
+unsigned long   capacity ( ) const;
+unsigned long   length   ( ) const;
+
+
+private:
+// The private copy constructor and assignment operator are not implemented.
+IAsyncNotificationChannel ( const IAsyncNotificationChannel & rhs );
+IAsyncNotificationChannel & operator = (
+                              const IAsyncNotificationChannel & rhs );
+
+IAsyncNotificationChannel & lockForSend   ( );
+IAsyncNotificationChannel & unlockForSend ( );
+
+/*--------------------------- Private State Data -----------------------------*/
+IString                           channelName;
+IBoolean                          creator;
+IEventSem *                       readyEventSem;
+IAsyncNotificationChannelHeader * header;
+unsigned long                     size;
+unsigned long                     sendMutex;
+
+}; // IAsyncNotificationChannel
+
+
+class IAsyncRemoteNotifier : public IAsyncNotifier {
+/*******************************************************************************
+*
+* This class creates an IAsyncNotificationChannel and starts a thread that
+* receives from it.  Each notification received is sent to the observers of
+* this object as a notification of its own, dispatched on the thread that
+* created it like any other asynchronous notification.  Other processes
+* open the channel by name and send on it.
+*
+* A notification id in another process is a different pointer, so the ids
+* this object sends must be added to it with addNotificationId.  The text of
+* a received id is matched against the text of the added ids.  Notifications
+* whose id was not added are thrown away and counted.
+*
+* Observers get the data sent with a notification with messageOf.  A
+* notification sent without data has no event data.
+*
+*******************************************************************************/
+
+public:
+/*------------------------------ Constructors ----------------------------------
+| You can construct an object of this class as follows:                        |
+|   - With the name of the channel to create and the number of notifications   |
+|     it holds.  The dispatch thread is the current thread.                    |
+| The destructor stops the receiving thread before anything else, then closes  |
+| the base class before the channel its observers read is destroyed.           |
+|-----------------------------------------------------------------------------*/
+IAsyncRemoteNotifier ( const IString & channelName,
+                       unsigned long   capacity = 256 );
+
+virtual ~IAsyncRemoteNotifier ( );
+
+/*------------------------------- Notification Ids -----------------------------
+| These functions may be called on any thread.                                 |
+|   addNotificationId - Adds an id to be sent when a notification with the     |
+|                       same text is received.                                 |
+|   unknownIdCount    - Returns the number of notifications received whose id  |
+|                       was not added.                                         |
+|-----------------------------------------------------------------------------*/
+IAsyncRemoteNotifier & addNotificationId ( const INotificationId & nId );
+unsigned long          unknownIdCount    ( ) const;
+
+/*-------------------------------- Accessors -----------------------------------
+|   channel   - Returns the channel this object receives on.                   |
+|   messageOf - Returns the notification received from the channel, with its   |
+|               data, for an event of this object that has event data.  It     |
+|               must only be used until the observer returns.                  |
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationChannel & channel ( );
+
+static const IAsyncNotificationChannel::Message & messageOf (
+                                          const INotificationEvent & anEvent );
+
+
+private:
+// The private copy constructor and assignment operator are not implemented.
+IAsyncRemoteNotifier ( const IAsyncRemoteNotifier & rhs );
+IAsyncRemoteNotifier & operator = ( const IAsyncRemoteNotifier & rhs );
+
+void receiveMessages ( );
+
+/*--------------------------- Private State Data -----------------------------*/
+IAsyncNotificationChannel theChannel;
+IThread *                 receiver;
+IAsyncRemoteId *          ids;
+IPrivateResource          idsKey;
+volatile long             unknownIds;
+volatile long             stopping;
+IEventSem                 stoppedEventSem;
+
+}; // IAsyncRemoteNotifier
+
+// Resume compiler default packing.
+#pragma pack()
+
+#endif // _IASYNIPC_
+
\ No newline at end of file
@@ -0,0 +1,278 @@
+/*******************************************************************************
+* FILE NAME: iasynmem.cpp
+*
+* DESCRIPTION:
+*   Functions to implement the class(es):
+*     IAsyncNotificationPool
+*
+* COPYRIGHT:
+*   Licensed Materials - Property of IBM
+*   (C) Copyright IBM Corporation 1995
+*   All Rights Reserved
+*   US Government Users Restricted Rights - Use, duplication, or disclosure
+*   restricted by GSA ADP Schedule Contract with IBM Corp.
+*
+*******************************************************************************/
+#include <string.h>
+
+#include <iasynmem.hpp>
+
+#ifndef _IATOMIC_
+  #include <iatomic.hpp>
+#endif
+
+// The dispatch thread adds released blocks to the free chain this many at a
+// time.
+static const unsigned long releaseBatch = 16;
+
+// A thread that finds the free chain taken looks for it this many times
+// before it goes to the heap.  Whoever took it only splits off a block or
+// joins a few, so it is usually back within a few looks.
+static const unsigned long takeAttempts = 64;
+
+//------------------------------------------------------------------------------
+// Only the first block of a chain has valid last and count fields.  Whoever
+// holds a chain owns all of its blocks, so they are updated without a guard.
+//------------------------------------------------------------------------------
+
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationPool :: IAsyncNotificationPool
+|
+| Implementation:
+|   Blocks hold the free chain links while they are free, so they are at
+|   least that big.
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationPool :: IAsyncNotificationPool ( unsigned long blockSize,
+                                                   unsigned long maximumFree ) :
+                   IBase ( ),
+                   size ( blockSize ),
+                   maxFree ( maximumFree ),
+                   freeBlocks ( 0 ),
+                   released ( 0 ),
+                   releasedCount ( 0 )
+{
+  if ( size < sizeof ( Block ) )
+    size = sizeof ( Block );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationPool :: ~IAsyncNotificationPool
+|
+| Implementation:
+|   Give the free and released blocks back to the heap.  Blocks that are
+|   still in use came from the heap one at a time, so they are unaffected.
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationPool :: ~IAsyncNotificationPool ( )
+{
+  Block * lists[2];
+  lists[0] = freeBlocks;
+  lists[1] = released;
+
+  for ( int i = 0; i < 2; i++ )
+  {
+    Block * block = lists[i];
+    while ( block != 0 )
+    {
+      Block * nextBlock = block->next;
+      ::operator delete ( block );
+      block = nextBlock;
+    }
+  }
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationPool :: allocate
+|
+| Implementation:
+|   Take the free chain.  Another thread may hold it for a moment, so look
+|   for it again a few times, reading it before each exchange so that the
+|   looking does not lock the bus.  If there was none, get a block from the
+|   heap.  Otherwise keep its first block and give the rest back.
+|-----------------------------------------------------------------------------*/
+void * IAsyncNotificationPool :: allocate ( )
+{
+  Block * block = 0;
+
+  for ( unsigned long i = 0; ( block == 0 ) && ( i < takeAttempts ); i++ )
+  {
+    if ( freeBlocks != 0 )
+      block = takeChain();
+  }
+
+  if ( block == 0 )
+    return ( ::operator new ( size ) );
+
+  Block * rest = block->next;
+  if ( rest != 0 )
+  {
+    rest->last = block->last;
+    rest->count = block->count - 1;
+    giveBack ( rest );
+  }
+
+  return block;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationPool :: release
+|
+| Implementation:
+|   Collect the block on the released list, which only this thread uses.
+|   Once there are enough, add them to the free chain.
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationPool & IAsyncNotificationPool :: release ( void * block )
+{
+  Block * releasedBlock = (Block *)block;
+  releasedBlock->next = released;
+  released = releasedBlock;
+  releasedCount++;
+
+  if ( releasedCount >= releaseBatch )
+    addReleased();
+
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationPool :: discard
+|
+| Implementation:
+|   Every block came from the heap, and the released list belongs to the
+|   dispatch thread, so give the block straight back to the heap.
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationPool & IAsyncNotificationPool :: discard ( void * block )
+{
+  ::operator delete ( block );
+
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationPool :: refill
+|
+| Implementation:
+|   Get and clear the new blocks.  Take the free chain and give the new
+|   blocks back in its place, then give the old free blocks and the
+|   released ones back to the heap.  Blocks that other threads give back
+|   meanwhile are kept with the new ones.
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationPool & IAsyncNotificationPool :: refill ( unsigned long count )
+{
+  if ( count > maxFree )
+    count = maxFree;
+
+  Block * newBlocks = 0;
+  for ( unsigned long i = 0; i < count; i++ )
+  {
+    Block * block = (Block *)::operator new ( size );
+    memset ( block, 0, size );
+    block->next = newBlocks;
+    block->last = ( newBlocks != 0 ) ? newBlocks->last : block;
+    block->count = i + 1;
+    newBlocks = block;
+  }
+
+  Block * oldBlocks = takeChain();
+  giveBack ( newBlocks );
+
+  Block * lists[2];
+  lists[0] = oldBlocks;
+  lists[1] = released;
+
+  for ( int j = 0; j < 2; j++ )
+  {
+    Block * block = lists[j];
+    while ( block != 0 )
+    {
+      Block * nextBlock = block->next;
+      ::operator delete ( block );
+      block = nextBlock;
+    }
+  }
+  released = 0;
+  releasedCount = 0;
+
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationPool :: addReleased
+|
+| Implementation:
+|   Take the free chain and add released blocks to its front until it has
+|   the maximum number, then give it back.
+|   Give any that are left back to the heap.
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationPool & IAsyncNotificationPool :: addReleased ( )
+{
+  Block * chain = takeChain();
+
+  while ( ( released != 0 ) &&
+          ( ( chain == 0 ) || ( chain->count < maxFree ) ) )
+  {
+    Block * block = released;
+    released = block->next;
+    block->next = chain;
+    block->last = ( chain != 0 ) ? chain->last : block;
+    block->count = ( chain != 0 ) ? chain->count + 1 : 1;
+    chain = block;
+  }
+
+  giveBack ( chain );
+
+  while ( released != 0 )
+  {
+    Block * block = released;
+    released = block->next;
+    ::operator delete ( block );
+  }
+  releasedCount = 0;
+
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationPool :: takeChain
+|
+| Implementation:
+|   Exchange the free chain for an empty one.  The caller then owns it.
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationPool::Block * IAsyncNotificationPool :: takeChain ( )
+{
+  return ( (Block *)IAtomic::exchange (
+                       *(void * volatile *)(&freeBlocks), 0 ) );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationPool :: giveBack
+|
+| Implementation:
+|   Exchange the chain into the free chain.  If another thread gave a chain
+|   back meanwhile, it was displaced and is now ours, so take whatever is
+|   free again, join the two and try once more.  Every exchange moves a
+|   whole chain from one owner to another, so no block is ever held twice.
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationPool & IAsyncNotificationPool :: giveBack ( Block * chain )
+{
+  while ( chain != 0 )
+  {
+    Block * displaced = (Block *)IAtomic::exchange (
+                                   *(void * volatile *)(&freeBlocks), chain );
+    if ( displaced == 0 )
+      break;
+
+    chain = takeChain();
+    if ( chain == 0 )
+      chain = displaced;
+    else
+    {
+      chain->last->next = displaced;
+      chain->last = displaced->last;
+      chain->count += displaced->count;
+    }
+  }
+
+  return *this;
+}
+
\ No newline at end of file
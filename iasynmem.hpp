@@ -0,0 +1,113 @@
+/* NOSHIP */
+#ifndef _IASYNMEM_
+#define _IASYNMEM_
+/*******************************************************************************
+* FILE NAME: iasynmem.hpp
+*
+* DESCRIPTION:
+*   Declaration of the class(es):
+*     IAsyncNotificationPool - Recycled storage for queued notifications.
+*
+* COPYRIGHT:
+*   Licensed Materials - Property of IBM
+*   (C) Copyright IBM Corporation 1995
+*   All Rights Reserved
+*   US Government Users Restricted Rights - Use, duplication, or disclosure
+*   restricted by GSA ADP Schedule Contract with IBM Corp.
+*
+*******************************************************************************/
+#ifndef _IBASE_
+  #include <ibase.hpp>
+#endif
+
+// Align classes on four byte boundary, except on Linux (see iatomic.hpp).
+#ifndef __linux__
+  #pragma pack(4)
+#endif
+
+class IAsyncNotificationPool : public IBase {
+/*******************************************************************************
+*
+* This class keeps blocks of storage of one size for the notifications queued
+* to one dispatch thread.  Any thread may allocate a block to queue a
+* notification.  Only the dispatch thread releases blocks, once it is done
+* with the notification.  Released blocks are kept and handed out again, so
+* once the pool has as many blocks as are usually queued, queuing and
+* dispatching a notification does not use the heap.
+*
+* The free blocks are kept as one chain.  A thread takes the whole chain with
+* an exchange, removes what it needs and gives the rest back the same way, so
+* no thread ever blocks on another one.  A thread that finds the chain taken
+* looks for it again a few times, then gets its block from the heap instead.
+* The dispatch thread collects released blocks and adds them to the chain a
+* few at a time.
+*
+* A dispatch thread that has been moved to other processors can refill the
+* pool, so that the free blocks are ones it touched first.  Systems that place
+* memory on the node of the processor that first touches it then keep the
+* queued notifications local to the dispatch thread.
+*
+*******************************************************************************/
+
+public:
+/*------------------------------ Constructors ----------------------------------
+| You can construct an object of this class as follows:                        |
+|   - With the size of the blocks and the maximum number of free blocks to     |
+|     keep.  Blocks released when that many are free go back to the heap.      |
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationPool ( unsigned long blockSize,
+                         unsigned long maximumFree = 1024 );
+
+~IAsyncNotificationPool ( );
+
+/*--------------------------------- Blocks -------------------------------------
+| Use these functions to get and give back storage.                            |
+|   allocate - Returns a free block, or a new one from the heap if there is    |
+|              none.  It can be called from any thread.                        |
+|   release  - Gives a block back to the pool.  It must only be called on the  |
+|              dispatch thread.                                                |
+|   discard  - Gives a block that was never used back to the heap.  It can be  |
+|              called from any thread, for a block whose notification could    |
+|              not be queued.                                                  |
+|   refill   - Gives the free blocks back to the heap and replaces them with   |
+|              the passed number of new ones, up to the maximum number of      |
+|              free blocks.  The new blocks are cleared, so this thread        |
+|              touches them first.  It must only be called on the dispatch     |
+|              thread.  Blocks in use are kept when they are released.         |
+|-----------------------------------------------------------------------------*/
+void *                   allocate ( );
+IAsyncNotificationPool & release  ( void * block );
+IAsyncNotificationPool & discard  ( void * block );
+IAsyncNotificationPool & refill   ( unsigned long count );
+
+
+private:
+// The private copy constructor and assignment operator are not implemented.
+IAsyncNotificationPool ( const IAsyncNotificationPool & rhs );
+IAsyncNotificationPool & operator = ( const IAsyncNotificationPool & rhs );
+
+class Block {
+public:
+  Block *       next;
+  Block *       last;
+  unsigned long count;
+};
+
+IAsyncNotificationPool & addReleased ( );
+IAsyncNotificationPool & giveBack    ( Block * chain );
+Block *                  takeChain   ( );
+
+/*--------------------------- Private State Data -----------------------------*/
+unsigned long   size;
+unsigned long   maxFree;
+Block * volatile freeBlocks;
+Block *         released;
+unsigned long   releasedCount;
+
+}; // IAsyncNotificationPool
+
+// Resume compiler default packing.
+#pragma pack()
+
+#endif // _IASYNMEM_
+
\ No newline at end of file
@@ -0,0 +1,738 @@
+/*******************************************************************************
+* FILE NAME: iasynmtr.cpp
+*
+* DESCRIPTION:
+*   Functions to implement the class(es):
+*     IAsyncNotificationMetrics
+*
+* COPYRIGHT:
+*   Licensed Materials - Property of IBM
+*   (C) Copyright IBM Corporation 1995
+*   All Rights Reserved
+*   US Government Users Restricted Rights - Use, duplication, or disclosure
+*   restricted by GSA ADP Schedule Contract with IBM Corp.
+*
+*******************************************************************************/
+#include <iasynmtr.hpp>
+
+#ifndef _IEXCEPT_
+  #include <iexcept.hpp>
+#endif
+
+#ifndef _IATOMIC_
+  #include <iatomic.hpp>
+#endif
+
+#include <math.h>
+
+#ifdef __linux__
+  #include <time.h>
+#else
+  #define INCL_DOSPROFILE
+  #include <os2.h>
+#endif
+
+unsigned long const IAsyncNotificationMetrics::numberOfLatencyBuckets = 24;
+
+// The id table starts with this many slots and doubles when it is three
+// quarters full.  A slot holds the number of an id plus one, or zero.
+static const unsigned long initialIdSlots = 16;
+
+
+//------------------------------------------------------------------------------
+// The counts and times for one notification id.
+//------------------------------------------------------------------------------
+class IAsyncNotificationIdMetrics
+{
+public:
+  INotificationId id;
+  unsigned long   count;
+  double          time;
+  unsigned long   maxTime;
+};
+
+
+/*------------------------------------------------------------------------------
+| Function Name: hashId
+|
+| Implementation:
+|   Notification ids are the addresses of static strings, so mix the bits of
+|   the address and keep as many as the table has slots for.
+|-----------------------------------------------------------------------------*/
+static unsigned long hashId ( INotificationId anId, unsigned long slots )
+{
+  unsigned long hash = (unsigned long)anId;
+  hash = ( hash >> 3 ) * 2654435761UL;
+  return ( ( hash >> 8 ) & ( slots - 1 ) );
+}
+
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationMetrics :: IAsyncNotificationMetrics
+|
+| Implementation:
+|   Everything starts at zero.  The id table is allocated with the first id.
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationMetrics :: IAsyncNotificationMetrics ( ) :
+                   IBase ( ),
+                   guard ( 0 ),
+                   depthNow ( 0 ),
+                   depthMax ( 0 ),
+                   dispatched ( 0 ),
+                   coalescedTotal ( 0 ),
+                   droppedTotal ( 0 ),
+                   overflowTotal ( 0 ),
+                   spinWins ( 0 ),
+                   blocks ( 0 ),
+                   latencies ( new unsigned long [numberOfLatencyBuckets] ),
+                   latencyMax ( 0 ),
+                   ids ( 0 ),
+                   idsUsed ( 0 ),
+                   idSlots ( 0 ),
+                   idSlotCount ( 0 )
+{
+  for ( unsigned long i = 0; i < numberOfLatencyBuckets; i++ )
+    latencies[i] = 0;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationMetrics :: IAsyncNotificationMetrics
+|
+| Implementation:
+|   Start empty and add the parameter, which holds its guard while we read.
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationMetrics :: IAsyncNotificationMetrics (
+                               const IAsyncNotificationMetrics & metrics ) :
+                   IBase ( ),
+                   guard ( 0 ),
+                   depthNow ( 0 ),
+                   depthMax ( 0 ),
+                   dispatched ( 0 ),
+                   coalescedTotal ( 0 ),
+                   droppedTotal ( 0 ),
+                   overflowTotal ( 0 ),
+                   spinWins ( 0 ),
+                   blocks ( 0 ),
+                   latencies ( new unsigned long [numberOfLatencyBuckets] ),
+                   latencyMax ( 0 ),
+                   ids ( 0 ),
+                   idsUsed ( 0 ),
+                   idSlots ( 0 ),
+                   idSlotCount ( 0 )
+{
+  for ( unsigned long i = 0; i < numberOfLatencyBuckets; i++ )
+    latencies[i] = 0;
+
+  add ( metrics );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationMetrics :: operator =
+|
+| Implementation:
+|   Clear this object, then add the right hand side.
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationMetrics & IAsyncNotificationMetrics :: operator = (
+                                     const IAsyncNotificationMetrics & rhs )
+{
+  if ( &rhs != this )
+  {
+    clear();
+    add ( rhs );
+  }
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationMetrics :: ~IAsyncNotificationMetrics
+|
+| Implementation:
+|   Delete the histogram and the id table.
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationMetrics :: ~IAsyncNotificationMetrics ( )
+{
+  delete [] latencies;
+  delete [] ids;
+  delete [] idSlots;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationMetrics :: queueDepth
+|
+| Implementation:
+|   Return the depth set by setCounts.
+|-----------------------------------------------------------------------------*/
+unsigned long IAsyncNotificationMetrics :: queueDepth ( ) const
+{
+  return depthNow;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationMetrics :: maxQueueDepth
+|
+| Implementation:
+|   Return the deepest queue seen by recordDispatch.
+|-----------------------------------------------------------------------------*/
+unsigned long IAsyncNotificationMetrics :: maxQueueDepth ( ) const
+{
+  return depthMax;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationMetrics :: dispatchedCount
+|
+| Implementation:
+|   Return the number of calls to recordDispatch.
+|-----------------------------------------------------------------------------*/
+unsigned long IAsyncNotificationMetrics :: dispatchedCount ( ) const
+{
+  return dispatched;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationMetrics :: coalescedCount
+|
+| Implementation:
+|   Return the count set by setCounts.
+|-----------------------------------------------------------------------------*/
+unsigned long IAsyncNotificationMetrics :: coalescedCount ( ) const
+{
+  return coalescedTotal;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationMetrics :: droppedCount
+|
+| Implementation:
+|   Return the count set by setCounts.
+|-----------------------------------------------------------------------------*/
+unsigned long IAsyncNotificationMetrics :: droppedCount ( ) const
+{
+  return droppedTotal;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationMetrics :: overflowCount
+|
+| Implementation:
+|   Return the count set by setCounts.
+|-----------------------------------------------------------------------------*/
+unsigned long IAsyncNotificationMetrics :: overflowCount ( ) const
+{
+  return overflowTotal;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationMetrics :: spinWonCount
+|
+| Implementation:
+|   Return the number of waits recordWait was told ended while polling.
+|-----------------------------------------------------------------------------*/
+unsigned long IAsyncNotificationMetrics :: spinWonCount ( ) const
+{
+  return spinWins;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationMetrics :: blockedCount
+|
+| Implementation:
+|   Return the number of waits recordWait was told blocked.
+|-----------------------------------------------------------------------------*/
+unsigned long IAsyncNotificationMetrics :: blockedCount ( ) const
+{
+  return blocks;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationMetrics :: latencyLimit
+|
+| Implementation:
+|   Bucket n holds waits up to 2 to the n microseconds, except for the last.
+|-----------------------------------------------------------------------------*/
+unsigned long IAsyncNotificationMetrics :: latencyLimit ( unsigned long bucket )
+{
+  IASSERTPARM ( bucket < numberOfLatencyBuckets );
+
+  if ( bucket == numberOfLatencyBuckets - 1 )
+    return 0xFFFFFFFFUL;
+
+  return ( 1UL << bucket );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationMetrics :: latencyCount
+|
+| Implementation:
+|   Return the count in the bucket.
+|-----------------------------------------------------------------------------*/
+unsigned long IAsyncNotificationMetrics :: latencyCount (
+                                             unsigned long bucket ) const
+{
+  IASSERTPARM ( bucket < numberOfLatencyBuckets );
+
+  return latencies[bucket];
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationMetrics :: latencyPercentile
+|
+| Implementation:
+|   Find how many notifications are at or below the percentile, rounding
+|   up, then add up the buckets until they hold that many.
+|-----------------------------------------------------------------------------*/
+unsigned long IAsyncNotificationMetrics :: latencyPercentile (
+                                             unsigned long percent ) const
+{
+  IASSERTPARM ( percent <= 100 );
+
+  if ( dispatched == 0 )
+    return 0;
+
+  double wanted = ceil ( (double)dispatched * (double)percent / 100.0 );
+  double counted = 0.0;
+  unsigned long bucket = 0;
+
+  for ( ; bucket < numberOfLatencyBuckets - 1; bucket++ )
+  {
+    counted += (double)latencies[bucket];
+    if ( ( counted >= wanted ) && ( counted != 0.0 ) )
+      break;
+  }
+
+  return ( latencyLimit ( bucket ) );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationMetrics :: maxLatency
+|
+| Implementation:
+|   Return the longest wait seen by recordDispatch.
+|-----------------------------------------------------------------------------*/
+unsigned long IAsyncNotificationMetrics :: maxLatency ( ) const
+{
+  return latencyMax;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationMetrics :: numberOfIds
+|
+| Implementation:
+|   Return the number of ids in the table.
+|-----------------------------------------------------------------------------*/
+unsigned long IAsyncNotificationMetrics :: numberOfIds ( ) const
+{
+  return idsUsed;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationMetrics :: id
+|
+| Implementation:
+|   The ids are kept in the order they were added.
+|-----------------------------------------------------------------------------*/
+INotificationId IAsyncNotificationMetrics :: id ( unsigned long index ) const
+{
+  IASSERTPARM ( index < idsUsed );
+
+  return ids[index].id;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationMetrics :: idCount
+|
+| Implementation:
+|   Return the count of the id.
+|-----------------------------------------------------------------------------*/
+unsigned long IAsyncNotificationMetrics :: idCount ( unsigned long index ) const
+{
+  IASSERTPARM ( index < idsUsed );
+
+  return ids[index].count;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationMetrics :: idTime
+|
+| Implementation:
+|   Return the total time of the id.  It is kept as a double so it does not
+|   wrap around.
+|-----------------------------------------------------------------------------*/
+double IAsyncNotificationMetrics :: idTime ( unsigned long index ) const
+{
+  IASSERTPARM ( index < idsUsed );
+
+  return ids[index].time;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationMetrics :: idMaxTime
+|
+| Implementation:
+|   Return the longest time of the id.
+|-----------------------------------------------------------------------------*/
+unsigned long IAsyncNotificationMetrics :: idMaxTime (
+                                             unsigned long index ) const
+{
+  IASSERTPARM ( index < idsUsed );
+
+  return ids[index].maxTime;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationMetrics :: asString
+|
+| Implementation:
+|   Build the counts line, the latency line and a line for each id with its
+|   average and longest time.
+|-----------------------------------------------------------------------------*/
+IString IAsyncNotificationMetrics :: asString ( ) const
+{
+  IString text = IString ( "  queued " ) + IString ( depthNow ) +
+                 IString ( ", most queued " ) + IString ( depthMax ) +
+                 IString ( ", dispatched " ) + IString ( dispatched ) +
+                 IString ( ", coalesced " ) + IString ( coalescedTotal ) +
+                 IString ( ", dropped " ) + IString ( droppedTotal ) +
+                 IString ( ", overflows " ) + IString ( overflowTotal ) +
+                 IString ( ", spin won " ) + IString ( spinWins ) +
+                 IString ( ", blocked " ) + IString ( blocks ) +
+                 IString ( "\n" );
+
+  text += IString ( "  wait us: 50% <= " ) +
+          IString ( latencyPercentile ( 50 ) ) +
+          IString ( ", 90% <= " ) + IString ( latencyPercentile ( 90 ) ) +
+          IString ( ", 99% <= " ) + IString ( latencyPercentile ( 99 ) ) +
+          IString ( ", longest " ) + IString ( latencyMax ) +
+          IString ( "\n" );
+
+  for ( unsigned long i = 0; i < idsUsed; i++ )
+  {
+    IAsyncNotificationIdMetrics & entry = ids[i];
+    unsigned long average
+                    = (unsigned long)( entry.time / (double)entry.count );
+
+    text += IString ( "  " ) + IString ( entry.id ) +
+            IString ( ": dispatched " ) + IString ( entry.count ) +
+            IString ( ", average us " ) + IString ( average ) +
+            IString ( ", longest us " ) + IString ( entry.maxTime ) +
+            IString ( "\n" );
+  }
+
+  return text;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationMetrics :: clock
+|
+| Implementation:
+|   Use the monotonic clock on Linux.  On OS/2 the millisecond count is too
+|   coarse, so use the high resolution timer and its frequency.  The count
+|   is kept to 32 bits on every system so it wraps the same way, and elapsed
+|   takes differences the same way.
+|-----------------------------------------------------------------------------*/
+unsigned long IAsyncNotificationMetrics :: clock ( )
+{
+#ifdef __linux__
+  struct timespec time;
+  clock_gettime ( CLOCK_MONOTONIC, &time );
+  return ( ( (unsigned long)time.tv_sec * 1000000UL +
+             (unsigned long)time.tv_nsec / 1000UL ) & 0xFFFFFFFFUL );
+#else
+  static ULONG frequency = 0;
+  if ( frequency == 0 )
+    DosTmrQueryFreq ( &frequency );
+
+  QWORD ticks;
+  DosTmrQueryTime ( &ticks );
+
+  double microseconds = ( (double)ticks.ulHi * 4294967296.0 +
+                          (double)ticks.ulLo ) * 1000000.0 /
+                        (double)frequency;
+  return ( (unsigned long)fmod ( microseconds, 4294967296.0 ) );
+#endif
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationMetrics :: elapsed
+|
+| Implementation:
+|   Counts are kept to 32 bits, so the difference is taken modulo 2 to the
+|   32.  An unsigned long may be wider than that.
+|-----------------------------------------------------------------------------*/
+unsigned long IAsyncNotificationMetrics :: elapsed ( unsigned long start,
+                                                     unsigned long end )
+{
+  return ( ( end - start ) & 0xFFFFFFFFUL );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationMetrics :: recordDispatch
+|
+| Implementation:
+|   Only this thread adds ids, so grow the id table before taking the guard
+|     if a new id may not fit.  Allocating while holding the guard would
+|     leave it held if the allocation threw.
+|   Under the guard, so a copy is never half updated:
+|     Count the notification and keep the deepest queue.
+|     Count the wait in the first bucket whose limit it does not pass.
+|     Find or add the id and add the time to it.
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationMetrics & IAsyncNotificationMetrics :: recordDispatch (
+                                                  INotificationId anId,
+                                                  unsigned long depth,
+                                                  unsigned long latency,
+                                                  unsigned long time )
+{
+  unsigned long bucket = 0;
+  while ( ( bucket < numberOfLatencyBuckets - 1 ) &&
+          ( latency > ( 1UL << bucket ) ) )
+    bucket++;
+
+  if ( isIdTableFull() )
+    growIds();
+
+  IAtomic::acquire ( guard );
+
+  dispatched++;
+  if ( depth > depthMax )
+    depthMax = depth;
+
+  latencies[bucket]++;
+  if ( latency > latencyMax )
+    latencyMax = latency;
+
+  IAsyncNotificationIdMetrics & entry = findOrAddId ( anId );
+  entry.count++;
+  entry.time += (double)time;
+  if ( time > entry.maxTime )
+    entry.maxTime = time;
+
+  IAtomic::release ( guard );
+
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationMetrics :: recordWait
+|
+| Implementation:
+|   Count the wait under the guard.
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationMetrics & IAsyncNotificationMetrics :: recordWait (
+                                                  IBoolean spun )
+{
+  IAtomic::acquire ( guard );
+
+  if ( spun )
+    spinWins++;
+  else
+    blocks++;
+
+  IAtomic::release ( guard );
+
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationMetrics :: setCounts
+|
+| Implementation:
+|   Save the counts under the guard.
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationMetrics & IAsyncNotificationMetrics :: setCounts (
+                                                  unsigned long depth,
+                                                  unsigned long coalesced,
+                                                  unsigned long dropped,
+                                                  unsigned long overflows )
+{
+  IAtomic::acquire ( guard );
+
+  depthNow = depth;
+  coalescedTotal = coalesced;
+  droppedTotal = dropped;
+  overflowTotal = overflows;
+
+  IAtomic::release ( guard );
+
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationMetrics :: add
+|
+| Implementation:
+|   Hold the guard of the other object while reading it.  Sum the counts,
+|   keep the larger maximums and add each of its ids to ours.  Our own guard
+|   is not needed, since only the thread that owns a snapshot adds to it.
+|   Adding an id may grow our table, so let the other guard go if that
+|   throws.
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationMetrics & IAsyncNotificationMetrics :: add (
+                                   const IAsyncNotificationMetrics & metrics )
+{
+  volatile long & otherGuard = ((IAsyncNotificationMetrics &)metrics).guard;
+
+  IAtomic::acquire ( otherGuard );
+
+  depthNow += metrics.depthNow;
+  if ( metrics.depthMax > depthMax )
+    depthMax = metrics.depthMax;
+  dispatched += metrics.dispatched;
+  coalescedTotal += metrics.coalescedTotal;
+  droppedTotal += metrics.droppedTotal;
+  overflowTotal += metrics.overflowTotal;
+  spinWins += metrics.spinWins;
+  blocks += metrics.blocks;
+
+  for ( unsigned long i = 0; i < numberOfLatencyBuckets; i++ )
+    latencies[i] += metrics.latencies[i];
+  if ( metrics.latencyMax > latencyMax )
+    latencyMax = metrics.latencyMax;
+
+  try
+  {
+    for ( unsigned long j = 0; j < metrics.idsUsed; j++ )
+    {
+      IAsyncNotificationIdMetrics & from = metrics.ids[j];
+      IAsyncNotificationIdMetrics & entry = findOrAddId ( from.id );
+      entry.count += from.count;
+      entry.time += from.time;
+      if ( from.maxTime > entry.maxTime )
+        entry.maxTime = from.maxTime;
+    }
+  }
+  catch ( ... )
+  {
+    IAtomic::release ( otherGuard );
+    throw;
+  }
+
+  IAtomic::release ( otherGuard );
+
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationMetrics :: findOrAddId
+|
+| Implementation:
+|   Probe the slots from the hash of the id until the id or an empty slot
+|   is found.  Grow the table first if it is full, so there is always an
+|   empty slot.  recordDispatch has already grown it, so this never
+|   allocates while our own guard is held.  A new id goes at the end of the
+|   entries.
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationIdMetrics & IAsyncNotificationMetrics :: findOrAddId (
+                                                     INotificationId anId )
+{
+  if ( isIdTableFull() )
+    growIds();
+
+  unsigned long slot = hashId ( anId, idSlotCount );
+  while ( idSlots[slot] != 0 )
+  {
+    IAsyncNotificationIdMetrics & entry = ids[idSlots[slot] - 1];
+    if ( entry.id == anId )
+      return entry;
+    slot = ( slot + 1 ) & ( idSlotCount - 1 );
+  }
+
+  IAsyncNotificationIdMetrics & entry = ids[idsUsed];
+  entry.id = anId;
+  entry.count = 0;
+  entry.time = 0.0;
+  entry.maxTime = 0;
+  idsUsed++;
+  idSlots[slot] = idsUsed;
+
+  return entry;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationMetrics :: isIdTableFull
+|
+| Implementation:
+|   The table is full when one more id would make it over three quarters
+|   full.
+|-----------------------------------------------------------------------------*/
+IBoolean IAsyncNotificationMetrics :: isIdTableFull ( ) const
+{
+  return ( ( idsUsed + 1 ) * 4 > idSlotCount * 3 );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationMetrics :: growIds
+|
+| Implementation:
+|   Double the number of slots and make room for three quarters as many
+|   entries.  Copy the entries and put each back in the new slots.  Only
+|   the thread that adds ids calls this, so the copies are made without the
+|   guard.  Swap the new table in under the guard, since other threads may
+|   be copying the old one, and delete the old one after.
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationMetrics & IAsyncNotificationMetrics :: growIds ( )
+{
+  unsigned long slotCount = ( idSlotCount == 0 ) ? initialIdSlots
+                                                 : idSlotCount * 2;
+  unsigned long * slots = new unsigned long [slotCount];
+  IAsyncNotificationIdMetrics * entries
+                    = new IAsyncNotificationIdMetrics [slotCount * 3 / 4];
+
+  for ( unsigned long i = 0; i < slotCount; i++ )
+    slots[i] = 0;
+
+  for ( unsigned long j = 0; j < idsUsed; j++ )
+  {
+    entries[j] = ids[j];
+
+    unsigned long slot = hashId ( ids[j].id, slotCount );
+    while ( slots[slot] != 0 )
+      slot = ( slot + 1 ) & ( slotCount - 1 );
+    slots[slot] = j + 1;
+  }
+
+  IAsyncNotificationIdMetrics * oldEntries = ids;
+  unsigned long * oldSlots = idSlots;
+
+  IAtomic::acquire ( guard );
+
+  ids = entries;
+  idSlots = slots;
+  idSlotCount = slotCount;
+
+  IAtomic::release ( guard );
+
+  delete [] oldEntries;
+  delete [] oldSlots;
+
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationMetrics :: clear
+|
+| Implementation:
+|   Zero the counts and the histogram and forget the ids, keeping the table.
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationMetrics & IAsyncNotificationMetrics :: clear ( )
+{
+  depthNow = 0;
+  depthMax = 0;
+  dispatched = 0;
+  coalescedTotal = 0;
+  droppedTotal = 0;
+  overflowTotal = 0;
+  spinWins = 0;
+  blocks = 0;
+
+  for ( unsigned long i = 0; i < numberOfLatencyBuckets; i++ )
+    latencies[i] = 0;
+  latencyMax = 0;
+
+  for ( unsigned long j = 0; j < idSlotCount; j++ )
+    idSlots[j] = 0;
+  idsUsed = 0;
+
+  return *this;
+}
+
\ No newline at end of file
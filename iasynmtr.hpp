@@ -0,0 +1,217 @@
+/* NOSHIP */
+#ifndef _IASYNMTR_
+#define _IASYNMTR_
+/*******************************************************************************
+* FILE NAME: iasynmtr.hpp
+*
+* DESCRIPTION:
+*   Declaration of the class(es):
+*     IAsyncNotificationMetrics - Counts and times kept for a dispatch thread.
+*
+* COPYRIGHT:
+*   Licensed Materials - Property of IBM
+*   (C) Copyright IBM Corporation 1995
+*   All Rights Reserved
+*   US Government Users Restricted Rights - Use, duplication, or disclosure
+*   restricted by GSA ADP Schedule Contract with IBM Corp.
+*
+*******************************************************************************/
+#ifndef _IBASE_
+  #include <ibase.hpp>
+#endif
+
+// Other dependency classes:
+#ifndef _INOTIFY_
+  #include <inotify.hpp>
+#endif
+
+#ifndef _ISTRING_
+  #include <istring.hpp>
+#endif
+
+class IAsyncNotificationIdMetrics;
+
+// Align classes on four byte boundary, except on Linux (see iatomic.hpp).
+#ifndef __linux__
+  #pragma pack(4)
+#endif
+
+class IAsyncNotificationMetrics : public IBase {
+/*******************************************************************************
+*
+* This class holds what is known about how well a dispatch thread is keeping
+* up with its notifications: how deep its queue gets, how long
+* notifications wait in it, how long the observers of each notification id
+* take, how many notifications were coalesced or thrown away, and how the
+* thread waited for them when its queue was empty.
+*
+* Each dispatch thread records into its own object, so recording never waits
+* for another dispatching thread.  A spin guard held for a few instructions
+* lets other threads copy the object while it is being recorded into.  The
+* copies returned by IAsyncNotifier are snapshots and do not change.
+*
+* Times are in microseconds.  Waiting times are kept in a histogram whose
+* buckets double in size, so percentiles are only known to within a factor
+* of two.
+*
+*******************************************************************************/
+
+public:
+/*------------------------------ Constructors ----------------------------------
+| You can construct an object of this class as follows:                        |
+|   - With the default constructor.  Everything is zero.                       |
+|   - With the copy constructor.  The copy is made while the guard of the      |
+|     parameter is held, so it is consistent.                                  |
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationMetrics ( );
+
+IAsyncNotificationMetrics ( const IAsyncNotificationMetrics & metrics );
+
+IAsyncNotificationMetrics & operator = (
+                              const IAsyncNotificationMetrics & rhs );
+
+virtual ~IAsyncNotificationMetrics ( );
+
+/*---------------------------------- Counts ------------------------------------
+| Use these functions to query the queue of the dispatch thread.               |
+|   queueDepth      - Returns the number of notifications queued when the      |
+|                     snapshot was taken.                                      |
+|   maxQueueDepth   - Returns the most notifications seen queued when one was  |
+|                     dispatched.                                              |
+|   dispatchedCount - Returns the number of notifications dispatched.          |
+|   coalescedCount  - Returns the number of notifications replaced by a later  |
+|                     one before they were dispatched.                         |
+|   droppedCount    - Returns the number of notifications thrown away because  |
+|                     the queue was full.                                      |
+|   overflowCount   - Returns the number of notifications sent while the queue |
+|                     was full.                                                |
+|-----------------------------------------------------------------------------*/
+unsigned long queueDepth      ( ) const;
+unsigned long maxQueueDepth   ( ) const;
+unsigned long dispatchedCount ( ) const;
+unsigned long coalescedCount  ( ) const;
+unsigned long droppedCount    ( ) const;
+unsigned long overflowCount   ( ) const;
+
+/*---------------------------------- Waiting -----------------------------------
+| Use these functions to query how the dispatch thread waited when its queue   |
+| was empty.  Only background dispatch threads count them.                     |
+|   spinWonCount - Returns the number of times a notification came while the   |
+|                  thread was polling its queue, before it would have blocked. |
+|   blockedCount - Returns the number of times the thread blocked.             |
+|-----------------------------------------------------------------------------*/
+unsigned long spinWonCount ( ) const;
+unsigned long blockedCount ( ) const;
+
+/*--------------------------------- Latency ------------------------------------
+| Use these functions to query how long notifications waited in the queue,     |
+| from when they were sent until their dispatch started.                       |
+|   numberOfLatencyBuckets - The number of buckets in the histogram.           |
+|   latencyLimit           - Returns the longest wait counted in the passed    |
+|                            bucket.  The last bucket has no limit and         |
+|                            returns the largest unsigned long.                |
+|   latencyCount           - Returns the number of notifications in the        |
+|                            passed bucket.                                    |
+|   latencyPercentile      - Returns the limit of the bucket that holds the    |
+|                            passed percentile, or zero if nothing has been    |
+|                            dispatched.                                       |
+|   maxLatency             - Returns the longest wait.                         |
+|-----------------------------------------------------------------------------*/
+static unsigned long const numberOfLatencyBuckets;
+
+static unsigned long latencyLimit      ( unsigned long bucket );
+unsigned long        latencyCount      ( unsigned long bucket ) const;
+unsigned long        latencyPercentile ( unsigned long percent ) const;
+unsigned long        maxLatency        ( ) const;
+
+/*----------------------------- Notification Ids -------------------------------
+| Use these functions to query the dispatch times of each notification id.     |
+| Ids are numbered from zero in the order they were first dispatched.          |
+| Coalesced notifications are counted under IAsyncNotifierThread::coalescedId. |
+|   numberOfIds - Returns the number of notification ids dispatched.           |
+|   id          - Returns the notification id with the passed number.          |
+|   idCount     - Returns the number of times it was dispatched.               |
+|   idTime      - Returns the total time its observers took.                   |
+|   idMaxTime   - Returns the longest time its observers took for one          |
+|                 notification.                                                |
+|-----------------------------------------------------------------------------*/
+unsigned long   numberOfIds ( ) const;
+INotificationId id          ( unsigned long index ) const;
+unsigned long   idCount     ( unsigned long index ) const;
+double          idTime      ( unsigned long index ) const;
+unsigned long   idMaxTime   ( unsigned long index ) const;
+
+/*--------------------------------- Report -------------------------------------
+| Use this function to get the metrics as text.                                |
+|   asString - Returns a line of counts, a line of latency percentiles and a   |
+|              line for each notification id, each ending with a new line.     |
+|-----------------------------------------------------------------------------*/
+IString asString ( ) const;
+
+/*-------------------------------- Recording -----------------------------------
+| Used by dispatch threads to record into their own object and to build        |
+| snapshots.                                                                   |
+|   clock          - Returns a count of microseconds that wraps around.  Only  |
+|                    differences between two counts mean anything.             |
+|   elapsed        - Returns the microseconds from the first count to the      |
+|                    second, even if the clock wrapped around in between.  The |
+|                    count wraps after about 71 minutes, so only shorter times |
+|                    can be measured.                                          |
+|   recordDispatch - Records one notification of the passed id, the number of  |
+|                    notifications that were queued when it was removed, how   |
+|                    long it waited and how long its observers took.  Only     |
+|                    one thread may record into an object.                     |
+|   recordWait     - Records one wait for an empty queue, which either ended   |
+|                    while polling (true is passed) or blocked.  Only one      |
+|                    thread may record into an object.                         |
+|   setCounts      - Sets the queue depth and the counts kept by the dispatch  |
+|                    thread itself.                                            |
+|   add            - Adds the counts and times of the passed object into this  |
+|                    one, while the guard of the passed object is held.        |
+|-----------------------------------------------------------------------------*/
+static unsigned long clock   ( );
+static unsigned long elapsed ( unsigned long start, unsigned long end );
+
+IAsyncNotificationMetrics & recordDispatch ( INotificationId anId,
+                                             unsigned long depth,
+                                             unsigned long latency,
+                                             unsigned long time );
+IAsyncNotificationMetrics & recordWait     ( IBoolean spun );
+IAsyncNotificationMetrics & setCounts      ( unsigned long depth,
+                                             unsigned long coalesced,
+                                             unsigned long dropped,
+                                             unsigned long overflows );
+IAsyncNotificationMetrics & add            (
+                              const IAsyncNotificationMetrics & metrics );
+
+
+private:
+IAsyncNotificationIdMetrics & findOrAddId   ( INotificationId anId );
+IBoolean                      isIdTableFull ( ) const;
+IAsyncNotificationMetrics &   growIds       ( );
+IAsyncNotificationMetrics &   clear       ( );
+
+/*--------------------------- Private State Data -----------------------------*/
+volatile long                 guard;
+unsigned long                 depthNow;
+unsigned long                 depthMax;
+unsigned long                 dispatched;
+unsigned long                 coalescedTotal;
+unsigned long                 droppedTotal;
+unsigned long                 overflowTotal;
+unsigned long                 spinWins;
+unsigned long                 blocks;
+unsigned long               * latencies;
+unsigned long                 latencyMax;
+IAsyncNotificationIdMetrics * ids;
+unsigned long                 idsUsed;
+unsigned long               * idSlots;
+unsigned long                 idSlotCount;
+
+}; // IAsyncNotificationMetrics
+
+// Resume compiler default packing.
+#pragma pack()
+
+#endif // _IASYNMTR_
+
\ No newline at end of file
@@ -0,0 +1,357 @@
+/*******************************************************************************
+* FILE NAME: iasynobs.cpp
+*
+* DESCRIPTION:
+*   Functions to implement the class(es):
+*     IAsyncObserverList
+*
+* COPYRIGHT:
+*   Licensed Materials - Property of IBM
+*   (C) Copyright IBM Corporation 1995
+*   All Rights Reserved
+*   US Government Users Restricted Rights - Use, duplication, or disclosure
+*   restricted by GSA ADP Schedule Contract with IBM Corp.
+*
+*******************************************************************************/
+#include <iasynobs.hpp>
+
+#ifndef _IOBSERVR_
+  #include <iobservr.hpp>
+#endif
+
+#ifndef _INOTIFEV_
+  #include <inotifev.hpp>
+#endif
+
+#ifndef _IATOMIC_
+  #include <iatomic.hpp>
+#endif
+
+
+//------------------------------------------------------------------------------
+// Counts the current thread as a reader of an IAsyncObserverList for as long
+// as it exists, even if an observer throws an exception.  While there is a
+// reader, changes retire replaced snapshots instead of deleting them, so the
+// last reader out deletes any that were retired.
+//------------------------------------------------------------------------------
+class IAsyncObserverReader {
+public:
+  IAsyncObserverReader ( IAsyncObserverList & aList )
+    : list ( aList )
+  {
+    IAtomic::increment ( list.readers );
+  }
+
+  ~IAsyncObserverReader ( )
+  {
+    if ( ( IAtomic::decrement ( list.readers ) == 0 ) &&
+         ( IAtomic::value ( *(void * const volatile *)(&list.retired) ) != 0 ) )
+      list.reclaim();
+  }
+
+  IAsyncObserverList & list;
+};
+
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncObserverList :: IAsyncObserverList
+|
+| Implementation:
+|   An empty list has no snapshot.
+|-----------------------------------------------------------------------------*/
+IAsyncObserverList :: IAsyncObserverList ( ) :
+                   IBase ( ),
+                   current ( 0 ),
+                   readers ( 0 ),
+                   guard ( 0 ),
+                   retired ( 0 )
+{ }
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncObserverList :: ~IAsyncObserverList
+|
+| Implementation:
+|   There are no readers left, so delete the current and retired snapshots.
+|-----------------------------------------------------------------------------*/
+IAsyncObserverList :: ~IAsyncObserverList ( )
+{
+  if ( current != 0 )
+  {
+    current->nextRetired = retired;
+    retired = current;
+  }
+
+  destroy ( retired );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncObserverList :: add
+|
+| Implementation:
+|   Under the guard, copy the current snapshot with room for one more
+|   observer, put the observer at the end and publish the copy.
+|   Delete whatever could be reclaimed after giving up the guard.
+|-----------------------------------------------------------------------------*/
+IAsyncObserverList & IAsyncObserverList :: add ( IObserver        & anObserver,
+                                                 const IEventData & userData )
+{
+  IAtomic::acquire ( guard );
+
+  Snapshot * snapshot = copy ( 1 );
+  snapshot->entries[snapshot->count].observer = &anObserver;
+  snapshot->entries[snapshot->count].userData = userData;
+  snapshot->count++;
+
+  Snapshot * reclaimed = publish ( snapshot );
+
+  IAtomic::release ( guard );
+
+  destroy ( reclaimed );
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncObserverList :: remove
+|
+| Implementation:
+|   Remove every entry for the observer.
+|-----------------------------------------------------------------------------*/
+IAsyncObserverList & IAsyncObserverList :: remove ( IObserver & anObserver )
+{
+  return ( removeMatching ( anObserver, 0 ) );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncObserverList :: remove
+|
+| Implementation:
+|   Remove the entries for the observer with the passed user data.
+|-----------------------------------------------------------------------------*/
+IAsyncObserverList & IAsyncObserverList :: remove (
+                                             IObserver        & anObserver,
+                                             const IEventData & userData )
+{
+  return ( removeMatching ( anObserver, &userData ) );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncObserverList :: removeAll
+|
+| Implementation:
+|   Publish no snapshot at all.
+|-----------------------------------------------------------------------------*/
+IAsyncObserverList & IAsyncObserverList :: removeAll ( )
+{
+  IAtomic::acquire ( guard );
+
+  Snapshot * reclaimed = publish ( 0 );
+
+  IAtomic::release ( guard );
+
+  destroy ( reclaimed );
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncObserverList :: count
+|
+| Implementation:
+|   A snapshot never changes, so it is safe to read its count while a reader
+|   is counted.
+|-----------------------------------------------------------------------------*/
+unsigned long IAsyncObserverList :: count ( ) const
+{
+  IAsyncObserverReader reader ( (IAsyncObserverList &)(*this) );
+  Snapshot * snapshot = current;
+
+  return ( snapshot ? snapshot->count : 0 );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncObserverList :: notify
+|
+| Implementation:
+|   Count this thread as a reader before taking the current snapshot, so a
+|   change that replaces it will not delete it while it is in use.
+|   Call each observer with a copy of the event that has its user data.
+|-----------------------------------------------------------------------------*/
+IAsyncObserverList & IAsyncObserverList :: notify (
+                                         const INotificationEvent & anEvent )
+{
+  IAsyncObserverReader reader ( *this );
+  Snapshot * snapshot = current;
+
+  if ( snapshot == 0 )
+    return *this;
+
+  INotificationEvent observerEvent ( anEvent );
+
+  for ( unsigned long i = 0; i < snapshot->count; i++ )
+  {
+    observerEvent.setObserverData ( snapshot->entries[i].userData );
+    snapshot->entries[i].observer->dispatchNotificationEvent ( observerEvent );
+  }
+
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncObserverList :: isNotifying
+|
+| Implementation:
+|   Every notify counts itself as a reader.
+|-----------------------------------------------------------------------------*/
+IBoolean IAsyncObserverList :: isNotifying ( ) const
+{
+  return ( IAtomic::value ( readers ) != 0 );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncObserverList :: removeMatching
+|
+| Implementation:
+|   Under the guard, copy the current snapshot without the entries for the
+|   observer, or only those with the user data if it is passed.  Leave the
+|   list alone if nothing matched.  Publish the copy, or nothing if no
+|   observers are left.  Delete whatever could be reclaimed after giving up
+|   the guard.
+|-----------------------------------------------------------------------------*/
+IAsyncObserverList & IAsyncObserverList :: removeMatching (
+                                             IObserver        & anObserver,
+                                             const IEventData * userData )
+{
+  IAtomic::acquire ( guard );
+
+  Snapshot * snapshot = copy ( 0 );
+  unsigned long kept = 0;
+
+  for ( unsigned long i = 0; i < snapshot->count; i++ )
+  {
+    Entry & entry = snapshot->entries[i];
+    if ( ( entry.observer != &anObserver ) ||
+         ( ( userData != 0 ) && ( ! ( entry.userData == *userData ) ) ) )
+      snapshot->entries[kept++] = entry;
+  }
+
+  Snapshot * reclaimed = 0;
+  if ( kept != snapshot->count )
+  {
+    snapshot->count = kept;
+    if ( kept == 0 )
+    {
+      reclaimed = publish ( 0 );
+      snapshot->nextRetired = reclaimed;
+      reclaimed = snapshot;
+    }
+    else
+      reclaimed = publish ( snapshot );
+  }
+  else
+    reclaimed = snapshot;
+
+  IAtomic::release ( guard );
+
+  destroy ( reclaimed );
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncObserverList :: copy
+|
+| Implementation:
+|   Return a new snapshot with the entries of the current one and room for
+|   the passed number more.  The caller holds the guard, so the current
+|   snapshot can not be replaced or deleted while it is copied.
+|-----------------------------------------------------------------------------*/
+IAsyncObserverList::Snapshot * IAsyncObserverList :: copy (
+                                                   unsigned long extra ) const
+{
+  Snapshot * old = current;
+  unsigned long oldCount = ( old ? old->count : 0 );
+
+  Snapshot * snapshot = new Snapshot;
+  snapshot->nextRetired = 0;
+  snapshot->count = oldCount;
+  snapshot->entries = new Entry [ ( oldCount + extra ) ? oldCount + extra : 1 ];
+
+  for ( unsigned long i = 0; i < oldCount; i++ )
+    snapshot->entries[i] = old->entries[i];
+
+  return snapshot;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncObserverList :: publish
+|
+| Implementation:
+|   Called with the guard held.  Swap the passed snapshot in and retire the
+|   old one.  If no thread is counted as a reader after the swap, none can
+|   be using a retired snapshot: a reader counted later takes the new one.
+|   Return the retired snapshots that can be deleted, for the caller to
+|   delete after giving up the guard.
+|-----------------------------------------------------------------------------*/
+IAsyncObserverList::Snapshot * IAsyncObserverList :: publish (
+                                                     Snapshot * snapshot )
+{
+  Snapshot * old = (Snapshot *)IAtomic::exchange (
+                                 *(void * volatile *)(&current), snapshot );
+  if ( old != 0 )
+  {
+    old->nextRetired = retired;
+    retired = old;
+  }
+
+  Snapshot * reclaimed = 0;
+  if ( IAtomic::value ( readers ) == 0 )
+  {
+    reclaimed = retired;
+    retired = 0;
+  }
+
+  return reclaimed;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncObserverList :: reclaim
+|
+| Implementation:
+|   Called by a reader that left no readers counted.  Under the guard, take
+|   the retired snapshots if there are still no readers, as publish does:
+|   a reader counted since then took a snapshot that is not retired yet, so
+|   the count must be checked again before any are deleted.  Delete them
+|   after giving up the guard.
+|-----------------------------------------------------------------------------*/
+IAsyncObserverList & IAsyncObserverList :: reclaim ( )
+{
+  IAtomic::acquire ( guard );
+
+  Snapshot * reclaimed = 0;
+  if ( IAtomic::value ( readers ) == 0 )
+  {
+    reclaimed = retired;
+    retired = 0;
+  }
+
+  IAtomic::release ( guard );
+
+  destroy ( reclaimed );
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncObserverList :: destroy
+|
+| Implementation:
+|   Delete a chain of snapshots.
+|-----------------------------------------------------------------------------*/
+void IAsyncObserverList :: destroy ( Snapshot * snapshots )
+{
+  while ( snapshots != 0 )
+  {
+    Snapshot * nextSnapshot = snapshots->nextRetired;
+    delete [] snapshots->entries;
+    delete snapshots;
+    snapshots = nextSnapshot;
+  }
+}
+
\ No newline at end of file
@@ -0,0 +1,138 @@
+/* NOSHIP */
+#ifndef _IASYNOBS_
+#define _IASYNOBS_
+/*******************************************************************************
+* FILE NAME: iasynobs.hpp
+*
+* DESCRIPTION:
+*   Declaration of the class(es):
+*     IAsyncObserverList - The observers of an IAsyncNotifier.
+*
+* COPYRIGHT:
+*   Licensed Materials - Property of IBM
+*   (C) Copyright IBM Corporation 1995
+*   All Rights Reserved
+*   US Government Users Restricted Rights - Use, duplication, or disclosure
+*   restricted by GSA ADP Schedule Contract with IBM Corp.
+*
+*******************************************************************************/
+#ifndef _IBASE_
+  #include <ibase.hpp>
+#endif
+
+// Other dependency classes:
+#ifndef _IEVTDATA_
+  #include <ievtdata.hpp>
+#endif
+
+class IObserver;
+class INotificationEvent;
+
+// Align classes on four byte boundary, except on Linux (see iatomic.hpp).
+#ifndef __linux__
+  #pragma pack(4)
+#endif
+
+class IAsyncObserverList : public IBase {
+/*******************************************************************************
+*
+* This class keeps the observers of one IAsyncNotifier so that they can be
+* added and removed on any thread while notifications are being dispatched.
+*
+* The observers are kept in a snapshot that is never changed once it is
+* published.  Adding or removing an observer copies the current snapshot
+* with the change made and publishes the copy in its place.  Changes hold a
+* spin guard while they copy, so changes made on several threads at once
+* are made one at a time.  Notifying observers takes no guard at all: the
+* dispatching thread counts itself as a reader, takes the current snapshot
+* and calls each observer in it.
+*
+* A replaced snapshot is retired rather than deleted, since a reader may
+* still be using it.  Retired snapshots are deleted by the last reader to
+* finish, by the next change made when there are no readers, or by the
+* destructor.
+*
+* A notification whose dispatch started before an observer was removed on
+* another thread may still be passed to that observer.  Remove an observer
+* on the dispatch thread to be sure it gets no more notifications.
+*
+*******************************************************************************/
+
+public:
+/*------------------------------ Constructors ----------------------------------
+| You can construct an object of this class as follows:                        |
+|   - With the default constructor.  The list is empty.                        |
+|-----------------------------------------------------------------------------*/
+IAsyncObserverList ( );
+
+~IAsyncObserverList ( );
+
+/*-------------------------------- Observers -----------------------------------
+| Use these functions to change the list.  They can be called on any thread.   |
+|   add       - Adds the observer with the passed user data.  An observer can  |
+|               be added more than once.                                       |
+|   remove    - Removes the observer, every time it was added, or only where   |
+|               it was added with the passed user data.                        |
+|   removeAll - Removes every observer.                                        |
+|   count     - Returns the number of observers in the current snapshot.       |
+|-----------------------------------------------------------------------------*/
+IAsyncObserverList & add       ( IObserver        & anObserver,
+                                 const IEventData & userData );
+IAsyncObserverList & remove    ( IObserver        & anObserver );
+IAsyncObserverList & remove    ( IObserver        & anObserver,
+                                 const IEventData & userData );
+IAsyncObserverList & removeAll ( );
+unsigned long        count     ( ) const;
+
+/*------------------------------ Notification ----------------------------------
+| Use these functions on the dispatch thread to notify the observers.          |
+|   notify      - Passes a copy of the event, with the observer's user data    |
+|                 set as the observer data, to each observer in the current    |
+|                 snapshot, in the order they were added.                      |
+|   isNotifying - Returns true if notify has not returned on some thread, or   |
+|                 if count is being called.                                    |
+|-----------------------------------------------------------------------------*/
+IAsyncObserverList & notify      ( const INotificationEvent & anEvent );
+IBoolean             isNotifying ( ) const;
+
+
+private:
+// The private copy constructor and assignment operator are not implemented.
+IAsyncObserverList ( const IAsyncObserverList & rhs );
+IAsyncObserverList & operator = ( const IAsyncObserverList & rhs );
+
+class Entry {
+public:
+  IObserver * observer;
+  IEventData  userData;
+};
+
+class Snapshot {
+public:
+  Snapshot      * nextRetired;
+  unsigned long   count;
+  Entry         * entries;
+};
+
+friend class IAsyncObserverReader;
+
+IAsyncObserverList & removeMatching ( IObserver        & anObserver,
+                                      const IEventData * userData );
+Snapshot *           copy           ( unsigned long extra ) const;
+Snapshot *           publish        ( Snapshot * snapshot );
+IAsyncObserverList & reclaim        ( );
+static void          destroy        ( Snapshot * snapshots );
+
+/*--------------------------- Private State Data -----------------------------*/
+Snapshot * volatile current;
+volatile long       readers;
+volatile long       guard;
+Snapshot * volatile retired;
+
+}; // IAsyncObserverList
+
+// Resume compiler default packing.
+#pragma pack()
+
+#endif // _IASYNOBS_
+
\ No newline at end of file
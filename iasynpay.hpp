@@ -0,0 +1,256 @@
+/* NOSHIP */
+#ifndef _IASYNPAY_
+#define _IASYNPAY_
+/*******************************************************************************
+* FILE NAME: iasynpay.hpp
+*
+* DESCRIPTION:
+*   Declaration of the class(es):
+*     IAsyncNotificationPayload - A value sent with an asynchronous
+*                                 notification.
+*     IAsyncTypedPayload        - A value of a given type sent with an
+*                                 asynchronous notification.
+*
+* COPYRIGHT:
+*   Licensed Materials - Property of IBM
+*   (C) Copyright IBM Corporation 1995
+*   All Rights Reserved
+*   US Government Users Restricted Rights - Use, duplication, or disclosure
+*   restricted by GSA ADP Schedule Contract with IBM Corp.
+*
+*******************************************************************************/
+#ifndef _IBASE_
+  #include <ibase.hpp>
+#endif
+
+// Other dependency classes:
+#ifndef _INOTIFEV_
+  #include <inotifev.hpp>
+#endif
+
+#ifdef __IBMCPP__
+  #include <new.h>
+#else
+  #include <new>
+#endif
+
+// Align classes on four byte boundary, except on Linux (see iatomic.hpp).
+#ifndef __linux__
+  #pragma pack(4)
+#endif
+
+class IAsyncNotificationPayload : public IBase {
+/*******************************************************************************
+*
+* This class describes a value to be sent with an asynchronous notification
+* without knowing its type.  It refers to the value and has the functions
+* that copy the value into storage kept with the queued notification and
+* destroy the copy once the notification is done with.
+*
+* A value of up to inlineSize bytes is copied into the storage itself, so
+* queuing it does not use the heap.  A larger value is copied to the heap
+* and the storage keeps a pointer to it.  The event data of the dispatched
+* notification points at the copy of the value.
+*
+* Use IAsyncTypedPayload rather than this class to send a value.
+*
+*******************************************************************************/
+
+public:
+/*--------------------------------- Storage ------------------------------------
+| The storage for a copy of a value kept with a queued notification.           |
+|   inlineSize      - The size of the largest value copied into the storage.   |
+|   Storage         - Room for inlineSize bytes, aligned for any type.         |
+|   CopyFunction    - Copies the value passed as the second argument into the  |
+|                     storage passed as the first and returns the address of   |
+|                     the copy.                                                |
+|   DestroyFunction - Destroys the copy kept in the passed storage.            |
+|-----------------------------------------------------------------------------*/
+enum { inlineSize = 16 };
+
+// Packing would limit the alignment of the storage to four bytes, so it is
+// declared with the compiler default packing.
+#pragma pack()
+
+union Storage {
+  double alignment;
+  void * pointer;
+  char   bytes [ inlineSize ];
+};
+
+#ifndef __linux__
+  #pragma pack(4)
+#endif
+
+typedef void * ( * CopyFunction    ) ( Storage & storage, const void * value );
+typedef void   ( * DestroyFunction ) ( Storage & storage );
+
+/*------------------------------ Constructors ----------------------------------
+| You can construct an object of this class as follows:                        |
+|   - With the address of the value and the functions that copy and destroy    |
+|     it.  The value must exist as long as this object.                        |
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationPayload ( const void    * value,
+                            CopyFunction    copy,
+                            DestroyFunction destroy );
+
+/*------------------------------- Accessors ------------------------------------
+| Used by the notification queue to keep a copy of the value.                  |
+|   value           - Returns the address of the value.                        |
+|   copyTo          - Copies the value into the passed storage and returns the |
+|                     address of the copy.                                     |
+|   destroyFunction - Returns the function that destroys a copy made by        |
+|                     copyTo.                                                  |
+|-----------------------------------------------------------------------------*/
+const void *    value           ( ) const;
+void *          copyTo          ( Storage & storage ) const;
+DestroyFunction destroyFunction ( ) const;
+
+
+private:
+/*--------------------------- Private State Data -----------------------------*/
+const void *    theValue;
+CopyFunction    copyValue;
+DestroyFunction destroyValue;
+
+}; // IAsyncNotificationPayload
+
+
+template <class Type>
+class IAsyncTypedPayload : public IAsyncNotificationPayload {
+/*******************************************************************************
+*
+* This class sends a value of the type Type with an asynchronous notification.
+* The type must have a copy constructor.  For example, a part sends:
+*
+*   notifyObservers ( sizeId, IAsyncTypedPayload<ISize> ( newSize ) );
+*
+* and an observer of the notification gets the value with:
+*
+*   const ISize & newSize = IAsyncTypedPayload<ISize>::valueOf ( anEvent );
+*
+* The value the observer gets is a copy, which is destroyed after the
+* notification is dispatched.
+*
+*******************************************************************************/
+
+public:
+/*------------------------------ Constructors ----------------------------------
+| You can construct an object of this class as follows:                        |
+|   - With the value.  The value must exist as long as this object.            |
+|-----------------------------------------------------------------------------*/
+IAsyncTypedPayload ( const Type & value );
+
+/*------------------------------- Accessors ------------------------------------
+| Used by observers to get the value.                                          |
+|   valueOf - Returns the value sent with the passed notification.  It must    |
+|             only be used for a notification sent with a value of this type,  |
+|             and only until the observer returns.                             |
+|-----------------------------------------------------------------------------*/
+static const Type & valueOf ( const INotificationEvent & anEvent );
+
+
+private:
+static void * copy    ( Storage & storage, const void * value );
+static void   destroy ( Storage & storage );
+
+}; // IAsyncTypedPayload
+
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationPayload :: IAsyncNotificationPayload
+|-----------------------------------------------------------------------------*/
+inline IAsyncNotificationPayload :: IAsyncNotificationPayload (
+                                      const void    * value,
+                                      CopyFunction    copy,
+                                      DestroyFunction destroy ) :
+                   IBase ( ),
+                   theValue ( value ),
+                   copyValue ( copy ),
+                   destroyValue ( destroy )
+{ }
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationPayload :: value
+|-----------------------------------------------------------------------------*/
+inline const void * IAsyncNotificationPayload :: value ( ) const
+{
+  return theValue;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationPayload :: copyTo
+|-----------------------------------------------------------------------------*/
+inline void * IAsyncNotificationPayload :: copyTo ( Storage & storage ) const
+{
+  return ( copyValue ( storage, theValue ) );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationPayload :: destroyFunction
+|-----------------------------------------------------------------------------*/
+inline IAsyncNotificationPayload::DestroyFunction
+                 IAsyncNotificationPayload :: destroyFunction ( ) const
+{
+  return destroyValue;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncTypedPayload :: IAsyncTypedPayload
+|-----------------------------------------------------------------------------*/
+template <class Type>
+inline IAsyncTypedPayload<Type> :: IAsyncTypedPayload ( const Type & value ) :
+                   IAsyncNotificationPayload ( &value, copy, destroy )
+{ }
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncTypedPayload :: valueOf
+|                                                                              |
+| Implementation:
+|   The event data points at the copy of the value.
+|-----------------------------------------------------------------------------*/
+template <class Type>
+inline const Type & IAsyncTypedPayload<Type> :: valueOf (
+                                   const INotificationEvent & anEvent )
+{
+  return *( (const Type *)( anEvent.eventData().asCharPtr() ) );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncTypedPayload :: copy
+|                                                                              |
+| Implementation:
+|   Construct a small value in the storage itself.  Keep a pointer to a
+|   copy on the heap for a larger one.
+|-----------------------------------------------------------------------------*/
+template <class Type>
+inline void * IAsyncTypedPayload<Type> :: copy ( Storage & storage,
+                                                 const void * value )
+{
+  if ( sizeof ( Type ) <= inlineSize )
+    return ( new ( storage.bytes ) Type ( *(const Type *)value ) );
+
+  storage.pointer = new Type ( *(const Type *)value );
+  return storage.pointer;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncTypedPayload :: destroy
+|                                                                              |
+| Implementation:
+|   Destroy the value where copy put it.
+|-----------------------------------------------------------------------------*/
+template <class Type>
+inline void IAsyncTypedPayload<Type> :: destroy ( Storage & storage )
+{
+  if ( sizeof ( Type ) <= inlineSize )
+    ((Type *)(storage.bytes))->~Type();
+  else
+    delete (Type *)(storage.pointer);
+}
+
+// Resume compiler default packing.
+#pragma pack()
+
+#endif // _IASYNPAY_
+
\ No newline at end of file
@@ -0,0 +1,172 @@
+/*******************************************************************************
+* FILE NAME: iasynpol.cpp
+*
+* DESCRIPTION:
+*   Functions to implement the class(es):
+*     IAsyncNotifierPollThread
+*
+* COPYRIGHT:
+*   Licensed Materials - Property of IBM
+*   (C) Copyright IBM Corporation 1995
+*   All Rights Reserved
+*   US Government Users Restricted Rights - Use, duplication, or disclosure
+*   restricted by GSA ADP Schedule Contract with IBM Corp.
+*
+*******************************************************************************/
+#ifdef __linux__
+  #include <errno.h>
+  #include <unistd.h>
+  #include <sys/eventfd.h>
+#endif
+
+#include <iasynpol.hpp>
+
+#ifndef _ITHREAD_
+  #include <ithread.hpp>
+#endif
+
+#ifndef _IEVNTSEM_
+  #include <ievntsem.hpp>
+#endif
+
+#ifndef _IHANDLE_
+  #include <ihandle.hpp>
+#endif
+
+#ifndef _IEXCEPT_
+  #include <iexcept.hpp>
+#endif
+
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierPollThread :: IAsyncNotifierPollThread
+|
+| Implementation:
+|   On Linux create a non-blocking eventfd.  On OS/2 use the handle of the
+|     base class's event sem, which is manual reset so that the application
+|     sees it posted until dispatchPending resets it.
+|   Nothing dispatches until the application sees the ready handle, so set
+|   the waiting flag now.  The queue is empty, so there is nothing to signal.
+|-----------------------------------------------------------------------------*/
+IAsyncNotifierPollThread :: IAsyncNotifierPollThread ( ) :
+                   IAsyncNotifierBackgroundThread ( IEventSem::manualReset ),
+                   ready ( 0 )
+{
+#ifdef __linux__
+  int fd = eventfd ( 0, EFD_NONBLOCK | EFD_CLOEXEC );
+  if ( fd == -1 )
+  {
+    ITHROWSYSTEMERROR ( errno,
+                        "eventfd",
+                        IErrorInfo::accessError,
+                        IException::recoverable );
+  }
+  ready = (unsigned long)fd;
+#else
+  ready = readySemaphore().handle().asUnsigned();
+#endif
+
+  prepareToWait();
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierPollThread :: ~IAsyncNotifierPollThread
+|
+| Implementation:
+|   On Linux close the eventfd.  The event sem is closed by the base class.
+|-----------------------------------------------------------------------------*/
+IAsyncNotifierPollThread :: ~IAsyncNotifierPollThread ( )
+{
+#ifdef __linux__
+  close ( (int)ready );
+#endif
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierPollThread :: isPolled
+|
+| Implementation:
+|   Notifications are dispatched by dispatchPending.
+|-----------------------------------------------------------------------------*/
+IBoolean IAsyncNotifierPollThread :: isPolled ( ) const
+{
+  return true;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierPollThread :: readyHandle
+|
+| Implementation:
+|   Return the eventfd or event sem handle.
+|-----------------------------------------------------------------------------*/
+unsigned long IAsyncNotifierPollThread :: readyHandle ( ) const
+{
+  return ready;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierPollThread :: dispatchPending
+|
+| Implementation:
+|   Mark this thread running so it is not deleted by an observer that deletes
+|     the last notifier.  IAsyncNotifier::dispatchPending deletes it then.
+|   Dispatch one batch.
+|   Reset the ready signal and set the waiting flag.
+|   If events were queued before the flag was set, nobody will signal for
+|     them, so clear the flag and signal again ourselves.
+|-----------------------------------------------------------------------------*/
+unsigned long IAsyncNotifierPollThread :: dispatchPending ( )
+{
+  IASSERTSTATE ( threadId() == IThread::currentId() );
+
+  setIsRunning ( true );
+
+  unsigned long dispatched = dispatchBatch();
+
+  if ( ! ( prepareToWait() ) )
+  {
+    stopWaiting();
+    signalReady();
+  }
+
+  setIsRunning ( false );
+
+  return dispatched;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierPollThread :: signalReady
+|
+| Implementation:
+|   On Linux add one to the eventfd counter, which makes it readable.
+|   Writing can only fail if the counter would overflow, in which case it is
+|   already readable.
+|-----------------------------------------------------------------------------*/
+IAsyncNotifierBackgroundThread & IAsyncNotifierPollThread :: signalReady ( )
+{
+#ifdef __linux__
+  eventfd_write ( (int)ready, 1 );
+#else
+  IAsyncNotifierBackgroundThread::signalReady();
+#endif
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierPollThread :: resetReady
+|
+| Implementation:
+|   On Linux read the eventfd counter, which sets it back to zero.  Reading
+|   fails with EAGAIN if it is already zero.
+|-----------------------------------------------------------------------------*/
+IAsyncNotifierBackgroundThread & IAsyncNotifierPollThread :: resetReady ( )
+{
+#ifdef __linux__
+  eventfd_t count;
+  eventfd_read ( (int)ready, &count );
+#else
+  IAsyncNotifierBackgroundThread::resetReady();
+#endif
+  return *this;
+}
+
\ No newline at end of file
@@ -0,0 +1,97 @@
+/* NOSHIP */
+#ifndef _IASYNPOL_
+#define _IASYNPOL_
+/*******************************************************************************
+* FILE NAME: iasynpol.hpp
+*
+* DESCRIPTION:
+*   Declaration of the class(es):
+*     IAsyncNotifierPollThread - Class for asynchronous notifier threads that
+*                                are dispatched from an application's own
+*                                event loop.
+*
+* COPYRIGHT:
+*   Licensed Materials - Property of IBM
+*   (C) Copyright IBM Corporation 1995
+*   All Rights Reserved
+*   US Government Users Restricted Rights - Use, duplication, or disclosure
+*   restricted by GSA ADP Schedule Contract with IBM Corp.
+*
+*******************************************************************************/
+#ifndef _IASYNBKG_
+  #include <iasynbkg.hpp>
+#endif
+
+// Align classes on four byte boundary, except on Linux (see iatomic.hpp).
+#ifndef __linux__
+  #pragma pack(4)
+#endif
+
+class IAsyncNotifierPollThread : public IAsyncNotifierBackgroundThread {
+/*******************************************************************************
+*
+* This class implements the interface for asynchronous notifier threads that
+* never block waiting for notifications.  The application waits on the ready
+* handle along with its other event sources and calls dispatchPending when it
+* is signaled.
+*
+* On OS/2 the ready handle is the handle of an event semaphore, which can be
+* added to a muxwait semaphore.  On Linux it is an eventfd file descriptor,
+* which polls readable while the handle is signaled.
+*
+*******************************************************************************/
+
+public:
+/*------------------------------ Constructors ----------------------------------
+| You can construct an object of this class as follows:                        |
+|   - With the default constructor.  The ready handle is created and the       |
+|     waiting flag is set, so the first notification signals it.               |
+|-----------------------------------------------------------------------------*/
+IAsyncNotifierPollThread ( );
+
+virtual ~IAsyncNotifierPollThread ( );
+
+/*---------------------------- Polled Dispatching ------------------------------
+| Used by IAsyncNotifier to dispatch from an event loop the application runs.  |
+|   isPolled        - Returns true.                                            |
+|   readyHandle     - Returns the handle that is signaled while notifications  |
+|                     are waiting.                                             |
+|   dispatchPending - Throws an invalid request exception if the current       |
+|                     thread is not this thread.  Dispatches one batch of the  |
+|                     waiting notifications and returns the number dispatched. |
+|                     The ready handle is left signaled if notifications are   |
+|                     still waiting, and is reset otherwise.  Timed            |
+|                     notifications that are due are queued first.             |
+|-----------------------------------------------------------------------------*/
+virtual IBoolean      isPolled        ( ) const;
+virtual unsigned long readyHandle     ( ) const;
+virtual unsigned long dispatchPending ( );
+
+
+protected:
+/*------------------------------ Implementation --------------------------------
+| These functions override the ready signal used by the base class.            |
+|   signalReady - On Linux, makes the eventfd readable.  On OS/2, calls the    |
+|                 base class implementation.                                   |
+|   resetReady  - On Linux, reads the eventfd so it is no longer readable.     |
+|                 On OS/2, calls the base class implementation.                |
+|-----------------------------------------------------------------------------*/
+virtual IAsyncNotifierBackgroundThread & signalReady ( );
+virtual IAsyncNotifierBackgroundThread & resetReady  ( );
+
+
+private:
+// The private copy constructor and assignment operator are not implemented.
+IAsyncNotifierPollThread ( const IAsyncNotifierPollThread & rhs );
+IAsyncNotifierPollThread & operator = ( const IAsyncNotifierPollThread & rhs );
+
+/*--------------------------- Private State Data -----------------------------*/
+unsigned long ready;
+
+}; // IAsyncNotifierPollThread
+
+// Resume compiler default packing.
+#pragma pack()
+
+#endif // _IASYNPOL_
+
\ No newline at end of file
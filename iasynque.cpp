@@ -0,0 +1,868 @@
+/*******************************************************************************
+* FILE NAME: iasynque.cpp
+*
+* DESCRIPTION:
+*   Functions to implement the class(es):
+*     IAsyncNotificationQueue
+*
+* COPYRIGHT:
+*   Licensed Materials - Property of IBM
+*   (C) Copyright IBM Corporation 1995
+*   All Rights Reserved
+*   US Government Users Restricted Rights - Use, duplication, or disclosure
+*   restricted by GSA ADP Schedule Contract with IBM Corp.
+*
+*******************************************************************************/
+#include <iasynque.hpp>
+
+#ifdef __IBMCPP__
+  #include <new.h>
+#else
+  #include <new>
+#endif
+
+#ifndef _IATOMIC_
+  #include <iatomic.hpp>
+#endif
+
+#ifndef _IASYNTFY_
+  #include <iasyntfy.hpp>
+#endif
+
+#ifndef _IASYNTHR_
+  #include <iasynthr.hpp>
+#endif
+
+#ifndef _IASYNTMR_
+  #include <iasyntmr.hpp>
+#endif
+
+#ifndef _IASYNMTR_
+  #include <iasynmtr.hpp>
+#endif
+
+#ifndef _INOTIFEV_
+  #include <inotifev.hpp>
+#endif
+
+#ifndef _IASYNPAY_
+  #include <iasynpay.hpp>
+#endif
+
+#ifndef _IEXCEPT_
+  #include <iexcept.hpp>
+#endif
+
+// The number of free nodes refillStorage gives the pool.
+static const unsigned long refillBlocks = 256;
+
+/*------------------------------------------------------------------------------
+| Function Name: isMarker
+|
+| Implementation:
+|   Return whether the id is one of the notifications IAsyncNotifier and
+|   the dispatch thread send themselves.  These are never shown to
+|   notificationCleanUp.
+|-----------------------------------------------------------------------------*/
+static IBoolean isMarker ( const INotificationId & nId )
+{
+  return ( ( nId == IAsyncNotifierThread::deleteThisId ) ||
+           ( nId == IAsyncNotifierThread::coalescedId ) ||
+           ( nId == IAsyncNotificationTimers::insertId ) ||
+           ( nId == IAsyncNotifierThread::closeId ) );
+}
+
+//------------------------------------------------------------------------------
+// A queued notification.  Each lane is a singly linked list that always
+// starts with an already removed (or stub) link.  Producers exchange
+// themselves into head and then link the previous head to themselves.  The
+// dispatch thread is the only one that ever follows or changes tail.
+//
+// When the dispatch thread first sees a node it links it back to the node
+// before it and into the list of pending nodes of its IAsyncNotifier.  That
+// list has the nodes of all lanes, so each node remembers its lane.  These
+// links are only used on the dispatch thread.
+//
+// The node also keeps the handle of its IAsyncNotifier, taken while the
+// sender still has the object, the clock count when it was added, for the
+// metrics of the dispatch thread, and the copy of the value sent with the
+// notification, if there is one.  The event data of the node's event points
+// at the copy.  The value is declared before the event so that a node
+// built from an id can copy the value first and construct its event just
+// once.
+//------------------------------------------------------------------------------
+class IAsyncNotificationNode : public IAsyncNotificationQueue::Link
+{
+public:
+  IAsyncNotificationNode ( const INotificationEvent & anEvent,
+                           IAsyncNotificationQueue::Lane * queueLane,
+                           const IAsyncNotificationPayload * payload );
+  IAsyncNotificationNode ( const INotificationId & nId,
+                           IAsyncNotifier & notifier,
+                           IAsyncNotificationQueue::Lane * queueLane,
+                           const IAsyncNotificationPayload * payload );
+  ~IAsyncNotificationNode ( );
+
+  IAsyncNotificationPayload::Storage  value;
+  IAsyncNotificationPayload::DestroyFunction destroyValue;
+  INotificationEvent                  event;
+  IAsyncNotificationQueue::Lane     * lane;
+  IBoolean                            cancelled;
+  IBoolean                            indexed;
+  IAsyncNotificationQueue::Link     * previous;
+  IAsyncNotificationNode            * previousForNotifier;
+  IAsyncNotificationNode            * nextForNotifier;
+  unsigned long                       handleIndex;
+  unsigned long                       handleGeneration;
+  unsigned long                       addedTime;
+};
+
+IAsyncNotificationNode :: IAsyncNotificationNode (
+                            const INotificationEvent & anEvent,
+                            IAsyncNotificationQueue::Lane * queueLane,
+                            const IAsyncNotificationPayload * payload ) :
+                   destroyValue ( 0 ),
+                   event ( anEvent ),
+                   lane ( queueLane ),
+                   cancelled ( false ),
+                   indexed ( false ),
+                   previous ( 0 ),
+                   previousForNotifier ( 0 ),
+                   nextForNotifier ( 0 ),
+                   handleIndex ( ((IAsyncNotifier &)(anEvent.notifier()))
+                                   .handleIndex ),
+                   handleGeneration ( ((IAsyncNotifier &)(anEvent.notifier()))
+                                        .handleGeneration ),
+                   addedTime ( IAsyncNotificationMetrics::clock() )
+{
+  next = 0;
+
+  if ( payload != 0 )
+  {
+    event.setEventData ( IEventData ( payload->copyTo ( value ) ) );
+    destroyValue = payload->destroyFunction();
+  }
+}
+
+IAsyncNotificationNode :: IAsyncNotificationNode (
+                            const INotificationId & nId,
+                            IAsyncNotifier & notifier,
+                            IAsyncNotificationQueue::Lane * queueLane,
+                            const IAsyncNotificationPayload * payload ) :
+                   destroyValue ( payload ? payload->destroyFunction() : 0 ),
+                   event ( nId, notifier, true,
+                           payload ? IEventData ( payload->copyTo ( value ) )
+                                   : IEventData() ),
+                   lane ( queueLane ),
+                   cancelled ( false ),
+                   indexed ( false ),
+                   previous ( 0 ),
+                   previousForNotifier ( 0 ),
+                   nextForNotifier ( 0 ),
+                   handleIndex ( notifier.handleIndex ),
+                   handleGeneration ( notifier.handleGeneration ),
+                   addedTime ( IAsyncNotificationMetrics::clock() )
+{
+  next = 0;
+}
+
+IAsyncNotificationNode :: ~IAsyncNotificationNode ( )
+{
+  if ( destroyValue != 0 )
+    destroyValue ( value );
+}
+
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationQueue :: IAsyncNotificationQueue
+|
+| Implementation:
+|   Both ends of an empty lane are its stub link.
+|   The pool hands out storage for nodes.
+|   The queue starts out empty with no capacity limit.  Only a queue that
+|   can be full needs the semaphores to wait for room.
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationQueue :: IAsyncNotificationQueue (
+                             unsigned long numberOfLanes,
+                             unsigned long maximumFree,
+                             IBoolean canBeFull ) :
+                   IBase ( ),
+                   lanes ( 0 ),
+                   laneCount ( numberOfLanes ),
+                   removedFrom ( 0 ),
+                   nodePool ( sizeof ( IAsyncNotificationNode ), maximumFree ),
+                   count ( 0 ),
+                   maxCount ( 0 ),
+                   roomKey ( 0 ),
+                   roomEventSem ( 0 ),
+                   roomWanted ( 0 ),
+                   removedPinned ( false )
+{
+  IASSERTPARM ( laneCount != 0 );
+
+  if ( canBeFull )
+  {
+    roomKey = new IPrivateResource;
+    roomEventSem = new IEventSem;
+  }
+
+  lanes = new Lane [laneCount];
+  for ( unsigned long i = 0; i < laneCount; i++ )
+  {
+    Lane & lane = lanes[i];
+    lane.stub.next = 0;
+    lane.head = &(lane.stub);
+    lane.tail = &(lane.stub);
+    lane.lastIndexed = &(lane.stub);
+  }
+  removedFrom = lanes;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationQueue :: ~IAsyncNotificationQueue
+|
+| Implementation:
+|   Delete every node, including the ones at the tails.  There are no more
+|   IAsyncNotifier objects for this thread, so the index can be ignored.
+|   Then delete the semaphores, if there are any.
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationQueue :: ~IAsyncNotificationQueue ( )
+{
+  for ( unsigned long i = 0; i < laneCount; i++ )
+  {
+    Link * link = lanes[i].tail;
+    while ( link != 0 )
+    {
+      Link * nextLink = link->next;
+      if ( link != &(lanes[i].stub) )
+        deleteNode ( (IAsyncNotificationNode *)link );
+      link = nextLink;
+    }
+  }
+
+  delete [] lanes;
+  delete roomEventSem;
+  delete roomKey;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationQueue :: addAsLast
+|
+| Implementation:
+|   Copy the event into a new node in storage from the pool.  The node
+|   notes the time and keeps a copy of the value sent with it.  If copying
+|   throws, give the storage back and pass the exception on.  Add the node
+|   to the lane.
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationQueue & IAsyncNotificationQueue :: addAsLast (
+                                     const INotificationEvent & anEvent,
+                                     unsigned long lane,
+                                     const IAsyncNotificationPayload * payload )
+{
+  IASSERTPARM ( lane < laneCount );
+
+  Lane & theLane = lanes[lane];
+  void * block = nodePool.allocate();
+  IAsyncNotificationNode * node;
+
+  try
+  {
+    node = new ( block ) IAsyncNotificationNode ( anEvent, &theLane,
+                                                  payload );
+  }
+  catch ( ... )
+  {
+    nodePool.discard ( block );
+    throw;
+  }
+
+  return ( addNode ( node, theLane ) );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationQueue :: addAsLast
+|
+| Implementation:
+|   Construct the event right in a new node in storage from the pool, so
+|   it is never copied.  If that throws, give the storage back and pass the
+|   exception on.  Add the node to the lane.
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationQueue & IAsyncNotificationQueue :: addAsLast (
+                                     const INotificationId & nId,
+                                     IAsyncNotifier & notifier,
+                                     unsigned long lane,
+                                     const IAsyncNotificationPayload * payload )
+{
+  IASSERTPARM ( lane < laneCount );
+
+  Lane & theLane = lanes[lane];
+  void * block = nodePool.allocate();
+  IAsyncNotificationNode * node;
+
+  try
+  {
+    node = new ( block ) IAsyncNotificationNode ( nId, notifier, &theLane,
+                                                  payload );
+  }
+  catch ( ... )
+  {
+    nodePool.discard ( block );
+    throw;
+  }
+
+  return ( addNode ( node, theLane ) );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationQueue :: addNode
+|
+| Implementation:
+|   Count the node before it can be seen, so the count never drops below
+|     zero.
+|   Exchange the node into the lane's head.  This orders us against every
+|     other thread.
+|   Link the previous head to the node.  Until this store the dispatch thread
+|     sees the lane end at the previous head.
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationQueue & IAsyncNotificationQueue :: addNode (
+                                     IAsyncNotificationNode * node,
+                                     Lane & lane )
+{
+  IAtomic::increment ( count );
+
+  Link * previous = (Link *)IAtomic::exchange (
+                              *(void * volatile *)(&(lane.head)), node );
+  previous->next = node;
+
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationQueue :: setCapacity
+|
+| Implementation:
+|   A light queue has nothing to wait for room with, so it can not be full.
+|   Save the new capacity.  A larger one may leave room for a waiting
+|   thread, so check for that.
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationQueue & IAsyncNotificationQueue :: setCapacity (
+                                                    unsigned long maximum )
+{
+  if ( ( maximum != 0 ) && ( roomKey == 0 ) )
+  {
+    IInvalidRequest exc ( "A light queue can not be given a capacity.",
+                          0, IException::recoverable );
+    ITHROW ( exc );
+  }
+
+  maxCount = maximum;
+  return ( madeRoom() );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationQueue :: capacity
+|
+| Implementation:
+|   Return the capacity.
+|-----------------------------------------------------------------------------*/
+unsigned long IAsyncNotificationQueue :: capacity ( ) const
+{
+  return maxCount;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationQueue :: length
+|
+| Implementation:
+|   Return the count of queued notifications.
+|-----------------------------------------------------------------------------*/
+unsigned long IAsyncNotificationQueue :: length ( ) const
+{
+  return ( (unsigned long)IAtomic::value ( count ) );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationQueue :: isFull
+|
+| Implementation:
+|   Compare the count of queued notifications with the capacity.
+|-----------------------------------------------------------------------------*/
+IBoolean IAsyncNotificationQueue :: isFull ( ) const
+{
+  unsigned long maximum = maxCount;
+
+  return ( ( maximum != 0 ) &&
+           ( IAtomic::value ( count ) >= (long)maximum ) );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationQueue :: waitForRoom
+|
+| Implementation:
+|   Get the room semaphore, so only one thread at a time uses the event sem.
+|   While the queue is full:
+|     Reset the event sem, then set the flag that asks the dispatch thread
+|       to post it.
+|     If the queue is still full, wait on the event sem.
+|     Clear the flag.
+|   The dispatch thread lowers the count before it looks at the flag, so it
+|   either posts after our reset or we see the lower count.
+|   A light queue is never full, so there is nothing to wait for.
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationQueue & IAsyncNotificationQueue :: waitForRoom ( )
+{
+  if ( roomKey == 0 )
+    return *this;
+
+  IResourceLock roomLock ( *roomKey );
+
+  while ( isFull() )
+  {
+    roomEventSem->reset();
+    IAtomic::exchange ( roomWanted, 1 );
+
+    if ( isFull() )
+      roomEventSem->wait();
+
+    IAtomic::exchange ( roomWanted, 0 );
+  }
+
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationQueue :: isEmpty
+|
+| Implementation:
+|   For each lane, throw away cancelled nodes at the front, then see if
+|   anything is linked after the tail.
+|-----------------------------------------------------------------------------*/
+IBoolean IAsyncNotificationQueue :: isEmpty ( )
+{
+  for ( unsigned long i = 0; i < laneCount; i++ )
+  {
+    removeCancelled ( lanes[i] );
+    if ( lanes[i].tail->next != 0 )
+      return false;
+  }
+
+  return true;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationQueue :: numberOfElements
+|
+| Implementation:
+|   Count the nodes after the tail of each lane that are not cancelled.
+|-----------------------------------------------------------------------------*/
+unsigned long IAsyncNotificationQueue :: numberOfElements (
+                                           unsigned long maximum ) const
+{
+  unsigned long count = 0;
+
+  for ( unsigned long i = 0; i < laneCount; i++ )
+  {
+    IAsyncNotificationNode * node
+                              = (IAsyncNotificationNode *)(lanes[i].tail->next);
+    while ( ( node != 0 ) && ( ( maximum == 0 ) || ( count < maximum ) ) )
+    {
+      if ( ! ( node->cancelled ) )
+        count++;
+      node = (IAsyncNotificationNode *)(node->next);
+    }
+  }
+
+  return count;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationQueue :: removeFirst
+|
+| Implementation:
+|   Find the highest lane with a node after its tail.
+|   The first node becomes the new tail and the old tail is deleted.  The
+|   new tail's event was removed, but stays until the node is deleted.
+|   Pin the handle of its notifier, then take it out of the notifier's
+|   index, which only looks at the notifier if the pin worked.
+|   Count it as removed and see if a thread is waiting for room.
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationQueue & IAsyncNotificationQueue :: removeFirst ( )
+{
+  unsigned long i = laneCount;
+  while ( i != 0 )
+  {
+    i--;
+    removeCancelled ( lanes[i] );
+    if ( lanes[i].tail->next != 0 )
+      break;
+  }
+
+  Lane & lane = lanes[i];
+  removedFrom = &lane;
+
+  Link * oldTail = lane.tail;
+  lane.tail = oldTail->next;
+
+  IAsyncNotificationNode * node = (IAsyncNotificationNode *)(lane.tail);
+  removedPinned = IAsyncNotifier::pinHandle ( node->handleIndex,
+                                              node->handleGeneration );
+  removeFromIndex ( node, removedPinned );
+  if ( lane.lastIndexed == oldTail )
+    lane.lastIndexed = lane.tail;
+
+  if ( oldTail != &(lane.stub) )
+    deleteNode ( (IAsyncNotificationNode *)oldTail );
+
+  IAtomic::decrement ( count );
+
+  return ( madeRoom() );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationQueue :: lastRemoved
+|
+| Implementation:
+|   The last removed notification is in the tail node of the lane it was
+|   removed from.
+|-----------------------------------------------------------------------------*/
+const INotificationEvent & IAsyncNotificationQueue :: lastRemoved ( ) const
+{
+  return ( ((IAsyncNotificationNode *)(removedFrom->tail))->event );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationQueue :: lastRemovedTime
+|
+| Implementation:
+|   The tail node of the lane also holds the time it was added.
+|-----------------------------------------------------------------------------*/
+unsigned long IAsyncNotificationQueue :: lastRemovedTime ( ) const
+{
+  return ( ((IAsyncNotificationNode *)(removedFrom->tail))->addedTime );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationQueue :: lastRemovedHasPayload
+|
+| Implementation:
+|   Only a node with a copy of a value has a function to destroy it.
+|-----------------------------------------------------------------------------*/
+IBoolean IAsyncNotificationQueue :: lastRemovedHasPayload ( ) const
+{
+  return ( ((IAsyncNotificationNode *)(removedFrom->tail))->destroyValue
+             != 0 );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationQueue :: lastRemovedIsPinned
+|
+| Implementation:
+|   removeFirst saved whether the pin worked.
+|-----------------------------------------------------------------------------*/
+IBoolean IAsyncNotificationQueue :: lastRemovedIsPinned ( ) const
+{
+  return removedPinned;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationQueue :: lastRemovedHandle
+|
+| Implementation:
+|   The tail node of the lane also holds the handle.
+|-----------------------------------------------------------------------------*/
+unsigned long IAsyncNotificationQueue :: lastRemovedHandle ( ) const
+{
+  return ( ((IAsyncNotificationNode *)(removedFrom->tail))->handleIndex );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationQueue :: removeAllFor
+|
+| Implementation:
+|   Index the nodes added since we last looked.
+|   Walk the notifier's index.  Clean up the event of each node, unless it
+|   has a payload or is a marker, and remove it.  Removing the node destroys
+|   the payload.
+|-----------------------------------------------------------------------------*/
+unsigned long IAsyncNotificationQueue :: removeAllFor (
+                                          const IAsyncNotifier & asyncNotifier )
+{
+  unsigned long removed = 0;
+
+  indexAdded();
+
+  while ( asyncNotifier.pendingEvents != 0 )
+  {
+    IAsyncNotificationNode * node = asyncNotifier.pendingEvents;
+
+    if ( ( node->destroyValue == 0 ) &&
+         ( ! isMarker ( node->event.notificationId() ) ) )
+      asyncNotifier.notificationCleanUp ( node->event );
+    removeNode ( node );
+    removed++;
+  }
+
+  return removed;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationQueue :: hasPendingFor
+|
+| Implementation:
+|   Index the nodes added since we last looked, then see if the notifier's
+|   index is empty.  Cancelled nodes are not indexed.
+|-----------------------------------------------------------------------------*/
+IBoolean IAsyncNotificationQueue :: hasPendingFor (
+                                      const IAsyncNotifier & asyncNotifier )
+{
+  indexAdded();
+
+  return ( asyncNotifier.pendingEvents != 0 );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationQueue :: removeExcess
+|
+| Implementation:
+|   Index the nodes added since we last looked, so every node up to the
+|   last one indexed is linked back to the node before it.
+|   Starting with the lowest lane, walk the indexed nodes from the front
+|   while the queue is over its capacity.  Skip cancelled nodes and the
+|   markers IAsyncNotifier needs.  Pin the handle of each other node.  If that
+|   works, clean up its event, unless it has a payload, and unpin.  Remove
+|   the node either way.
+|-----------------------------------------------------------------------------*/
+unsigned long IAsyncNotificationQueue :: removeExcess ( )
+{
+  unsigned long removed = 0;
+
+  if ( maxCount == 0 )
+    return removed;
+
+  indexAdded();
+
+  for ( unsigned long i = 0;
+        ( i < laneCount ) && ( IAtomic::value ( count ) > (long)maxCount );
+        i++ )
+  {
+    Link * last = lanes[i].lastIndexed;
+    Link * link = lanes[i].tail;
+
+    while ( ( link != last ) &&
+            ( IAtomic::value ( count ) > (long)maxCount ) )
+    {
+      IAsyncNotificationNode * node = (IAsyncNotificationNode *)(link->next);
+      link = node;
+
+      if ( ( node->cancelled ) ||
+           ( isMarker ( node->event.notificationId() ) ) )
+        continue;
+
+      unsigned long handle = node->handleIndex;
+      IBoolean pinned = IAsyncNotifier::pinHandle ( handle,
+                                                    node->handleGeneration );
+      if ( ( pinned ) && ( node->destroyValue == 0 ) )
+      {
+        IAsyncNotifier * theNotifier
+                           = (IAsyncNotifier *)(&(node->event.notifier()));
+        theNotifier->notificationCleanUp ( node->event );
+      }
+
+      link = node->previous;
+      if ( node == last )
+        last = link;
+      removeNode ( node, pinned );
+      if ( pinned )
+        IAsyncNotifier::unpinHandle ( handle );
+      removed++;
+    }
+  }
+
+  return removed;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationQueue :: refillStorage
+|
+| Implementation:
+|   Refill the pool with enough blocks for a busy queue.
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationQueue & IAsyncNotificationQueue :: refillStorage ( )
+{
+  nodePool.refill ( refillBlocks );
+
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationQueue :: indexAdded
+|
+| Implementation:
+|   In each lane, follow the nodes after the last one indexed.  Link each
+|   one back to the node before it.  Pin the handle of its notifier and, if
+|   that works, add it to the front of the notifier's index and unpin.  The
+|   node of a deleted notifier is never indexed.
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationQueue & IAsyncNotificationQueue :: indexAdded ( )
+{
+  for ( unsigned long i = 0; i < laneCount; i++ )
+  {
+    Link * & lastIndexed = lanes[i].lastIndexed;
+    IAsyncNotificationNode * node;
+
+    while ( ( node = (IAsyncNotificationNode *)(lastIndexed->next) ) != 0 )
+    {
+      node->previous = lastIndexed;
+
+      if ( ( ! ( node->cancelled ) ) &&
+           ( node->handleIndex != 0 ) &&
+           ( IAsyncNotifier::pinHandle ( node->handleIndex,
+                                         node->handleGeneration ) ) )
+      {
+        IAsyncNotifier * theNotifier
+                           = (IAsyncNotifier *)(&(node->event.notifier()));
+
+        node->nextForNotifier = theNotifier->pendingEvents;
+        if ( node->nextForNotifier != 0 )
+          node->nextForNotifier->previousForNotifier = node;
+        theNotifier->pendingEvents = node;
+        node->indexed = true;
+
+        IAsyncNotifier::unpinHandle ( node->handleIndex );
+      }
+
+      lastIndexed = node;
+    }
+  }
+
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationQueue :: removeFromIndex
+|
+| Implementation:
+|   If the node is in its notifier's index, unlink it.  If the notifier
+|   was deleted, the rest of its index is only linked among the nodes, so
+|   do not set its first node.
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationQueue & IAsyncNotificationQueue
+                            :: removeFromIndex ( IAsyncNotificationNode * node,
+                                                 IBoolean notifierExists )
+{
+  if ( node->indexed )
+  {
+    if ( node->previousForNotifier != 0 )
+    {
+      node->previousForNotifier->nextForNotifier = node->nextForNotifier;
+    }
+    else if ( notifierExists )
+    {
+      IAsyncNotifier * theNotifier
+                         = (IAsyncNotifier *)(&(node->event.notifier()));
+      theNotifier->pendingEvents = node->nextForNotifier;
+    }
+
+    if ( node->nextForNotifier != 0 )
+      node->nextForNotifier->previousForNotifier = node->previousForNotifier;
+
+    node->previousForNotifier = 0;
+    node->nextForNotifier = 0;
+    node->indexed = false;
+  }
+
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationQueue :: removeCancelled
+|
+| Implementation:
+|   Remove nodes from the front of the lane while they are cancelled.
+|   Cancelled nodes are never in an index.
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationQueue & IAsyncNotificationQueue
+                            :: removeCancelled ( Lane & lane )
+{
+  while ( ( lane.tail->next != 0 ) &&
+          ( ((IAsyncNotificationNode *)(lane.tail->next))->cancelled ) )
+  {
+    Link * oldTail = lane.tail;
+    lane.tail = oldTail->next;
+    if ( lane.lastIndexed == oldTail )
+      lane.lastIndexed = lane.tail;
+
+    if ( oldTail != &(lane.stub) )
+      deleteNode ( (IAsyncNotificationNode *)oldTail );
+  }
+
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationQueue :: removeNode
+|
+| Implementation:
+|   Take the node out of its notifier's index, which only looks at the
+|   notifier if it still exists, and count it as removed.
+|   If a node is linked after it, unlink and delete it.
+|   Else, it may be the head that a producer is about to link to, so only
+|     mark it cancelled.  It will be thrown away when it reaches the front.
+|   See if a thread is waiting for room.
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationQueue & IAsyncNotificationQueue
+                            :: removeNode ( IAsyncNotificationNode * node,
+                                            IBoolean notifierExists )
+{
+  removeFromIndex ( node, notifierExists );
+  IAtomic::decrement ( count );
+
+  Link * nextLink = node->next;
+  if ( nextLink != 0 )
+  {
+    node->previous->next = nextLink;
+    ((IAsyncNotificationNode *)nextLink)->previous = node->previous;
+    if ( node->lane->lastIndexed == node )
+      node->lane->lastIndexed = node->previous;
+    deleteNode ( node );
+  }
+  else
+  {
+    node->cancelled = true;
+  }
+
+  return ( madeRoom() );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationQueue :: deleteNode
+|
+| Implementation:
+|   Destroy the node and give its storage back to the pool.
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationQueue & IAsyncNotificationQueue
+                            :: deleteNode ( IAsyncNotificationNode * node )
+{
+  node->~IAsyncNotificationNode();
+  nodePool.release ( node );
+
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationQueue :: madeRoom
+|
+| Implementation:
+|   If the queue is not full and a thread asked to be told, clear the flag
+|   and post the event sem it waits on.  Nobody waits on a light queue.
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationQueue & IAsyncNotificationQueue :: madeRoom ( )
+{
+  if ( ( roomEventSem != 0 ) &&
+       ( ! ( isFull() ) ) &&
+       ( IAtomic::exchange ( roomWanted, 0 ) != 0 ) )
+    roomEventSem->post();
+
+  return *this;
+}
+
\ No newline at end of file
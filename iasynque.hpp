@@ -0,0 +1,264 @@
+/* NOSHIP */
+#ifndef _IASYNQUE_
+#define _IASYNQUE_
+/*******************************************************************************
+* FILE NAME: iasynque.hpp
+*
+* DESCRIPTION:
+*   Declaration of the class(es):
+*     IAsyncNotificationQueue - Queue of notifications waiting for dispatch.
+*
+* COPYRIGHT:
+*   Licensed Materials - Property of IBM
+*   (C) Copyright IBM Corporation 1995
+*   All Rights Reserved
+*   US Government Users Restricted Rights - Use, duplication, or disclosure
+*   restricted by GSA ADP Schedule Contract with IBM Corp.
+*
+*******************************************************************************/
+#ifndef _IBASE_
+  #include <ibase.hpp>
+#endif
+
+// Other dependency classes:
+#ifndef _IASYNMEM_
+  #include <iasynmem.hpp>
+#endif
+
+#ifndef _IEVNTSEM_
+  #include <ievntsem.hpp>
+#endif
+
+#ifndef _INOTIFY_
+  #include <inotify.hpp>
+#endif
+
+#ifndef _IRESLOCK_
+  #include <ireslock.hpp>
+#endif
+
+class INotificationEvent;
+class IAsyncNotifier;
+class IAsyncNotificationNode;
+class IAsyncNotificationPayload;
+
+// Align classes on four byte boundary, except on Linux (see iatomic.hpp).
+#ifndef __linux__
+  #pragma pack(4)
+#endif
+
+class IAsyncNotificationQueue : public IBase {
+/*******************************************************************************
+*
+* This class implements the notification queue of an asynchronous notifier
+* thread.  Any number of threads may add notifications to the queue at the
+* same time without a semaphore.  Only the dispatch thread that owns the
+* queue may look at or remove notifications.
+*
+* The queue is made up of a number of lanes.  Notifications are always
+* removed from the highest numbered lane that has any.  Within a lane they
+* are removed in the order in which they were added.  In particular, the
+* notifications added to a lane by any one thread are always removed in the
+* order that thread added them.
+*
+* The dispatch thread keeps an index of the pending notifications of each
+* IAsyncNotifier in the IAsyncNotifier itself.  Removing the notifications
+* of one IAsyncNotifier only visits its own notifications and the ones that
+* were added since the dispatch thread last looked at the queue.
+*
+* Each queued notification also notes the handle of its IAsyncNotifier.  An
+* IAsyncNotifier deleted on another thread leaves its notifications in the
+* queue.  The dispatch thread pins the handle before it looks at the object,
+* so it finds out that the object is gone without touching it.
+*
+* The copies of queued notifications are kept in storage from a pool owned
+* by the queue, so they do not use the heap once the pool has warmed up.
+*
+* Each queued notification keeps the time it was added, so the dispatch
+* thread can tell how long it waited.
+*
+* The queue can be given a capacity.  It does not refuse notifications when
+* it is full; it only reports that it is full, lets adding threads wait for
+* room and lets the dispatch thread throw away the oldest notifications.
+*
+*******************************************************************************/
+
+public:
+/*------------------------------ Constructors ----------------------------------
+| You can construct an object of this class as follows:                        |
+|   - With the number of lanes.  The default is one.  The queue is initially   |
+|     empty.                                                                   |
+|   - With the number of lanes, the number of free blocks of storage to keep   |
+|     for queued notifications and false, for a light queue that can never be  |
+|     given a capacity.  It has no semaphores, so one can be kept for each     |
+|     IAsyncNotifier.                                                          |
+| The destructor deletes any notifications that are still queued.              |
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationQueue ( unsigned long numberOfLanes = 1,
+                          unsigned long maximumFree = 1024,
+                          IBoolean canBeFull = true );
+
+virtual ~IAsyncNotificationQueue ( );
+
+/*-------------------------------- Adding --------------------------------------
+| This function may be called on any thread.                                   |
+|   addAsLast - Places a copy of the notification at the end of the passed     |
+|               lane, or constructs a notification with the passed id from     |
+|               the passed notifier right in the queue, so that it is never    |
+|               copied.  Lanes are numbered from zero.  An invalid parameter   |
+|               exception is thrown if there is no such lane.  If a payload is |
+|               passed, a copy of its value is kept with the notification and  |
+|               the event data of the notification points at it.  The value is |
+|               destroyed when the notification is deleted.                    |
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationQueue & addAsLast (
+                            const INotificationEvent & anEvent,
+                            unsigned long lane = 0,
+                            const IAsyncNotificationPayload * payload = 0 );
+IAsyncNotificationQueue & addAsLast (
+                            const INotificationId & nId,
+                            IAsyncNotifier & notifier,
+                            unsigned long lane = 0,
+                            const IAsyncNotificationPayload * payload = 0 );
+
+/*------------------------------- Capacity -------------------------------------
+| These functions may be called on any thread.                                 |
+|   setCapacity - Sets the number of notifications the queue holds when it is  |
+|                 full.  Zero means it is never full.  The default is zero.    |
+|                 A light queue throws an invalid request exception for any    |
+|                 other capacity.                                              |
+|   capacity    - Returns the capacity.                                        |
+|   length      - Returns the number of notifications in the queue.  One that  |
+|                 is still being added may already be counted.                 |
+|   isFull      - Returns true if the queue holds at least capacity            |
+|                 notifications.                                               |
+|   waitForRoom - Returns when the queue is not full.  Only one thread at a    |
+|                 time waits for the dispatch thread to make room; others wait |
+|                 for it.  Since a thread can add as soon as it sees room, the |
+|                 queue can go over its capacity by one notification for each  |
+|                 thread that adds at the same time.                           |
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationQueue & setCapacity ( unsigned long maximum );
+unsigned long             capacity    ( ) const;
+unsigned long             length      ( ) const;
+IBoolean                  isFull      ( ) const;
+IAsyncNotificationQueue & waitForRoom ( );
+
+/*------------------------------- Removing -------------------------------------
+| These functions may only be called on the dispatch thread.                   |
+|   isEmpty          - Returns true if there are no notifications in the       |
+|                      queue.  A notification that is still being added on     |
+|                      another thread may not be seen until that thread's      |
+|                      addAsLast returns.                                      |
+|   numberOfElements - Returns the number of notifications in the queue,       |
+|                      counting no further than the passed maximum.  A maximum |
+|                      of zero counts all of them.                             |
+|   removeFirst      - Removes the notification at the front of the highest    |
+|                      lane that is not empty.  The queue must not be empty.   |
+|                      The handle of its IAsyncNotifier is pinned, unless the  |
+|                      object has been deleted.  The caller must unpin it.     |
+|   lastRemoved      - Returns the notification most recently removed by       |
+|                      removeFirst.  It stays valid until the next call to     |
+|                      isEmpty or removeFirst, so it can be dispatched         |
+|                      without being copied.                                   |
+|   lastRemovedTime  - Returns the IAsyncNotificationMetrics::clock count      |
+|                      when the notification returned by lastRemoved was       |
+|                      added.                                                  |
+|   lastRemovedHasPayload - Returns true if the notification returned by       |
+|                      lastRemoved was added with a payload.                   |
+|   lastRemovedIsPinned - Returns true if removeFirst pinned the handle of the |
+|                      IAsyncNotifier of the notification.  If not, the        |
+|                      object has been deleted and must not be used.           |
+|   lastRemovedHandle - Returns the index of the handle to unpin.              |
+|   removeAllFor     - Deletes every notification of the passed                |
+|                      IAsyncNotifier, after calling its notificationCleanUp   |
+|                      function for each one without a payload, and returns    |
+|                      the number deleted.                                     |
+|                      The order of the remaining notifications is not         |
+|                      changed.  lastRemoved is not affected.                  |
+|   hasPendingFor    - Returns true if there are notifications of the passed   |
+|                      IAsyncNotifier in the queue.  lastRemoved is not        |
+|                      affected.                                               |
+|   removeExcess     - Deletes the oldest notifications, starting with the     |
+|                      lowest lane, until the queue is at its capacity, and    |
+|                      returns the number deleted.  notificationCleanUp is     |
+|                      called for each one without a payload.  The             |
+|                      notifications used by IAsyncNotifier to delete itself   |
+|                      and to dispatch coalesced notifications are never       |
+|                      deleted.  Those of deleted objects are deleted without  |
+|                      being cleaned up.                                       |
+|-----------------------------------------------------------------------------*/
+IBoolean                   isEmpty          ( );
+unsigned long              numberOfElements ( unsigned long maximum ) const;
+IAsyncNotificationQueue &  removeFirst      ( );
+const INotificationEvent & lastRemoved      ( ) const;
+unsigned long              lastRemovedTime  ( ) const;
+IBoolean                   lastRemovedHasPayload ( ) const;
+IBoolean                   lastRemovedIsPinned   ( ) const;
+unsigned long              lastRemovedHandle     ( ) const;
+unsigned long              removeAllFor     (
+                             const IAsyncNotifier & asyncNotifier );
+IBoolean                   hasPendingFor    (
+                             const IAsyncNotifier & asyncNotifier );
+unsigned long              removeExcess     ( );
+
+/*-------------------------------- Storage -------------------------------------
+| This function may only be called on the dispatch thread.                     |
+|   refillStorage - Replaces the free storage for queued notifications with    |
+|                   storage this thread touches first.  Called after the       |
+|                   dispatch thread is moved to other processors.              |
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationQueue & refillStorage ( );
+
+
+private:
+// The private copy constructor and assignment operator are not implemented.
+IAsyncNotificationQueue ( const IAsyncNotificationQueue & rhs );
+IAsyncNotificationQueue & operator = ( const IAsyncNotificationQueue & rhs );
+
+class Lane;
+
+IAsyncNotificationQueue & addNode         ( IAsyncNotificationNode * node,
+                                            Lane & lane );
+IAsyncNotificationQueue & indexAdded      ( );
+IAsyncNotificationQueue & removeFromIndex ( IAsyncNotificationNode * node,
+                                            IBoolean notifierExists );
+IAsyncNotificationQueue & removeCancelled ( Lane & lane );
+IAsyncNotificationQueue & removeNode      ( IAsyncNotificationNode * node,
+                                            IBoolean notifierExists = true );
+IAsyncNotificationQueue & deleteNode      ( IAsyncNotificationNode * node );
+IAsyncNotificationQueue & madeRoom        ( );
+
+/*--------------------------- Private State Data -----------------------------*/
+class Link {
+public:
+  Link * volatile next;
+};
+
+class Lane {
+public:
+  Link            stub;
+  Link * volatile head;
+  Link *          tail;
+  Link *          lastIndexed;
+};
+friend class IAsyncNotificationNode;
+
+Lane *                 lanes;
+unsigned long          laneCount;
+Lane *                 removedFrom;
+IAsyncNotificationPool nodePool;
+volatile long          count;
+unsigned long          maxCount;
+IPrivateResource *     roomKey;
+IEventSem *            roomEventSem;
+volatile long          roomWanted;
+IBoolean               removedPinned;
+
+}; // IAsyncNotificationQueue
+
+// Resume compiler default packing.
+#pragma pack()
+
+#endif // _IASYNQUE_
+
\ No newline at end of file
@@ -0,0 +1,760 @@
+/*******************************************************************************
+* FILE NAME: iasynstr.cpp
+*
+* DESCRIPTION:
+*   Functions to implement the class(es):
+*     IAsyncNotifierThreadPool
+*
+* COPYRIGHT:
+*   Licensed Materials - Property of IBM
+*   (C) Copyright IBM Corporation 1995
+*   All Rights Reserved
+*   US Government Users Restricted Rights - Use, duplication, or disclosure
+*   restricted by GSA ADP Schedule Contract with IBM Corp.
+*
+*******************************************************************************/
+#ifdef __linux__
+  #include <unistd.h>
+  #include <sched.h>
+#endif
+
+#include <iasynstr.hpp>
+
+#ifndef _IASYNTFY_
+  #include <iasyntfy.hpp>
+#endif
+
+#ifndef _IASYNQUE_
+  #include <iasynque.hpp>
+#endif
+
+#ifndef _INOTIFEV_
+  #include <inotifev.hpp>
+#endif
+
+#ifndef _ITHREAD_
+  #include <ithread.hpp>
+#endif
+
+#ifndef _IEVNTSEM_
+  #include <ievntsem.hpp>
+#endif
+
+#ifndef _IEXCEPT_
+  #include <iexcept.hpp>
+#endif
+
+#ifndef _IATOMIC_
+  #include <iatomic.hpp>
+#endif
+
+#ifndef __linux__
+  #define INCL_DOSMISC
+  #define INCL_DOSPROCESS
+  #include <os2.h>
+
+  // Older toolkits do not define the processor count index.
+  #ifndef QSV_NUMPROCESSORS
+    #define QSV_NUMPROCESSORS 26
+  #endif
+#endif
+
+// The number of notifications a worker dispatches from a strand before it
+// gives the other strands on its deque a turn.
+static const unsigned long eventsPerTurn = 64;
+
+// The number of free blocks of storage the queue of a strand keeps.  A
+// strand is made for every IAsyncNotifier, so only a turn's worth of
+// notifications at most is kept.
+static const unsigned long strandFreeBlocks = 16;
+
+/*------------------------------------------------------------------------------
+| Function Name: giveUpTimeSlice
+|
+| Implementation:
+|   Let the other threads that are ready run before this one goes on.
+|-----------------------------------------------------------------------------*/
+static void giveUpTimeSlice ( )
+{
+#ifdef __linux__
+  sched_yield();
+#else
+  DosSleep ( 0 );
+#endif
+}
+
+
+//------------------------------------------------------------------------------
+// The notifications of one IAsyncNotifier dispatched by the pool.  The queue
+// is a light one, so a strand holds no semaphores.  pending counts the
+// notifications added to the queue and not yet dispatched.  While it is not
+// zero, the strand is on a deque or being run by a worker, and only that
+// worker looks at the queue.  runner is the thread running it, so that only
+// it can delete the IAsyncNotifier.
+//------------------------------------------------------------------------------
+class IAsyncNotificationStrand
+{
+public:
+  IAsyncNotificationStrand ( );
+
+  IAsyncNotificationQueue    queue;
+  volatile long              pending;
+  IThreadId                  runner;
+  IBoolean                   deleted;
+  IAsyncNotificationStrand * next;
+};
+
+IAsyncNotificationStrand :: IAsyncNotificationStrand ( ) :
+                   queue ( IAsyncNotifierThread::numberOfPriorities,
+                           strandFreeBlocks, false ),
+                   pending ( 0 ),
+                   runner ( ),
+                   deleted ( false ),
+                   next ( NULL )
+{
+}
+
+
+//------------------------------------------------------------------------------
+// A thread of the pool and its deque of strands that are ready to run.  The
+// deque is only held for a few instructions, so a spin guard protects it.
+// The worker waits on its event sem while waiting is set, with the same
+// handshake the background thread uses.  It posts its stopped event sem
+// when it stops.  Each worker records its own metrics, so dispatching never
+// waits for another worker.
+//------------------------------------------------------------------------------
+class IAsyncNotificationWorker
+{
+public:
+  IAsyncNotificationWorker ( IAsyncNotifierThreadPool & threadPool,
+                             unsigned long workerIndex );
+
+  void                       run     ( );
+  IAsyncNotificationWorker & push    ( IAsyncNotificationStrand * strand );
+  IAsyncNotificationStrand * pop     ( );
+  IBoolean                   isEmpty ( );
+  IAsyncNotificationWorker & wakeUp  ( );
+
+  IAsyncNotifierThreadPool & pool;
+  unsigned long              index;
+  IThread                  * thread;
+  IThreadId                  threadId;
+  volatile long              guard;
+  IAsyncNotificationStrand * first;
+  IAsyncNotificationStrand * last;
+  IEventSem                  readyEventSem;
+  volatile long              waiting;
+  IAsyncNotificationMetrics  metrics;
+  IEventSem                  stoppedEventSem;
+};
+
+IAsyncNotificationWorker :: IAsyncNotificationWorker (
+                              IAsyncNotifierThreadPool & threadPool,
+                              unsigned long workerIndex ) :
+                   pool ( threadPool ),
+                   index ( workerIndex ),
+                   thread ( NULL ),
+                   threadId ( ),
+                   guard ( 0 ),
+                   first ( NULL ),
+                   last ( NULL ),
+                   readyEventSem ( IEventSem::autoReset ),
+                   waiting ( 0 ),
+                   metrics ( ),
+                   stoppedEventSem ( )
+{
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationWorker :: run
+|
+| Implementation:
+|   Until the pool is stopping:
+|     The first worker queues the timed notifications that are due.
+|     Take a strand from our own deque, or steal one, and run it.
+|     Otherwise set the waiting flag.  If there is still no strand
+|       anywhere, wait on the event sem, which the wait also resets.  The
+|       first worker only waits until the next timed notification may be
+|       due.  A signal left over from a wakeUp that came after the last wait
+|       ended just ends the next wait early.
+|     Clear the waiting flag.
+|   Post the stopped semaphore as the very last use of the worker.
+|-----------------------------------------------------------------------------*/
+void IAsyncNotificationWorker :: run ( )
+{
+  while ( IAtomic::value ( pool.stopping ) == 0 )
+  {
+    if ( index == 0 )
+      pool.expireTimers();
+
+    IAsyncNotificationStrand * strand = pop();
+    if ( strand == NULL )
+      strand = pool.steal ( *this );
+
+    if ( strand != NULL )
+    {
+      pool.runStrand ( strand, *this );
+      continue;
+    }
+
+    long timeout = -1;
+    if ( index == 0 )
+    {
+      timeout = pool.timeUntilTimer();
+      if ( timeout == 0 )
+        continue;
+    }
+
+    IAtomic::exchange ( waiting, 1 );
+
+    if ( ! ( pool.hasWork() ) )
+      readyEventSem.timedWait ( timeout );
+
+    IAtomic::exchange ( waiting, 0 );
+  }
+
+  stoppedEventSem.post();
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationWorker :: push
+|
+| Implementation:
+|   Add the strand at the end of the deque under the guard.
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationWorker & IAsyncNotificationWorker :: push (
+                                      IAsyncNotificationStrand * strand )
+{
+  strand->next = NULL;
+
+  IAtomic::acquire ( guard );
+
+  if ( last == NULL )
+    first = strand;
+  else
+    last->next = strand;
+  last = strand;
+
+  IAtomic::release ( guard );
+
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationWorker :: pop
+|
+| Implementation:
+|   Take the strand at the front of the deque under the guard.  Thieves take
+|   from the front too, so strands are run roughly in the order they became
+|   ready.
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationStrand * IAsyncNotificationWorker :: pop ( )
+{
+  IAtomic::acquire ( guard );
+
+  IAsyncNotificationStrand * strand = first;
+  if ( strand != NULL )
+  {
+    first = strand->next;
+    if ( first == NULL )
+      last = NULL;
+  }
+
+  IAtomic::release ( guard );
+
+  return strand;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationWorker :: isEmpty
+|
+| Implementation:
+|   Look at the front of the deque under the guard.
+|-----------------------------------------------------------------------------*/
+IBoolean IAsyncNotificationWorker :: isEmpty ( )
+{
+  IAtomic::acquire ( guard );
+  IBoolean empty = ( first == NULL );
+  IAtomic::release ( guard );
+
+  return empty;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationWorker :: wakeUp
+|
+| Implementation:
+|   If the worker may be waiting, signal it.  Clearing the waiting flag
+|   makes sure only one thread signals for each wait.
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationWorker & IAsyncNotificationWorker :: wakeUp ( )
+{
+  if ( IAtomic::exchange ( waiting, 0 ) != 0 )
+    readyEventSem.post();
+
+  return *this;
+}
+
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierThreadPool :: IAsyncNotifierThreadPool
+|
+| Implementation:
+|   Initialize the base class.  Create the workers, then start a thread for
+|   each.  Nothing can be scheduled until the constructor returns, so the
+|   thread ids are saved before any worker looks for its own.
+|-----------------------------------------------------------------------------*/
+IAsyncNotifierThreadPool :: IAsyncNotifierThreadPool (
+                              unsigned long numberOfThreads ) :
+                   IAsyncNotifierThread ( ),
+                   workers ( NULL ),
+                   workerCount ( numberOfThreads ),
+                   nextWorker ( 0 ),
+                   stopping ( 0 ),
+                   timersKey ( )
+{
+  IASSERTPARM ( workerCount != 0 );
+
+  workers = new IAsyncNotificationWorker * [workerCount];
+  for ( unsigned long i = 0; i < workerCount; i++ )
+    workers[i] = new IAsyncNotificationWorker ( *this, i );
+
+  for ( unsigned long j = 0; j < workerCount; j++ )
+  {
+    IAsyncNotificationWorker * worker = workers[j];
+    worker->thread = new IThread (
+                       new IThreadMemberFn<IAsyncNotificationWorker> (
+                             *worker, &IAsyncNotificationWorker::run ),
+                       false );
+    worker->threadId = worker->thread->id();
+  }
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierThreadPool :: ~IAsyncNotifierThreadPool
+|
+| Implementation:
+|   Tell the workers to stop and interrupt their waits.  A post that comes
+|   before a worker waits ends its next wait at once.  Wait until each worker
+|   has stopped, then delete its thread and the worker itself.
+|-----------------------------------------------------------------------------*/
+IAsyncNotifierThreadPool :: ~IAsyncNotifierThreadPool ( )
+{
+  IAtomic::exchange ( stopping, 1 );
+
+  for ( unsigned long i = 0; i < workerCount; i++ )
+    workers[i]->readyEventSem.post();
+
+  for ( unsigned long j = 0; j < workerCount; j++ )
+  {
+    workers[j]->stoppedEventSem.wait();
+    delete workers[j]->thread;
+    delete workers[j];
+  }
+
+  delete [] workers;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierThreadPool :: createStrand
+|
+| Implementation:
+|   Return a new strand.  It is not on any deque until it has notifications.
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationStrand * IAsyncNotifierThreadPool :: createStrand ( )
+{
+  return ( new IAsyncNotificationStrand );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierThreadPool :: numberOfThreads
+|
+| Implementation:
+|   Return the number of workers.
+|-----------------------------------------------------------------------------*/
+unsigned long IAsyncNotifierThreadPool :: numberOfThreads ( ) const
+{
+  return workerCount;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierThreadPool :: processorCount
+|
+| Implementation:
+|   Ask the system.  A kernel that does not know about more than one
+|   processor fails the OS/2 query, so count one then.
+|-----------------------------------------------------------------------------*/
+unsigned long IAsyncNotifierThreadPool :: processorCount ( )
+{
+  unsigned long count = 1;
+
+#ifdef __linux__
+  long online = sysconf ( _SC_NPROCESSORS_ONLN );
+  if ( online > 0 )
+    count = (unsigned long)online;
+#else
+  ULONG processors = 0;
+  if ( ( DosQuerySysInfo ( QSV_NUMPROCESSORS, QSV_NUMPROCESSORS,
+                           &processors, sizeof ( processors ) ) == 0 ) &&
+       ( processors != 0 ) )
+    count = processors;
+#endif
+
+  return count;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierThreadPool :: enqueueNotification
+|
+| Implementation:
+|   Add the notification to the strand of its notifier.  The queue will make
+|     a copy of the event and of the payload value.
+|   Count it only after it is in the queue, so the worker always finds a
+|     notification for each count.  If the count was zero, no worker has
+|     the strand, so schedule it.
+|-----------------------------------------------------------------------------*/
+IAsyncNotifierThreadPool & IAsyncNotifierThreadPool :: enqueueNotification (
+                            const INotificationEvent & anEvent,
+                            IAsyncNotifier::Priority priority,
+                            const IAsyncNotificationPayload * payload )
+{
+  IAsyncNotifier * theNotifier = (IAsyncNotifier *)(&(anEvent.notifier()));
+  IAsyncNotificationStrand * strand = theNotifier->strand;
+
+  strand->queue.addAsLast ( anEvent, priority, payload );
+
+  if ( IAtomic::increment ( strand->pending ) == 1 )
+    schedule ( strand );
+
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierThreadPool :: enqueueNotification
+|
+| Implementation:
+|   As above, but the queue of the strand constructs the event in place.
+|-----------------------------------------------------------------------------*/
+IAsyncNotifierThreadPool & IAsyncNotifierThreadPool :: enqueueNotification (
+                            const INotificationId & nId,
+                            IAsyncNotifier & notifier,
+                            IAsyncNotifier::Priority priority,
+                            const IAsyncNotificationPayload * payload )
+{
+  IAsyncNotificationStrand * strand = notifier.strand;
+
+  strand->queue.addAsLast ( nId, notifier, priority, payload );
+
+  if ( IAtomic::increment ( strand->pending ) == 1 )
+    schedule ( strand );
+
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierThreadPool :: metrics
+|
+| Implementation:
+|   Start with the counts kept by the base class and add the metrics of
+|   each worker.
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationMetrics IAsyncNotifierThreadPool :: metrics ( ) const
+{
+  IAsyncNotificationMetrics snapshot ( IAsyncNotifierThread::metrics() );
+
+  for ( unsigned long i = 0; i < workerCount; i++ )
+    snapshot.add ( workers[i]->metrics );
+
+  return snapshot;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierThreadPool :: processMsgs
+|
+| Implementation:
+|   The workers dispatch, so nobody else may.
+|-----------------------------------------------------------------------------*/
+IAsyncNotifierThreadPool & IAsyncNotifierThreadPool :: processMsgs ( )
+{
+  IInvalidRequest exc ( "The thread pool dispatches on its own threads.",
+                        0, IException::recoverable );
+  ITHROW ( exc );
+
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierThreadPool :: cancelTimer
+|
+| Implementation:
+|   Call the base class while holding the timers semaphore.
+|-----------------------------------------------------------------------------*/
+IBoolean IAsyncNotifierThreadPool :: cancelTimer (
+                                       unsigned long handle,
+                                       const IAsyncNotifier & asyncNotifier )
+{
+  IResourceLock timersLock ( timersKey );
+
+  return ( IAsyncNotifierThread::cancelTimer ( handle, asyncNotifier ) );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierThreadPool :: insertTimer
+|
+| Implementation:
+|   Call the base class while holding the timers semaphore.  Then wake the
+|   first worker, which may be waiting for a later notification.
+|-----------------------------------------------------------------------------*/
+IAsyncNotifierThreadPool & IAsyncNotifierThreadPool :: insertTimer (
+                                                     unsigned long handle )
+{
+  {
+    IResourceLock timersLock ( timersKey );
+
+    IAsyncNotifierThread::insertTimer ( handle );
+  }
+
+  workers[0]->wakeUp();
+
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierThreadPool :: timeUntilTimer
+|
+| Implementation:
+|   Call the base class while holding the timers semaphore.
+|-----------------------------------------------------------------------------*/
+long IAsyncNotifierThreadPool :: timeUntilTimer ( )
+{
+  IResourceLock timersLock ( timersKey );
+
+  return ( IAsyncNotifierThread::timeUntilTimer() );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierThreadPool :: cancelTimersFor
+|
+| Implementation:
+|   Call the base class while holding the timers semaphore.
+|-----------------------------------------------------------------------------*/
+IAsyncNotifierThreadPool & IAsyncNotifierThreadPool :: cancelTimersFor (
+                                     const IAsyncNotifier & asyncNotifier )
+{
+  IResourceLock timersLock ( timersKey );
+
+  IAsyncNotifierThread::cancelTimersFor ( asyncNotifier );
+
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierThreadPool :: expireTimers
+|
+| Implementation:
+|   Call the base class while holding the timers semaphore.  The due
+|   notifications are queued on their strands.
+|-----------------------------------------------------------------------------*/
+unsigned long IAsyncNotifierThreadPool :: expireTimers ( )
+{
+  IResourceLock timersLock ( timersKey );
+
+  return ( IAsyncNotifierThread::expireTimers() );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierThreadPool :: isDispatchThreadFor
+|
+| Implementation:
+|   Only the worker running the strand counts, and only while it dispatches.
+|-----------------------------------------------------------------------------*/
+IBoolean IAsyncNotifierThreadPool :: isDispatchThreadFor (
+                                   const IAsyncNotifier & asyncNotifier ) const
+{
+  return ( asyncNotifier.strand->runner == IThread::currentId() );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierThreadPool :: deleteNotificationsFor
+|
+| Implementation:
+|   Only the worker running the strand may look at its queue.  Remove the
+|   pending notifications of the notifier and mark the strand deleted, so
+|   the worker deletes it when the current notification returns.
+|-----------------------------------------------------------------------------*/
+IAsyncNotifierThreadPool & IAsyncNotifierThreadPool :: deleteNotificationsFor (
+                                     const IAsyncNotifier & asyncNotifier )
+{
+  IAsyncNotificationStrand * strand = asyncNotifier.strand;
+
+  IASSERTSTATE ( strand->runner == IThread::currentId() );
+
+  strand->queue.removeAllFor ( asyncNotifier );
+  strand->deleted = true;
+
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierThreadPool :: schedule
+|
+| Implementation:
+|   On a worker, put the strand on its own deque.  On any other thread, put
+|   it on the deques in turn.  Wake the worker if it is waiting.  Otherwise
+|   it is busy, so wake an idle worker to steal the strand.
+|-----------------------------------------------------------------------------*/
+IAsyncNotifierThreadPool & IAsyncNotifierThreadPool :: schedule (
+                                      IAsyncNotificationStrand * strand )
+{
+  IAsyncNotificationWorker * worker = currentWorker();
+  if ( worker == NULL )
+  {
+    unsigned long turn = (unsigned long)IAtomic::increment ( nextWorker );
+    worker = workers[turn % workerCount];
+  }
+
+  worker->push ( strand );
+
+  if ( IAtomic::exchange ( worker->waiting, 0 ) != 0 )
+    worker->readyEventSem.post();
+  else
+    wakeIdleWorker();
+
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierThreadPool :: runStrand
+|
+| Implementation:
+|   Dispatch the strand's notifications one at a time:
+|     A notification is counted when addAsLast returns, but one added by
+|       another thread just before it may not be linked into its lane yet.
+|       If the queue looks empty, put the strand back at the end of our
+|       deque and give up the time slice, so the adding thread can finish
+|       before we come back to it after the others.
+|     Mark this thread as the runner only while a notification is
+|       dispatched, so only an observer of the strand can delete its
+|       notifier.  The notification is recorded in our worker's metrics.
+|     If the notifier was deleted, delete the strand.  Nothing else refers
+|       to it any more.  A notifier deleted on another thread sends a
+|       closeId notification last; the ones before it were skipped.
+|     Count the notification as done.  If that was the last one, let the
+|       strand go; the next notification schedules it again.
+|     After a full turn, put the strand back at the end of our deque.
+|-----------------------------------------------------------------------------*/
+IAsyncNotifierThreadPool & IAsyncNotifierThreadPool :: runStrand (
+                                      IAsyncNotificationStrand * strand,
+                                      IAsyncNotificationWorker & worker )
+{
+  IThreadId threadId = IThread::currentId();
+
+  for ( unsigned long dispatched = 1; ; dispatched++ )
+  {
+    if ( strand->queue.isEmpty() )
+    {
+      worker.push ( strand );
+      giveUpTimeSlice();
+      break;
+    }
+
+    strand->runner = threadId;
+    dispatchNext ( strand->queue, worker.metrics );
+    strand->runner = IThreadId();
+
+    if ( ( strand->deleted ) ||
+         ( strand->queue.lastRemoved().notificationId() == closeId ) )
+    {
+      delete strand;
+      break;
+    }
+
+    if ( IAtomic::decrement ( strand->pending ) == 0 )
+      break;
+
+    if ( dispatched == eventsPerTurn )
+    {
+      worker.push ( strand );
+      break;
+    }
+  }
+
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierThreadPool :: steal
+|
+| Implementation:
+|   Look at the other workers' deques, starting with the next worker, and
+|   take the first strand found.
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationStrand * IAsyncNotifierThreadPool :: steal (
+                                      IAsyncNotificationWorker & thief )
+{
+  IAsyncNotificationStrand * strand = NULL;
+
+  for ( unsigned long i = 1; ( i < workerCount ) && ( strand == NULL ); i++ )
+    strand = workers[( thief.index + i ) % workerCount]->pop();
+
+  return strand;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierThreadPool :: hasWork
+|
+| Implementation:
+|   Return true if any deque has a strand.  A worker calls this after it
+|   sets its waiting flag, so a strand pushed before that is seen here and
+|   one pushed after that wakes it.
+|-----------------------------------------------------------------------------*/
+IBoolean IAsyncNotifierThreadPool :: hasWork ( ) const
+{
+  for ( unsigned long i = 0; i < workerCount; i++ )
+  {
+    if ( ! ( workers[i]->isEmpty() ) )
+      return true;
+  }
+
+  return false;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierThreadPool :: currentWorker
+|
+| Implementation:
+|   Return the worker for the current thread, or NULL if it is not one.
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationWorker * IAsyncNotifierThreadPool :: currentWorker ( ) const
+{
+  IThreadId threadId = IThread::currentId();
+
+  for ( unsigned long i = 0; i < workerCount; i++ )
+  {
+    if ( workers[i]->threadId == threadId )
+      return workers[i];
+  }
+
+  return NULL;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierThreadPool :: wakeIdleWorker
+|
+| Implementation:
+|   Wake the first worker that is waiting, if any.
+|-----------------------------------------------------------------------------*/
+IAsyncNotifierThreadPool & IAsyncNotifierThreadPool :: wakeIdleWorker ( )
+{
+  for ( unsigned long i = 0; i < workerCount; i++ )
+  {
+    if ( IAtomic::exchange ( workers[i]->waiting, 0 ) != 0 )
+    {
+      workers[i]->readyEventSem.post();
+      break;
+    }
+  }
+
+  return *this;
+}
+
\ No newline at end of file
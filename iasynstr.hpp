@@ -0,0 +1,196 @@
+/* NOSHIP */
+#ifndef _IASYNSTR_
+#define _IASYNSTR_
+/*******************************************************************************
+* FILE NAME: iasynstr.hpp
+*
+* DESCRIPTION:
+*   Declaration of the class(es):
+*     IAsyncNotifierThreadPool - Class for dispatching the notifications of
+*                                asynchronous notifiers on a pool of threads.
+*
+* COPYRIGHT:
+*   Licensed Materials - Property of IBM
+*   (C) Copyright IBM Corporation 1995
+*   All Rights Reserved
+*   US Government Users Restricted Rights - Use, duplication, or disclosure
+*   restricted by GSA ADP Schedule Contract with IBM Corp.
+*
+*******************************************************************************/
+#ifndef _IASYNTHR_
+  #include <iasynthr.hpp>
+#endif
+
+// Other dependency classes:
+#ifndef _IRESLOCK_
+  #include <ireslock.hpp>
+#endif
+
+class INotificationEvent;
+class IAsyncNotificationPayload;
+class IAsyncNotificationStrand;
+class IAsyncNotificationWorker;
+
+// Align classes on four byte boundary, except on Linux (see iatomic.hpp).
+#ifndef __linux__
+  #pragma pack(4)
+#endif
+
+class IAsyncNotifierThreadPool : public IAsyncNotifierThread {
+/*******************************************************************************
+*
+* This class implements the interface for asynchronous notifier threads for
+* IAsyncNotifier objects that are not bound to the thread they were created
+* on.  It starts a number of worker threads that dispatch the notifications
+* of all of these objects.
+*
+* Each IAsyncNotifier dispatched by the pool has a strand: a light queue,
+* without semaphores and keeping only a few free blocks of storage, with a
+* lane for each priority and a count of the notifications in it.  The
+* notification that makes the count one puts the strand on the deque of a
+* worker.  The worker that takes the strand dispatches its notifications one
+* at a time and only lets it go when the count drops back to zero.  After a
+* batch, it puts the strand back at the end of its own deque so other strands
+* get a turn.  So the notifications of one object are dispatched in order and
+* never at the same time, while those of different objects are dispatched in
+* parallel.
+*
+* A strand made ready on a worker goes on that worker's deque, and one made
+* ready on any other thread goes on the deques in turn.  A worker whose own
+* deque is empty steals the oldest strand from another worker before it
+* waits, and an idle worker is woken whenever a strand is put on the deque of
+* a busy one.
+*
+* The first worker also dispatches the timed notifications of the pool.  They
+* may be late while it is busy with a strand.
+*
+*******************************************************************************/
+
+public:
+/*------------------------------ Constructors ----------------------------------
+| You can construct an object of this class as follows:                        |
+|   - With the number of worker threads.  The workers are started at once.     |
+| IAsyncNotifier creates one pool when the first object that uses it is        |
+| created and never deletes it.  When there is nothing to dispatch, the        |
+| workers wait until the process ends.  The destructor stops the workers and   |
+| waits for each of them to end before deleting it.  The pool must not be      |
+| deleted while any IAsyncNotifier uses it.                                    |
+|-----------------------------------------------------------------------------*/
+IAsyncNotifierThreadPool ( unsigned long numberOfThreads );
+
+virtual ~IAsyncNotifierThreadPool ( );
+
+/*--------------------------------- Strands ------------------------------------
+| Used by IAsyncNotifier to set up the objects the pool dispatches.            |
+|   createStrand    - Returns a new, empty strand for an IAsyncNotifier.  The  |
+|                     pool deletes it after the object is deleted.             |
+|   numberOfThreads - Returns the number of worker threads.                    |
+|   processorCount  - Returns the number of processors, which is the default   |
+|                     number of worker threads.                                |
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationStrand * createStrand    ( );
+unsigned long              numberOfThreads ( ) const;
+static unsigned long       processorCount  ( );
+
+/*-------------------------- Enqueue Notification ------------------------------
+| Used by IAsyncNotifier objects to enque notifications.                       |
+|   enqueueNotification - Places the notification at the end of the lane for   |
+|                         the priority in the strand of its notifier.  If the  |
+|                         strand was idle, it is put on a worker's deque.  A   |
+|                         notification passed as an id and a notifier is       |
+|                         constructed right in the strand's queue.             |
+|-----------------------------------------------------------------------------*/
+virtual IAsyncNotifierThreadPool & enqueueNotification (
+                           const INotificationEvent & anEvent,
+                           IAsyncNotifier::Priority priority,
+                           const IAsyncNotificationPayload * payload = 0 );
+virtual IAsyncNotifierThreadPool & enqueueNotification (
+                           const INotificationId & nId,
+                           IAsyncNotifier & notifier,
+                           IAsyncNotifier::Priority priority,
+                           const IAsyncNotificationPayload * payload = 0 );
+
+/*--------------------------------- Metrics ------------------------------------
+| Used by IAsyncNotifier to report how well the pool keeps up.                 |
+|   metrics - Returns the sum of the metrics recorded by the workers.  The     |
+|             pool has no one queue, so the queue depth is zero and the        |
+|             deepest queue is that of the busiest strand.                     |
+|-----------------------------------------------------------------------------*/
+virtual IAsyncNotificationMetrics metrics ( ) const;
+
+/*----------------------------- Process Messages -------------------------------
+| The pool dispatches on its own threads.                                      |
+|   processMsgs - Throws an invalid request exception.                         |
+|-----------------------------------------------------------------------------*/
+virtual IAsyncNotifierThreadPool & processMsgs ( );
+
+/*--------------------------- Timed Notification -------------------------------
+| These functions call the base class implementation while holding a           |
+| semaphore, since any worker may dispatch an insertId notification and any    |
+| worker may delete an IAsyncNotifier.                                         |
+|   cancelTimer     - May be called on any thread.                             |
+|   insertTimer     - Also wakes the first worker so it waits no longer than   |
+|                     the new notification needs.                              |
+|   timeUntilTimer  - Called by the first worker before it waits.              |
+|   cancelTimersFor - Called by IAsyncNotifier::close on any thread.           |
+|-----------------------------------------------------------------------------*/
+virtual IBoolean                   cancelTimer     (
+                                     unsigned long handle,
+                                     const IAsyncNotifier & asyncNotifier );
+virtual IAsyncNotifierThreadPool & insertTimer     ( unsigned long handle );
+virtual long                       timeUntilTimer  ( );
+virtual IAsyncNotifierThreadPool & cancelTimersFor (
+                                     const IAsyncNotifier & asyncNotifier );
+
+/*-------------------------- Delete Notifications ------------------------------
+| IAsyncNotifier calls these from close to have all pending notifications      |
+| deleted.                                                                     |
+|   isDispatchThreadFor    - Returns true if the current thread is             |
+|                            dispatching a notification of the passed object.  |
+|   deleteNotificationsFor - Ensures that all notifications for the passed     |
+|                            object are never dispatched.  Throws an invalid   |
+|                            request exception if the current thread is not    |
+|                            dispatching a notification of the object.  The    |
+|                            strand is deleted when that notification returns. |
+| An object deleted on any other thread queues a closeId notification on its   |
+| strand instead.  The strand is deleted when the worker dispatches it.        |
+|-----------------------------------------------------------------------------*/
+virtual IBoolean                   isDispatchThreadFor    (
+                                   const IAsyncNotifier & asyncNotifier ) const;
+virtual IAsyncNotifierThreadPool & deleteNotificationsFor (
+                                     const IAsyncNotifier & asyncNotifier );
+
+
+protected:
+virtual unsigned long expireTimers ( );
+
+
+private:
+// The private copy constructor and assignment operator are not implemented.
+IAsyncNotifierThreadPool ( const IAsyncNotifierThreadPool & rhs );
+IAsyncNotifierThreadPool & operator = ( const IAsyncNotifierThreadPool & rhs );
+
+friend class IAsyncNotificationWorker;
+
+IAsyncNotifierThreadPool & schedule      ( IAsyncNotificationStrand * strand );
+IAsyncNotifierThreadPool & runStrand     ( IAsyncNotificationStrand * strand,
+                                           IAsyncNotificationWorker & worker );
+IAsyncNotificationStrand * steal         ( IAsyncNotificationWorker & thief );
+IBoolean                   hasWork       ( ) const;
+IAsyncNotificationWorker * currentWorker ( ) const;
+IAsyncNotifierThreadPool & wakeIdleWorker ( );
+
+/*--------------------------- Private State Data -----------------------------*/
+IAsyncNotificationWorker ** workers;
+unsigned long               workerCount;
+volatile long               nextWorker;
+volatile long               stopping;
+IPrivateResource            timersKey;
+
+}; // IAsyncNotifierThreadPool
+
+// Resume compiler default packing.
+#pragma pack()
+
+#endif // _IASYNSTR_
+
\ No newline at end of file
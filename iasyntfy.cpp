@@ -31,12 +31,36 @@
   #include <ievntsem.hpp>
 #endif
 
+#ifndef _IEXCEPT_
+  #include <iexcept.hpp>
+#endif
+
 #ifndef _IKEYSET_H
   #include <ikeyset.h>
 #endif
 
+#ifndef _IASYNTMR_
+  #include <iasyntmr.hpp>
+#endif
+
+#ifndef _IASYNSTR_
+  #include <iasynstr.hpp>
+#endif
+
+#ifndef _IATOMIC_
+  #include <iatomic.hpp>
+#endif
+
+#include <stdio.h>
+
+#ifndef __linux__
+  #define INCL_DOSPROCESS
+  #include <os2.h>
+#endif
+
 // Define the functions and static data members to be exported.
-// Ordinals 200 through 249 are reserved for use by IAsyncNotifier.
+// Ordinals 200 through 249 are reserved for use by IAsyncNotifier, and once
+// those ran out, 300 through 349.
 #pragma export(IAsyncNotifier::IAsyncNotifier(),, 200)
 #pragma export(IAsyncNotifier::IAsyncNotifier(const IAsyncNotifier&),, 201)
 #pragma export(IAsyncNotifier::~IAsyncNotifier(),, 202)
@@ -51,6 +75,66 @@
 #pragma export(IAsyncNotifier::dispatchThreadId,, 210)
 // *********** TEMPORARY *************
 #pragma export(IAsyncNotifier::thisRefId,, 211)
+#pragma export(IAsyncNotifier::setDispatchBatchSize(unsigned long),, 212)
+#pragma export(IAsyncNotifier::dispatchBatchSize(),, 213)
+#pragma export(IAsyncNotifier::enableCoalescingFor(                    \
+                 const INotificationId&,IBoolean),, 214)
+#pragma export(IAsyncNotifier::disableCoalescingFor(                   \
+                 const INotificationId&),, 215)
+#pragma export(IAsyncNotifier::isCoalescingEnabledFor(                 \
+                 const INotificationId&) const,, 216)
+#pragma export(IAsyncNotifier::enablePolledDispatch(),, 217)
+#pragma export(IAsyncNotifier::disablePolledDispatch(),, 218)
+#pragma export(IAsyncNotifier::dispatchPending(),, 219)
+#pragma export(IAsyncNotifier::notifyObservers(                        \
+                 const INotificationEvent&,IAsyncNotifier::Priority),, 220)
+#pragma export(IAsyncNotifier::notifyObservers(                        \
+                 const INotificationId&,IAsyncNotifier::Priority),, 221)
+#pragma export(IAsyncNotifier::setDispatchCapacity(                    \
+                 unsigned long,IAsyncNotifier::OverflowPolicy),, 222)
+#pragma export(IAsyncNotifier::dispatchCapacity(),, 223)
+#pragma export(IAsyncNotifier::dispatchOverflowPolicy(),, 224)
+#pragma export(IAsyncNotifier::dispatchOverflowCount(),, 225)
+#pragma export(IAsyncNotifier::notifyObserversAfter(                   \
+                 const INotificationEvent&,unsigned long,              \
+                 IAsyncNotifier::Priority),, 226)
+#pragma export(IAsyncNotifier::notifyObserversAt(                      \
+                 const INotificationEvent&,unsigned long,              \
+                 IAsyncNotifier::Priority),, 227)
+#pragma export(IAsyncNotifier::cancelTimedNotification(unsigned long),, 228)
+#pragma export(IAsyncNotifier::currentTime(),, 229)
+#pragma export(IAsyncNotifier::dispatchTimeout(),, 230)
+#pragma export(IAsyncNotifier::IAsyncNotifier(                         \
+                 IAsyncNotifier::DispatchPolicy),, 231)
+#pragma export(IAsyncNotifier::setDispatchPoolSize(unsigned long),, 232)
+#pragma export(IAsyncNotifier::dispatchPoolSize(),, 233)
+#pragma export(IAsyncNotifier::dispatchMetrics(),, 234)
+#pragma export(IAsyncNotifier::dispatchMetrics(const IThreadId&),, 235)
+#pragma export(IAsyncNotifier::dispatchPoolMetrics(),, 236)
+#pragma export(IAsyncNotifier::dispatchMetricsReport(),, 237)
+#pragma export(IAsyncNotifier::startMetricsReport(                     \
+                 unsigned long,IAsyncNotifier::MetricsWriter),, 238)
+#pragma export(IAsyncNotifier::stopMetricsReport(),, 239)
+#pragma export(IAsyncNotifier::addObserver(                            \
+                 IObserver&,const IEventData&),, 240)
+#pragma export(IAsyncNotifier::removeObserver(IObserver&),, 241)
+#pragma export(IAsyncNotifier::removeObserver(                         \
+                 IObserver&,const IEventData&),, 242)
+#pragma export(IAsyncNotifier::removeAllObservers(),, 243)
+#pragma export(IAsyncNotifier::enableInlineDispatch(IBoolean),, 244)
+#pragma export(IAsyncNotifier::disableInlineDispatch(),, 245)
+#pragma export(IAsyncNotifier::isInlineDispatchEnabled() const,, 246)
+#pragma export(IAsyncNotifier::notifyObservers(                        \
+                 const INotificationId&,                               \
+                 const IAsyncNotificationPayload&,                     \
+                 IAsyncNotifier::Priority),, 247)
+#pragma export(IAsyncNotifier::setDispatchSpinTime(unsigned long),, 248)
+#pragma export(IAsyncNotifier::dispatchSpinTime(),, 249)
+#pragma export(IAsyncNotifier::setDispatchProcessors(                  \
+                 unsigned long,unsigned long),, 300)
+#pragma export(IAsyncNotifier::dispatchPlacement(),, 301)
+#pragma export(IAsyncNotifier::dispatchPlacement(const IThreadId&),, 302)
+#pragma export(IAsyncNotifier::close(),, 303)
 
 // It's possible for the caller of the external entry points to have a
 // different C library environment.  Make sure the exception handler for
@@ -59,6 +143,11 @@
 #pragma handler(IAsyncNotifier::IAsyncNotifier(const IAsyncNotifier&))
 #pragma handler(IAsyncNotifier::~IAsyncNotifier())
 #pragma handler(IAsyncNotifier::deleteThis())
+#pragma handler(IAsyncNotifier::close())
+#pragma handler(IAsyncNotifier::setDispatchProcessors(                 \
+                  unsigned long,unsigned long))
+#pragma handler(IAsyncNotifier::dispatchPlacement())
+#pragma handler(IAsyncNotifier::dispatchPlacement(const IThreadId&))
 #pragma handler(IAsyncNotifier::operator=(const IAsyncNotifier&))
 #pragma handler(IAsyncNotifier::run())
 #pragma handler(IAsyncNotifier::notifyObservers(const INotificationEvent&))
@@ -66,27 +155,347 @@
 #pragma handler(IAsyncNotifier::notificationCleanUp(                   \
                   const INotificationEvent&) const)
 #pragma handler(IAsyncNotifier::notifyObservers(const INotificationId&))
+#pragma handler(IAsyncNotifier::setDispatchBatchSize(unsigned long))
+#pragma handler(IAsyncNotifier::dispatchBatchSize())
+#pragma handler(IAsyncNotifier::enableCoalescingFor(                   \
+                  const INotificationId&,IBoolean))
+#pragma handler(IAsyncNotifier::disableCoalescingFor(                  \
+                  const INotificationId&))
+#pragma handler(IAsyncNotifier::isCoalescingEnabledFor(                \
+                  const INotificationId&) const)
+#pragma handler(IAsyncNotifier::enablePolledDispatch())
+#pragma handler(IAsyncNotifier::disablePolledDispatch())
+#pragma handler(IAsyncNotifier::dispatchPending())
+#pragma handler(IAsyncNotifier::notifyObservers(                       \
+                  const INotificationEvent&,IAsyncNotifier::Priority))
+#pragma handler(IAsyncNotifier::notifyObservers(                       \
+                  const INotificationId&,IAsyncNotifier::Priority))
+#pragma handler(IAsyncNotifier::setDispatchCapacity(                   \
+                  unsigned long,IAsyncNotifier::OverflowPolicy))
+#pragma handler(IAsyncNotifier::dispatchCapacity())
+#pragma handler(IAsyncNotifier::dispatchOverflowPolicy())
+#pragma handler(IAsyncNotifier::dispatchOverflowCount())
+#pragma handler(IAsyncNotifier::notifyObserversAfter(                  \
+                  const INotificationEvent&,unsigned long,             \
+                  IAsyncNotifier::Priority))
+#pragma handler(IAsyncNotifier::notifyObserversAt(                     \
+                  const INotificationEvent&,unsigned long,             \
+                  IAsyncNotifier::Priority))
+#pragma handler(IAsyncNotifier::cancelTimedNotification(unsigned long))
+#pragma handler(IAsyncNotifier::currentTime())
+#pragma handler(IAsyncNotifier::dispatchTimeout())
+#pragma handler(IAsyncNotifier::IAsyncNotifier(                        \
+                  IAsyncNotifier::DispatchPolicy))
+#pragma handler(IAsyncNotifier::setDispatchPoolSize(unsigned long))
+#pragma handler(IAsyncNotifier::dispatchPoolSize())
+#pragma handler(IAsyncNotifier::dispatchMetrics())
+#pragma handler(IAsyncNotifier::dispatchMetrics(const IThreadId&))
+#pragma handler(IAsyncNotifier::dispatchPoolMetrics())
+#pragma handler(IAsyncNotifier::dispatchMetricsReport())
+#pragma handler(IAsyncNotifier::startMetricsReport(                    \
+                  unsigned long,IAsyncNotifier::MetricsWriter))
+#pragma handler(IAsyncNotifier::stopMetricsReport())
+#pragma handler(IAsyncNotifier::addObserver(                           \
+                  IObserver&,const IEventData&))
+#pragma handler(IAsyncNotifier::removeObserver(IObserver&))
+#pragma handler(IAsyncNotifier::removeObserver(                        \
+                  IObserver&,const IEventData&))
+#pragma handler(IAsyncNotifier::removeAllObservers())
+#pragma handler(IAsyncNotifier::enableInlineDispatch(IBoolean))
+#pragma handler(IAsyncNotifier::disableInlineDispatch())
+#pragma handler(IAsyncNotifier::isInlineDispatchEnabled() const)
+#pragma handler(IAsyncNotifier::notifyObservers(                       \
+                  const INotificationId&,                              \
+                  const IAsyncNotificationPayload&,                    \
+                  IAsyncNotifier::Priority))
+#pragma handler(IAsyncNotifier::setDispatchSpinTime(unsigned long))
+#pragma handler(IAsyncNotifier::dispatchSpinTime())
 
 // Initialize class static members.
 IKeySet<IAsyncNotifierThread *, IThreadId> * IAsyncNotifier::threads
                                = new IKeySet<IAsyncNotifierThread *, IThreadId>;
 IPrivateResource IAsyncNotifier::threadsKey;
+IAsyncNotifierThreadPool * IAsyncNotifier::pool = NULL;
+unsigned long IAsyncNotifier::poolSize = 0;
+IAsyncNotificationReporter * IAsyncNotifier::reporter = NULL;
 INotificationId const IAsyncNotifier::dispatchThreadId
                                         = "IAsyncNotifier::dispatchThread";
 // *********** TEMPORARY *************
 INotificationId const IAsyncNotifier::thisRefId = "IAsyncNotifier::thisRef";
 
 
+//------------------------------------------------------------------------------
+// A notification id for which coalescing has been enabled and the latest
+// notification with that id that is waiting to be dispatched.  Slots are
+// only deleted with their IAsyncNotifier because a coalescedId event that
+// refers to the slot may still be queued after coalescing is disabled.
+//------------------------------------------------------------------------------
+class IAsyncNotificationSlot
+{
+public:
+  IAsyncNotificationSlot ( const INotificationId & nId,
+                           IAsyncNotificationSlot * nextSlot );
+
+  INotificationId          notificationId;
+  IBoolean                 enabled;
+  INotificationEvent     * pendingEvent;
+  IAsyncNotificationSlot * next;
+};
+
+IAsyncNotificationSlot :: IAsyncNotificationSlot (
+                            const INotificationId & nId,
+                            IAsyncNotificationSlot * nextSlot ) :
+                   notificationId ( nId ),
+                   enabled ( true ),
+                   pendingEvent ( NULL ),
+                   next ( nextSlot )
+{
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: findSlot
+|
+| Implementation:
+|   Return the slot for the notification id or NULL if there is none.
+|-----------------------------------------------------------------------------*/
+static IAsyncNotificationSlot * findSlot ( IAsyncNotificationSlot * slot,
+                                           const INotificationId & nId )
+{
+  while ( ( slot != NULL ) && ( slot->notificationId != nId ) )
+    slot = slot->next;
+
+  return slot;
+}
+
+
+//------------------------------------------------------------------------------
+// An entry in the table of handles.  Each IAsyncNotifier holds one while it
+// exists, and each of its queued and timed notifications notes the index and
+// generation of the entry.  Deleting the IAsyncNotifier changes the
+// generation, so a dispatch thread can tell a notification is stale without
+// looking at the deleted object.  While a dispatch thread uses the object of
+// a notification, it counts itself in pins.  A close on another thread that
+// has to wait for the pins to go puts its event semaphore in closer, and the
+// unpin that takes the last pin posts it.  Entries are allocated in blocks
+// that are never freed, so an old index can always be looked at, and freed
+// entries are used again oldest first.  Index zero is never given out: a
+// notification with index zero has no IAsyncNotifier to check.
+//------------------------------------------------------------------------------
+class IAsyncNotifierHandle
+{
+public:
+  volatile long          generation;
+  volatile long          pins;
+  void * volatile        closer;
+  unsigned long          index;
+  IAsyncNotifierHandle * next;
+};
+
+// The table has up to this many blocks of entries.
+static const unsigned long handlesPerBlock     = 1024;
+static const unsigned long maximumHandleBlocks = 4096;
+
+// The free list and the block count are only changed while the guard is
+// held.  Once a block is added it is only read.
+static IAsyncNotifierHandle * handleBlocks [maximumHandleBlocks];
+static unsigned long          handleBlockCount = 0;
+static IAsyncNotifierHandle * firstFreeHandle  = NULL;
+static IAsyncNotifierHandle * lastFreeHandle   = NULL;
+static volatile long          handleGuard      = 0;
+
+/*------------------------------------------------------------------------------
+| Function Name: handleAt
+|
+| Implementation:
+|   Return the entry at the index.
+|-----------------------------------------------------------------------------*/
+static IAsyncNotifierHandle & handleAt ( unsigned long index )
+{
+  return ( handleBlocks[index / handlesPerBlock][index % handlesPerBlock] );
+}
+
+
+//------------------------------------------------------------------------------
+// The thread started by IAsyncNotifier::startMetricsReport.  It waits on its
+// event semaphore for the interval and passes a report to the writer each
+// time the wait times out.  To stop it, the semaphore is posted and stopped
+// is set; the thread deletes itself and its IThread object, so nothing may
+// touch it after that.
+//------------------------------------------------------------------------------
+class IAsyncNotificationReporter {
+public:
+  IAsyncNotificationReporter ( unsigned long                 anInterval,
+                               IAsyncNotifier::MetricsWriter aWriter )
+    : interval ( anInterval ),
+      writer ( aWriter ),
+      thread ( NULL ),
+      stopped ( 0 )
+  { }
+
+  void run  ( );
+  void stop ( );
+
+  unsigned long                 interval;
+  IAsyncNotifier::MetricsWriter writer;
+  IThread                     * thread;
+  IEventSem                     stopEventSem;
+  volatile long                 stopped;
+};
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationReporter :: run
+|
+| Implementation:
+|   Until stopped, wait for the interval and pass a report to the writer.
+|   The wait ends early when the reporter is stopped.  Once it is stopped,
+|   delete the IThread object, which does not end this thread, and the
+|   reporter.  The object was set before the reporter could be stopped.
+|-----------------------------------------------------------------------------*/
+void IAsyncNotificationReporter :: run ( )
+{
+  while ( IAtomic::value ( stopped ) == 0 )
+  {
+    stopEventSem.timedWait ( interval );
+
+    if ( IAtomic::value ( stopped ) == 0 )
+      writer ( IAsyncNotifier::dispatchMetricsReport() );
+  }
+
+  delete thread;
+  delete this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationReporter :: stop
+|
+| Implementation:
+|   Wake the reporter thread and tell it to stop.  Setting stopped is the
+|   last use of the object, because the thread may delete it right after.
+|-----------------------------------------------------------------------------*/
+void IAsyncNotificationReporter :: stop ( )
+{
+  stopEventSem.post();
+  IAtomic::exchange ( stopped, 1 );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: writeToStandardError
+|
+| Implementation:
+|   The default metrics writer.  Write the report to standard error.
+|-----------------------------------------------------------------------------*/
+static void writeToStandardError ( const IString & report )
+{
+  fputs ( (char *)report, stderr );
+  fflush ( stderr );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: appendMetrics
+|
+| Implementation:
+|   Append a heading, with the placement of a dispatch thread if it has
+|   one, and the metrics of the thread to the report.
+|   Used with IKeySet::allElementsDo.
+|-----------------------------------------------------------------------------*/
+static IBoolean appendMetrics ( IAsyncNotifierThread * & anAsyncNotifierThread,
+                                void                   * report )
+{
+  IString heading ( "Dispatch thread " );
+  heading += IString ( anAsyncNotifierThread->threadId().asUnsigned() );
+
+  IString placement = anAsyncNotifierThread->placement();
+  if ( placement.length() != 0 )
+    heading += IString ( " on " ) + placement;
+
+  *(IString *)report += heading +
+                        IString ( ":\n" ) +
+                        anAsyncNotifierThread->metrics().asString();
+
+  return true;
+}
+
+
+//------------------------------------------------------------------------------
+// Each thread caches a pointer to its own entry in IAsyncNotifier::threads so
+// that notifiers created on a thread that already has a dispatch thread do
+// not need threadsKey.  A thread's entry is only added and removed by that
+// thread, so the cache is set and cleared along with the entry.  On OS/2 the
+// cache is a word of thread local memory.  If it can not be allocated, the
+// cache stays empty and every lookup uses the collection.
+//------------------------------------------------------------------------------
+#ifdef __linux__
+static __thread IAsyncNotifierThread * cachedThread = NULL;
+#else
+static PULONG allocateCacheSlot ( )
+{
+  PULONG slot = NULL;
+
+  if ( DosAllocThreadLocalMemory ( 1, &slot ) != 0 )
+    slot = NULL;
+
+  return slot;
+}
+
+static PULONG cacheSlot = allocateCacheSlot();
+#endif
+
+/*------------------------------------------------------------------------------
+| Function Name: cachedDispatchThread
+|
+| Implementation:
+|   Return the cached dispatch thread for the current thread or NULL if there
+|   is none.
+|-----------------------------------------------------------------------------*/
+static IAsyncNotifierThread * cachedDispatchThread ( )
+{
+#ifdef __linux__
+  return cachedThread;
+#else
+  if ( cacheSlot == NULL )
+    return NULL;
+
+  return ( (IAsyncNotifierThread *)(*cacheSlot) );
+#endif
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: cacheDispatchThread
+|
+| Implementation:
+|   Save the dispatch thread for the current thread.  NULL clears it.
+|-----------------------------------------------------------------------------*/
+static void cacheDispatchThread ( IAsyncNotifierThread * anAsyncNotifierThread )
+{
+#ifdef __linux__
+  cachedThread = anAsyncNotifierThread;
+#else
+  if ( cacheSlot != NULL )
+    *cacheSlot = (ULONG)anAsyncNotifierThread;
+#endif
+}
+
+
 /*------------------------------------------------------------------------------
 | Function Name: IAsyncNotifier :: IAsyncNotifier
 |
 | Implementation:
-|   Initialize the base class then find or create the dispatch thread.
+|   Initialize the base class, take a handle, then find or create the
+|   dispatch thread.
 |-----------------------------------------------------------------------------*/
 IAsyncNotifier :: IAsyncNotifier ( ) :
                    IStandardNotifier ( ),
-                   theDispatchThread ( NULL )
+                   theDispatchThread ( NULL ),
+                   coalescedSlots ( NULL ),
+                   coalesceKey ( NULL ),
+                   pendingEvents ( NULL ),
+                   timerCount ( 0 ),
+                   strand ( NULL ),
+                   handleIndex ( 0 ),
+                   handleGeneration ( 0 ),
+                   inlineDispatch ( false )
 {
+  openHandle();
   findOrCreateDispatchThread();
 }
 
@@ -94,14 +503,51 @@ IAsyncNotifier :: IAsyncNotifier ( ) :
 | Function Name: IAsyncNotifier :: IAsyncNotifier
 |
 | Implementation:
-|   Initialize the base class then find or create the dispatch thread.
+|   Initialize the base class and take a handle, then find or create the
+|   dispatch thread or the thread pool, as the policy asks.
+|-----------------------------------------------------------------------------*/
+IAsyncNotifier :: IAsyncNotifier ( DispatchPolicy policy ) :
+                   IStandardNotifier ( ),
+                   theDispatchThread ( NULL ),
+                   coalescedSlots ( NULL ),
+                   coalesceKey ( NULL ),
+                   pendingEvents ( NULL ),
+                   timerCount ( 0 ),
+                   strand ( NULL ),
+                   handleIndex ( 0 ),
+                   handleGeneration ( 0 ),
+                   inlineDispatch ( false )
+{
+  openHandle();
+
+  if ( policy == threadPool )
+    findOrCreateDispatchPool();
+  else
+    findOrCreateDispatchThread();
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifier :: IAsyncNotifier
+|
+| Implementation:
+|   Initialize the base class, take a handle, then find or create the
+|   dispatch thread.
 |   Use the base class default constructor so notification will always be
 |   disabled for a new object.
 |-----------------------------------------------------------------------------*/
 IAsyncNotifier :: IAsyncNotifier ( const IAsyncNotifier & asyncNotifier ) :
                    IStandardNotifier ( ),
-                   theDispatchThread ( NULL )
+                   theDispatchThread ( NULL ),
+                   coalescedSlots ( NULL ),
+                   coalesceKey ( NULL ),
+                   pendingEvents ( NULL ),
+                   timerCount ( 0 ),
+                   strand ( NULL ),
+                   handleIndex ( 0 ),
+                   handleGeneration ( 0 ),
+                   inlineDispatch ( false )
 {
+  openHandle();
   findOrCreateDispatchThread();
 }
 
@@ -109,35 +555,128 @@ IAsyncNotifier :: IAsyncNotifier ( const IAsyncNotifier & asyncNotifier ) :
 | Function Name: IAsyncNotifier :: ~IAsyncNotifier
 |
 | Implementation:
-|   Delete all pending notifications for this object.
-|   Remove our reference to the thread.
-|   If the reference count is zero, remove the thread from the collection.
-|     If it is not running, delete it.  If it is running,
-|     IAsyncNotifier::run will delete it.
+|   Close, unless a subclass did already.  Nothing is checked, since a
+|   destructor must not throw: on another thread, if the dispatch thread is
+|   not dispatching, our reference to it is released when it next does.
 |-----------------------------------------------------------------------------*/
 IAsyncNotifier :: ~IAsyncNotifier ( )
 {
-  theDispatchThread->deleteNotificationsFor ( *this );
-  if ( theDispatchThread->removeRef() == 0 )
-  {
-    threads->removeElementWithKey ( theDispatchThread->threadId() );
-
-    if ( ! ( theDispatchThread->isRunning() ) )
-      delete theDispatchThread;
-  }
+  closeNotifier();
 }
 
 /*------------------------------------------------------------------------------
 | Function Name: IAsyncNotifier :: deleteThis
 |
 | Implementation:
-|   Post our secret notification for async delete.
+|   Post our secret notification for async delete.  It goes in the normal
+|   lane, after the notifications of normal or higher priority already sent.
 |-----------------------------------------------------------------------------*/
 IAsyncNotifier & IAsyncNotifier :: deleteThis ( )
 {
   theDispatchThread->enqueueNotification ( INotificationEvent (
                                              IAsyncNotifierThread::deleteThisId,
-                                             *this ) );
+                                             *this ),
+                                           normal );
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifier :: close
+|
+| Implementation:
+|   Nothing to do if already closed, which clears the dispatch thread.
+|   On another thread, make sure the dispatch thread will take the closeId
+|     notification queued by closeNotifier: only a running, polled or pool
+|     thread does, and a running background thread keeps running while we
+|     hold our reference.
+|   Then close.
+|-----------------------------------------------------------------------------*/
+IAsyncNotifier & IAsyncNotifier :: close ( )
+{
+  if ( theDispatchThread == NULL )
+    return *this;
+
+  if ( ( ! ( theDispatchThread->isDispatchThreadFor ( *this ) ) ) &&
+       ( theDispatchThread != pool ) &&
+       ( ! ( theDispatchThread->isPolled() ) ) &&
+       ( ! ( theDispatchThread->isRunning() ) ) )
+  {
+    IInvalidRequest exc ( "The dispatch thread is not dispatching.",
+                          0, IException::recoverable );
+    ITHROW ( exc );
+  }
+
+  return closeNotifier();
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifier :: closeNotifier
+|
+| Implementation:
+|   Nothing to do if already closed, which clears the dispatch thread.
+|   Tell the observers the object is being deleted, as IStandardNotifier
+|     does with its own list, which is empty for this class.
+|   On the dispatch thread, delete all pending and timed notifications for
+|     this object, then close the handle.  The dispatch thread may be in the
+|     middle of one of our notifications, so do not wait for it.
+|   On any other thread, cancel the timed notifications while we can still
+|     be pinned, then close the handle and wait until the dispatch thread is
+|     done with us.  It skips our queued notifications from then on.
+|   Delete the coalescing slots and any notifications they still hold.
+|   Remove our reference to the thread.  On another thread, leave that to
+|     the dispatch thread with a closeId notification, since only it may
+|     remove its entry from the collection.  It is queued with no handle,
+|     after all of ours, so our queued insertId notifications are done first.
+|-----------------------------------------------------------------------------*/
+IAsyncNotifier & IAsyncNotifier :: closeNotifier ( )
+{
+  if ( theDispatchThread == NULL )
+    return *this;
+
+  IBoolean onDispatchThread = theDispatchThread->isDispatchThreadFor ( *this );
+
+  if ( isEnabledForNotification() )
+    observerList.notify ( INotificationEvent ( IStandardNotifier::deleteId,
+                                               *this ) );
+
+  if ( onDispatchThread )
+  {
+    theDispatchThread->deleteNotificationsFor ( *this );
+    theDispatchThread->cancelTimersFor ( *this );
+    closeHandle ( false );
+  }
+  else
+  {
+    theDispatchThread->cancelTimersFor ( *this );
+    closeHandle ( true );
+  }
+
+  while ( coalescedSlots != NULL )
+  {
+    IAsyncNotificationSlot * slot = coalescedSlots;
+    coalescedSlots = slot->next;
+
+    if ( slot->pendingEvent != NULL )
+    {
+      notificationCleanUp ( *(slot->pendingEvent) );
+      delete slot->pendingEvent;
+    }
+    delete slot;
+  }
+  delete coalesceKey;
+  coalesceKey = NULL;
+
+  IAsyncNotifierThread * anAsyncNotifierThread = theDispatchThread;
+  theDispatchThread = NULL;
+
+  if ( onDispatchThread )
+    releaseDispatchThread ( anAsyncNotifierThread );
+  else
+    anAsyncNotifierThread->enqueueNotification (
+                             INotificationEvent ( IAsyncNotifierThread::closeId,
+                                                  *this ),
+                             low );
+
   return *this;
 }
 
@@ -160,8 +699,11 @@ IAsyncNotifier & IAsyncNotifier :: operator = ( const IAsyncNotifier & rhs )
 | Implementation:
 |   Find the current thread in the list of threads.
 |   If not found try to create one, but only for GUI.
+|   Polled threads are dispatched by dispatchPending.
 |   Call the thread's run function.
-|   Remove the thread from the collection and delete it.
+|   Remove the thread from the collection under the lock, unless the last
+|     release already did, so nobody finds it there any more, then delete
+|     it.
 |-----------------------------------------------------------------------------*/
 void IAsyncNotifier :: run ( )
 {
@@ -179,94 +721,1267 @@ void IAsyncNotifier :: run ( )
     {
       anAsyncNotifierThread = IAsyncNotifierThread::make ( true );
       threads->add ( anAsyncNotifierThread );
+      cacheDispatchThread ( anAsyncNotifierThread );
     }
+
+    IASSERTSTATE ( ! ( anAsyncNotifierThread->isPolled() ) );
   }
 
   anAsyncNotifierThread->processMsgs();
 
-  threads->removeElementWithKey ( threadId );
+  {
+    IResourceLock threadsLock ( threadsKey );
+
+    if ( ( threads->containsElementWithKey ( threadId ) ) &&
+         ( threads->elementWithKey ( threadId ) == anAsyncNotifierThread ) )
+      threads->removeElementWithKey ( threadId );
+    cacheDispatchThread ( NULL );
+  }
+
   delete anAsyncNotifierThread;
 }
 
 /*------------------------------------------------------------------------------
-| Function Name: IAsyncNotifier :: notifyObservers
+| Function Name: IAsyncNotifier :: enablePolledDispatch
 |
 | Implementation:
-|   If enabled for notification, enqueue the event.
+|   The current thread must not have a dispatch thread yet.
+|   Create a polled one and add it to the collection.
+|   Hold a reference for the caller so the thread is kept while there are
+|     no IAsyncNotifier objects.  disablePolledDispatch removes it.
 |-----------------------------------------------------------------------------*/
-IAsyncNotifier & IAsyncNotifier :: notifyObservers (
-                                     const INotificationEvent & anEvent )
+unsigned long IAsyncNotifier :: enablePolledDispatch ( )
 {
-  if ( isEnabledForNotification() )
-    theDispatchThread->enqueueNotification ( anEvent );
+  IThreadId threadId = IThread::currentId();
 
-  return *this;
+  IResourceLock threadsLock ( threadsKey );
+
+  IASSERTSTATE ( ! ( threads->containsElementWithKey ( threadId ) ) );
+
+  IAsyncNotifierThread * anAsyncNotifierThread
+                           = IAsyncNotifierThread::makePolled();
+  threads->add ( anAsyncNotifierThread );
+  cacheDispatchThread ( anAsyncNotifierThread );
+
+  anAsyncNotifierThread->addRef();
+
+  return ( anAsyncNotifierThread->readyHandle() );
 }
 
 /*------------------------------------------------------------------------------
-| Function Name: IAsyncNotifier :: dispatchThread
+| Function Name: IAsyncNotifier :: disablePolledDispatch
 |
 | Implementation:
-|   Return the dispatch thread for this object.
+|   Remove the reference held by enablePolledDispatch.
 |-----------------------------------------------------------------------------*/
-const IThreadId & IAsyncNotifier :: dispatchThread ( ) const
+void IAsyncNotifier :: disablePolledDispatch ( )
 {
-  return ( theDispatchThread->threadId() );
+  IAsyncNotifierThread * anAsyncNotifierThread = NULL;
+
+  {
+    IResourceLock threadsLock ( threadsKey );
+
+    anAsyncNotifierThread = currentDispatchThread();
+    IASSERTSTATE ( anAsyncNotifierThread->isPolled() );
+  }
+
+  releaseDispatchThread ( anAsyncNotifierThread );
 }
 
 /*------------------------------------------------------------------------------
-| Function Name: IAsyncNotifier :: notificationCleanUp
+| Function Name: IAsyncNotifier :: dispatchPending
 |
 | Implementation:
-|   This default implementation does nothing.
+|   Find the current thread's dispatch thread and have it dispatch.
+|   Observers may delete the last IAsyncNotifier while we dispatch.  The
+|     thread is running then, so it is only removed from the collection.
+|     If it is no longer there, delete it.
 |-----------------------------------------------------------------------------*/
-const IAsyncNotifier & IAsyncNotifier :: notificationCleanUp (
-                         const INotificationEvent & anEvent ) const
+unsigned long IAsyncNotifier :: dispatchPending ( )
 {
-  return *this;
+  IAsyncNotifierThread * anAsyncNotifierThread = NULL;
+  IThreadId threadId = IThread::currentId();
+
+  {
+    IResourceLock threadsLock ( threadsKey );
+
+    anAsyncNotifierThread = currentDispatchThread();
+  }
+
+  unsigned long dispatched = anAsyncNotifierThread->dispatchPending();
+
+  {
+    IResourceLock threadsLock ( threadsKey );
+
+    if ( ( ! ( threads->containsElementWithKey ( threadId ) ) ) ||
+         ( threads->elementWithKey ( threadId ) != anAsyncNotifierThread ) )
+      delete anAsyncNotifierThread;
+  }
+
+  return dispatched;
 }
 
 /*------------------------------------------------------------------------------
-| Function Name: IAsyncNotifier :: notifyObservers
+| Function Name: IAsyncNotifier :: setDispatchBatchSize
 |
 | Implementation:
-|   If enabled for notification, create an event and enqueue.
+|   Pass the batch size on to the current thread's dispatch thread.
 |-----------------------------------------------------------------------------*/
-IAsyncNotifier & IAsyncNotifier :: notifyObservers (
-                                     const INotificationId & nId )
+void IAsyncNotifier :: setDispatchBatchSize ( unsigned long maxEvents )
 {
-  if ( isEnabledForNotification() )
-  {
-    INotificationEvent anEvent ( nId, *this );
-    theDispatchThread->enqueueNotification ( anEvent );
-  }
+  IResourceLock threadsLock ( threadsKey );
 
-  return *this;
+  currentDispatchThread()->setBatchSize ( maxEvents );
 }
 
 /*------------------------------------------------------------------------------
-| Function Name: IAsyncNotifier :: findOrCreateDispatchThread
+| Function Name: IAsyncNotifier :: dispatchBatchSize
 |
 | Implementation:
-|   Find or create the dispatch thread.
+|   Return the batch size of the current thread's dispatch thread.
 |-----------------------------------------------------------------------------*/
-IAsyncNotifier & IAsyncNotifier :: findOrCreateDispatchThread ( )
+unsigned long IAsyncNotifier :: dispatchBatchSize ( )
 {
-  IThreadId threadId = IThread::currentId();
+  IResourceLock threadsLock ( threadsKey );
+
+  return ( currentDispatchThread()->batchSize() );
+}
 
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifier :: setDispatchSpinTime
+|
+| Implementation:
+|   Pass the spin time on to the current thread's dispatch thread.
+|-----------------------------------------------------------------------------*/
+void IAsyncNotifier :: setDispatchSpinTime ( unsigned long microseconds )
+{
   IResourceLock threadsLock ( threadsKey );
 
-  if ( threads->containsElementWithKey ( threadId ) )
-  {
-    theDispatchThread = threads->elementWithKey ( threadId );
-  }
-  else
-  {
-    theDispatchThread = IAsyncNotifierThread::make();
-    threads->add ( theDispatchThread );
-  }
+  currentDispatchThread()->setSpinTime ( microseconds );
+}
 
-  theDispatchThread->addRef();
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifier :: dispatchSpinTime
+|
+| Implementation:
+|   Return the spin time of the current thread's dispatch thread.
+|-----------------------------------------------------------------------------*/
+unsigned long IAsyncNotifier :: dispatchSpinTime ( )
+{
+  IResourceLock threadsLock ( threadsKey );
+
+  return ( currentDispatchThread()->spinTime() );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifier :: setDispatchProcessors
+|
+| Implementation:
+|   Pass the processors on to the current thread's dispatch thread, which
+|   is always the current thread.
+|-----------------------------------------------------------------------------*/
+void IAsyncNotifier :: setDispatchProcessors ( unsigned long firstProcessor,
+                                               unsigned long count )
+{
+  IResourceLock threadsLock ( threadsKey );
+
+  currentDispatchThread()->setProcessors ( firstProcessor, count );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifier :: dispatchPlacement
+|
+| Implementation:
+|   Return the placement of the current thread's dispatch thread.
+|-----------------------------------------------------------------------------*/
+IString IAsyncNotifier :: dispatchPlacement ( )
+{
+  IResourceLock threadsLock ( threadsKey );
+
+  return ( currentDispatchThread()->placement() );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifier :: dispatchPlacement
+|
+| Implementation:
+|   Return the placement of the passed thread's dispatch thread.
+|   Throw an invalid request exception if there is none.
+|-----------------------------------------------------------------------------*/
+IString IAsyncNotifier :: dispatchPlacement ( const IThreadId & threadId )
+{
+  IResourceLock threadsLock ( threadsKey );
+
+  IASSERTSTATE ( threads->containsElementWithKey ( threadId ) );
+
+  return ( threads->elementWithKey ( threadId )->placement() );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifier :: setDispatchCapacity
+|
+| Implementation:
+|   Pass the capacity and policy on to the current thread's dispatch thread.
+|-----------------------------------------------------------------------------*/
+void IAsyncNotifier :: setDispatchCapacity ( unsigned long maxEvents,
+                                             OverflowPolicy policy )
+{
+  IResourceLock threadsLock ( threadsKey );
+
+  currentDispatchThread()->setCapacity ( maxEvents, policy );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifier :: dispatchCapacity
+|
+| Implementation:
+|   Return the capacity of the current thread's dispatch thread.
+|-----------------------------------------------------------------------------*/
+unsigned long IAsyncNotifier :: dispatchCapacity ( )
+{
+  IResourceLock threadsLock ( threadsKey );
+
+  return ( currentDispatchThread()->capacity() );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifier :: dispatchOverflowPolicy
+|
+| Implementation:
+|   Return the overflow policy of the current thread's dispatch thread.
+|-----------------------------------------------------------------------------*/
+IAsyncNotifier::OverflowPolicy IAsyncNotifier :: dispatchOverflowPolicy ( )
+{
+  IResourceLock threadsLock ( threadsKey );
+
+  return ( currentDispatchThread()->overflowPolicy() );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifier :: dispatchOverflowCount
+|
+| Implementation:
+|   Return the overflow count of the current thread's dispatch thread.
+|-----------------------------------------------------------------------------*/
+unsigned long IAsyncNotifier :: dispatchOverflowCount ( )
+{
+  IResourceLock threadsLock ( threadsKey );
+
+  return ( currentDispatchThread()->overflowCount() );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifier :: setDispatchPoolSize
+|
+| Implementation:
+|   Save the size for when the pool is started.  It is too late once the
+|   pool exists.
+|-----------------------------------------------------------------------------*/
+void IAsyncNotifier :: setDispatchPoolSize ( unsigned long numberOfThreads )
+{
+  IResourceLock threadsLock ( threadsKey );
+
+  IASSERTSTATE ( pool == NULL );
+
+  poolSize = numberOfThreads;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifier :: dispatchPoolSize
+|
+| Implementation:
+|   Return the size of the pool if it exists, else the size it will have.
+|-----------------------------------------------------------------------------*/
+unsigned long IAsyncNotifier :: dispatchPoolSize ( )
+{
+  IResourceLock threadsLock ( threadsKey );
+
+  if ( pool != NULL )
+    return ( pool->numberOfThreads() );
+
+  if ( poolSize != 0 )
+    return poolSize;
+
+  return ( IAsyncNotifierThreadPool::processorCount() );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifier :: dispatchMetrics
+|
+| Implementation:
+|   Return a snapshot of the metrics of the current thread's dispatch thread.
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationMetrics IAsyncNotifier :: dispatchMetrics ( )
+{
+  IResourceLock threadsLock ( threadsKey );
+
+  return ( currentDispatchThread()->metrics() );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifier :: dispatchMetrics
+|
+| Implementation:
+|   Return a snapshot of the metrics of the passed thread's dispatch thread.
+|   Throw an invalid request exception if there is none.
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationMetrics IAsyncNotifier :: dispatchMetrics (
+                                              const IThreadId & threadId )
+{
+  IResourceLock threadsLock ( threadsKey );
+
+  IASSERTSTATE ( threads->containsElementWithKey ( threadId ) );
+
+  return ( threads->elementWithKey ( threadId )->metrics() );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifier :: dispatchPoolMetrics
+|
+| Implementation:
+|   Return a snapshot of the metrics of the pool, or empty metrics if the
+|   pool has not started.
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationMetrics IAsyncNotifier :: dispatchPoolMetrics ( )
+{
+  IResourceLock threadsLock ( threadsKey );
+
+  if ( pool == NULL )
+    return IAsyncNotificationMetrics();
+
+  return ( pool->metrics() );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifier :: dispatchMetricsReport
+|
+| Implementation:
+|   Append the metrics of every dispatch thread, then those of the pool.
+|   The pool is not in the collection of threads.
+|-----------------------------------------------------------------------------*/
+IString IAsyncNotifier :: dispatchMetricsReport ( )
+{
+  IResourceLock threadsLock ( threadsKey );
+
+  IString report;
+  threads->allElementsDo ( appendMetrics, &report );
+
+  if ( pool != NULL )
+    report += IString ( "Dispatch pool:\n" ) + pool->metrics().asString();
+
+  return report;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifier :: startMetricsReport
+|
+| Implementation:
+|   Stop any reports already started, then start a reporter thread with
+|   the passed interval and writer.  With no writer, use standard error.
+|   The reporter keeps its IThread object and deletes it when it stops.
+|-----------------------------------------------------------------------------*/
+void IAsyncNotifier :: startMetricsReport ( unsigned long interval,
+                                            MetricsWriter writer )
+{
+  IResourceLock threadsLock ( threadsKey );
+
+  if ( reporter != NULL )
+    reporter->stop();
+
+  reporter = new IAsyncNotificationReporter ( interval,
+                                              writer ? writer
+                                                     : writeToStandardError );
+  reporter->thread = new IThread (
+                       new IThreadMemberFn<IAsyncNotificationReporter> (
+                             *reporter, &IAsyncNotificationReporter::run ),
+                       false );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifier :: stopMetricsReport
+|
+| Implementation:
+|   Stop the reporter thread, if there is one.  It deletes itself.
+|-----------------------------------------------------------------------------*/
+void IAsyncNotifier :: stopMetricsReport ( )
+{
+  IResourceLock threadsLock ( threadsKey );
+
+  if ( reporter != NULL )
+  {
+    reporter->stop();
+    reporter = NULL;
+  }
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifier :: notifyObservers
+|
+| Implementation:
+|   Send the event with normal priority.
+|-----------------------------------------------------------------------------*/
+IAsyncNotifier & IAsyncNotifier :: notifyObservers (
+                                     const INotificationEvent & anEvent )
+{
+  return ( notifyObservers ( anEvent, normal ) );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifier :: notifyObservers
+|
+| Implementation:
+|   If enabled for notification, enqueue the event.
+|-----------------------------------------------------------------------------*/
+IAsyncNotifier & IAsyncNotifier :: notifyObservers (
+                                     const INotificationEvent & anEvent,
+                                     Priority priority )
+{
+  if ( isEnabledForNotification() )
+    enqueue ( anEvent, priority );
+
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifier :: addObserver
+|
+| Implementation:
+|   Keep observers in our own list, not the one of IStandardNotifier, which
+|   is only safe to use on one thread.
+|-----------------------------------------------------------------------------*/
+IAsyncNotifier & IAsyncNotifier :: addObserver ( IObserver        & anObserver,
+                                                 const IEventData & userData )
+{
+  observerList.add ( anObserver, userData );
+
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifier :: removeObserver
+|
+| Implementation:
+|   Remove every entry for the observer from our list.
+|-----------------------------------------------------------------------------*/
+IAsyncNotifier & IAsyncNotifier :: removeObserver ( IObserver & anObserver )
+{
+  observerList.remove ( anObserver );
+
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifier :: removeObserver
+|
+| Implementation:
+|   Remove the entries for the observer with the user data from our list.
+|-----------------------------------------------------------------------------*/
+IAsyncNotifier & IAsyncNotifier :: removeObserver (
+                                     IObserver        & anObserver,
+                                     const IEventData & userData )
+{
+  observerList.remove ( anObserver, userData );
+
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifier :: removeAllObservers
+|
+| Implementation:
+|   Empty our list.
+|-----------------------------------------------------------------------------*/
+IAsyncNotifier & IAsyncNotifier :: removeAllObservers ( )
+{
+  observerList.removeAll();
+
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifier :: notifyObserversAfter
+|
+| Implementation:
+|   Keep the delay within the range of times the wheel can tell apart, then
+|   schedule the notification for that much after now.
+|-----------------------------------------------------------------------------*/
+unsigned long IAsyncNotifier :: notifyObserversAfter (
+                                  const INotificationEvent & anEvent,
+                                  unsigned long milliseconds,
+                                  Priority priority )
+{
+  if ( milliseconds > 0x7FFFFFFFUL )
+    milliseconds = 0x7FFFFFFFUL;
+
+  return ( notifyObserversAt ( anEvent,
+                               IAsyncNotificationTimers::now() + milliseconds,
+                               priority ) );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifier :: notifyObserversAt
+|
+| Implementation:
+|   If enabled for notification, have the dispatch thread keep the event
+|   until the time comes.
+|-----------------------------------------------------------------------------*/
+unsigned long IAsyncNotifier :: notifyObserversAt (
+                                  const INotificationEvent & anEvent,
+                                  unsigned long time,
+                                  Priority priority )
+{
+  unsigned long handle = 0;
+
+  if ( isEnabledForNotification() )
+    handle = theDispatchThread->addTimer ( anEvent, priority, time );
+
+  return handle;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifier :: cancelTimedNotification
+|
+| Implementation:
+|   Pass the handle on to the dispatch thread, which only cancels it if it
+|   is one of ours.  Zero is never a handle.
+|-----------------------------------------------------------------------------*/
+IBoolean IAsyncNotifier :: cancelTimedNotification ( unsigned long handle )
+{
+  if ( handle == 0 )
+    return false;
+
+  return ( theDispatchThread->cancelTimer ( handle, *this ) );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifier :: currentTime
+|
+| Implementation:
+|   Return the time the timer wheel uses.
+|-----------------------------------------------------------------------------*/
+unsigned long IAsyncNotifier :: currentTime ( )
+{
+  return ( IAsyncNotificationTimers::now() );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifier :: dispatchTimeout
+|
+| Implementation:
+|   Ask the current thread's dispatch thread.
+|-----------------------------------------------------------------------------*/
+long IAsyncNotifier :: dispatchTimeout ( )
+{
+  IResourceLock threadsLock ( threadsKey );
+
+  return ( currentDispatchThread()->timeUntilTimer() );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifier :: enableCoalescingFor
+|
+| Implementation:
+|   Create the coalescing lock the first time coalescing is enabled.
+|   Find or add the slot for the id and set whether it is enabled.
+|-----------------------------------------------------------------------------*/
+IAsyncNotifier & IAsyncNotifier :: enableCoalescingFor (
+                                     const INotificationId & nId,
+                                     IBoolean enable )
+{
+  IPrivateResource * key = coalescingKey();
+  if ( key == NULL )
+  {
+    if ( ! enable )
+      return *this;
+    key = &(createCoalesceKey());
+  }
+
+  IResourceLock coalesceLock ( *key );
+
+  IAsyncNotificationSlot * slot = findSlot ( coalescedSlots, nId );
+  if ( slot == NULL )
+  {
+    if ( enable )
+      coalescedSlots = new IAsyncNotificationSlot ( nId, coalescedSlots );
+  }
+  else
+  {
+    slot->enabled = enable;
+  }
+
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifier :: disableCoalescingFor
+|
+| Implementation:
+|   Call enableCoalescingFor with false.
+|-----------------------------------------------------------------------------*/
+IAsyncNotifier & IAsyncNotifier :: disableCoalescingFor (
+                                     const INotificationId & nId )
+{
+  return enableCoalescingFor ( nId, false );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifier :: isCoalescingEnabledFor
+|
+| Implementation:
+|   Find the slot for the id and return whether it is enabled.
+|-----------------------------------------------------------------------------*/
+IBoolean IAsyncNotifier :: isCoalescingEnabledFor (
+                             const INotificationId & nId ) const
+{
+  IBoolean enabled = false;
+
+  IPrivateResource * key = coalescingKey();
+  if ( key != NULL )
+  {
+    IResourceLock coalesceLock ( *key );
+
+    IAsyncNotificationSlot * slot = findSlot ( coalescedSlots, nId );
+    enabled = ( ( slot != NULL ) && ( slot->enabled ) );
+  }
+
+  return enabled;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifier :: enableInlineDispatch
+|
+| Implementation:
+|   Save the flag.  enqueue looks at it.
+|-----------------------------------------------------------------------------*/
+IAsyncNotifier & IAsyncNotifier :: enableInlineDispatch ( IBoolean enable )
+{
+  inlineDispatch = enable;
+
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifier :: disableInlineDispatch
+|
+| Implementation:
+|   Call enableInlineDispatch with false.
+|-----------------------------------------------------------------------------*/
+IAsyncNotifier & IAsyncNotifier :: disableInlineDispatch ( )
+{
+  return enableInlineDispatch ( false );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifier :: isInlineDispatchEnabled
+|-----------------------------------------------------------------------------*/
+IBoolean IAsyncNotifier :: isInlineDispatchEnabled ( ) const
+{
+  return inlineDispatch;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifier :: dispatchThread
+|
+| Implementation:
+|   Return the dispatch thread for this object.
+|-----------------------------------------------------------------------------*/
+const IThreadId & IAsyncNotifier :: dispatchThread ( ) const
+{
+  return ( theDispatchThread->threadId() );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifier :: notificationCleanUp
+|
+| Implementation:
+|   This default implementation does nothing.
+|-----------------------------------------------------------------------------*/
+const IAsyncNotifier & IAsyncNotifier :: notificationCleanUp (
+                         const INotificationEvent & anEvent ) const
+{
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifier :: notifyObservers
+|
+| Implementation:
+|   Send the notification with normal priority.
+|-----------------------------------------------------------------------------*/
+IAsyncNotifier & IAsyncNotifier :: notifyObservers (
+                                     const INotificationId & nId )
+{
+  return ( notifyObservers ( nId, normal ) );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifier :: notifyObservers
+|
+| Implementation:
+|   If enabled for notification, enqueue the id.
+|-----------------------------------------------------------------------------*/
+IAsyncNotifier & IAsyncNotifier :: notifyObservers (
+                                     const INotificationId & nId,
+                                     Priority priority )
+{
+  if ( isEnabledForNotification() )
+    enqueue ( nId, priority );
+
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifier :: notifyObservers
+|
+| Implementation:
+|   If enabled for notification, enqueue the id with the payload.
+|-----------------------------------------------------------------------------*/
+IAsyncNotifier & IAsyncNotifier :: notifyObservers (
+                                     const INotificationId & nId,
+                                     const IAsyncNotificationPayload & payload,
+                                     Priority priority )
+{
+  if ( isEnabledForNotification() )
+    enqueue ( nId, priority, &payload );
+
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifier :: findOrCreateDispatchThread
+|
+| Implementation:
+|   If the current thread has cached its dispatch thread, just add a
+|     reference.  Only this thread can remove it, so no lock is needed.
+|   Otherwise find or create the dispatch thread and cache it.
+|-----------------------------------------------------------------------------*/
+IAsyncNotifier & IAsyncNotifier :: findOrCreateDispatchThread ( )
+{
+  theDispatchThread = cachedDispatchThread();
+  if ( theDispatchThread != NULL )
+  {
+    theDispatchThread->addRef();
+    return *this;
+  }
+
+  IThreadId threadId = IThread::currentId();
+
+  IResourceLock threadsLock ( threadsKey );
+
+  if ( threads->containsElementWithKey ( threadId ) )
+  {
+    theDispatchThread = threads->elementWithKey ( threadId );
+  }
+  else
+  {
+    theDispatchThread = IAsyncNotifierThread::make();
+    threads->add ( theDispatchThread );
+  }
+  cacheDispatchThread ( theDispatchThread );
+
+  theDispatchThread->addRef();
+
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifier :: findOrCreateDispatchPool
+|
+| Implementation:
+|   Start the pool if this is the first object that uses it.  It is never
+|     put in the collection of threads, so it is never found by thread id.
+|   Add a reference and create our strand.
+|-----------------------------------------------------------------------------*/
+IAsyncNotifier & IAsyncNotifier :: findOrCreateDispatchPool ( )
+{
+  IResourceLock threadsLock ( threadsKey );
+
+  if ( pool == NULL )
+  {
+    unsigned long size = poolSize;
+    if ( size == 0 )
+      size = IAsyncNotifierThreadPool::processorCount();
+    pool = new IAsyncNotifierThreadPool ( size );
+  }
+
+  theDispatchThread = pool;
+  theDispatchThread->addRef();
+  strand = pool->createStrand();
+
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifier :: currentDispatchThread
+|
+| Implementation:
+|   Return the dispatch thread for the current thread.  The caller must hold
+|   threadsKey.  Throw an invalid request exception if there is none.
+|-----------------------------------------------------------------------------*/
+IAsyncNotifierThread * IAsyncNotifier :: currentDispatchThread ( )
+{
+  IThreadId threadId = IThread::currentId();
+
+  IASSERTSTATE ( threads->containsElementWithKey ( threadId ) );
+
+  return ( threads->elementWithKey ( threadId ) );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifier :: releaseDispatchThread
+|
+| Implementation:
+|   Remove a reference to the thread.
+|   If the reference count is zero, remove the thread from the collection
+|     and clear the cache.  This is always called on the dispatch thread.
+|     If it is not running, delete it.  If it is running,
+|     IAsyncNotifier::run or IAsyncNotifier::dispatchPending will delete it.
+|   The thread pool is kept for the rest of the process.
+|-----------------------------------------------------------------------------*/
+void IAsyncNotifier :: releaseDispatchThread (
+                         IAsyncNotifierThread * anAsyncNotifierThread )
+{
+  IResourceLock threadsLock ( threadsKey );
+
+  if ( ( anAsyncNotifierThread->removeRef() == 0 ) &&
+       ( anAsyncNotifierThread != pool ) )
+  {
+    threads->removeElementWithKey ( anAsyncNotifierThread->threadId() );
+    cacheDispatchThread ( NULL );
+
+    if ( ! ( anAsyncNotifierThread->isRunning() ) )
+      delete anAsyncNotifierThread;
+  }
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifier :: openHandle
+|
+| Implementation:
+|   Take the oldest free entry under the guard.  If there is none, allocate
+|     a block without the guard held, then add its entries to the free list
+|     under the guard and try again.  Another object may have freed an entry
+|     in the meantime, so the new block may not be needed.  The first block
+|     does not give out index zero.
+|   Note the index and generation of the entry.
+|-----------------------------------------------------------------------------*/
+IAsyncNotifier & IAsyncNotifier :: openHandle ( )
+{
+  IAsyncNotifierHandle * newBlock = NULL;
+  IAsyncNotifierHandle * handle = NULL;
+
+  while ( handle == NULL )
+  {
+    IBoolean full = false;
+
+    IAtomic::acquire ( handleGuard );
+
+    if ( ( firstFreeHandle == NULL ) && ( newBlock != NULL ) &&
+         ( handleBlockCount < maximumHandleBlocks ) )
+    {
+      unsigned long firstIndex = handleBlockCount * handlesPerBlock;
+      for ( unsigned long i = ( firstIndex == 0 ) ? 1 : 0;
+            i < handlesPerBlock;
+            i++ )
+      {
+        IAsyncNotifierHandle & newHandle = newBlock[i];
+        newHandle.generation = 1;
+        newHandle.pins = 0;
+        newHandle.closer = NULL;
+        newHandle.index = firstIndex + i;
+        newHandle.next = NULL;
+        if ( lastFreeHandle != NULL )
+          lastFreeHandle->next = &newHandle;
+        else
+          firstFreeHandle = &newHandle;
+        lastFreeHandle = &newHandle;
+      }
+      handleBlocks[handleBlockCount++] = newBlock;
+      newBlock = NULL;
+    }
+
+    handle = firstFreeHandle;
+    if ( handle != NULL )
+    {
+      firstFreeHandle = handle->next;
+      if ( firstFreeHandle == NULL )
+        lastFreeHandle = NULL;
+      handle->next = NULL;
+    }
+    else
+    {
+      full = ( handleBlockCount == maximumHandleBlocks );
+    }
+
+    IAtomic::release ( handleGuard );
+
+    if ( full )
+    {
+      IResourceExhausted exc ( "Too many IAsyncNotifier objects exist.",
+                               0, IException::recoverable );
+      ITHROW ( exc );
+    }
+
+    if ( handle == NULL )
+      newBlock = new IAsyncNotifierHandle [handlesPerBlock];
+  }
+
+  delete [] newBlock;
+
+  handleIndex = handle->index;
+  handleGeneration = (unsigned long)IAtomic::value ( handle->generation );
+
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifier :: closeHandle
+|
+| Implementation:
+|   Change the generation of our entry, skipping zero.  From now on every
+|     pin of our notifications fails.
+|   If asked to, wait until no dispatch thread has us pinned.  The exchange
+|     comes before the read of the pins, and a pin adds itself before it
+|     reads the generation, so either the pin sees the new generation or we
+|     see the pin.  While there are pins, put an event semaphore in the
+|     entry and wait on it.  The unpin that takes the last pin reads the
+|     entry after it, so either it posts or we see no pins.  Any other unpin
+|     only wakes us to look again.  Take the semaphore out under the guard,
+|     which the unpin holds while it posts.
+|   Put the entry at the end of the free list.  A dispatch thread that still
+|     has it pinned only takes its own pin back.
+|   Our notifications queued from now on have no handle.
+|-----------------------------------------------------------------------------*/
+IAsyncNotifier & IAsyncNotifier :: closeHandle ( IBoolean waitForDispatch )
+{
+  IAsyncNotifierHandle & handle = handleAt ( handleIndex );
+
+  unsigned long generation = handleGeneration + 1;
+  if ( generation == 0 )
+    generation = 1;
+  IAtomic::exchange ( handle.generation, (long)generation );
+
+  if ( ( waitForDispatch ) && ( IAtomic::value ( handle.pins ) != 0 ) )
+  {
+    IEventSem unpinned ( IEventSem::autoReset );
+    IAtomic::exchange ( handle.closer, &unpinned );
+
+    while ( IAtomic::value ( handle.pins ) != 0 )
+      unpinned.wait();
+
+    IAtomic::acquire ( handleGuard );
+    IAtomic::exchange ( handle.closer, NULL );
+    IAtomic::release ( handleGuard );
+  }
+
+  IAtomic::acquire ( handleGuard );
+  if ( lastFreeHandle != NULL )
+    lastFreeHandle->next = &handle;
+  else
+    firstFreeHandle = &handle;
+  lastFreeHandle = &handle;
+  IAtomic::release ( handleGuard );
+
+  handleIndex = 0;
+  handleGeneration = 0;
+
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifier :: pinHandle
+|
+| Implementation:
+|   Index zero has no object to check.
+|   Count the pin, then see if the entry still has the generation.  If not,
+|   the object was deleted, so take the pin back as unpinHandle does, in
+|   case a close is waiting for it, and return false.
+|-----------------------------------------------------------------------------*/
+IBoolean IAsyncNotifier :: pinHandle ( unsigned long index,
+                                       unsigned long generation )
+{
+  if ( index == 0 )
+    return true;
+
+  IAsyncNotifierHandle & handle = handleAt ( index );
+
+  IAtomic::increment ( handle.pins );
+  if ( (unsigned long)IAtomic::value ( handle.generation ) == generation )
+    return true;
+
+  unpinHandle ( index );
+  return false;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifier :: unpinHandle
+|
+| Implementation:
+|   Take back a pin that pinHandle counted.  If it was the last one and a
+|   close is waiting, post its event semaphore under the guard, so the close
+|   can not destroy it first.
+|-----------------------------------------------------------------------------*/
+void IAsyncNotifier :: unpinHandle ( unsigned long index )
+{
+  if ( index == 0 )
+    return;
+
+  IAsyncNotifierHandle & handle = handleAt ( index );
+
+  if ( ( IAtomic::decrement ( handle.pins ) == 0 ) &&
+       ( IAtomic::value ( handle.closer ) != NULL ) )
+  {
+    IAtomic::acquire ( handleGuard );
+    IEventSem * unpinned = (IEventSem *)IAtomic::value ( handle.closer );
+    if ( unpinned != NULL )
+      unpinned->post();
+    IAtomic::release ( handleGuard );
+  }
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifier :: enqueue
+|
+| Implementation:
+|   If the event has no payload and is coalesced, it is done.
+|   If inline dispatching is enabled and the dispatch thread says it can,
+|     dispatch the event now.  Not while our observers are being notified:
+|     the new event would reach the first of them before the one being
+|     dispatched reaches the rest.
+|   If the dispatch thread's queue is full, count the overflow and apply
+|     the overflow policy:
+|     blockSender    - Wait for room, unless this is the dispatch thread,
+|                      which would wait forever.
+|     dropOldest     - Nothing to do here.  The dispatch thread throws away
+|                      the excess.
+|     dropNewest     - Count the drop, clean up the event if it has no
+|                      payload and return.
+|     coalesceLatest - Coalesce the event and return.  An event with a
+|                      payload is queued anyway.
+|     throwException - Throw a recoverable resource exhausted exception.
+|   Enqueue the event on the dispatch thread in the lane for its priority,
+|   with its payload.
+|-----------------------------------------------------------------------------*/
+IAsyncNotifier & IAsyncNotifier :: enqueue (
+                                     const INotificationEvent & anEvent,
+                                     Priority priority,
+                                     const IAsyncNotificationPayload * payload )
+{
+  if ( ( payload == 0 ) && ( coalesce ( anEvent, priority ) ) )
+    return *this;
+
+  if ( ( inlineDispatch ) &&
+       ( ! ( observerList.isNotifying() ) ) &&
+       ( theDispatchThread->canDispatchInline ( *this ) ) )
+  {
+    theDispatchThread->dispatchInline ( anEvent, payload != 0 );
+    return *this;
+  }
+
+  if ( theDispatchThread->isFull() )
+  {
+    theDispatchThread->noteOverflow();
+
+    switch ( theDispatchThread->overflowPolicy() )
+    {
+      case blockSender :
+        if ( theDispatchThread->threadId() != IThread::currentId() )
+          theDispatchThread->waitForRoom();
+        break;
+
+      case dropOldest :
+        break;
+
+      case dropNewest :
+        theDispatchThread->noteDropped ( 1 );
+        if ( payload == 0 )
+          notificationCleanUp ( anEvent );
+        return *this;
+
+      case coalesceLatest :
+        if ( payload != 0 )
+          break;
+        coalesce ( anEvent, priority, true );
+        return *this;
+
+      case throwException :
+      {
+        IResourceExhausted exc ( "The notification queue is full.",
+                                 0, IException::recoverable );
+        ITHROW ( exc );
+      }
+    }
+  }
+
+  theDispatchThread->enqueueNotification ( anEvent, priority, payload );
+
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifier :: enqueue
+|
+| Implementation:
+|   In the usual case, where the notification can not be coalesced, is not
+|     dispatched inline and the queue has room, have the dispatch thread
+|     construct the event right in its queue.  The event is never copied
+|     and the payload value is copied once, into the queue.
+|   Otherwise create an event and enqueue it as above.  Its data points at
+|     the payload value, so it can be dispatched inline without a copy.
+|     The queue points the data of its copy at its copy of the value.
+|-----------------------------------------------------------------------------*/
+IAsyncNotifier & IAsyncNotifier :: enqueue (
+                                     const INotificationId & nId,
+                                     Priority priority,
+                                     const IAsyncNotificationPayload * payload )
+{
+  if ( ( ( payload != 0 ) || ( coalescingKey() == NULL ) ) &&
+       ( ! ( inlineDispatch ) ) &&
+       ( ! ( theDispatchThread->isFull() ) ) )
+  {
+    theDispatchThread->enqueueNotification ( nId, *this, priority, payload );
+    return *this;
+  }
+
+  INotificationEvent anEvent ( nId, *this, true,
+                               payload ? IEventData ( (void *)payload->value() )
+                                       : IEventData() );
+  return ( enqueue ( anEvent, priority, payload ) );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifier :: coalesce
+|
+| Implementation:
+|   If coalescing is not enabled for the event's id, return false.  If the
+|     queue is overflowing, coalesce anyway, creating the lock and a
+|     disabled slot for the id if needed.
+|   Save a copy of the event in the slot.
+|   If the slot already held an event, that event was not dispatched yet.
+|     Count it as coalesced, clean it up and delete it.  Its coalescedId
+|     event is still queued and will dispatch the new one.
+|   Else, enqueue a coalescedId event with the event's priority to dispatch
+|     the new one.
+|-----------------------------------------------------------------------------*/
+IBoolean IAsyncNotifier :: coalesce ( const INotificationEvent & anEvent,
+                                      Priority priority,
+                                      IBoolean overflowing )
+{
+  IPrivateResource * key = coalescingKey();
+  if ( key == NULL )
+  {
+    if ( ! overflowing )
+      return false;
+    key = &(createCoalesceKey());
+  }
+
+  IAsyncNotificationSlot * slot = NULL;
+  INotificationEvent * replacedEvent = NULL;
+
+  {
+    IResourceLock coalesceLock ( *key );
+
+    slot = findSlot ( coalescedSlots, anEvent.notificationId() );
+    if ( ( slot == NULL ) && ( overflowing ) )
+    {
+      slot = coalescedSlots = new IAsyncNotificationSlot (
+                                    anEvent.notificationId(),
+                                    coalescedSlots );
+      slot->enabled = false;
+    }
+
+    if ( ( slot == NULL ) || ( ( ! ( slot->enabled ) ) && ( ! overflowing ) ) )
+      return false;
+
+    replacedEvent = slot->pendingEvent;
+    slot->pendingEvent = new INotificationEvent ( anEvent );
+  }
+
+  if ( replacedEvent != NULL )
+  {
+    theDispatchThread->noteCoalesced();
+    notificationCleanUp ( *replacedEvent );
+    delete replacedEvent;
+  }
+  else
+  {
+    theDispatchThread->enqueueNotification ( INotificationEvent (
+                                               IAsyncNotifierThread::coalescedId,
+                                               *this,
+                                               false,
+                                               IEventData ( (void *)slot ) ),
+                                             priority );
+  }
+
+  return true;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifier :: coalescingKey
+|
+| Implementation:
+|   The lock is created once, by any sending thread, and then never changes
+|   until the object is deleted.  Read it with IAtomic so a thread that sees
+|   the pointer also sees the constructed lock.
+|-----------------------------------------------------------------------------*/
+IPrivateResource * IAsyncNotifier :: coalescingKey ( ) const
+{
+  return ( (IPrivateResource *)IAtomic::value (
+                                 *(void * const volatile *)(&coalesceKey) ) );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifier :: createCoalesceKey
+|
+| Implementation:
+|   Sending threads may create the coalescing lock when the queue overflows,
+|   so create it under threadsKey and only if no other thread has.  Store it
+|   with an exchange after it is constructed, since other threads read it
+|   without threadsKey.
+|-----------------------------------------------------------------------------*/
+IPrivateResource & IAsyncNotifier :: createCoalesceKey ( )
+{
+  IResourceLock threadsLock ( threadsKey );
+
+  IPrivateResource * key = coalescingKey();
+  if ( key == NULL )
+  {
+    key = new IPrivateResource;
+    IAtomic::exchange ( *(void * volatile *)(&coalesceKey), key );
+  }
+
+  return *key;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifier :: dispatchCoalesced
+|
+| Implementation:
+|   Called on the dispatch thread for a coalescedId event.
+|   Take the latest event out of the slot so later ones queue a new
+|     coalescedId event, then notify observers and clean it up.
+|-----------------------------------------------------------------------------*/
+IAsyncNotifier & IAsyncNotifier :: dispatchCoalesced (
+                                     const INotificationEvent & anEvent )
+{
+  IAsyncNotificationSlot * slot = (IAsyncNotificationSlot *)
+                                    (anEvent.eventData().asUnsignedLong());
+  INotificationEvent * latestEvent = NULL;
+
+  {
+    IResourceLock coalesceLock ( *coalescingKey() );
+
+    latestEvent = slot->pendingEvent;
+    slot->pendingEvent = NULL;
+  }
+
+  if ( latestEvent != NULL )
+  {
+    if ( isEnabledForNotification() )
+      observerList.notify ( *latestEvent );
+    notificationCleanUp ( *latestEvent );
+    delete latestEvent;
+  }
 
   return *this;
 }
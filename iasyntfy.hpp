@@ -28,13 +28,32 @@
   #include <ireslock.hpp>
 #endif
 
+#ifndef _IASYNMTR_
+  #include <iasynmtr.hpp>
+#endif
+
+#ifndef _IASYNOBS_
+  #include <iasynobs.hpp>
+#endif
+
+#ifndef _IASYNPAY_
+  #include <iasynpay.hpp>
+#endif
+
 #pragma library("asyncnot.lib")
 
 class IAsyncNotifierThread;
+class IAsyncNotifierThreadPool;
+class IAsyncNotificationSlot;
+class IAsyncNotificationNode;
+class IAsyncNotificationStrand;
+class IAsyncNotificationReporter;
 template <class Element, class Key> class IKeySet;
 
-// Align classes on four byte boundary.
-#pragma pack(4)
+// Align classes on four byte boundary, except on Linux (see iatomic.hpp).
+#ifndef __linux__
+  #pragma pack(4)
+#endif
 
 class IAsyncNotifier : public IStandardNotifier {
 /*******************************************************************************
@@ -68,32 +87,58 @@ class IAsyncNotifier : public IStandardNotifier {
 * time, for example as the thread it was created on terminates, use the
 * delete operator.
 *
-* An IAsyncNotifier object must be deleted on the same thread on which it was
-* created.  The deleteThis function may be used from any thread and this
-* condition will be met.  When an IAsyncNotifier object is deleted, all pending
-* notifications are destroyed and are never dispatched.  This is to ensure that
-* notifications are not sent for objects that do not exist.  The delete
-* notification is sent on the same thread on which the object is deleted.  When
-* deleteThis is used, the delete notification will occur on the same thread
-* on which the object was created.
+* An IAsyncNotifier object may be deleted on any thread.  When it is deleted,
+* all pending notifications are destroyed and are never dispatched.  This is
+* to ensure that notifications are not sent for objects that do not exist.  On
+* the thread on which it was created, they are cleaned up and deleted at once.
+* On any other thread the delete does not look at the queue at all: the
+* dispatch thread skips the notifications when it reaches them, without
+* calling notificationCleanUp, so their event data should be owned by a
+* payload.  A delete on another thread waits while a notification of the
+* object is being dispatched, and cancels its timed notifications.  That wait
+* is done by the IAsyncNotifier destructor, after subclass destructors have
+* run, so a subclass that may be deleted on another thread and has data its
+* observers use can call close first in its destructor.  The delete
+* notification is sent on the same thread on which the object is deleted or
+* closed.
+* When deleteThis is used, the delete notification will occur on the same
+* thread on which the object was created.
 *
 * Subclass destructors must ensure that all internal threads are stopped.
 *
+* An IAsyncNotifier object can instead be constructed to have its
+* notifications dispatched by a pool of threads shared by the process.  Its
+* notifications are still dispatched one at a time and in order, but not
+* always on the same thread, and the notifications of different objects are
+* dispatched in parallel.  Such an object may be deleted on any thread.  It
+* is only deleted on its dispatch thread by one of its own notifications:
+* either with deleteThis or by an observer that uses the delete operator.
+* Deleted anywhere else, it is treated as deleted on another thread.
+*
 *******************************************************************************/
 
 public:
 /*------------------------------ Constructors ----------------------------------
 | You can not directly construct an object of this abstract base class.        |
-| An IAsyncNotifier object must be deleted on the same thread on which it was  |
-| created.  An invalid request exception is thrown if a delete is attempted    |
-| a different thread and the object will be in an undefined state.             |
+| An IAsyncNotifier object may be deleted on any thread; see the class         |
+| description for what happens to its pending notifications.  A resource       |
+| exhausted exception is thrown if 4194303 objects already exist.              |
 | Subclasses can initialize this class as follows:                             |
 |   - With the default constructor.                                            |
+|   - With the dispatch policy:                                                |
+|       currentThread - The current thread is the dispatch thread, as with the |
+|                       default constructor.                                   |
+|       threadPool    - The notifications are dispatched by the thread pool.   |
+|                       It is started when the first such object is created.   |
 |   - With the copy constructor.  The created object's dispatch thread is the  |
 |     current thread, not the dispatch thread of the parameter.                |
 |-----------------------------------------------------------------------------*/
+enum DispatchPolicy { currentThread, threadPool };
+
 IAsyncNotifier ( );
 
+IAsyncNotifier ( DispatchPolicy policy );
+
 IAsyncNotifier ( const IAsyncNotifier & asyncNotifier );
 
 virtual ~IAsyncNotifier ( ) = 0;
@@ -105,8 +150,20 @@ virtual ~IAsyncNotifier ( ) = 0;
 |                function should be used instead of the delete operator when   |
 |                you wish to delete this object in response to one of its      |
 |                notifications.                                                |
+|   close      - Sends the delete notification and stops the notifications of  |
+|                this object as deleting it does, waiting on another thread    |
+|                while one is being dispatched.  The destructor does this if   |
+|                it was not done, so it is only needed to stop notifications   |
+|                early, for example first thing in a subclass destructor.      |
+|                Afterwards the object may only be deleted.  It does nothing   |
+|                if the object is already closed.  On another thread,          |
+|                an invalid request exception is thrown if the dispatch thread |
+|                is not running, is not polled and is not the thread pool,     |
+|                since nothing would then release the object's reference to    |
+|                it.                                                           |
 |-----------------------------------------------------------------------------*/
 IAsyncNotifier & deleteThis ( );
+IAsyncNotifier & close      ( );
 
 /*------------------------------- Assignment -----------------------------------
 | The assignment for this class is the standard assignment operator.           |
@@ -125,20 +182,342 @@ IAsyncNotifier & operator = ( const IAsyncNotifier & rhs );
 |         return until there are no more objects with this thread as their     |
 |         dispatch thread.  If this is not a GUI thread and no IAsyncNotifier  |
 |         objects have been created on this thread, an invalid request         |
-|         exception is thrown.                                                 |
+|         exception is thrown.  If polled dispatch is enabled for this thread, |
+|         an invalid request exception is thrown.                              |
 |-----------------------------------------------------------------------------*/
 static void run ( );
 
+/*---------------------------- Polled Dispatching ------------------------------
+| Use these functions to dispatch notifications for the current thread from an |
+| event loop the application already runs, rather than by calling run.         |
+|   enablePolledDispatch  - Creates a dispatch thread for the current thread   |
+|                           that never blocks, and returns a handle that is    |
+|                           signaled while notifications are waiting.  On OS/2 |
+|                           it is an event semaphore handle that can be added  |
+|                           to a muxwait semaphore.  On Linux it is a file     |
+|                           descriptor that polls readable.  An invalid        |
+|                           request exception is thrown if this is a GUI       |
+|                           thread or if IAsyncNotifier objects have already   |
+|                           been created on this thread.                       |
+|   disablePolledDispatch - Releases the dispatch thread created by            |
+|                           enablePolledDispatch.  The handle is closed when   |
+|                           there are no IAsyncNotifier objects left on the    |
+|                           thread.  Until then dispatchPending still works.   |
+|   dispatchPending       - Dispatches one batch of the waiting notifications  |
+|                           and returns the number dispatched.  It does not    |
+|                           wait for notifications.  Call it when the handle   |
+|                           is signaled.  The handle stays signaled if more    |
+|                           notifications are waiting.  An invalid request     |
+|                           exception is thrown if polled dispatch is not      |
+|                           enabled for the current thread.  Timed             |
+|                           notifications do not signal the handle, so use     |
+|                           dispatchTimeout as the timeout of the wait.        |
+|-----------------------------------------------------------------------------*/
+static unsigned long enablePolledDispatch  ( );
+static void          disablePolledDispatch ( );
+static unsigned long dispatchPending       ( );
+
+/*------------------------------- Thread Pool ----------------------------------
+| Use these functions to size the thread pool that dispatches the              |
+| notifications of objects constructed with the threadPool dispatch policy.    |
+| The batch size, capacity and polling functions for the current thread do     |
+| not apply to the pool.                                                       |
+|   setDispatchPoolSize - Sets the number of threads the pool starts with.     |
+|                         Zero means one for each processor, which is the      |
+|                         default.  An invalid request exception is thrown if  |
+|                         the pool has already been started.                   |
+|   dispatchPoolSize    - Returns the number of threads the pool has, or will  |
+|                         have when it is started.                             |
+|-----------------------------------------------------------------------------*/
+static void          setDispatchPoolSize ( unsigned long numberOfThreads );
+static unsigned long dispatchPoolSize    ( );
+
+/*---------------------------- Dispatch Batching -------------------------------
+| Use these functions to control how many queued notifications the current     |
+| thread dispatches at a time.  An invalid request exception is thrown if no   |
+| IAsyncNotifier objects have been created on this thread.                     |
+|   setDispatchBatchSize - Sets the maximum number of notifications that are   |
+|                          taken from the queue and dispatched as one batch.   |
+|                          Notifications queued while a batch is dispatched    |
+|                          wait for the next batch, so a small size bounds the |
+|                          time before the thread looks for other work.  Zero  |
+|                          means no limit.                                     |
+|   dispatchBatchSize    - Returns the maximum batch size for the current      |
+|                          thread.  The default is 64.                         |
+|-----------------------------------------------------------------------------*/
+static void          setDispatchBatchSize ( unsigned long maxEvents );
+static unsigned long dispatchBatchSize    ( );
+
+/*------------------------------- Spin Polling ---------------------------------
+| Use these functions to have the current thread poll its empty queue for a    |
+| while before it blocks, so a notification sent soon after is dispatched      |
+| within microseconds instead of after the thread is woken.  The thread uses   |
+| processor time while it polls.  Only threads without a message queue that    |
+| dispatch by calling run spin.  An invalid request exception is thrown if no  |
+| IAsyncNotifier objects have been created on this thread.                     |
+|   setDispatchSpinTime - Sets the longest time, in microseconds, that the     |
+|                         thread polls.  The time actually spent follows the   |
+|                         recent gaps between notifications: about twice       |
+|                         their average, or none while they are longer than    |
+|                         the spin time.  Zero, the default, means the thread  |
+|                         blocks at once.  With only one processor the spin    |
+|                         time stays zero.  dispatchMetrics counts how often   |
+|                         a notification came while polling.                   |
+|   dispatchSpinTime    - Returns the longest spin time for the current        |
+|                         thread.                                              |
+|-----------------------------------------------------------------------------*/
+static void          setDispatchSpinTime ( unsigned long microseconds );
+static unsigned long dispatchSpinTime    ( );
+
+/*-------------------------------- Placement -----------------------------------
+| Use these functions to keep the current thread, and the storage its queue    |
+| uses, on a set of processors, so notifications do not cross between memory   |
+| nodes.  An invalid request exception is thrown if no IAsyncNotifier objects  |
+| have been created on the thread.                                             |
+|   setDispatchProcessors - Runs the current thread only on the passed number  |
+|                           of processors, starting with the passed one.       |
+|                           Processors are numbered from zero.  The free       |
+|                           storage for the thread's queue is then allocated   |
+|                           again by the thread, so where the system places    |
+|                           memory on the node of the processor that first     |
+|                           touches it, queued notifications are local to the  |
+|                           thread.  Call it before sending many               |
+|                           notifications.  An invalid parameter exception is  |
+|                           thrown if the system can not name all of the       |
+|                           processors.                                        |
+|   dispatchPlacement     - Returns the processors and memory node of the      |
+|                           current thread, or of the thread with the passed   |
+|                           id, as text.  It is empty if the thread may run on |
+|                           any processor.  dispatchMetricsReport includes it. |
+|-----------------------------------------------------------------------------*/
+static void    setDispatchProcessors ( unsigned long firstProcessor,
+                                       unsigned long count = 1 );
+static IString dispatchPlacement     ( );
+static IString dispatchPlacement     ( const IThreadId & threadId );
+
+/*------------------------------ Queue Capacity --------------------------------
+| Use these functions to bound the number of notifications waiting for the     |
+| current thread, and to choose what happens to a notification sent while the  |
+| queue is full.  The notifications IAsyncNotifier sends to itself to delete   |
+| itself and to dispatch coalesced notifications are always queued.  An        |
+| invalid request exception is thrown if no IAsyncNotifier objects have been   |
+| created on this thread.                                                      |
+|   OverflowPolicy         - What to do with a notification sent while the     |
+|                            queue is full:                                    |
+|                            blockSender    - The sending thread waits until   |
+|                                             there is room.  A notification   |
+|                                             sent on the dispatch thread      |
+|                                             itself is queued anyway.         |
+|                            dropOldest     - The notification is queued.  The |
+|                                             dispatch thread throws away the  |
+|                                             oldest notifications of the      |
+|                                             lowest priority before its next  |
+|                                             batch.                           |
+|                            dropNewest     - The notification is not queued.  |
+|                                             notificationCleanUp is called    |
+|                                             for it on the sending thread.    |
+|                            coalesceLatest - The notification replaces one    |
+|                                             with the same id from the same   |
+|                                             object, as if coalescing were    |
+|                                             enabled for the id.              |
+|                            throwException - notifyObservers throws a         |
+|                                             resource exhausted exception.    |
+|                                             The sender still owns the event  |
+|                                             data.                            |
+|   setDispatchCapacity    - Sets the number of waiting notifications at which |
+|                            the queue is full and the overflow policy.  Zero  |
+|                            means no limit.  This is the default, with        |
+|                            blockSender.                                      |
+|   dispatchCapacity       - Returns the capacity for the current thread.      |
+|   dispatchOverflowPolicy - Returns the overflow policy for the current       |
+|                            thread.                                           |
+|   dispatchOverflowCount  - Returns the number of notifications that have     |
+|                            been sent to the current thread while its queue   |
+|                            was full.                                         |
+|-----------------------------------------------------------------------------*/
+enum OverflowPolicy { blockSender, dropOldest, dropNewest, coalesceLatest,
+                      throwException };
+
+static void           setDispatchCapacity    (
+                        unsigned long maxEvents,
+                        OverflowPolicy policy = blockSender );
+static unsigned long  dispatchCapacity       ( );
+static OverflowPolicy dispatchOverflowPolicy ( );
+static unsigned long  dispatchOverflowCount  ( );
+
+/*--------------------------------- Metrics ------------------------------------
+| Use these functions to find out how well dispatch threads keep up.  Every    |
+| dispatch thread records the depth of its queue, how long notifications wait  |
+| in it, how long the observers of each notification id take and how many      |
+| notifications were coalesced or dropped.  See IAsyncNotificationMetrics.     |
+|   dispatchMetrics       - Returns a snapshot of the metrics of the current   |
+|                           thread, or of the thread with the passed id.  An   |
+|                           invalid request exception is thrown if the thread  |
+|                           has no IAsyncNotifier objects.                     |
+|   dispatchPoolMetrics   - Returns a snapshot of the metrics of the thread    |
+|                           pool.  They are all zero if it has not started.    |
+|   dispatchMetricsReport - Returns the metrics of every thread and of the     |
+|                           pool as text.                                      |
+|   MetricsWriter         - A function that is passed a report.                |
+|   startMetricsReport    - Starts a thread that passes a report to the        |
+|                           writer each time the passed number of              |
+|                           milliseconds goes by.  The default writer writes   |
+|                           it to standard error.  Reports already started     |
+|                           are stopped first.                                 |
+|   stopMetricsReport     - Stops the reports.                                 |
+|-----------------------------------------------------------------------------*/
+typedef void (* MetricsWriter) ( const IString & report );
+
+static IAsyncNotificationMetrics dispatchMetrics       ( );
+static IAsyncNotificationMetrics dispatchMetrics       (
+                                   const IThreadId & threadId );
+static IAsyncNotificationMetrics dispatchPoolMetrics   ( );
+static IString                   dispatchMetricsReport ( );
+static void                      startMetricsReport    (
+                                   unsigned long interval,
+                                   MetricsWriter writer = 0 );
+static void                      stopMetricsReport     ( );
+
+/*------------------------- Notification Priority ------------------------------
+| Each dispatch thread has a queue, or lane, for each of these priorities.     |
+| Notifications in a higher priority lane are always dispatched before those   |
+| in a lower one.  Within a lane, the notifications of each object are         |
+| dispatched in the order they were sent.                                      |
+|   low    - For notifications that can wait, such as progress reports.        |
+|   normal - The priority of notifications sent without one.                   |
+|   high   - For notifications that should not wait behind normal ones.        |
+|   urgent - For control and status notifications that must be seen first.     |
+|-----------------------------------------------------------------------------*/
+enum Priority { low, normal, high, urgent };
+
 /*-------------------------- Observer Notification -----------------------------
-| Use this function to asynchronously notify observers of an event.            |
+| Use these functions to asynchronously notify observers of an event.          |
 |   notifyObservers - If notification is enabled, queues notification for      |
-|                     dispatch and returns.                                    |
+|                     dispatch and returns.  Without a priority it is queued   |
+|                     with normal priority.                                    |
 |-----------------------------------------------------------------------------*/
 virtual IAsyncNotifier & notifyObservers ( const INotificationEvent & anEvent );
+virtual IAsyncNotifier & notifyObservers ( const INotificationEvent & anEvent,
+                                           Priority priority );
+
+/*-------------------------------- Observers -----------------------------------
+| Use these functions to add and remove observers.  Unlike those of            |
+| IStandardNotifier, they can be called on any thread, even while the dispatch |
+| thread is notifying observers, which never waits for them.  See              |
+| IAsyncObserverList.                                                          |
+|   addObserver        - Adds the observer with the passed user data.  It is   |
+|                        set as the observer data of the events passed to the  |
+|                        observer.                                             |
+|   removeObserver     - Removes the observer, or only where it was added with |
+|                        the passed user data.  A notification whose dispatch  |
+|                        already started on another thread may still reach it. |
+|   removeAllObservers - Removes every observer.                               |
+|-----------------------------------------------------------------------------*/
+virtual IAsyncNotifier & addObserver        ( IObserver        & anObserver,
+                                              const IEventData & userData
+                                                           = IEventData() );
+virtual IAsyncNotifier & removeObserver     ( IObserver        & anObserver );
+virtual IAsyncNotifier & removeObserver     ( IObserver        & anObserver,
+                                              const IEventData & userData );
+virtual IAsyncNotifier & removeAllObservers ( );
+
+/*--------------------------- Timed Notification -------------------------------
+| Use these functions to have observers notified later without a thread of     |
+| your own.  The dispatch thread keeps timed notifications until they are due  |
+| and then queues them with their priority.  They are dispatched after the     |
+| notifications already queued at that time, so they can be late but never     |
+| early.  Deleting this object cancels its timed notifications.                |
+|   notifyObserversAfter    - If notification is enabled, queues the           |
+|                             notification for dispatch after the passed       |
+|                             number of milliseconds and returns a handle for  |
+|                             it.  Otherwise returns zero.  A resource         |
+|                             exhausted exception is thrown if the dispatch    |
+|                             thread already has 65536 timed notifications.    |
+|   notifyObserversAt       - Like notifyObserversAfter, but the notification  |
+|                             is due at the passed time, as returned by        |
+|                             currentTime.  It must be less than 24 days away. |
+|   cancelTimedNotification - If the handle is for a timed notification of     |
+|                             this object that has not been queued for         |
+|                             dispatch yet, it is never dispatched and true is |
+|                             returned.  notificationCleanUp is called for it  |
+|                             on the dispatch thread.  Old handles never       |
+|                             cancel other notifications.                      |
+|   currentTime             - Returns the current time in milliseconds.  It    |
+|                             wraps around about every 49 days.                |
+|   dispatchTimeout         - Returns the number of milliseconds until a timed |
+|                             notification for the current thread may be due,  |
+|                             or -1 if there are none.  With polled dispatch,  |
+|                             the ready handle is not signaled when a timed    |
+|                             notification is due, so call dispatchPending     |
+|                             when this time has passed.  An invalid request   |
+|                             exception is thrown if no IAsyncNotifier objects |
+|                             have been created on this thread.                |
+|-----------------------------------------------------------------------------*/
+unsigned long notifyObserversAfter    ( const INotificationEvent & anEvent,
+                                        unsigned long milliseconds,
+                                        Priority priority = normal );
+unsigned long notifyObserversAt       ( const INotificationEvent & anEvent,
+                                        unsigned long time,
+                                        Priority priority = normal );
+IBoolean      cancelTimedNotification ( unsigned long handle );
+
+static unsigned long currentTime     ( );
+static long          dispatchTimeout ( );
+
+/*------------------------- Notification Coalescing ----------------------------
+| Use these functions to have a newer notification replace an older one that   |
+| is still waiting to be dispatched.  This bounds the number of pending        |
+| attribute change notifications by the number of attributes rather than by    |
+| how often they change.  Coalescing should be enabled before notifications    |
+| with the id are sent.                                                        |
+|   enableCoalescingFor    - If true is passed, a notification with the passed |
+|                            id that is sent while another one with the same   |
+|                            id from this object is pending replaces the       |
+|                            pending one and is dispatched in its place in the |
+|                            queue, with its priority.  The replaced           |
+|                            notification is never dispatched.                 |
+|                            notificationCleanUp is called for it on the       |
+|                            thread that replaced it.  If false is passed,     |
+|                            coalescing is disabled for the id.                |
+|   disableCoalescingFor   - Notifications with the passed id are queued one   |
+|                            after another.  This is the default.              |
+|   isCoalescingEnabledFor - Returns true if notifications with the passed id  |
+|                            are coalesced.                                    |
+|-----------------------------------------------------------------------------*/
+IAsyncNotifier & enableCoalescingFor    ( const INotificationId & nId,
+                                          IBoolean enable = true );
+IAsyncNotifier & disableCoalescingFor   ( const INotificationId & nId );
+IBoolean         isCoalescingEnabledFor ( const INotificationId & nId ) const;
+
+/*--------------------------- Inline Dispatching -------------------------------
+| Use these functions to have notifications sent on the dispatch thread, such  |
+| as those sent by an observer of another notification, dispatched right away  |
+| instead of being queued.  A notification is only dispatched inline if the    |
+| dispatch thread is running, none of this object's notifications are queued   |
+| and none is being dispatched, so the order of its notifications does not     |
+| change.  Otherwise it is queued as usual.  Notifications dispatched inline   |
+| do not wait behind those of higher priority from other objects, and an       |
+| observer that deletes this object deletes it before notifyObservers returns. |
+| Objects dispatched by the thread pool always queue.  Inline dispatching      |
+| should be enabled before notifications are sent.                             |
+|   enableInlineDispatch    - If true is passed, notifications are dispatched  |
+|                             inline when they can be.  If false is passed,    |
+|                             inline dispatching is disabled.                  |
+|   disableInlineDispatch   - Notifications are always queued.  This is the    |
+|                             default.                                         |
+|   isInlineDispatchEnabled - Returns true if notifications are dispatched     |
+|                             inline when they can be.                         |
+|-----------------------------------------------------------------------------*/
+IAsyncNotifier & enableInlineDispatch    ( IBoolean enable = true );
+IAsyncNotifier & disableInlineDispatch   ( );
+IBoolean         isInlineDispatchEnabled ( ) const;
 
 /*----------------------------- Dispatch Thread --------------------------------
 | Use this function to query the dispatch thread.                              |
-|   dispatchThread    - Returns the thread id for the dispatch thread.         |
+|   dispatchThread    - Returns the thread id for the dispatch thread.  An     |
+|                       object dispatched by the thread pool has no one        |
+|                       dispatch thread, and the id of the thread that started |
+|                       the pool is returned.                                  |
 |-----------------------------------------------------------------------------*/
 const IThreadId & dispatchThread ( ) const;
 
@@ -181,21 +560,70 @@ static INotificationId const thisRefId;
 
 protected:
 /*-------------------------- Observer Notification -----------------------------
-| Use this function to asynchronously notify observers of an event.            |
+| Use these functions to asynchronously notify observers of an event.          |
 |   notifyObservers - If notification is enabled, queues notification for      |
-|                     dispatch and returns.                                    |
+|                     dispatch and returns.  Without a priority it is queued   |
+|                     with normal priority.  If a payload is passed, a copy    |
+|                     of its value is queued with the notification and the     |
+|                     event data points at it; see IAsyncTypedPayload.  The    |
+|                     copy is destroyed after the notification is dispatched   |
+|                     or deleted, and notificationCleanUp is not called for    |
+|                     it.  A notification with a payload is never coalesced.   |
 |-----------------------------------------------------------------------------*/
 virtual IAsyncNotifier & notifyObservers ( const INotificationId & nId );
+virtual IAsyncNotifier & notifyObservers ( const INotificationId & nId,
+                                           Priority priority );
+virtual IAsyncNotifier & notifyObservers (
+                           const INotificationId & nId,
+                           const IAsyncNotificationPayload & payload,
+                           Priority priority = normal );
 
 
 private:
+friend class IAsyncNotifierThread;
+friend class IAsyncNotificationQueue;
+friend class IAsyncNotificationNode;
+friend class IAsyncNotificationTimers;
+friend class IAsyncNotifierThreadPool;
+
 IAsyncNotifier & findOrCreateDispatchThread ( );
+IAsyncNotifier & findOrCreateDispatchPool ( );
+IAsyncNotifier & closeNotifier ( );
+IAsyncNotifier & openHandle ( );
+IAsyncNotifier & closeHandle ( IBoolean waitForDispatch );
+static IBoolean pinHandle ( unsigned long index, unsigned long generation );
+static void unpinHandle ( unsigned long index );
+static IAsyncNotifierThread * currentDispatchThread ( );
+static void releaseDispatchThread ( IAsyncNotifierThread * anAsyncNotifierThread );
+IAsyncNotifier & enqueue ( const INotificationEvent & anEvent,
+                           Priority priority,
+                           const IAsyncNotificationPayload * payload = 0 );
+IAsyncNotifier & enqueue ( const INotificationId & nId,
+                           Priority priority,
+                           const IAsyncNotificationPayload * payload = 0 );
+IBoolean coalesce ( const INotificationEvent & anEvent, Priority priority,
+                   IBoolean overflowing = false );
+IPrivateResource * coalescingKey ( ) const;
+IPrivateResource & createCoalesceKey ( );
+IAsyncNotifier & dispatchCoalesced ( const INotificationEvent & anEvent );
 
 /*--------------------------- Private State Data -----------------------------*/
-IAsyncNotifierThread * theDispatchThread;
+IAsyncNotifierThread   * theDispatchThread;
+IAsyncNotificationSlot * coalescedSlots;
+IPrivateResource * volatile coalesceKey;
+IAsyncNotificationNode * pendingEvents;
+volatile long            timerCount;
+IAsyncNotificationStrand * strand;
+unsigned long            handleIndex;
+unsigned long            handleGeneration;
+IBoolean                 inlineDispatch;
+IAsyncObserverList       observerList;
 
 static IKeySet<IAsyncNotifierThread *, IThreadId> * threads;
 static IPrivateResource                             threadsKey;
+static IAsyncNotifierThreadPool                   * pool;
+static unsigned long                                poolSize;
+static IAsyncNotificationReporter                 * reporter;
 
 }; // IAsyncNotifier
 
@@ -13,6 +13,13 @@
 *   restricted by GSA ADP Schedule Contract with IBM Corp.
 *
 *******************************************************************************/
+#ifdef __linux__
+  #include <pthread.h>
+  #include <sched.h>
+  #include <unistd.h>
+  #include <sys/syscall.h>
+#endif
+
 #include <iasynthr.hpp>
 
 #ifndef _ITHREAD_
@@ -31,12 +38,53 @@
   #include <iasynbkg.hpp>
 #endif
 
+#ifndef _IASYNPOL_
+  #include <iasynpol.hpp>
+#endif
+
+#ifndef _IASYNSTR_
+  #include <iasynstr.hpp>
+#endif
+
 #ifndef _IEXCEPT_
   #include <iexcept.hpp>
 #endif
 
+#ifndef _INOTIFEV_
+  #include <inotifev.hpp>
+#endif
+
+#ifndef _IATOMIC_
+  #include <iatomic.hpp>
+#endif
+
+#ifndef _IASYNTMR_
+  #include <iasyntmr.hpp>
+#endif
+
+#ifndef _IASYNQUE_
+  #include <iasynque.hpp>
+#endif
+
+#ifdef __linux__
+  // The number of processors a cpu_set_t can name.
+  static const unsigned long maxProcessors = CPU_SETSIZE;
+#else
+  #define INCL_DOSPROCESS
+  #include <os2.h>
+
+  // The number of processors an MPAFFINITY mask can name.
+  static const unsigned long maxProcessors = 64;
+#endif
+
 INotificationId const IAsyncNotifierThread::deleteThisId
                         = "IAsyncNotifierThread::deleteThis";
+INotificationId const IAsyncNotifierThread::coalescedId
+                        = "IAsyncNotifierThread::coalesced";
+INotificationId const IAsyncNotifierThread::closeId
+                        = "IAsyncNotifierThread::close";
+unsigned long const IAsyncNotifierThread::numberOfPriorities
+                        = IAsyncNotifier::urgent + 1;
 
 
 /*------------------------------------------------------------------------------
@@ -44,13 +92,25 @@ INotificationId const IAsyncNotifierThread::deleteThisId
 |
 | Implementation:
 |   Initialize the base class then find our thread id.
+|   Create the timed notifications and the metrics for this thread.
 |-----------------------------------------------------------------------------*/
 IAsyncNotifierThread :: IAsyncNotifierThread ( ) :
                    IVBase ( ),
                    asyncNotifierCount ( 0 ),
                    theThreadId ( IThread::currentId() ),
-                   bRunning ( false )
+                   bRunning ( 0 ),
+                   overflow ( IAsyncNotifier::blockSender ),
+                   overflows ( 0 ),
+                   timers ( NULL ),
+                   coalesces ( 0 ),
+                   drops ( 0 ),
+                   recorded ( NULL ),
+                   firstProc ( 0 ),
+                   procCount ( 0 ),
+                   node ( -1 )
 {
+  timers = new IAsyncNotificationTimers;
+  recorded = new IAsyncNotificationMetrics;
 }
 
 /*------------------------------------------------------------------------------
@@ -76,14 +136,30 @@ IAsyncNotifierThread * IAsyncNotifierThread :: make ( IBoolean guiOnly )
   return result;
 }
 
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierThread :: makePolled
+|
+| Implementation:
+|   GUI threads dispatch from their message queue, so they can not be polled.
+|   Create a poll thread object and return it.
+|-----------------------------------------------------------------------------*/
+IAsyncNotifierThread * IAsyncNotifierThread :: makePolled ( )
+{
+  IASSERTSTATE ( ! ( IThread::current().isGUIInitialized() ) );
+
+  return ( new IAsyncNotifierPollThread );
+}
+
 /*------------------------------------------------------------------------------
 | Function Name: IAsyncNotifierThread :: ~IAsyncNotifierThread
 |
 | Implementation:
-|   Nothing to delete.
+|   Delete the timed notifications and the metrics.
 |-----------------------------------------------------------------------------*/
 IAsyncNotifierThread :: ~IAsyncNotifierThread ( )
 {
+  delete timers;
+  delete recorded;
 }
 
 /*------------------------------------------------------------------------------
@@ -105,20 +181,19 @@ const IThreadId & IAsyncNotifierThread :: threadId ( ) const
 |-----------------------------------------------------------------------------*/
 unsigned long IAsyncNotifierThread :: addRef ( )
 {
-  asyncNotifierCount++;
-  return asyncNotifierCount;
+  return ( (unsigned long)IAtomic::increment ( asyncNotifierCount ) );
 }
 
 /*------------------------------------------------------------------------------
 | Function Name: IAsyncNotifierThread :: removeRef
 |
 | Implementation:
-|   Decrement and return the reference count.
+|   Decrement and return the reference count.  Return the value from the
+|   decrement itself, since the count may change again before it is read.
 |-----------------------------------------------------------------------------*/
 unsigned long IAsyncNotifierThread :: removeRef ( )
 {
-  asyncNotifierCount--;
-  return asyncNotifierCount;
+  return ( (unsigned long)IAtomic::decrement ( asyncNotifierCount ) );
 }
 
 /*------------------------------------------------------------------------------
@@ -129,7 +204,7 @@ unsigned long IAsyncNotifierThread :: removeRef ( )
 |-----------------------------------------------------------------------------*/
 unsigned long IAsyncNotifierThread :: refCount ( ) const
 {
-  return asyncNotifierCount;
+  return ( (unsigned long)IAtomic::value ( asyncNotifierCount ) );
 }
 
 /*------------------------------------------------------------------------------
@@ -140,18 +215,651 @@ unsigned long IAsyncNotifierThread :: refCount ( ) const
 |-----------------------------------------------------------------------------*/
 IBoolean IAsyncNotifierThread :: isRunning ( ) const
 {
-  return bRunning;
+  return ( IAtomic::value ( bRunning ) != 0 );
 }
 
 /*------------------------------------------------------------------------------
 | Function Name: IAsyncNotifierThread :: setIsRunning
 |
 | Implementation:
-|   Set the running flag.
+|   Set the running flag.  The exchange makes everything this thread did
+|   before setting it visible to threads that see the new value.
 |-----------------------------------------------------------------------------*/
 IAsyncNotifierThread & IAsyncNotifierThread :: setIsRunning ( IBoolean running )
 {
-  bRunning = running;
+  IAtomic::exchange ( bRunning, ( running ) ? 1 : 0 );
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierThread :: setBatchSize
+|
+| Implementation:
+|   Notifications are dispatched one at a time, so there is nothing to do.
+|-----------------------------------------------------------------------------*/
+IAsyncNotifierThread & IAsyncNotifierThread :: setBatchSize (
+                                                 unsigned long /* maxEvents */ )
+{
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierThread :: batchSize
+|
+| Implementation:
+|   Notifications are dispatched one at a time.
+|-----------------------------------------------------------------------------*/
+unsigned long IAsyncNotifierThread :: batchSize ( ) const
+{
+  return 1;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierThread :: setSpinTime
+|
+| Implementation:
+|   This thread does not wait on its own queue, so there is nothing to do.
+|-----------------------------------------------------------------------------*/
+IAsyncNotifierThread & IAsyncNotifierThread :: setSpinTime (
+                                        unsigned long /* microseconds */ )
+{
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierThread :: spinTime
+|
+| Implementation:
+|   This thread never spins.
+|-----------------------------------------------------------------------------*/
+unsigned long IAsyncNotifierThread :: spinTime ( ) const
+{
+  return 0;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierThread :: setProcessors
+|
+| Implementation:
+|   Set the affinity of the current thread to the processors.  The system
+|   moves the thread before the call returns, so the processor it runs on
+|   now tells which memory node it is on.  Then have the subclass move its
+|   storage.
+|-----------------------------------------------------------------------------*/
+IAsyncNotifierThread & IAsyncNotifierThread :: setProcessors (
+                                                 unsigned long first,
+                                                 unsigned long count )
+{
+  IASSERTSTATE ( threadId() == IThread::currentId() );
+  IASSERTPARM ( ( count != 0 ) &&
+                ( first < maxProcessors ) &&
+                ( count <= maxProcessors - first ) );
+
+#ifdef __linux__
+  cpu_set_t processors;
+  CPU_ZERO ( &processors );
+  for ( unsigned long i = first; i < first + count; i++ )
+    CPU_SET ( i, &processors );
+
+  int rc = pthread_setaffinity_np ( pthread_self(),
+                                    sizeof ( processors ), &processors );
+  if ( rc != 0 )
+  {
+    ITHROWSYSTEMERROR( rc,
+                       "pthread_setaffinity_np",
+                       IErrorInfo::accessError,
+                       IException::recoverable );
+  }
+
+  unsigned processor = 0;
+  unsigned processorNode = 0;
+  if ( syscall ( SYS_getcpu, &processor, &processorNode, 0 ) == 0 )
+    node = (long)processorNode;
+  else
+    node = -1;
+#else
+  MPAFFINITY processors;
+  processors.mask[0] = 0;
+  processors.mask[1] = 0;
+  for ( unsigned long i = first; i < first + count; i++ )
+    processors.mask[i / 32] |= 1UL << ( i % 32 );
+
+  APIRET rc = DosSetThreadAffinity ( &processors );
+  if ( rc != 0 )
+  {
+    ITHROWSYSTEMERROR( rc,
+                       "DosSetThreadAffinity",
+                       IErrorInfo::accessError,
+                       IException::recoverable );
+  }
+
+  // OS/2 does not report memory nodes.
+  node = -1;
+#endif
+
+  firstProc = first;
+  procCount = count;
+
+  localizeStorage();
+
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierThread :: firstProcessor
+|
+| Implementation:
+|   Return the saved first processor.
+|-----------------------------------------------------------------------------*/
+unsigned long IAsyncNotifierThread :: firstProcessor ( ) const
+{
+  return firstProc;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierThread :: numberOfProcessors
+|
+| Implementation:
+|   Return the saved number of processors.
+|-----------------------------------------------------------------------------*/
+unsigned long IAsyncNotifierThread :: numberOfProcessors ( ) const
+{
+  return procCount;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierThread :: runnableProcessors
+|
+| Implementation:
+|   Start with the processors online.  On this thread count the processors
+|   in its affinity, otherwise use the count saved by setProcessors.  A
+|   failed query leaves the count alone.
+|-----------------------------------------------------------------------------*/
+unsigned long IAsyncNotifierThread :: runnableProcessors ( ) const
+{
+  unsigned long count = IAsyncNotifierThreadPool::processorCount();
+  unsigned long allowed = procCount;
+
+  if ( threadId() == IThread::currentId() )
+  {
+#ifdef __linux__
+    cpu_set_t processors;
+    CPU_ZERO ( &processors );
+    if ( pthread_getaffinity_np ( pthread_self(),
+                                  sizeof ( processors ), &processors ) == 0 )
+      allowed = (unsigned long)CPU_COUNT ( &processors );
+#else
+    MPAFFINITY processors;
+    if ( DosQueryThreadAffinity ( AFNTY_THREAD, &processors ) == 0 )
+    {
+      allowed = 0;
+      for ( unsigned long i = 0; i < maxProcessors; i++ )
+        if ( processors.mask[i / 32] & ( 1UL << ( i % 32 ) ) )
+          allowed++;
+    }
+#endif
+  }
+
+  if ( ( allowed != 0 ) && ( allowed < count ) )
+    count = allowed;
+  return count;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierThread :: memoryNode
+|
+| Implementation:
+|   Return the node found by setProcessors.
+|-----------------------------------------------------------------------------*/
+long IAsyncNotifierThread :: memoryNode ( ) const
+{
+  return node;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierThread :: placement
+|
+| Implementation:
+|   Name the processor, or the range of processors, then the node if it is
+|   known.
+|-----------------------------------------------------------------------------*/
+IString IAsyncNotifierThread :: placement ( ) const
+{
+  IString text;
+
+  if ( procCount == 0 )
+    return text;
+
+  if ( procCount == 1 )
+    text = IString ( "processor " ) + IString ( firstProc );
+  else
+    text = IString ( "processors " ) + IString ( firstProc ) +
+           IString ( "-" ) + IString ( firstProc + procCount - 1 );
+
+  if ( node >= 0 )
+    text += IString ( ", node " ) + IString ( node );
+
+  return text;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierThread :: setCapacity
+|
+| Implementation:
+|   The queue is not bounded here, so only save the policy.
+|-----------------------------------------------------------------------------*/
+IAsyncNotifierThread & IAsyncNotifierThread :: setCapacity (
+                                 unsigned long /* maxEvents */,
+                                 IAsyncNotifier::OverflowPolicy policy )
+{
+  overflow = policy;
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierThread :: capacity
+|
+| Implementation:
+|   The queue is not bounded.
+|-----------------------------------------------------------------------------*/
+unsigned long IAsyncNotifierThread :: capacity ( ) const
+{
+  return 0;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierThread :: isFull
+|
+| Implementation:
+|   The queue is never full.
+|-----------------------------------------------------------------------------*/
+IBoolean IAsyncNotifierThread :: isFull ( ) const
+{
+  return false;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierThread :: waitForRoom
+|
+| Implementation:
+|   There is always room.
+|-----------------------------------------------------------------------------*/
+IAsyncNotifierThread & IAsyncNotifierThread :: waitForRoom ( )
+{
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierThread :: overflowPolicy
+|
+| Implementation:
+|   Return the overflow policy.
+|-----------------------------------------------------------------------------*/
+IAsyncNotifier::OverflowPolicy IAsyncNotifierThread :: overflowPolicy ( ) const
+{
+  return overflow;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierThread :: noteOverflow
+|
+| Implementation:
+|   Bump the overflow count.  Any thread may send, so use an interlocked
+|   increment.
+|-----------------------------------------------------------------------------*/
+IAsyncNotifierThread & IAsyncNotifierThread :: noteOverflow ( )
+{
+  IAtomic::increment ( overflows );
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierThread :: overflowCount
+|
+| Implementation:
+|   Return the overflow count.
+|-----------------------------------------------------------------------------*/
+unsigned long IAsyncNotifierThread :: overflowCount ( ) const
+{
+  return ( (unsigned long)IAtomic::value ( overflows ) );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierThread :: metrics
+|
+| Implementation:
+|   Copy the recorded metrics and set the queue depth and our counts.
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationMetrics IAsyncNotifierThread :: metrics ( ) const
+{
+  IAsyncNotificationMetrics snapshot ( *recorded );
+
+  snapshot.setCounts ( queueDepth(),
+                       (unsigned long)IAtomic::value ( coalesces ),
+                       (unsigned long)IAtomic::value ( drops ),
+                       (unsigned long)IAtomic::value ( overflows ) );
+
+  return snapshot;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierThread :: queueDepth
+|
+| Implementation:
+|   There is no queue.
+|-----------------------------------------------------------------------------*/
+unsigned long IAsyncNotifierThread :: queueDepth ( ) const
+{
+  return 0;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierThread :: noteCoalesced
+|
+| Implementation:
+|   Any thread may send, so use an interlocked increment.
+|-----------------------------------------------------------------------------*/
+IAsyncNotifierThread & IAsyncNotifierThread :: noteCoalesced ( )
+{
+  IAtomic::increment ( coalesces );
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierThread :: noteDropped
+|
+| Implementation:
+|   Both senders and this thread drop notifications, so add them with one
+|   interlocked add.
+|-----------------------------------------------------------------------------*/
+IAsyncNotifierThread & IAsyncNotifierThread :: noteDropped (
+                                                 unsigned long count )
+{
+  if ( count != 0 )
+    IAtomic::add ( drops, (long)count );
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierThread :: recordedMetrics
+|
+| Implementation:
+|   Return the metrics this thread records into.
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationMetrics & IAsyncNotifierThread :: recordedMetrics ( )
+{
+  return *recorded;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierThread :: localizeStorage
+|
+| Implementation:
+|   There is no queue here, so there is nothing to move.
+|-----------------------------------------------------------------------------*/
+IAsyncNotifierThread & IAsyncNotifierThread :: localizeStorage ( )
+{
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierThread :: isPolled
+|
+| Implementation:
+|   Notifications are dispatched by processMsgs.
+|-----------------------------------------------------------------------------*/
+IBoolean IAsyncNotifierThread :: isPolled ( ) const
+{
+  return false;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierThread :: readyHandle
+|
+| Implementation:
+|   Only polled threads have a ready handle.
+|-----------------------------------------------------------------------------*/
+unsigned long IAsyncNotifierThread :: readyHandle ( ) const
+{
+  IASSERTSTATE ( isPolled() );
+
+  return 0;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierThread :: dispatchPending
+|
+| Implementation:
+|   Only polled threads can be asked to dispatch.
+|-----------------------------------------------------------------------------*/
+unsigned long IAsyncNotifierThread :: dispatchPending ( )
+{
+  IASSERTSTATE ( isPolled() );
+
+  return 0;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierThread :: addTimer
+|
+| Implementation:
+|   Save the notification, then get its handle to this thread with an
+|   urgent insertId notification so it goes on the wheel promptly.
+|-----------------------------------------------------------------------------*/
+unsigned long IAsyncNotifierThread :: addTimer (
+                                        const INotificationEvent & anEvent,
+                                        IAsyncNotifier::Priority priority,
+                                        unsigned long time )
+{
+  unsigned long handle = timers->add ( anEvent, priority, time );
+
+  enqueueNotification ( INotificationEvent (
+                          IAsyncNotificationTimers::insertId,
+                          anEvent.notifier(),
+                          false,
+                          IEventData ( handle ) ),
+                        IAsyncNotifier::urgent );
+
+  return handle;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierThread :: cancelTimer
+|
+| Implementation:
+|   Pass the handle and the owner on to the timed notifications.
+|-----------------------------------------------------------------------------*/
+IBoolean IAsyncNotifierThread :: cancelTimer (
+                                   unsigned long handle,
+                                   const IAsyncNotifier & asyncNotifier )
+{
+  return ( timers->cancel ( handle, asyncNotifier ) );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierThread :: insertTimer
+|
+| Implementation:
+|   Have the timed notifications put it on the wheel.
+|-----------------------------------------------------------------------------*/
+IAsyncNotifierThread & IAsyncNotifierThread :: insertTimer (
+                                                 unsigned long handle )
+{
+  timers->insert ( handle );
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierThread :: timeUntilTimer
+|
+| Implementation:
+|   Ask the timed notifications.
+|-----------------------------------------------------------------------------*/
+long IAsyncNotifierThread :: timeUntilTimer ( )
+{
+  return ( timers->timeUntilNext() );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierThread :: cancelTimersFor
+|
+| Implementation:
+|   Have the timed notifications delete the ones for the notifier.
+|-----------------------------------------------------------------------------*/
+IAsyncNotifierThread & IAsyncNotifierThread :: cancelTimersFor (
+                                     const IAsyncNotifier & asyncNotifier )
+{
+  timers->cancelAllFor ( asyncNotifier );
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierThread :: expireTimers
+|
+| Implementation:
+|   Have the timed notifications queue the ones that are due.
+|-----------------------------------------------------------------------------*/
+unsigned long IAsyncNotifierThread :: expireTimers ( )
+{
+  return ( timers->expire ( *this ) );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierThread :: isDispatchThreadFor
+|
+| Implementation:
+|   Every notifier of this object is dispatched on this thread.
+|-----------------------------------------------------------------------------*/
+IBoolean IAsyncNotifierThread :: isDispatchThreadFor (
+                             const IAsyncNotifier & /* asyncNotifier */ ) const
+{
+  return ( threadId() == IThread::currentId() );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierThread :: dispatch
+|
+| Implementation:
+|   Check for deleteThisId, coalescedId, insertId and closeId, otherwise
+|   notify observers.  The value of a payload is destroyed by whoever copied
+|   it, so there is nothing for the notifier to clean up.  The notifier of a
+|   closeId notification has been deleted; only release its reference to
+|   this object, which may delete this object if it is not running.
+|-----------------------------------------------------------------------------*/
+void IAsyncNotifierThread :: dispatch ( const INotificationEvent & anEvent,
+                                        IBoolean hasPayload )
+{
+  IAsyncNotifier * theNotifier = (IAsyncNotifier *)(&(anEvent.notifier()));
+  if ( anEvent.notificationId() == deleteThisId )
+  {
+    delete theNotifier;
+  }
+  else if ( anEvent.notificationId() == closeId )
+  {
+    IAsyncNotifier::releaseDispatchThread ( this );
+  }
+  else if ( anEvent.notificationId() == coalescedId )
+  {
+    theNotifier->dispatchCoalesced ( anEvent );
+  }
+  else if ( anEvent.notificationId() == IAsyncNotificationTimers::insertId )
+  {
+    theNotifier->theDispatchThread->insertTimer (
+                                      anEvent.eventData().asUnsignedLong() );
+  }
+  else
+  {
+    if ( theNotifier->isEnabledForNotification() )
+      theNotifier->observerList.notify ( anEvent );
+    if ( ! hasPayload )
+      theNotifier->notificationCleanUp ( anEvent );
+  }
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierThread :: dispatchNext
+|
+| Implementation:
+|   Note the queue depth, then remove the notification, which pins the
+|     handle of its notifier.  If the notifier was deleted on another
+|     thread, skip the notification.  An insertId notification still puts
+|     its timed notification on the wheel, which finds the notifier gone
+|     and frees it.
+|   Take the id, the handle and the waiting time before dispatching: an
+|     observer may delete its notifier, and with it the queue.
+|   Time the dispatch and record it.  The metrics belong to the thread, so
+|     they are still there.  Then unpin the handle.
+|-----------------------------------------------------------------------------*/
+void IAsyncNotifierThread :: dispatchNext (
+                               IAsyncNotificationQueue & queue,
+                               IAsyncNotificationMetrics & metrics )
+{
+  unsigned long depth = queue.length();
+
+  queue.removeFirst();
+  const INotificationEvent & anEvent = queue.lastRemoved();
+
+  if ( ! ( queue.lastRemovedIsPinned() ) )
+  {
+    if ( anEvent.notificationId() == IAsyncNotificationTimers::insertId )
+      insertTimer ( anEvent.eventData().asUnsignedLong() );
+    return;
+  }
+
+  INotificationId anId = anEvent.notificationId();
+  IBoolean hasPayload = queue.lastRemovedHasPayload();
+  unsigned long handle = queue.lastRemovedHandle();
+
+  unsigned long start = IAsyncNotificationMetrics::clock();
+  unsigned long latency = IAsyncNotificationMetrics::elapsed (
+                                         queue.lastRemovedTime(), start );
+
+  dispatch ( anEvent, hasPayload );
+
+  unsigned long time = IAsyncNotificationMetrics::elapsed (
+                                 start, IAsyncNotificationMetrics::clock() );
+
+  metrics.recordDispatch ( anId, depth, latency, time );
+
+  IAsyncNotifier::unpinHandle ( handle );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierThread :: canDispatchInline
+|
+| Implementation:
+|   This class has no queue to look at, so always queue.
+|-----------------------------------------------------------------------------*/
+IBoolean IAsyncNotifierThread :: canDispatchInline (
+                                   const IAsyncNotifier & /* asyncNotifier */ )
+{
+  return false;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotifierThread :: dispatchInline
+|
+| Implementation:
+|   Take the id before dispatching, since an observer may delete the
+|   notifier.  Time the dispatch and record it with the current queue depth
+|   and no waiting time.  This object is dispatching, so it is still there.
+|-----------------------------------------------------------------------------*/
+IAsyncNotifierThread & IAsyncNotifierThread :: dispatchInline (
+                                          const INotificationEvent & anEvent,
+                                          IBoolean hasPayload )
+{
+  INotificationId anId = anEvent.notificationId();
+  unsigned long depth = queueDepth();
+
+  unsigned long start = IAsyncNotificationMetrics::clock();
+
+  dispatch ( anEvent, hasPayload );
+
+  unsigned long time = IAsyncNotificationMetrics::elapsed (
+                                 start, IAsyncNotificationMetrics::clock() );
+
+  recordedMetrics().recordDispatch ( anId, depth, 0, time );
+
   return *this;
 }
 
@@ -29,11 +29,23 @@
   #include <inotify.hpp>
 #endif
 
+#ifndef _IASYNTFY_
+  #include <iasyntfy.hpp>
+#endif
+
+#ifndef _IASYNMTR_
+  #include <iasynmtr.hpp>
+#endif
+
 class INotificationEvent;
-class IAsyncNotifier;
+class IAsyncNotificationTimers;
+class IAsyncNotificationQueue;
+class IAsyncNotificationPayload;
 
-// Align classes on four byte boundary.
-#pragma pack(4)
+// Align classes on four byte boundary, except on Linux (see iatomic.hpp).
+#ifndef __linux__
+  #pragma pack(4)
+#endif
 
 class IAsyncNotifierThread : public IVBase {
 /*******************************************************************************
@@ -54,10 +66,14 @@ public:
 |     current thread.  By default it will make one for any thread.  Of true is |
 |     passed and the current thread is not a GUI thread, an invalid request    |
 |     exception is thrown.                                                     |
+|   - Use the makePolled constructor to create a subclass for the current      |
+|     thread that is dispatched by calling dispatchPending.  If the current    |
+|     thread is a GUI thread, an invalid request exception is thrown.          |
 |-----------------------------------------------------------------------------*/
 IAsyncNotifierThread ( );
 
 static IAsyncNotifierThread * make ( IBoolean guiOnly = false );
+static IAsyncNotifierThread * makePolled ( );
 
 virtual ~IAsyncNotifierThread ( );
 
@@ -69,6 +85,7 @@ const IThreadId & threadId ( ) const;
 
 /*--------------------------- Reference Counting -------------------------------
 | Used by IAsyncNotifier objects to add and remove references to this object.  |
+| The count is updated with interlocked operations, so no semaphore is needed. |
 |   addRef    - Bumps and returns the reference count.                         |
 |   removeRef - Decrements and returns the reference count.                    |
 |-----------------------------------------------------------------------------*/
@@ -77,10 +94,23 @@ virtual unsigned long removeRef ( );
 
 /*-------------------------- Enqueue Notification ------------------------------
 | Used by IAsyncNotifier objects to enque notifications.                       |
-|   enqueueNotification - Places the notification on this thread's queue.      |
+|   enqueueNotification - Places the notification at the end of the lane for   |
+|                         the priority in this thread's queue.  A              |
+|                         notification passed as an id and a notifier is       |
+|                         constructed right in the queue, without copying an   |
+|                         event.                                               |
+|   numberOfPriorities  - The number of lanes each queue has.                  |
 |-----------------------------------------------------------------------------*/
 virtual IAsyncNotifierThread & enqueueNotification (
-                                 const INotificationEvent & anEvent ) = 0;
+                           const INotificationEvent & anEvent,
+                           IAsyncNotifier::Priority priority,
+                           const IAsyncNotificationPayload * payload = 0 ) = 0;
+virtual IAsyncNotifierThread & enqueueNotification (
+                           const INotificationId & nId,
+                           IAsyncNotifier & notifier,
+                           IAsyncNotifier::Priority priority,
+                           const IAsyncNotificationPayload * payload = 0 ) = 0;
+static unsigned long const numberOfPriorities;
 
 /*----------------------------- Process Messages -------------------------------
 | Use this to start dispatching notifications for this thread.                 |
@@ -94,24 +124,242 @@ virtual IAsyncNotifierThread & enqueueNotification (
 virtual IAsyncNotifierThread & processMsgs ( ) = 0;
 IBoolean isRunning ( ) const;
 
+/*---------------------------- Dispatch Batching -------------------------------
+| Used by IAsyncNotifier to control how many queued notifications are          |
+| dispatched at a time.                                                        |
+|   setBatchSize - Sets the maximum number of notifications dispatched as one  |
+|                  batch.  Zero means no limit.  This implementation does      |
+|                  nothing.                                                    |
+|   batchSize    - Returns the maximum batch size.  This implementation        |
+|                  returns one.                                                |
+|-----------------------------------------------------------------------------*/
+virtual IAsyncNotifierThread & setBatchSize ( unsigned long maxEvents );
+virtual unsigned long batchSize ( ) const;
+
+/*------------------------------- Spin Polling ---------------------------------
+| Used by IAsyncNotifier to have an idle thread poll its queue for a while     |
+| before it blocks.                                                            |
+|   setSpinTime - Sets the longest time, in microseconds, that the thread      |
+|                 polls its empty queue before it blocks.  Zero means it       |
+|                 blocks at once.  This implementation does nothing.           |
+|   spinTime    - Returns the longest spin time.  This implementation returns  |
+|                 zero.                                                        |
+|-----------------------------------------------------------------------------*/
+virtual IAsyncNotifierThread & setSpinTime ( unsigned long microseconds );
+virtual unsigned long spinTime ( ) const;
+
+/*-------------------------------- Placement -----------------------------------
+| Used by IAsyncNotifier to keep this thread, and the storage for its queue,   |
+| on a set of processors.                                                      |
+|   setProcessors      - Runs this thread only on the passed number of         |
+|                        processors, starting with the passed one.             |
+|                        Processors are numbered from zero.  Then              |
+|                        localizeStorage is called.  Throws an invalid request |
+|                        exception if the current thread is not this thread,   |
+|                        an invalid parameter exception if the system can not  |
+|                        name all of the processors, and a system error if     |
+|                        the system refuses.                                   |
+|   firstProcessor     - Returns the first processor this thread is kept on.   |
+|   numberOfProcessors - Returns the number of processors this thread is kept  |
+|                        on, or zero if it may run on any.                     |
+|   runnableProcessors - Returns the number of online processors this thread   |
+|                        may run on.  On this thread the system's affinity for |
+|                        it is read, so an affinity set by other means counts; |
+|                        on any other thread the count from setProcessors is   |
+|                        used.                                                 |
+|   memoryNode         - Returns the memory node of the processor this thread  |
+|                        ran on when it was moved, or -1 if it is not known.   |
+|   placement          - Returns the processors and the memory node as text,   |
+|                        or an empty string if this thread may run on any      |
+|                        processor.                                            |
+|-----------------------------------------------------------------------------*/
+IAsyncNotifierThread & setProcessors      ( unsigned long first,
+                                            unsigned long count = 1 );
+unsigned long          firstProcessor     ( ) const;
+unsigned long          numberOfProcessors ( ) const;
+unsigned long          runnableProcessors ( ) const;
+long                   memoryNode         ( ) const;
+IString                placement          ( ) const;
+
+/*------------------------------ Queue Capacity --------------------------------
+| Used by IAsyncNotifier to bound the number of queued notifications.  All of  |
+| these functions may be called on any thread.                                 |
+|   setCapacity    - Sets the number of queued notifications at which the      |
+|                    queue is full and the policy IAsyncNotifier applies to    |
+|                    notifications sent while it is full.  Zero means no       |
+|                    limit.  This implementation only saves the policy.        |
+|   capacity       - Returns the capacity.  This implementation returns zero.  |
+|   overflowPolicy - Returns the overflow policy.                              |
+|   isFull         - Returns true if the queue is full.  This implementation   |
+|                    returns false.                                            |
+|   waitForRoom    - Returns when the queue is not full.  It must not be       |
+|                    called on this thread.  This implementation returns       |
+|                    immediately.                                              |
+|   noteOverflow   - Counts a notification sent while the queue was full.      |
+|   overflowCount  - Returns the number of notifications counted by            |
+|                    noteOverflow.                                             |
+|-----------------------------------------------------------------------------*/
+virtual IAsyncNotifierThread & setCapacity (
+                                 unsigned long maxEvents,
+                                 IAsyncNotifier::OverflowPolicy policy );
+virtual unsigned long          capacity    ( ) const;
+virtual IBoolean               isFull      ( ) const;
+virtual IAsyncNotifierThread & waitForRoom ( );
+
+IAsyncNotifier::OverflowPolicy overflowPolicy ( ) const;
+IAsyncNotifierThread &         noteOverflow   ( );
+unsigned long                  overflowCount  ( ) const;
+
+/*--------------------------------- Metrics ------------------------------------
+| Used by IAsyncNotifier to report how well this thread keeps up.  All of      |
+| these functions may be called on any thread.                                 |
+|   metrics       - Returns a copy of the metrics recorded by dispatchNext,    |
+|                   with the queue depth and the counts kept by this object.   |
+|   queueDepth    - Returns the number of queued notifications.  This          |
+|                   implementation returns zero.                               |
+|   noteCoalesced - Counts a notification replaced by a later one before it    |
+|                   was dispatched.                                            |
+|   noteDropped   - Counts notifications thrown away because the queue was     |
+|                   full.                                                      |
+|-----------------------------------------------------------------------------*/
+virtual IAsyncNotificationMetrics metrics       ( ) const;
+virtual unsigned long             queueDepth    ( ) const;
+IAsyncNotifierThread &            noteCoalesced ( );
+IAsyncNotifierThread &            noteDropped   ( unsigned long count );
+
+/*---------------------------- Polled Dispatching ------------------------------
+| Used by IAsyncNotifier to dispatch from an event loop the application runs.  |
+|   isPolled        - Returns true if notifications are dispatched by calling  |
+|                     dispatchPending rather than processMsgs.  This           |
+|                     implementation returns false.                            |
+|   readyHandle     - Returns a handle that is signaled while notifications    |
+|                     are waiting.  This implementation throws an invalid      |
+|                     request exception.                                       |
+|   dispatchPending - Dispatches one batch of the waiting notifications        |
+|                     without blocking and returns the number dispatched.      |
+|                     This implementation throws an invalid request exception. |
+|-----------------------------------------------------------------------------*/
+virtual IBoolean      isPolled        ( ) const;
+virtual unsigned long readyHandle     ( ) const;
+virtual unsigned long dispatchPending ( );
+
+/*--------------------------- Timed Notification -------------------------------
+| Used by IAsyncNotifier to queue notifications later.  The timed              |
+| notifications are kept by an IAsyncNotificationTimers object.  Subclasses    |
+| call expireTimers before each batch and must not wait longer than            |
+| timeUntilTimer for new notifications.  A subclass that dispatches on more    |
+| than one thread must override the virtual functions to serialize them.       |
+|   addTimer        - Saves the notification to be queued with the passed      |
+|                     priority at the passed time and returns its handle.      |
+|                     May be called on any thread.                             |
+|   cancelTimer     - Cancels the timed notification for the handle.  Returns  |
+|                     false if it is not one of the passed object's or has     |
+|                     been queued already.  May be called on any thread.       |
+|   insertTimer     - Puts the timed notification for the handle on the timer  |
+|                     wheel.  Called by dispatch for its insertId              |
+|                     notification.                                            |
+|   timeUntilTimer  - Returns the number of milliseconds until a timed         |
+|                     notification may be due, or -1 if there are none.        |
+|   cancelTimersFor - Cleans up and deletes all the timed notifications of the |
+|                     passed object.  May be called on any thread; on another  |
+|                     thread this thread frees their storage later.            |
+|-----------------------------------------------------------------------------*/
+unsigned long                  addTimer        (
+                                 const INotificationEvent & anEvent,
+                                 IAsyncNotifier::Priority priority,
+                                 unsigned long time );
+virtual IBoolean               cancelTimer     (
+                                 unsigned long handle,
+                                 const IAsyncNotifier & asyncNotifier );
+virtual IAsyncNotifierThread & insertTimer     ( unsigned long handle );
+virtual long                   timeUntilTimer  ( );
+virtual IAsyncNotifierThread & cancelTimersFor (
+                                 const IAsyncNotifier & asyncNotifier );
+
 /*-------------------------- Delete Notifications ------------------------------
-| IAsyncNotifier calls this from its destructor to have all pending            |
-| notifications deleted.                                                       |
+| IAsyncNotifier calls these from close to have all pending notifications      |
+| deleted.                                                                     |
+|   isDispatchThreadFor    - Returns true if the current thread dispatches the |
+|                            notifications of the passed object.  This         |
+|                            implementation returns true if the current thread |
+|                            is this thread.                                   |
 |   deleteNotificationsFor - Ensures that all notifications for the passed     |
 |                            object are never dispatched.  Throws an invalid   |
-|                            request exception if the current thread is not    |
-|                            this thread.                                      |
+|                            request exception if isDispatchThreadFor returns  |
+|                            false.  An object deleted on another thread does  |
+|                            not call this; dispatchNext skips its             |
+|                            notifications instead.                            |
 |   deleteThisId           - Used by IAsyncNotifier and this class to signal   |
 |                            async deletion of an IAsyncNotifier.              |
+|   closeId                - Used by IAsyncNotifier to have this thread        |
+|                            release the reference of an object deleted on     |
+|                            another thread.  Its notifier must not be used.   |
+|   coalescedId            - Used by IAsyncNotifier and this class to mark the |
+|                            queue position of a coalesced notification.  The  |
+|                            event data identifies the notification, which is  |
+|                            kept by the IAsyncNotifier.                       |
 |-----------------------------------------------------------------------------*/
+virtual IBoolean               isDispatchThreadFor    (
+                                 const IAsyncNotifier & asyncNotifier ) const;
 virtual IAsyncNotifierThread & deleteNotificationsFor (
                                  const IAsyncNotifier & asyncNotifier ) = 0;
 static INotificationId const deleteThisId;
+static INotificationId const coalescedId;
+static INotificationId const closeId;
+
+/*------------------------------- Dispatching ----------------------------------
+| Used by subclasses to dispatch a notification taken from their queue.        |
+|   dispatch - Deletes the notifier for deleteThisId, dispatches the latest    |
+|              notification for coalescedId, calls insertTimer of the          |
+|              notifier's dispatch thread for                                  |
+|              IAsyncNotificationTimers::insertId, releases the reference of   |
+|              the deleted notifier for closeId, and otherwise notifies the    |
+|              observers of the notifier and calls its notificationCleanUp,    |
+|              unless true is passed because the notification was sent with a  |
+|              payload.                                                        |
+|   dispatchNext - Removes the first notification from the passed queue,       |
+|                  dispatches it and records it in the passed metrics.  The    |
+|                  queue must not be empty.  If its notifier has been deleted  |
+|                  on another thread, the notification is skipped, except for  |
+|                  insertId, whose timed notification is still put on the      |
+|                  wheel so it can be freed.                                   |
+|-----------------------------------------------------------------------------*/
+void dispatch     ( const INotificationEvent & anEvent,
+                    IBoolean hasPayload = false );
+void dispatchNext ( IAsyncNotificationQueue & queue,
+                    IAsyncNotificationMetrics & metrics );
+
+/*--------------------------- Inline Dispatching -------------------------------
+| Used by IAsyncNotifier to dispatch a notification without queuing it when    |
+| that can not change the order of its notifications.                          |
+|   canDispatchInline - Returns true if the current thread is this thread, it  |
+|                       is dispatching, and no notifications of the passed     |
+|                       object are queued.  This implementation returns false. |
+|   dispatchInline    - Dispatches the notification right away and records it  |
+|                       in the metrics as one that did not wait.  Must be      |
+|                       called on this thread.  Pass true if the notification  |
+|                       has a payload.                                         |
+|-----------------------------------------------------------------------------*/
+virtual IBoolean       canDispatchInline (
+                         const IAsyncNotifier & asyncNotifier );
+IAsyncNotifierThread & dispatchInline    (
+                         const INotificationEvent & anEvent,
+                         IBoolean hasPayload = false );
 
 
 protected:
 unsigned long refCount ( ) const;
 IAsyncNotifierThread & setIsRunning ( IBoolean running );
+virtual unsigned long expireTimers ( );
+IAsyncNotificationMetrics & recordedMetrics ( );
+
+/*------------------------------ Local Storage ---------------------------------
+| Called by setProcessors once this thread runs on its new processors.         |
+|   localizeStorage - Subclasses with a queue refill its free storage, so that |
+|                     the storage is local to this thread.  This               |
+|                     implementation does nothing.                             |
+|-----------------------------------------------------------------------------*/
+virtual IAsyncNotifierThread & localizeStorage ( );
 
 
 private:
@@ -120,9 +368,18 @@ IAsyncNotifierThread ( const IAsyncNotifierThread & rhs );
 IAsyncNotifierThread & operator = ( const IAsyncNotifierThread & rhs );
 
 /*--------------------------- Private State Data -----------------------------*/
-unsigned long asyncNotifierCount;
-IThreadId     theThreadId;
-IBoolean      bRunning;
+volatile long                  asyncNotifierCount;
+IThreadId                      theThreadId;
+volatile long                  bRunning;
+IAsyncNotifier::OverflowPolicy overflow;
+volatile long                  overflows;
+IAsyncNotificationTimers *     timers;
+volatile long                  coalesces;
+volatile long                  drops;
+IAsyncNotificationMetrics *    recorded;
+unsigned long                  firstProc;
+unsigned long                  procCount;
+long                           node;
 
 }; // IAsyncNotifierThread
 
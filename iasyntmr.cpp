@@ -0,0 +1,681 @@
+/*******************************************************************************
+* FILE NAME: iasyntmr.cpp
+*
+* DESCRIPTION:
+*   Functions to implement the class(es):
+*     IAsyncNotificationTimers
+*
+* COPYRIGHT:
+*   Licensed Materials - Property of IBM
+*   (C) Copyright IBM Corporation 1995
+*   All Rights Reserved
+*   US Government Users Restricted Rights - Use, duplication, or disclosure
+*   restricted by GSA ADP Schedule Contract with IBM Corp.
+*
+*******************************************************************************/
+#include <iasyntmr.hpp>
+
+#ifndef _IASYNTHR_
+  #include <iasynthr.hpp>
+#endif
+
+#ifndef _INOTIFEV_
+  #include <inotifev.hpp>
+#endif
+
+#ifndef _IEXCEPT_
+  #include <iexcept.hpp>
+#endif
+
+#ifndef _IATOMIC_
+  #include <iatomic.hpp>
+#endif
+
+#ifdef __linux__
+  #include <time.h>
+#else
+  #define INCL_DOSMISC
+  #include <os2.h>
+#endif
+
+INotificationId const IAsyncNotificationTimers::insertId
+                        = "IAsyncNotificationTimers::insert";
+
+// Times are kept to 32 bits on every system so that they wrap the same way.
+static const unsigned long timeMask      = 0xFFFFFFFFUL;
+static const unsigned long halfTimeRange = 0x80000000UL;
+
+// The wheel has this many levels of 256 slots each.
+static const unsigned long levels        = 4;
+static const unsigned long slotBits      = 8;
+static const unsigned long slotsPerLevel = 1UL << slotBits;
+static const unsigned long slotMask      = slotsPerLevel - 1;
+
+// Timed notifications are allocated in blocks.  A handle has the index in
+// the low 16 bits and the generation in the high 16 bits.
+static const unsigned long timersPerBlock = 256;
+static const unsigned long maximumBlocks  = 256;
+static const unsigned long indexMask      = 0xFFFFUL;
+static const unsigned long generationBits = 16;
+
+
+//------------------------------------------------------------------------------
+// A timed notification.  While it is on the wheel it is in the list of its
+// slot.  While it is free it is in the free list.  Its state and handle are
+// only changed while the guard is held, since any thread may cancel it.  It
+// also notes the handle of its IAsyncNotifier, which may be deleted on
+// another thread before it is due.
+//------------------------------------------------------------------------------
+class IAsyncNotificationTimer
+{
+public:
+  enum State { free, scheduled, waiting, cancelled, queued };
+
+  INotificationEvent        * event;
+  IAsyncNotifier::Priority    priority;
+  unsigned long               time;
+  unsigned long               handle;
+  unsigned long               notifierIndex;
+  unsigned long               notifierGeneration;
+  State                       state;
+  IAsyncNotificationTimer   * next;
+  IAsyncNotificationTimer  ** previousNext;
+};
+
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationTimers :: IAsyncNotificationTimers
+|
+| Implementation:
+|   Remember the dispatch thread and make room for the block pointers.  The
+|   blocks and the wheel are allocated when they are first needed.
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationTimers :: IAsyncNotificationTimers ( ) :
+                   IBase ( ),
+                   ownerId ( IThread::currentId() ),
+                   guard ( 0 ),
+                   blocks ( new IAsyncNotificationTimer * [maximumBlocks] ),
+                   blockCount ( 0 ),
+                   freeTimers ( 0 ),
+                   wheel ( 0 ),
+                   currentTime ( now() ),
+                   waitingCount ( 0 )
+{
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationTimers :: ~IAsyncNotificationTimers
+|
+| Implementation:
+|   Delete the events of timed notifications that are not free, then the
+|   blocks and the wheel.
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationTimers :: ~IAsyncNotificationTimers ( )
+{
+  for ( unsigned long i = 0; i < blockCount; i++ )
+  {
+    for ( unsigned long j = 0; j < timersPerBlock; j++ )
+    {
+      if ( blocks[i][j].state != IAsyncNotificationTimer::free )
+        delete blocks[i][j].event;
+    }
+    delete [] blocks[i];
+  }
+
+  delete [] blocks;
+  delete [] wheel;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationTimers :: add
+|
+| Implementation:
+|   Copy the event and note the handle of its IAsyncNotifier.
+|   Take a free timed notification under the guard and fill it in.  If there
+|     is none, allocate a block without the guard held, then add it to the
+|     free list under the guard and try again.  Another thread may have
+|     freed one in the meantime, so the new block may not be needed.
+|   Count the notification in its IAsyncNotifier.
+|-----------------------------------------------------------------------------*/
+unsigned long IAsyncNotificationTimers :: add (
+                                const INotificationEvent & anEvent,
+                                IAsyncNotifier::Priority priority,
+                                unsigned long time )
+{
+  INotificationEvent * copiedEvent = new INotificationEvent ( anEvent );
+  IAsyncNotifier * theNotifier = (IAsyncNotifier *)(&(anEvent.notifier()));
+  IAsyncNotificationTimer * newBlock = 0;
+  IAsyncNotificationTimer * timer = 0;
+  unsigned long handle = 0;
+
+  while ( timer == 0 )
+  {
+    IBoolean full = false;
+
+    IAtomic::acquire ( guard );
+
+    if ( ( freeTimers == 0 ) && ( newBlock != 0 ) &&
+         ( blockCount < maximumBlocks ) )
+    {
+      unsigned long firstIndex = blockCount * timersPerBlock;
+      for ( unsigned long i = timersPerBlock; i != 0; i-- )
+      {
+        IAsyncNotificationTimer & newTimer = newBlock[i - 1];
+        newTimer.event = 0;
+        newTimer.handle = ( 1UL << generationBits ) | ( firstIndex + i - 1 );
+        newTimer.state = IAsyncNotificationTimer::free;
+        newTimer.next = freeTimers;
+        freeTimers = &newTimer;
+      }
+      blocks[blockCount++] = newBlock;
+      newBlock = 0;
+    }
+
+    timer = freeTimers;
+    if ( timer != 0 )
+    {
+      freeTimers = timer->next;
+      timer->event = copiedEvent;
+      timer->priority = priority;
+      timer->time = time & timeMask;
+      timer->notifierIndex = theNotifier->handleIndex;
+      timer->notifierGeneration = theNotifier->handleGeneration;
+      timer->state = IAsyncNotificationTimer::scheduled;
+      timer->next = 0;
+      timer->previousNext = 0;
+      handle = timer->handle;
+    }
+    else
+    {
+      full = ( blockCount == maximumBlocks );
+    }
+
+    IAtomic::release ( guard );
+
+    if ( full )
+    {
+      delete copiedEvent;
+      IResourceExhausted exc ( "Too many timed notifications are waiting.",
+                               0, IException::recoverable );
+      ITHROW ( exc );
+    }
+
+    if ( timer == 0 )
+      newBlock = new IAsyncNotificationTimer [timersPerBlock];
+  }
+
+  delete [] newBlock;
+
+  IAtomic::increment ( theNotifier->timerCount );
+
+  return handle;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationTimers :: cancel
+|
+| Implementation:
+|   Under the guard, find the timed notification.  If it belongs to the
+|   IAsyncNotifier, by the handle it noted, and has not been queued yet,
+|   mark it cancelled.
+|   If it is on the wheel and this is the dispatch thread, take it off and
+|   delete it now.  Otherwise the dispatch thread deletes it when it gets
+|   the insertId notification or finds it on the wheel.
+|-----------------------------------------------------------------------------*/
+IBoolean IAsyncNotificationTimers :: cancel (
+                                     unsigned long handle,
+                                     const IAsyncNotifier & asyncNotifier )
+{
+  IBoolean onDispatchThread = ( IThread::currentId() == ownerId );
+  IBoolean cancelled = false;
+  IBoolean removeNow = false;
+
+  IAtomic::acquire ( guard );
+
+  IAsyncNotificationTimer * timer = find ( handle );
+  if ( ( timer != 0 ) &&
+       ( timer->notifierIndex == asyncNotifier.handleIndex ) &&
+       ( timer->notifierGeneration == asyncNotifier.handleGeneration ) &&
+       ( ( timer->state == IAsyncNotificationTimer::scheduled ) ||
+         ( timer->state == IAsyncNotificationTimer::waiting ) ) )
+  {
+    removeNow = ( ( onDispatchThread ) &&
+                  ( timer->state == IAsyncNotificationTimer::waiting ) );
+    timer->state = IAsyncNotificationTimer::cancelled;
+    cancelled = true;
+  }
+
+  IAtomic::release ( guard );
+
+  if ( removeNow )
+  {
+    unlink ( timer );
+    remove ( timer, true );
+  }
+
+  return cancelled;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationTimers :: now
+|
+| Implementation:
+|   Use the monotonic clock on Linux and the millisecond count on OS/2.
+|-----------------------------------------------------------------------------*/
+unsigned long IAsyncNotificationTimers :: now ( )
+{
+#ifdef __linux__
+  struct timespec time;
+  clock_gettime ( CLOCK_MONOTONIC, &time );
+  return ( ( (unsigned long)time.tv_sec * 1000UL +
+             (unsigned long)time.tv_nsec / 1000000UL ) & timeMask );
+#else
+  ULONG milliseconds = 0;
+  DosQuerySysInfo ( QSV_MS_COUNT, QSV_MS_COUNT,
+                    &milliseconds, sizeof ( milliseconds ) );
+  return ( (unsigned long)milliseconds );
+#endif
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationTimers :: later
+|
+| Implementation:
+|   The first time is later if it is less than half the time range ahead.
+|-----------------------------------------------------------------------------*/
+IBoolean IAsyncNotificationTimers :: later ( unsigned long time,
+                                             unsigned long than )
+{
+  unsigned long difference = ( time - than ) & timeMask;
+
+  return ( ( difference != 0 ) && ( difference < halfTimeRange ) );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationTimers :: insert
+|
+| Implementation:
+|   Under the guard, find the timed notification.  If it is scheduled, it is
+|   now waiting.  A stale handle finds nothing, since the notification was
+|   already deleted by cancelAllFor.
+|   Put a waiting notification on the wheel and delete a cancelled one.  If
+|   the wheel is empty, its current time may be old, so bring it up to date
+|   first.
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationTimers & IAsyncNotificationTimers :: insert (
+                                                      unsigned long handle )
+{
+  IBoolean wasCancelled = false;
+
+  IAtomic::acquire ( guard );
+
+  IAsyncNotificationTimer * timer = find ( handle );
+  if ( timer != 0 )
+  {
+    if ( timer->state == IAsyncNotificationTimer::scheduled )
+      timer->state = IAsyncNotificationTimer::waiting;
+    else if ( timer->state == IAsyncNotificationTimer::cancelled )
+      wasCancelled = true;
+    else
+      timer = 0;
+  }
+
+  IAtomic::release ( guard );
+
+  if ( timer != 0 )
+  {
+    if ( wasCancelled )
+    {
+      remove ( timer, true );
+    }
+    else
+    {
+      if ( waitingCount == 0 )
+        currentTime = now();
+      link ( timer );
+    }
+  }
+
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationTimers :: expire
+|
+| Implementation:
+|   If nothing is waiting, just catch the wheel up with the clock.
+|   Otherwise process each millisecond up to now:
+|     When the first level comes around to its first slot, move the current
+|       slot of the second level down, and so on up while each level is also
+|       at its first slot.
+|     Take every notification out of the first level slot.  Under the guard,
+|       mark each waiting one queued, so it can no longer be cancelled, and
+|       queue it on the thread while its IAsyncNotifier is pinned, unless
+|       that was deleted.  Delete it either way.
+|   Stop early if the wheel empties.
+|-----------------------------------------------------------------------------*/
+unsigned long IAsyncNotificationTimers :: expire (
+                                          IAsyncNotifierThread & thread )
+{
+  unsigned long queuedCount = 0;
+  unsigned long time = now();
+
+  while ( ( waitingCount != 0 ) && ( ! ( later ( currentTime, time ) ) ) )
+  {
+    unsigned long index = currentTime & slotMask;
+    if ( index == 0 )
+    {
+      for ( unsigned long level = 1;
+            ( level < levels ) && ( cascade ( level ) == 0 );
+            level++ )
+        ;
+    }
+
+    IAsyncNotificationTimer * timer = wheel[index];
+    wheel[index] = 0;
+    currentTime = ( currentTime + 1 ) & timeMask;
+
+    while ( timer != 0 )
+    {
+      IAsyncNotificationTimer * nextTimer = timer->next;
+      waitingCount--;
+
+      IAtomic::acquire ( guard );
+      IBoolean due = ( timer->state == IAsyncNotificationTimer::waiting );
+      if ( due )
+        timer->state = IAsyncNotificationTimer::queued;
+      IAtomic::release ( guard );
+
+      if ( ( due ) &&
+           ( IAsyncNotifier::pinHandle ( timer->notifierIndex,
+                                         timer->notifierGeneration ) ) )
+      {
+        thread.enqueueNotification ( *(timer->event), timer->priority );
+        IAsyncNotifier::unpinHandle ( timer->notifierIndex );
+        queuedCount++;
+      }
+      remove ( timer, ! due );
+
+      timer = nextTimer;
+    }
+  }
+
+  if ( waitingCount == 0 )
+    currentTime = ( time + 1 ) & timeMask;
+
+  return queuedCount;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationTimers :: timeUntilNext
+|
+| Implementation:
+|   If nothing is waiting, return -1.
+|   If the clock has reached the next millisecond to process, return zero.
+|   Otherwise look for the next slot of the first level that is not empty,
+|   up to the end of the level.  Return the time until that slot, or until
+|   the end of the level, when the next level moves a slot down.  If the
+|   first level is at its first slot, that move has not been made yet, so
+|   return the time until then.
+|-----------------------------------------------------------------------------*/
+long IAsyncNotificationTimers :: timeUntilNext ( )
+{
+  if ( waitingCount == 0 )
+    return -1;
+
+  unsigned long time = now();
+  if ( ! ( later ( currentTime, time ) ) )
+    return 0;
+
+  unsigned long index = currentTime & slotMask;
+  unsigned long ticks = 0;
+  if ( index != 0 )
+  {
+    while ( ( index + ticks < slotsPerLevel ) &&
+            ( wheel[index + ticks] == 0 ) )
+      ticks++;
+  }
+
+  return ( (long)( ( currentTime + ticks - time ) & timeMask ) );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationTimers :: cancelAllFor
+|
+| Implementation:
+|   If the IAsyncNotifier has no timed notifications, there is nothing to do.
+|   Otherwise look at every allocated timed notification.  Under the guard,
+|   mark the ones of the IAsyncNotifier that are not free or queued
+|   cancelled.  On the dispatch thread, take them off the wheel if they are
+|   on it and delete them.  Their insertId notifications are either deleted
+|   already or have stale handles.
+|   On any other thread only the event is taken under the guard, and is
+|   uncounted, cleaned up and deleted here.  The wheel is left alone: the
+|   dispatch thread frees the notification when its insertId notification
+|   comes or it is due, and finds no event to clean up.
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationTimers & IAsyncNotificationTimers :: cancelAllFor (
+                                     const IAsyncNotifier & asyncNotifier )
+{
+  if ( IAtomic::value ( asyncNotifier.timerCount ) == 0 )
+    return *this;
+
+  IBoolean onDispatchThread = ( IThread::currentId() == ownerId );
+  IAsyncNotifier * theNotifier = (IAsyncNotifier *)(&asyncNotifier);
+
+  IAtomic::acquire ( guard );
+  unsigned long count = blockCount;
+  IAtomic::release ( guard );
+
+  for ( unsigned long i = 0; i < count; i++ )
+  {
+    for ( unsigned long j = 0; j < timersPerBlock; j++ )
+    {
+      IAsyncNotificationTimer * timer = &(blocks[i][j]);
+      IAsyncNotificationTimer::State state = IAsyncNotificationTimer::free;
+      INotificationEvent * takenEvent = 0;
+
+      IAtomic::acquire ( guard );
+      if ( ( timer->state != IAsyncNotificationTimer::free ) &&
+           ( timer->state != IAsyncNotificationTimer::queued ) &&
+           ( timer->event != 0 ) &&
+           ( &(timer->event->notifier()) == &asyncNotifier ) )
+      {
+        state = timer->state;
+        timer->state = IAsyncNotificationTimer::cancelled;
+        if ( ! ( onDispatchThread ) )
+        {
+          takenEvent = timer->event;
+          timer->event = 0;
+        }
+      }
+      IAtomic::release ( guard );
+
+      if ( takenEvent != 0 )
+      {
+        IAtomic::decrement ( theNotifier->timerCount );
+        asyncNotifier.notificationCleanUp ( *takenEvent );
+        delete takenEvent;
+      }
+      else if ( state != IAsyncNotificationTimer::free )
+      {
+        if ( timer->previousNext != 0 )
+          unlink ( timer );
+        remove ( timer, true );
+      }
+    }
+  }
+
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationTimers :: find
+|
+| Implementation:
+|   The caller holds the guard.  Return the timed notification at the index
+|   of the handle if its handle has the same generation, else zero.
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationTimer * IAsyncNotificationTimers :: find (
+                                                 unsigned long handle ) const
+{
+  unsigned long index = handle & indexMask;
+  if ( index >= blockCount * timersPerBlock )
+    return 0;
+
+  IAsyncNotificationTimer * timer
+                = &(blocks[index / timersPerBlock][index % timersPerBlock]);
+
+  return ( ( timer->handle == handle ) ? timer : 0 );
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationTimers :: link
+|
+| Implementation:
+|   Allocate the wheel the first time.
+|   Find the lowest level that reaches the notification's time and put it in
+|   the slot for that time on that level.  An overdue notification goes in
+|   the next slot of the first level to be processed.
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationTimers & IAsyncNotificationTimers :: link (
+                                          IAsyncNotificationTimer * timer )
+{
+  if ( wheel == 0 )
+  {
+    wheel = new IAsyncNotificationTimer * [levels * slotsPerLevel];
+    for ( unsigned long i = 0; i < levels * slotsPerLevel; i++ )
+      wheel[i] = 0;
+  }
+
+  unsigned long time = timer->time;
+  unsigned long delta = ( time - currentTime ) & timeMask;
+  unsigned long slot;
+
+  if ( delta >= halfTimeRange )
+  {
+    slot = currentTime & slotMask;
+  }
+  else
+  {
+    unsigned long level = 0;
+    while ( ( level < levels - 1 ) &&
+            ( delta >= ( 1UL << ( slotBits * ( level + 1 ) ) ) ) )
+      level++;
+
+    slot = level * slotsPerLevel +
+           ( ( time >> ( slotBits * level ) ) & slotMask );
+  }
+
+  timer->next = wheel[slot];
+  if ( timer->next != 0 )
+    timer->next->previousNext = &(timer->next);
+  wheel[slot] = timer;
+  timer->previousNext = &(wheel[slot]);
+  waitingCount++;
+
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationTimers :: unlink
+|
+| Implementation:
+|   Take the notification out of its slot.
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationTimers & IAsyncNotificationTimers :: unlink (
+                                          IAsyncNotificationTimer * timer )
+{
+  *(timer->previousNext) = timer->next;
+  if ( timer->next != 0 )
+    timer->next->previousNext = timer->previousNext;
+
+  timer->next = 0;
+  timer->previousNext = 0;
+  waitingCount--;
+
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationTimers :: remove
+|
+| Implementation:
+|   The notification is off the wheel.  Under the guard, take its event,
+|   free it and change the generation of its handle, skipping zero.  The
+|   event is gone if cancelAllFor took it on another thread, which has done
+|   the rest.  Otherwise, if its IAsyncNotifier can be pinned, uncount it
+|   there, clean up the event if asked to and unpin.  A deleted
+|   IAsyncNotifier is left alone.  Delete the event.
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationTimers & IAsyncNotificationTimers :: remove (
+                                          IAsyncNotificationTimer * timer,
+                                          IBoolean cleanUp )
+{
+  unsigned long notifierIndex = timer->notifierIndex;
+  unsigned long notifierGeneration = timer->notifierGeneration;
+
+  IAtomic::acquire ( guard );
+
+  INotificationEvent * theEvent = timer->event;
+
+  unsigned long generation = ( ( timer->handle >> generationBits ) + 1 ) &
+                             indexMask;
+  if ( generation == 0 )
+    generation = 1;
+
+  timer->handle = ( generation << generationBits ) |
+                  ( timer->handle & indexMask );
+  timer->event = 0;
+  timer->state = IAsyncNotificationTimer::free;
+  timer->next = freeTimers;
+  timer->previousNext = 0;
+  freeTimers = timer;
+
+  IAtomic::release ( guard );
+
+  if ( ( theEvent != 0 ) &&
+       ( IAsyncNotifier::pinHandle ( notifierIndex, notifierGeneration ) ) )
+  {
+    IAsyncNotifier * theNotifier
+                       = (IAsyncNotifier *)(&(theEvent->notifier()));
+    IAtomic::decrement ( theNotifier->timerCount );
+
+    if ( cleanUp )
+      theNotifier->notificationCleanUp ( *theEvent );
+
+    IAsyncNotifier::unpinHandle ( notifierIndex );
+  }
+  delete theEvent;
+
+  return *this;
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAsyncNotificationTimers :: cascade
+|
+| Implementation:
+|   Take every notification out of the current slot of the level and put it
+|   back on the wheel, which puts it on a lower level.  Return the index of
+|   the slot, so the caller knows whether the next level is also at its
+|   first slot.
+|-----------------------------------------------------------------------------*/
+unsigned long IAsyncNotificationTimers :: cascade ( unsigned long level )
+{
+  unsigned long index = ( currentTime >> ( slotBits * level ) ) & slotMask;
+  unsigned long slot = level * slotsPerLevel + index;
+
+  IAsyncNotificationTimer * timer = wheel[slot];
+  wheel[slot] = 0;
+
+  while ( timer != 0 )
+  {
+    IAsyncNotificationTimer * nextTimer = timer->next;
+    waitingCount--;
+    link ( timer );
+    timer = nextTimer;
+  }
+
+  return index;
+}
+
\ No newline at end of file
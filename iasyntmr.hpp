@@ -0,0 +1,161 @@
+/* NOSHIP */
+#ifndef _IASYNTMR_
+#define _IASYNTMR_
+/*******************************************************************************
+* FILE NAME: iasyntmr.hpp
+*
+* DESCRIPTION:
+*   Declaration of the class(es):
+*     IAsyncNotificationTimers - Notifications waiting for their time to come.
+*
+* COPYRIGHT:
+*   Licensed Materials - Property of IBM
+*   (C) Copyright IBM Corporation 1995
+*   All Rights Reserved
+*   US Government Users Restricted Rights - Use, duplication, or disclosure
+*   restricted by GSA ADP Schedule Contract with IBM Corp.
+*
+*******************************************************************************/
+#ifndef _IBASE_
+  #include <ibase.hpp>
+#endif
+
+// Other dependency classes:
+#ifndef _IASYNTFY_
+  #include <iasyntfy.hpp>
+#endif
+
+#ifndef _ITHREAD_
+  #include <ithread.hpp>
+#endif
+
+class INotificationEvent;
+class IAsyncNotifierThread;
+class IAsyncNotificationTimer;
+
+// Align classes on four byte boundary, except on Linux (see iatomic.hpp).
+#ifndef __linux__
+  #pragma pack(4)
+#endif
+
+class IAsyncNotificationTimers : public IBase {
+/*******************************************************************************
+*
+* This class keeps the timed notifications of one dispatch thread until they
+* are due, then queues them to the thread like any other notification.
+*
+* Any thread may add a timed notification or cancel one.  Only the dispatch
+* thread puts them on the timer wheel and takes them off again, so it needs
+* no semaphore for that.  A notification added on another thread reaches the
+* dispatch thread through its queue, as an insertId notification in the
+* urgent lane.
+*
+* The wheel counts time in milliseconds.  It has four levels of 256 slots.
+* The first level has a slot for each of the next 256 milliseconds, the
+* second a slot for each of the next 256 runs of the first level, and so on.
+* A notification is put in the slot for its time on the lowest level that
+* reaches that far, and is moved down a level each time the level below
+* comes around to it.  Adding and cancelling a notification take the same
+* time no matter how many are waiting.
+*
+* Timed notifications are known by handles.  A handle holds the index of
+* the notification and a generation that changes each time its storage is
+* used again, so an old handle can never cancel a newer notification.
+*
+* A notification whose IAsyncNotifier is closed on another thread is cleaned
+* up and deleted by the close, but its storage stays on the wheel.  When it
+* is due, the dispatch thread finds it cancelled and frees it.
+*
+*******************************************************************************/
+
+public:
+/*------------------------------ Constructors ----------------------------------
+| You can construct an object of this class as follows:                        |
+|   - With the default constructor, on the dispatch thread.  The wheel is      |
+|     empty and is not allocated until a notification is put on it.            |
+| The destructor deletes any notifications that are still waiting.  There are  |
+| no IAsyncNotifier objects left by then, so they are not cleaned up.          |
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationTimers ( );
+
+virtual ~IAsyncNotificationTimers ( );
+
+/*------------------------------- Scheduling -----------------------------------
+| These functions may be called on any thread.                                 |
+|   add    - Saves a copy of the notification, to be queued with the passed    |
+|            priority when the passed time comes, and returns its handle.      |
+|            The caller must get it to the dispatch thread in an insertId      |
+|            notification.  A resource exhausted exception is thrown if 65536  |
+|            timed notifications are already waiting.                          |
+|   cancel - If the handle is for a notification of the passed object that     |
+|            has not been queued yet, it will never be queued and true is      |
+|            returned.  On the dispatch thread it is cleaned up and deleted at |
+|            once.  Otherwise that is left to the dispatch thread.             |
+|   now    - Returns the current time in milliseconds.  The time wraps around  |
+|            about every 49 days, so only differences between nearby times     |
+|            mean anything.                                                    |
+|   later  - Returns true if the first time is after the second.               |
+|-----------------------------------------------------------------------------*/
+unsigned long   add    ( const INotificationEvent & anEvent,
+                         IAsyncNotifier::Priority priority,
+                         unsigned long time );
+IBoolean        cancel ( unsigned long handle,
+                         const IAsyncNotifier & asyncNotifier );
+
+static unsigned long now   ( );
+static IBoolean      later ( unsigned long time, unsigned long than );
+
+/*------------------------------- Dispatching ----------------------------------
+| These functions may only be called on the dispatch thread, except for        |
+| cancelAllFor.                                                                |
+|   insert        - Puts the notification for the handle on the wheel.  If it  |
+|                   was cancelled, it is cleaned up and deleted instead.       |
+|   expire        - Queues every notification that is due on the passed        |
+|                   thread and returns the number queued.                      |
+|   timeUntilNext - Returns the number of milliseconds until expire may have   |
+|                   something to do, or -1 if nothing is waiting.              |
+|   cancelAllFor  - Cleans up and deletes all the timed notifications of the   |
+|                   passed IAsyncNotifier.  On another thread their storage    |
+|                   is left for the dispatch thread to free, and the object    |
+|                   must stay pinnable until it returns.                       |
+|   insertId      - The id of the notification that gets a handle to the       |
+|                   dispatch thread.  Its event data is the handle.            |
+|-----------------------------------------------------------------------------*/
+IAsyncNotificationTimers & insert        ( unsigned long handle );
+unsigned long              expire        ( IAsyncNotifierThread & thread );
+long                       timeUntilNext ( );
+IAsyncNotificationTimers & cancelAllFor  (
+                             const IAsyncNotifier & asyncNotifier );
+
+static INotificationId const insertId;
+
+
+private:
+// The private copy constructor and assignment operator are not implemented.
+IAsyncNotificationTimers ( const IAsyncNotificationTimers & rhs );
+IAsyncNotificationTimers & operator = ( const IAsyncNotificationTimers & rhs );
+
+IAsyncNotificationTimer * find     ( unsigned long handle ) const;
+IAsyncNotificationTimers & link    ( IAsyncNotificationTimer * timer );
+IAsyncNotificationTimers & unlink  ( IAsyncNotificationTimer * timer );
+IAsyncNotificationTimers & remove  ( IAsyncNotificationTimer * timer,
+                                     IBoolean cleanUp );
+unsigned long              cascade ( unsigned long level );
+
+/*--------------------------- Private State Data -----------------------------*/
+IThreadId                  ownerId;
+volatile long              guard;
+IAsyncNotificationTimer ** blocks;
+unsigned long              blockCount;
+IAsyncNotificationTimer *  freeTimers;
+IAsyncNotificationTimer ** wheel;
+unsigned long              currentTime;
+unsigned long              waitingCount;
+
+}; // IAsyncNotificationTimers
+
+// Resume compiler default packing.
+#pragma pack()
+
+#endif // _IASYNTMR_
+
\ No newline at end of file
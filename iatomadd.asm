@@ -0,0 +1,31 @@
+; iatomadd.asm
+; Locked add for IAtomic::add with the IBM compiler, which has no built in
+; function for it.  Assemble with ALP.
+;
+; COPYRIGHT:
+;   Licensed Materials - Property of IBM
+;   (C) Copyright IBM Corporation 1995
+;   All Rights Reserved
+;   US Government Users Restricted Rights - Use, duplication, or disclosure
+;   restricted by GSA ADP Schedule Contract with IBM Corp.
+
+        .386
+        .MODEL  FLAT
+        .CODE
+
+; long _System IAtomicAdd ( volatile long * target, long value )
+;   Adds the value to the target with lock xadd, which is atomic against
+;   the locked exchange of __lxchg, and returns the new value.
+
+        PUBLIC  IAtomicAdd
+IAtomicAdd      PROC
+        mov     ecx, [esp+4]
+        mov     eax, [esp+8]
+        mov     edx, eax
+        lock xadd DWORD PTR [ecx], eax
+        add     eax, edx
+        ret
+IAtomicAdd      ENDP
+
+        END
+
\ No newline at end of file
@@ -0,0 +1,63 @@
+/*******************************************************************************
+* FILE NAME: iatomic.cpp
+*
+* DESCRIPTION:
+*   Functions to implement the class(es):
+*     IAtomic
+*
+* COPYRIGHT:
+*   Licensed Materials - Property of IBM
+*   (C) Copyright IBM Corporation 1995
+*   All Rights Reserved
+*   US Government Users Restricted Rights - Use, duplication, or disclosure
+*   restricted by GSA ADP Schedule Contract with IBM Corp.
+*
+*******************************************************************************/
+#include <iatomic.hpp>
+
+#ifdef __linux__
+  #include <sched.h>
+#else
+  #define INCL_DOSPROCESS
+  #include <os2.h>
+#endif
+
+#ifdef __IBMCPP__
+// The locked add in iatomadd.asm.
+extern "C" long _System IAtomicAdd ( volatile long * target, long value );
+#endif
+
+
+/*------------------------------------------------------------------------------
+| Function Name: IAtomic :: acquire
+|
+| Implementation:
+|   Take the guard with exchange, giving up the time slice while another
+|   thread holds it.  That thread may have been preempted while holding it.
+|-----------------------------------------------------------------------------*/
+void IAtomic :: acquire ( volatile long & guard )
+{
+  while ( exchange ( guard, 1 ) != 0 )
+  {
+#ifdef __linux__
+    sched_yield();
+#else
+    DosSleep ( 0 );
+#endif
+  }
+}
+
+#ifdef __IBMCPP__
+/*------------------------------------------------------------------------------
+| Function Name: IAtomic :: add
+|
+| Implementation:
+|   Add with lock xadd in the assembler helper.  Like the locked exchange,
+|   it is a full barrier and atomic against the other operations.
+|-----------------------------------------------------------------------------*/
+long IAtomic :: add ( volatile long & target, long value )
+{
+  return IAtomicAdd ( &target, value );
+}
+#endif
+
\ No newline at end of file
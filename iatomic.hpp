@@ -0,0 +1,204 @@
+/* NOSHIP */
+#ifndef _IATOMIC_
+#define _IATOMIC_
+/*******************************************************************************
+* FILE NAME: iatomic.hpp
+*
+* DESCRIPTION:
+*   Declaration of the class(es):
+*     IAtomic - Interlocked operations on words shared between threads.
+*
+* COPYRIGHT:
+*   Licensed Materials - Property of IBM
+*   (C) Copyright IBM Corporation 1995
+*   All Rights Reserved
+*   US Government Users Restricted Rights - Use, duplication, or disclosure
+*   restricted by GSA ADP Schedule Contract with IBM Corp.
+*
+*******************************************************************************/
+#ifndef _IBASE_
+  #include <ibase.hpp>
+#endif
+
+#ifdef __IBMCPP__
+  #include <builtin.h>
+#endif
+
+// Align classes on four byte boundary, except on Linux (see below).
+#ifndef __linux__
+  #pragma pack(4)
+#endif
+
+class IAtomic : public IBase {
+/*******************************************************************************
+*
+* This class groups the interlocked operations used by the asynchronous
+* notification classes to share data between threads without a semaphore.
+* Each operation is a full memory barrier.
+*
+* Exchange, add, increment and decrement are each a single locked instruction
+* with both compilers, so they are atomic against each other and may be mixed
+* on the same word.  The IBM compiler only has a built in function for
+* exchange; add is a lock xadd in iatomadd.asm.  A word changed by these
+* operations must not also be changed by a plain store while other threads
+* may update it, and a guard word must only be changed by acquire and
+* release.
+*
+* A word passed to these operations must be aligned on its own size.  The
+* classes are packed on four byte boundaries on OS/2, where that is the size
+* of a long.  On Linux a long can be eight bytes, and packing would leave it
+* misaligned, so there the classes keep the compiler default packing.
+*
+*******************************************************************************/
+
+public:
+/*-------------------------------- Exchange ------------------------------------
+| Use these functions to swap a new value into a shared word.                  |
+|   exchange - Stores the value in the target and returns the value that the   |
+|              target held before the store, as one indivisible operation.     |
+|-----------------------------------------------------------------------------*/
+static long   exchange ( volatile long & target, long value );
+static void * exchange ( void * volatile & target, void * value );
+
+/*------------------------------- Arithmetic -----------------------------------
+| Use these functions to count in a shared word.                               |
+|   add       - Adds the value to the target and returns the new value.        |
+|   increment - Adds one to the target and returns the new value.              |
+|   decrement - Subtracts one from the target and returns the new value.       |
+|   value     - Returns the value of the target.  Stores made by other         |
+|               threads before their last interlocked operation on the target  |
+|               are visible after this returns.  Read a pointer stored with    |
+|               exchange this way before using what it points at.              |
+|-----------------------------------------------------------------------------*/
+static long   add       ( volatile long & target, long value );
+static long   increment ( volatile long & target );
+static long   decrement ( volatile long & target );
+static long   value     ( const volatile long & target );
+static void * value     ( void * const volatile & target );
+
+/*-------------------------------- Spin Guard ----------------------------------
+| Use these functions to guard a few instructions that update shared data.     |
+| The guard word must start out zero.  It should only be held for a short,     |
+| bounded time, since other threads spin while it is held.                     |
+|   acquire - Takes the guard, giving up the time slice while another thread   |
+|             holds it.                                                        |
+|   release - Gives up the guard.  Stores made while it was held are visible   |
+|             to the next thread that takes it.                                |
+|-----------------------------------------------------------------------------*/
+static void acquire ( volatile long & guard );
+static void release ( volatile long & guard );
+
+
+}; // IAtomic
+
+
+/*------------------------------------------------------------------------------
+| Function Name: IAtomic :: exchange
+|
+| Implementation:
+|   Use the locked exchange built in function of the compiler.
+|-----------------------------------------------------------------------------*/
+inline long IAtomic :: exchange ( volatile long & target, long value )
+{
+#ifdef __IBMCPP__
+  return (long)__lxchg ( (volatile int *)(&target), (int)value );
+#else
+  return __atomic_exchange_n ( &target, value, __ATOMIC_SEQ_CST );
+#endif
+}
+
+inline void * IAtomic :: exchange ( void * volatile & target, void * value )
+{
+#ifdef __IBMCPP__
+  return (void *)__lxchg ( (volatile int *)(&target), (int)value );
+#else
+  return __atomic_exchange_n ( &target, value, __ATOMIC_SEQ_CST );
+#endif
+}
+
+#ifndef __IBMCPP__
+/*------------------------------------------------------------------------------
+| Function Name: IAtomic :: add
+|
+| Implementation:
+|   Use the locked add built in function of the compiler.  The IBM compiler
+|   has none, so its add is not inline and calls the assembler helper.
+|-----------------------------------------------------------------------------*/
+inline long IAtomic :: add ( volatile long & target, long value )
+{
+  return __atomic_add_fetch ( &target, value, __ATOMIC_SEQ_CST );
+}
+#endif
+
+/*------------------------------------------------------------------------------
+| Function Name: IAtomic :: increment
+|
+| Implementation:
+|   Use the locked add built in function of the compiler, or add.
+|-----------------------------------------------------------------------------*/
+inline long IAtomic :: increment ( volatile long & target )
+{
+#ifdef __IBMCPP__
+  return add ( target, 1 );
+#else
+  return __atomic_add_fetch ( &target, 1, __ATOMIC_SEQ_CST );
+#endif
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAtomic :: decrement
+|
+| Implementation:
+|   Use the locked add built in function of the compiler, or add.
+|-----------------------------------------------------------------------------*/
+inline long IAtomic :: decrement ( volatile long & target )
+{
+#ifdef __IBMCPP__
+  return add ( target, -1 );
+#else
+  return __atomic_sub_fetch ( &target, 1, __ATOMIC_SEQ_CST );
+#endif
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAtomic :: value
+|
+| Implementation:
+|   Aligned words are read in one access and the Intel processors do not move
+|   reads ahead of the locked writes that made them, so the IBM compiler only
+|   needs a volatile read.
+|-----------------------------------------------------------------------------*/
+inline long IAtomic :: value ( const volatile long & target )
+{
+#ifdef __IBMCPP__
+  return target;
+#else
+  return __atomic_load_n ( &target, __ATOMIC_SEQ_CST );
+#endif
+}
+
+inline void * IAtomic :: value ( void * const volatile & target )
+{
+#ifdef __IBMCPP__
+  return target;
+#else
+  return __atomic_load_n ( &target, __ATOMIC_SEQ_CST );
+#endif
+}
+
+/*------------------------------------------------------------------------------
+| Function Name: IAtomic :: release
+|
+| Implementation:
+|   Exchange is a full barrier, so it also publishes the guarded stores.
+|-----------------------------------------------------------------------------*/
+inline void IAtomic :: release ( volatile long & guard )
+{
+  exchange ( guard, 0 );
+}
+
+// Resume compiler default packing.
+#pragma pack()
+
+#endif // _IATOMIC_
+
\ No newline at end of file
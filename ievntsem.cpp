@@ -2,7 +2,8 @@
 * FILE NAME: IEVNTSEM.CPP
 *
 * DESCRIPTION:
-*   This file contains implementation of the class IEventSem.
+*   This file contains implementation of the classes IEventSem and
+*   IMuxWaitSem.
 *
 * COPYRIGHT:
 *   Licensed Materials - Property of IBM
@@ -13,20 +14,35 @@
 *
 *******************************************************************************/
 
+#ifdef __linux__
+ #include <errno.h>
+ #include <fcntl.h>
+ #include <limits.h>
+ #include <signal.h>
+ #include <time.h>
+ #include <unistd.h>
+ #include <sys/mman.h>
+ #include <sys/stat.h>
+ #include <sys/syscall.h>
+ #include <linux/futex.h>
+#else
  #define INCL_DOSSEMAPHORES
  #define INCL_DOSERRORS
  #define INCL_DOSPROCESS
  #include <os2.h>
+#endif
  #include <stdio.h>
  #include <string.h>
 
  #include <iexcept.hpp>
  #include <istring.hpp>
+ #include <itrace.hpp>
  #include <ihandle.hpp>
  #include <ievntsem.hpp>
+ #include <iatomic.hpp>
 
 // Define the functions and static data members to be exported.
-// Ordinals 150 through 199 are reserved for use by IEventSem.
+// Ordinals 150 through 199 are reserved for use by IEventSem and IMuxWaitSem.
 #pragma export(IEventSem::handle(),, 150)
 #pragma export(IEventSem::IEventSem(const IString&,IEventSem::SemOperation),, 151)
 #pragma export(IEventSem::IEventSem(),, 152)
@@ -38,6 +54,16 @@
 #pragma export(IEventSem::type(),, 158)
 #pragma export(IEventSem::wait(long),, 159)
 #pragma export(IEventSem::~IEventSem(),, 160)
+#pragma export(IMuxWaitSem::IMuxWaitSem(IMuxWaitSem::WaitType),, 161)
+#pragma export(IMuxWaitSem::~IMuxWaitSem(),, 162)
+#pragma export(IMuxWaitSem::add(IEventSem&,unsigned long),, 163)
+#pragma export(IMuxWaitSem::remove(IEventSem&),, 164)
+#pragma export(IMuxWaitSem::wait(long),, 165)
+#pragma export(IMuxWaitSem::count() const,, 166)
+#pragma export(IMuxWaitSem::waitType() const,, 167)
+#pragma export(IEventSem::IEventSem(IEventSem::ResetMode),, 168)
+#pragma export(IEventSem::resetMode() const,, 169)
+#pragma export(IEventSem::timedWait(long),, 170)
 
 // It's possible for the caller of the external entry points to have a
 // different C library environment.  Make sure the exception handler for
@@ -54,8 +80,20 @@
 #pragma handler(IEventSem::wait())
 #pragma handler(IEventSem::wait(long))
 #pragma handler(IEventSem::~IEventSem())
+#pragma handler(IMuxWaitSem::IMuxWaitSem(IMuxWaitSem::WaitType))
+#pragma handler(IMuxWaitSem::~IMuxWaitSem())
+#pragma handler(IMuxWaitSem::add(IEventSem&,unsigned long))
+#pragma handler(IMuxWaitSem::remove(IEventSem&))
+#pragma handler(IMuxWaitSem::wait(long))
+#pragma handler(IMuxWaitSem::count() const)
+#pragma handler(IMuxWaitSem::waitType() const)
+#pragma handler(IEventSem::IEventSem(IEventSem::ResetMode))
+#pragma handler(IEventSem::resetMode() const)
+#pragma handler(IEventSem::timedWait(long))
 
 
+#ifndef __linux__
+
 IEventSem :: IEventSem( const IString& semName, SemOperation semOp):
                szName( *(new IString("\\SEM32\\" + semName)) )
    {
@@ -108,6 +146,8 @@ IEventSem :: IEventSem( const IString& semName, SemOperation semOp):
           }
        }  //end else Opening semaphore
 
+    semMode = manualReset;
+    available = 0;
     hndlSem = new ISemaphoreHandle( handle);
     return;
    }
@@ -116,7 +156,6 @@ IEventSem :: IEventSem( const IString& semName, SemOperation semOp):
 IEventSem :: IEventSem( ):
                szName( *(new IString("")) )
    {
-                                   // an unnamed semaphore here.
     long      rc = 0;
     HEV       handle = 0;          // no handle yet.
 
@@ -135,6 +174,36 @@ IEventSem :: IEventSem( ):
                            IException::recoverable) ;
        }
 
+    semMode = manualReset;
+    available = 0;
+    hndlSem = new ISemaphoreHandle( handle);
+    return;
+   }
+
+ /*----------------------------*/
+IEventSem :: IEventSem( ResetMode resetMode):
+               szName( *(new IString("")) )
+   {
+    long      rc = 0;
+    HEV       handle = 0;          // no handle yet.
+
+     // Semaphore is unnamed, private
+     // and initial semaphore state is "set" (i.e. FALSE)
+     semType = localRam;
+     rc = (long) DosCreateEventSem( (PSZ)0,
+                                    &handle,
+                                    0,
+                                    FALSE );
+     if ( rc != 0 )
+       {
+        ITHROWSYSTEMERROR( rc,
+                           "DosCreateEventSem",
+                           IErrorInfo::accessError,
+                           IException::recoverable) ;
+       }
+
+    semMode = resetMode;
+    available = 0;
     hndlSem = new ISemaphoreHandle( handle);
     return;
    }
@@ -161,10 +230,49 @@ IEventSem :: IEventSem( ISemaphoreHandle& handle):
                           IException::recoverable) ;
       }
 
+    semMode = manualReset;
+    available = 0;
     hndlSem = new ISemaphoreHandle( hand);
     return;
    }
 
+//------------------------------------------------------------------------------
+// OS/2 event semaphores are all manual reset.  An auto reset or counting
+// semaphore keeps its posts in available, and the event semaphore only wakes
+// the waiters to look at it.  A waiter resets the event semaphore before its
+// last look, so a post after that look posts it again.  A waiter that takes
+// one post of several posts the event semaphore again for the others, in
+// case another waiter reset it before taking one.  available is only changed
+// with add, increment and decrement.  A taker that takes too many gives them
+// back, so available can be below zero for a moment.
+//------------------------------------------------------------------------------
+ static long takeAll( volatile long & available )
+   {
+    long posts = IAtomic::value( available );
+    while ( posts > 0 )
+      {
+       if ( IAtomic::add( available, -posts ) >= 0 )
+         return posts;
+       IAtomic::add( available, posts );
+       posts = IAtomic::value( available );
+      }
+    return 0;
+   }
+
+ /*----------------------------*/
+ static IBoolean takePost( volatile long & available,
+                           IEventSem::ResetMode mode )
+   {
+    if ( IAtomic::value( available ) <= 0 )
+      return false;
+    if ( mode == IEventSem::autoReset )
+      return ( takeAll( available ) > 0 );
+    if ( IAtomic::decrement( available ) >= 0 )
+      return true;
+    IAtomic::increment( available );
+    return false;
+   }
+
  /*----------------------------*/
 IEventSem :: ~IEventSem( )
    {
@@ -186,6 +294,8 @@ IEventSem :: ~IEventSem( )
 IEventSem & IEventSem :: post( )
    {
     long      rc = 0;
+    if ( semMode != manualReset )
+      IAtomic::increment( available );
     rc = (long) DosPostEventSem( (HEV)(*hndlSem) );
     if ( rc)
      {
@@ -205,6 +315,12 @@ unsigned long IEventSem :: postCount( )
     long      rc = 0;
     unsigned long count = 0;
 
+    if ( semMode != manualReset )
+      {
+       long posts = IAtomic::value( available );
+       return ( ( posts > 0 ) ? (unsigned long)posts : 0 );
+      }
+
     rc = (long) DosQueryEventSem( (HEV)(*hndlSem), &count);
     if ( rc)
      {
@@ -223,6 +339,8 @@ unsigned long IEventSem :: reset( )
     unsigned long ulPostCount = 0;
 
     rc = (long) DosResetEventSem( (HEV)(*hndlSem), &ulPostCount );
+    if ( semMode != manualReset )
+      ulPostCount = (unsigned long)takeAll( available );
     if ( rc)
      {
       // Treat the case of already-reset as OK.
@@ -235,11 +353,210 @@ unsigned long IEventSem :: reset( )
     return( ulPostCount );
    }
 
+//------------------------------------------------------------------------------
+// wait and timedWait share waitForPost, which returns zero once the
+// semaphore is posted, waitTimedOut if the time ran out first, or the error.
+//------------------------------------------------------------------------------
+ static const long waitTimedOut = ERROR_TIMEOUT;
+ static const char * const waitFunction = "DosWaitEventSem";
+
+ static long waitForPost( ISemaphoreHandle * hndlSem,
+                          IEventSem::ResetMode semMode,
+                          volatile long & available,
+                          long timeOut )
+   {
+    long      rc = 0;
+    if ( semMode == IEventSem::manualReset )
+      rc = (long) DosWaitEventSem( (HEV)(*hndlSem), timeOut );
+    else
+      {
+       unsigned long start = 0;
+       unsigned long now = 0;
+       unsigned long count = 0;
+       long remaining = timeOut;
+       if ( timeOut > 0 )
+         DosQuerySysInfo( QSV_MS_COUNT, QSV_MS_COUNT, &start, sizeof( start ) );
+
+       while ( ! takePost( available, semMode ) )
+         {
+          DosResetEventSem( (HEV)(*hndlSem), &count );
+          if ( takePost( available, semMode ) )
+            break;
+
+          rc = (long) DosWaitEventSem( (HEV)(*hndlSem), remaining );
+          if ( rc)
+            {
+             if ( takePost( available, semMode ) )
+               rc = 0;
+             break;
+            }
+
+          if ( timeOut > 0 )
+            {
+             DosQuerySysInfo( QSV_MS_COUNT, QSV_MS_COUNT, &now, sizeof( now ) );
+             remaining = ( now - start < (unsigned long)timeOut ) ?
+                           timeOut - (long)( now - start ) : 0;
+            }
+         }
+
+       if ( ( rc == 0 ) && ( IAtomic::value( available ) > 0 ) )
+         DosPostEventSem( (HEV)(*hndlSem) );
+      }
+    return rc;
+   }
+
  /*----------------------------*/
-IEventSem & IEventSem :: wait( long timeOut)
+IMuxWaitSem :: IMuxWaitSem( WaitType waitType ):
+               type( waitType ),
+               semCount( 0 )
+   {
+    long      rc = 0;
+    HMUX      handle = 0;          // no handle yet.
+
+    // The muxwait semaphore is private and starts out empty.
+    rc = (long) DosCreateMuxWaitSem( (PSZ)0,
+                                     &handle,
+                                     0,
+                                     (PSEMRECORD)0,
+                                     ( type == waitAny ) ? DCMW_WAIT_ANY
+                                                         : DCMW_WAIT_ALL );
+    if ( rc != 0 )
+      {
+       ITHROWSYSTEMERROR( rc,
+                          "DosCreateMuxWaitSem",
+                          IErrorInfo::accessError,
+                          IException::recoverable) ;
+      }
+
+    hndlMux = new ISemaphoreHandle( handle);
+    return;
+   }
+
+ /*----------------------------*/
+IMuxWaitSem :: ~IMuxWaitSem( )
+   {
+    long      rc = 0;
+    rc = (long) DosCloseMuxWaitSem( (HMUX)(*hndlMux) );
+    if ( rc)
+     {
+      // A destructor must not throw, so the error is only traced.
+      ITRACE_RUNTIME( IString( "DosCloseMuxWaitSem failed, rc = " ) +
+                      IString( rc ) );
+     }
+    delete hndlMux;
+   }
+
+ /*----------------------------*/
+ static void addToMuxWait( ISemaphoreHandle * hndlMux,
+                           IEventSem & eventSem, unsigned long id )
+   {
+    long      rc = 0;
+    SEMRECORD record;
+    record.hsemCur = (HSEM)(HEV)(eventSem.handle());
+    record.ulUser  = id;
+    rc = (long) DosAddMuxWaitSem( (HMUX)(*hndlMux), &record );
+    if ( rc)
+     {
+      ITHROWSYSTEMERROR( rc,
+                         "DosAddMuxWaitSem",
+                         IErrorInfo::accessError,
+                         IException::recoverable) ;
+     }
+   }
+
+ /*----------------------------*/
+ static void removeFromMuxWait( ISemaphoreHandle * hndlMux,
+                                IEventSem & eventSem )
+   {
+    long      rc = 0;
+    rc = (long) DosDeleteMuxWaitSem( (HMUX)(*hndlMux),
+                                     (HSEM)(HEV)(eventSem.handle()) );
+    if ( rc)
+     {
+      ITHROWSYSTEMERROR( rc,
+                         "DosDeleteMuxWaitSem",
+                         IErrorInfo::accessError,
+                         IException::recoverable) ;
+     }
+   }
+
+ /*----------------------------*/
+ static void resetUnlessPosted( IEventSem & eventSem,
+                                volatile long & available )
+   {
+    // No post was left to take.  Reset the event semaphore so the next
+    // wait blocks, unless a post came in meanwhile.
+    unsigned long count = 0;
+    DosResetEventSem( (HEV)(eventSem.handle()), &count );
+    if ( IAtomic::value( available ) > 0 )
+      DosPostEventSem( (HEV)(eventSem.handle()) );
+   }
+
+//------------------------------------------------------------------------------
+// The event semaphore of an auto reset or counting IEventSem only wakes the
+// muxwait semaphore.  Once it returns, the posts are taken as IEventSem::wait
+// takes them: for waitAny, that of a semaphore with the returned id, and for
+// waitAll, one of each.  If another thread took them first, the posts taken
+// are given back and the wait goes on.
+//------------------------------------------------------------------------------
+IBoolean IMuxWaitSem :: takePosts( unsigned long id )
+   {
+    unsigned long i = 0;
+    if ( type == waitAny )
+      {
+       for ( i = 0; i < semCount; i++ )
+         if ( ids[i] == id )
+           {
+            IEventSem * sem = sems[i];
+            if ( ( sem->semMode == IEventSem::manualReset ) ||
+                 takePost( sem->available, sem->semMode ) )
+              return true;
+            resetUnlessPosted( *sem, sem->available );
+           }
+       return false;
+      }
+
+    for ( i = 0; i < semCount; i++ )
+      {
+       IEventSem * sem = sems[i];
+       if ( ( sem->semMode != IEventSem::manualReset ) &&
+            ( ! takePost( sem->available, sem->semMode ) ) )
+         {
+          resetUnlessPosted( *sem, sem->available );
+          while ( i-- > 0 )
+            if ( sems[i]->semMode != IEventSem::manualReset )
+              sems[i]->post();
+          return false;
+         }
+      }
+    return true;
+   }
+
+ /*----------------------------*/
+unsigned long IMuxWaitSem :: wait( long timeOut)
    {
     long      rc = 0;
-    rc = (long) DosWaitEventSem( (HEV)(*hndlSem), timeOut );
+    ULONG     id = 0;
+    unsigned long start = 0;
+    unsigned long now = 0;
+    long remaining = timeOut;
+    if ( timeOut > 0 )
+      DosQuerySysInfo( QSV_MS_COUNT, QSV_MS_COUNT, &start, sizeof( start ) );
+
+    for ( ;; )
+      {
+       rc = (long) DosWaitMuxWaitSem( (HMUX)(*hndlMux), remaining, &id );
+       if ( ( rc ) || takePosts( id ) )
+         break;
+
+       if ( timeOut > 0 )
+         {
+          DosQuerySysInfo( QSV_MS_COUNT, QSV_MS_COUNT, &now, sizeof( now ) );
+          remaining = ( now - start < (unsigned long)timeOut ) ?
+                        timeOut - (long)( now - start ) : 0;
+         }
+      }
+
     if ( rc)
      {
       IErrorInfo::ExceptionType type;
@@ -249,14 +566,738 @@ IEventSem & IEventSem :: wait( long timeOut)
         type = IErrorInfo::accessError;
 
       ITHROWSYSTEMERROR( rc,
-                         "DosWaitEventSem",
+                         "DosWaitMuxWaitSem",
                          type,
                          IException::recoverable) ;
      } /* endif */
+    return ( ( this->type == waitAny ) ? id : 0 );
+   }
+
+#else // __linux__
+
+//------------------------------------------------------------------------------
+// On Linux the semaphore is a futex word holding the number of posts since
+// the last reset, so zero means reset.  post only enters the kernel when
+// the count leaves zero while a thread is parked, and wait spins briefly
+// before it parks.  The handle is the address of the state.  Private
+// semaphores live on the heap.  Shared semaphores live in a shared memory
+// object (named) or an anonymous shared mapping (unnamed, for the process
+// and the children it forks).
+//------------------------------------------------------------------------------
+struct IEventSemState
+   {
+    volatile int posts;            // futex word; posts since last reset
+    volatile int waiters;          // threads that may be parked
+    volatile int muxWaiters;       // of those, IMuxWaitSem waits
+    int          futexFlags;       // FUTEX_PRIVATE_FLAG if not shared
+    int          mode;             // IEventSem::ResetMode
+    volatile int creator;          // pid of the creating process, if named
+   };
+
+ static const int spinLimit = 100; // polls before a wait parks
+
+ // Without futex_waitv an IMuxWaitSem wait parks on muxWake, which a post
+ // in this process changes and wakes if an IMuxWaitSem waits on the
+ // semaphore.
+ static volatile int muxWake = 0;
+ static volatile int muxSleepers = 0;  // threads parked on muxWake
+
+ /*----------------------------*/
+ static long futex( volatile int * word, int op, int value,
+                    const struct timespec * deadline )
+   {
+    return syscall( SYS_futex, word, op, value, deadline, 0,
+                    FUTEX_BITSET_MATCH_ANY );
+   }
+
+ /*----------------------------*/
+ static void deadlineAfter( long timeOut, struct timespec & deadline )
+   {
+    clock_gettime( CLOCK_MONOTONIC, &deadline );
+    deadline.tv_sec += timeOut / 1000;
+    deadline.tv_nsec += ( timeOut % 1000 ) * 1000000;
+    if ( deadline.tv_nsec >= 1000000000 )
+      {
+       deadline.tv_sec++;
+       deadline.tv_nsec -= 1000000000;
+      }
+   }
+
+ /*----------------------------*/
+ static IEventSemState * state( ISemaphoreHandle * hndlSem )
+   {
+    return (IEventSemState *)(hndlSem->asUnsigned());
+   }
+
+ /*----------------------------*/
+ static int takePost( IEventSemState * sem )
+   {
+    // A manual reset semaphore is only looked at.  Auto reset takes all the
+    // posts and counting takes one, if no other thread took them first.
+    int posts = __atomic_load_n( &sem->posts, __ATOMIC_ACQUIRE );
+    while ( posts != 0 )
+      {
+       if ( sem->mode == IEventSem::manualReset )
+         return 1;
+       int left = ( sem->mode == IEventSem::counting ) ? posts - 1 : 0;
+       if ( __atomic_compare_exchange_n( &sem->posts, &posts, left, 0,
+                                         __ATOMIC_SEQ_CST, __ATOMIC_ACQUIRE ) )
+         return 1;
+      }
+    return 0;
+   }
+
+ /*----------------------------*/
+ static IString sharedMemoryName( const IString & semName )
+   {
+    // "\SEM32\CS\SIGNAL.SEM" becomes "/SEM32.CS.SIGNAL.SEM".
+    IString shmName( semName );
+    char * name = (char *)shmName;
+    for ( unsigned i = 0; i < shmName.length(); i++ )
+      if ( ( name[i] == '\\' ) || ( name[i] == '/' ) )
+        name[i] = ( i == 0 ) ? '/' : '.';
+    return shmName;
+   }
+
+ /*----------------------------*/
+ static int isStale( const IString & shmName )
+   {
+    // A named semaphore is stale if the process that created it has ended.
+    // One still being created has no pid yet, and is not stale.
+    int stale = 0;
+    struct stat status;
+    int fd = shm_open( (char *)shmName, O_RDONLY, 0 );
+    if ( fd == -1 )
+      return 0;
+    if ( ( fstat( fd, &status ) == 0 ) &&
+         ( status.st_size >= (off_t)sizeof( IEventSemState ) ) )
+      {
+       void * mem = mmap( 0, sizeof( IEventSemState ), PROT_READ,
+                          MAP_SHARED, fd, 0 );
+       if ( mem != MAP_FAILED )
+         {
+          int pid = __atomic_load_n( &((IEventSemState *)mem)->creator,
+                                     __ATOMIC_ACQUIRE );
+          stale = ( pid != 0 ) && ( kill( pid, 0 ) == -1 ) &&
+                  ( errno == ESRCH );
+          munmap( mem, sizeof( IEventSemState ) );
+         }
+      }
+    close( fd );
+    return stale;
+   }
+
+IEventSem :: IEventSem( const IString& semName, SemOperation semOp):
+               szName( *(new IString("\\SEM32\\" + semName)) )
+   {
+    void * mem = MAP_FAILED;
+
+    if ( semOp == createSem )
+       {
+         semType = created;
+         if ( semName.length() != 0)
+          {
+           // A process that ended without destroying its semaphore left
+           // the name behind.  Remove it, or the name can never be
+           // created again.  A name still in use fails, as on OS/2.
+           IString shmName( sharedMemoryName( szName ) );
+           int fd = shm_open( (char *)shmName,
+                              O_RDWR | O_CREAT | O_EXCL, 0600 );
+           if ( ( fd == -1 ) && ( errno == EEXIST ) && ( isStale( shmName ) ) )
+             {
+              shm_unlink( (char *)shmName );
+              fd = shm_open( (char *)shmName,
+                             O_RDWR | O_CREAT | O_EXCL, 0600 );
+             }
+           if ( fd == -1 )
+             {
+              ITHROWSYSTEMERROR( errno,
+                                 "shm_open",
+                                 IErrorInfo::accessError,
+                                 IException::recoverable) ;
+             }
+           // A new shared memory object is zero filled, so it is reset
+           // and manual reset.
+           if ( ftruncate( fd, sizeof( IEventSemState ) ) == 0 )
+             mem = mmap( 0, sizeof( IEventSemState ), PROT_READ | PROT_WRITE,
+                         MAP_SHARED, fd, 0 );
+           close( fd );
+          }
+         else
+          {
+           mem = mmap( 0, sizeof( IEventSemState ), PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_ANONYMOUS, -1, 0 );
+           IString nullStr;
+           szName = nullStr;
+          }
+       }  //end if Creating semaphore
+    else
+       {
+        // Open an existing semaphore.
+        semType = opened;
+        int fd = shm_open( (char *)sharedMemoryName( szName ), O_RDWR, 0 );
+        if ( fd == -1 )
+          {
+           ITHROWSYSTEMERROR( errno,
+                              "shm_open",
+                              IErrorInfo::accessError,
+                              IException::recoverable) ;
+          }
+        // A semaphore still being created may not have its size yet.
+        struct stat status;
+        if ( ( fstat( fd, &status ) == 0 ) &&
+             ( status.st_size >= (off_t)sizeof( IEventSemState ) ) )
+          mem = mmap( 0, sizeof( IEventSemState ), PROT_READ | PROT_WRITE,
+                      MAP_SHARED, fd, 0 );
+        else
+          errno = ENOENT;
+        int rc = errno;
+        close( fd );
+        errno = rc;
+       }  //end else Opening semaphore
+
+    if ( mem == MAP_FAILED )
+      {
+       ITHROWSYSTEMERROR( errno,
+                          "mmap",
+                          IErrorInfo::accessError,
+                          IException::recoverable) ;
+      }
+
+    // Record the creator once the name is ours, so a later creator can tell
+    // whether it is stale.
+    if ( ( semType == created ) && ( szName.length() != 0 ) )
+      __atomic_store_n( &((IEventSemState *)mem)->creator, (int)getpid(),
+                        __ATOMIC_RELEASE );
+
+    semMode = (ResetMode)( ( (IEventSemState *)mem )->mode );
+    available = 0;
+    hndlSem = new ISemaphoreHandle( (unsigned long)mem );
+    return;
+   }
+
+ /*----------------------------*/
+IEventSem :: IEventSem( ):
+               szName( *(new IString("")) )
+   {
+     // Semaphore is unnamed, private
+     // and initial semaphore state is reset.
+     semType = localRam;
+     IEventSemState * newState = new IEventSemState;
+     newState->posts = 0;
+     newState->waiters = 0;
+     newState->muxWaiters = 0;
+     newState->futexFlags = FUTEX_PRIVATE_FLAG;
+     newState->creator = 0;
+     newState->mode = manualReset;
+
+    semMode = manualReset;
+    available = 0;
+    hndlSem = new ISemaphoreHandle( (unsigned long)newState );
+    return;
+   }
+
+ /*----------------------------*/
+IEventSem :: IEventSem( ResetMode resetMode):
+               szName( *(new IString("")) )
+   {
+     // Semaphore is unnamed, private
+     // and initial semaphore state is reset.
+     semType = localRam;
+     IEventSemState * newState = new IEventSemState;
+     newState->posts = 0;
+     newState->waiters = 0;
+     newState->muxWaiters = 0;
+     newState->futexFlags = FUTEX_PRIVATE_FLAG;
+     newState->creator = 0;
+     newState->mode = resetMode;
+
+    semMode = resetMode;
+    available = 0;
+    hndlSem = new ISemaphoreHandle( (unsigned long)newState );
+    return;
+   }
+
+
+ /*----------------------------*/
+IEventSem :: IEventSem( ISemaphoreHandle& handle):
+               szName( *(new IString("")) )
+   {
+    // A previously created semaphore in this process (or inherited from
+    // the parent process).  It must outlive this object.
+    semType = opened;
+    hndlSem = new ISemaphoreHandle( handle );
+    semMode = (ResetMode)( state( hndlSem )->mode );
+    available = 0;
+    return;
+   }
+
+ /*----------------------------*/
+IEventSem :: ~IEventSem( )
+   {
+    void * mem = (void *)state( hndlSem );
+
+    // Only release the state if this object mapped or allocated it.
+    if ( semType == localRam )
+      delete (IEventSemState *)mem;
+    else if ( ( semType == created ) || ( szName.length() != 0 ) )
+      munmap( mem, sizeof( IEventSemState ) );
+
+    if ( ( semType == created ) && ( szName.length() != 0 ) )
+      shm_unlink( (char *)sharedMemoryName( szName ) );
+
+    delete  &szName;
+    delete hndlSem;
+   }
+
+/*----------------------------*/
+ static void wakeMuxSleepers( )
+   {
+    __atomic_add_fetch( &muxWake, 1, __ATOMIC_SEQ_CST );
+    if ( __atomic_load_n( &muxSleepers, __ATOMIC_SEQ_CST ) != 0 )
+      futex( &muxWake, FUTEX_WAKE | FUTEX_PRIVATE_FLAG, INT_MAX, 0 );
+   }
+
+/*----------------------------*/
+IEventSem & IEventSem :: post( )
+   {
+    IEventSemState * sem = state( hndlSem );
+
+    // Only the post that takes the semaphore out of the reset state can
+    // have anyone to wake, and only if someone has gone to wait.  Each post
+    // of a counting semaphore lets another waiter through.  Auto reset and
+    // counting semaphores wake only the one waiter they let through, unless
+    // an IMuxWaitSem waits: it may take another semaphore's post instead,
+    // so then every waiter is woken to look.
+    int before = __atomic_fetch_add( &sem->posts, 1, __ATOMIC_SEQ_CST );
+    if ( ( ( before == 0 ) || ( sem->mode == counting ) ) &&
+         ( __atomic_load_n( &sem->waiters, __ATOMIC_SEQ_CST ) != 0 ) )
+      {
+       int muxed = ( __atomic_load_n( &sem->muxWaiters,
+                                      __ATOMIC_SEQ_CST ) != 0 );
+       futex( &sem->posts, FUTEX_WAKE | sem->futexFlags,
+              ( ( sem->mode == manualReset ) || muxed ) ? INT_MAX : 1, 0 );
+       if ( muxed )
+         wakeMuxSleepers();
+      }
+    return (*this);
+   }
+
+ /*----------------------------*/
+unsigned long IEventSem :: postCount( )
+   {
+    return ( (unsigned long)__atomic_load_n( &state( hndlSem )->posts,
+                                             __ATOMIC_SEQ_CST ) );
+   }
+
+ /*----------------------------*/
+unsigned long IEventSem :: reset( )
+   {
+    return ( (unsigned long)__atomic_exchange_n( &state( hndlSem )->posts, 0,
+                                                 __ATOMIC_SEQ_CST ) );
+   }
+
+//------------------------------------------------------------------------------
+// wait and timedWait share waitForPost, which returns zero once the
+// semaphore is posted, waitTimedOut if the time ran out first, or the error.
+// The reset mode is kept in the state, so the other arguments are unused.
+//------------------------------------------------------------------------------
+ static const long waitTimedOut = ETIMEDOUT;
+ static const char * const waitFunction = "futex";
+
+ static long waitForPost( ISemaphoreHandle * hndlSem,
+                          IEventSem::ResetMode,
+                          volatile long &,
+                          long timeOut )
+   {
+    IEventSemState * sem = state( hndlSem );
+
+    // Spin for a short while in case the post is about to happen.
+    for ( int spin = 0; spin < spinLimit; spin++ )
+      {
+       if ( takePost( sem ) )
+         return 0;
+ #if defined(__i386__) || defined(__x86_64__)
+       __builtin_ia32_pause();
+ #endif
+      }
+
+    struct timespec deadline;
+    if ( timeOut > 0 )
+      deadlineAfter( timeOut, deadline );
+
+    // Announce the waiter before the last look at the count.  post makes
+    // its change before it looks for waiters, so one of us sees the other.
+    __atomic_add_fetch( &sem->waiters, 1, __ATOMIC_SEQ_CST );
+
+    long rc = 0;
+    while ( ( rc == 0 ) && ( ! takePost( sem ) ) )
+      {
+       if ( timeOut == 0 )
+         rc = ETIMEDOUT;
+       else if ( futex( &sem->posts, FUTEX_WAIT_BITSET | sem->futexFlags, 0,
+                        ( timeOut > 0 ) ? &deadline : 0 ) == -1 )
+         {
+          // EAGAIN means a post got in first and EINTR is a signal.
+          if ( ( errno != EAGAIN ) && ( errno != EINTR ) )
+            rc = errno;
+         }
+      }
+
+    __atomic_sub_fetch( &sem->waiters, 1, __ATOMIC_SEQ_CST );
+
+    // A post that woke this thread as it timed out is still taken.
+    if ( ( rc == ETIMEDOUT ) && takePost( sem ) )
+      rc = 0;
+
+    return rc;
+   }
+
+//------------------------------------------------------------------------------
+// On Linux a muxwait semaphore is only the list of its event semaphores.  A
+// wait counts itself as a waiter on each of them, so that a post wakes it,
+// and blocks on all of their futex words at once with futex_waitv, until
+// one of them is no longer what it last saw.  A kernel without futex_waitv
+// gets a wait on muxWake instead, which posts in this process change.
+// Posts from another process to a shared semaphore do not, so then the
+// wait blocks for a slice of time at most before it looks again.
+//
+// A wait for any returns the id of the first semaphore whose post it could
+// take.  A wait for all returns once one look sees all of them posted and
+// their posts can be taken.  If another thread takes one first, the posts
+// this wait took are given back and it waits again.
+//------------------------------------------------------------------------------
+#ifdef SYS_futex_waitv
+struct IMuxWaitVector              // the kernel's struct futex_waitv
+   {
+    unsigned long long value;      // expected value of the futex word
+    unsigned long long address;    // address of the futex word
+    unsigned int       flags;      // size and FUTEX_PRIVATE_FLAG
+    unsigned int       reserved;
+   };
+
+ static const unsigned int futexSize32 = 2;  // FUTEX_32
+ static volatile int waitvMissing = 0;       // the kernel has no futex_waitv
+#endif
+
+ static const long sliceTime = 10; // ms blocked for another process
+
+ /*----------------------------*/
+ static IEventSemState * state( IEventSem * eventSem )
+   {
+    return (IEventSemState *)(eventSem->handle().asUnsigned());
+   }
+
+ /*----------------------------*/
+ static long millisecondsUntil( const struct timespec & deadline )
+   {
+    struct timespec now;
+    clock_gettime( CLOCK_MONOTONIC, &now );
+    long remaining = ( deadline.tv_sec - now.tv_sec ) * 1000 +
+                     ( deadline.tv_nsec - now.tv_nsec ) / 1000000;
+    return ( remaining > 0 ) ? remaining : 0;
+   }
+
+ /*----------------------------*/
+ static unsigned long firstPosted( IEventSem * const * sems,
+                                   unsigned long semCount,
+                                   int * seen )
+   {
+    for ( unsigned long i = 0; i < semCount; i++ )
+      {
+       seen[i] = 0;
+       if ( takePost( state( sems[i] ) ) )
+         return i;
+      }
+    return semCount;
+   }
+
+ /*----------------------------*/
+ static unsigned long allPosted( IEventSem * const * sems,
+                                 unsigned long semCount,
+                                 int * seen )
+   {
+    // Returns zero once all the posts are taken, or semCount.
+    unsigned long i = 0;
+    int all = 1;
+    for ( i = 0; i < semCount; i++ )
+      {
+       seen[i] = __atomic_load_n( &state( sems[i] )->posts, __ATOMIC_SEQ_CST );
+       if ( seen[i] == 0 )
+         all = 0;
+      }
+    if ( ! all )
+      return semCount;
+
+    for ( i = 0; i < semCount; i++ )
+      if ( ! takePost( state( sems[i] ) ) )
+        {
+         while ( i-- > 0 )
+           if ( state( sems[i] )->mode != IEventSem::manualReset )
+             sems[i]->post();
+         return semCount;
+        }
+    return 0;
+   }
+
+ /*----------------------------*/
+ static void countWaiter( IEventSem * const * sems, unsigned long semCount,
+                          int change )
+   {
+    // A post looks at waiters before muxWaiters, so a waiter it sees is
+    // already counted as an IMuxWaitSem wait.
+    for ( unsigned long i = 0; i < semCount; i++ )
+      {
+       IEventSemState * sem = state( sems[i] );
+       if ( change > 0 )
+         {
+          __atomic_add_fetch( &sem->muxWaiters, 1, __ATOMIC_SEQ_CST );
+          __atomic_add_fetch( &sem->waiters, 1, __ATOMIC_SEQ_CST );
+         }
+       else
+         {
+          __atomic_sub_fetch( &sem->waiters, 1, __ATOMIC_SEQ_CST );
+          __atomic_sub_fetch( &sem->muxWaiters, 1, __ATOMIC_SEQ_CST );
+         }
+      }
+   }
+
+ /*----------------------------*/
+ static long blockOnAny( IEventSem * const * sems, unsigned long semCount,
+                         const int * seen, const struct timespec * deadline )
+   {
+    // A wake, a change that got in first, a signal or a slice that ran out
+    // all return zero; the caller looks at the semaphores and the time.
+    unsigned long i = 0;
+#ifdef SYS_futex_waitv
+    if ( ! waitvMissing )
+      {
+       IMuxWaitVector vector[IMuxWaitSem::maxSemaphores];
+       for ( i = 0; i < semCount; i++ )
+         {
+          IEventSemState * sem = state( sems[i] );
+          vector[i].value = (unsigned int)seen[i];
+          vector[i].address = (unsigned long)(&sem->posts);
+          vector[i].flags = futexSize32 | sem->futexFlags;
+          vector[i].reserved = 0;
+         }
+       if ( syscall( SYS_futex_waitv, vector, semCount, 0, deadline,
+                     CLOCK_MONOTONIC ) != -1 )
+         return 0;
+       if ( errno != ENOSYS )
+         return ( ( errno == EAGAIN ) || ( errno == EINTR ) ||
+                  ( errno == ETIMEDOUT ) ) ? 0 : errno;
+       waitvMissing = 1;
+      }
+#endif
+
+    struct timespec slice;
+    const struct timespec * until = deadline;
+    for ( i = 0; i < semCount; i++ )
+      if ( state( sems[i] )->futexFlags == 0 )
+        {
+         deadlineAfter( sliceTime, slice );
+         if ( ( deadline == 0 ) ||
+              ( slice.tv_sec < deadline->tv_sec ) ||
+              ( ( slice.tv_sec == deadline->tv_sec ) &&
+                ( slice.tv_nsec < deadline->tv_nsec ) ) )
+           until = &slice;
+         break;
+        }
+
+    // Announce the sleeper before reading muxWake, and look at the
+    // semaphores once more after: a post changes its semaphore before
+    // muxWake, so either the change is seen or the wait does not block.
+    __atomic_add_fetch( &muxSleepers, 1, __ATOMIC_SEQ_CST );
+    int wake = __atomic_load_n( &muxWake, __ATOMIC_SEQ_CST );
+
+    long rc = 0;
+    for ( i = 0; i < semCount; i++ )
+      if ( __atomic_load_n( &state( sems[i] )->posts,
+                            __ATOMIC_SEQ_CST ) != seen[i] )
+        break;
+    if ( ( i == semCount ) &&
+         ( futex( &muxWake, FUTEX_WAIT_BITSET | FUTEX_PRIVATE_FLAG, wake,
+                  until ) == -1 ) &&
+         ( errno != EAGAIN ) && ( errno != EINTR ) && ( errno != ETIMEDOUT ) )
+      rc = errno;
+
+    __atomic_sub_fetch( &muxSleepers, 1, __ATOMIC_SEQ_CST );
+    return rc;
+   }
+
+ /*----------------------------*/
+IMuxWaitSem :: IMuxWaitSem( WaitType waitType ):
+               type( waitType ),
+               semCount( 0 ),
+               hndlMux( 0 )
+   {
+   }
+
+ /*----------------------------*/
+IMuxWaitSem :: ~IMuxWaitSem( )
+   {
+   }
+
+ /*----------------------------*/
+ static void addToMuxWait( ISemaphoreHandle *, IEventSem &, unsigned long )
+   {
+   }
+
+ /*----------------------------*/
+ static void removeFromMuxWait( ISemaphoreHandle *, IEventSem & )
+   {
+   }
+
+ /*----------------------------*/
+unsigned long IMuxWaitSem :: wait( long timeOut)
+   {
+    IASSERTSTATE( semCount != 0 );
+
+    struct timespec deadline;
+    if ( timeOut > 0 )
+      deadlineAfter( timeOut, deadline );
+
+    int seen[maxSemaphores];
+    unsigned long ( * look )( IEventSem * const *, unsigned long, int * ) =
+                    ( type == waitAny ) ? firstPosted : allPosted;
+
+    // Spin for a short while in case a post is about to happen.
+    unsigned long posted = semCount;
+    for ( int spin = 0; spin < spinLimit; spin++ )
+      {
+       posted = look( sems, semCount, seen );
+       if ( posted < semCount )
+         return ( ( type == waitAny ) ? ids[posted] : 0 );
+ #if defined(__i386__) || defined(__x86_64__)
+       __builtin_ia32_pause();
+ #endif
+      }
+
+    // Announce the waiter on every semaphore before the last look at them.
+    // post makes its change before it looks for waiters, so one of us sees
+    // the other.
+    long rc = 0;
+    while ( rc == 0 )
+      {
+       countWaiter( sems, semCount, 1 );
+
+       posted = look( sems, semCount, seen );
+       if ( posted == semCount )
+         {
+          if ( ( timeOut == 0 ) ||
+               ( ( timeOut > 0 ) && ( millisecondsUntil( deadline ) == 0 ) ) )
+            rc = ETIMEDOUT;
+          else
+            rc = blockOnAny( sems, semCount, seen,
+                             ( timeOut > 0 ) ? &deadline : 0 );
+         }
+
+       countWaiter( sems, semCount, -1 );
+
+       if ( posted < semCount )
+         return ( ( type == waitAny ) ? ids[posted] : 0 );
+      }
+
+    IErrorInfo::ExceptionType type;
+    if ( rc == ETIMEDOUT)
+      type = IErrorInfo::resourceExhausted;
+    else
+      type = IErrorInfo::accessError;
+
+    ITHROWSYSTEMERROR( rc,
+                       "futex_waitv",
+                       type,
+                       IException::recoverable) ;
+    return 0;
+   }
+
+#endif // __linux__
+
+ /*----------------------------*/
+ static void throwWaitError( long rc )
+   {
+    IErrorInfo::ExceptionType type;
+    if ( rc == waitTimedOut)
+      type = IErrorInfo::resourceExhausted;
+    else
+      type = IErrorInfo::accessError;
+
+    ITHROWSYSTEMERROR( rc,
+                       waitFunction,
+                       type,
+                       IException::recoverable) ;
+   }
+
+ /*----------------------------*/
+IEventSem & IEventSem :: wait( long timeOut)
+   {
+    long rc = waitForPost( hndlSem, semMode, available, timeOut );
+    if ( rc)
+      throwWaitError( rc );
     return (*this);
    }
 
  /*----------------------------*/
+IBoolean IEventSem :: timedWait( long timeOut)
+   {
+    long rc = waitForPost( hndlSem, semMode, available, timeOut );
+    if ( rc == waitTimedOut)
+      return false;
+    if ( rc)
+      throwWaitError( rc );
+    return true;
+   }
+
+ /*----------------------------*/
+IMuxWaitSem & IMuxWaitSem :: add( IEventSem& eventSem, unsigned long id)
+   {
+    if ( semCount == maxSemaphores )
+      {
+       IResourceExhausted exc( "The muxwait semaphore is full.",
+                               0,
+                               IException::recoverable);
+       ITHROW( exc );
+      }
+
+    addToMuxWait( hndlMux, eventSem, id );
+    sems[semCount] = &eventSem;
+    ids[semCount] = id;
+    semCount++;
+    return (*this);
+   }
+
+ /*----------------------------*/
+IMuxWaitSem & IMuxWaitSem :: remove( IEventSem& eventSem)
+   {
+    unsigned long i = 0;
+    while ( ( i < semCount ) && ( sems[i] != &eventSem ) )
+      i++;
+    IASSERTPARM( i < semCount );
+
+    removeFromMuxWait( hndlMux, eventSem );
+    for ( ; i + 1 < semCount; i++ )
+      {
+       sems[i] = sems[i + 1];
+       ids[i] = ids[i + 1];
+      }
+    semCount--;
+    return (*this);
+   }
+
+ /*----------------------------*/
+unsigned long IMuxWaitSem :: count( ) const
+   {
+    return semCount;
+   }
+
+ /*----------------------------*/
+IMuxWaitSem::WaitType IMuxWaitSem :: waitType( ) const
+   {
+    return type;
+   }
+
+ /*----------------------------*/
  const IString & IEventSem :: name( )
    {
     return szName;
@@ -274,4 +1315,10 @@ IEventSem & IEventSem :: wait( long timeOut)
     return( *hndlSem );
    }
 
+ /*----------------------------*/
+ IEventSem::ResetMode IEventSem :: resetMode( ) const
+   {
+    return semMode;
+   }
+
 
\ No newline at end of file
@@ -6,7 +6,8 @@
 *
 * DESCRIPTION:
 *   Declaration of the class(es):
-*     IEventSem - Provides a signaling mechanism among threads or processes.
+*     IEventSem   - Provides a signaling mechanism among threads or processes.
+*     IMuxWaitSem - Waits for any or all of several event semaphores.
 *
 * COPYRIGHT:
 *   Licensed Materials - Property of IBM
@@ -24,8 +25,10 @@
 class IString;
 class ISemaphoreHandle;
 
-// Align classes on four byte boundary.
-#pragma pack(4)
+// Align classes on four byte boundary, except on Linux (see iatomic.hpp).
+#ifndef __linux__
+  #pragma pack(4)
+#endif
 
 class IEventSem : public IBase {
 /*******************************************************************************
@@ -41,6 +44,23 @@ class IEventSem : public IBase {
 * posted state, all threads or processes waiting on the event semaphore resume *
 * execution.                                                                   *
 *                                                                              *
+* On Linux the semaphore is built on a futex.  Posting does not call the       *
+* kernel unless a thread is blocked in wait, and wait polls briefly before it  *
+* blocks.  A named semaphore is a shared memory object whose name is removed   *
+* when the creating IEventSem object is destroyed.  A name left behind by a    *
+* process that ended first is removed when the semaphore is created again.  A  *
+* name whose creating process still exists can not be created, as on OS/2.     *
+* An unnamed shared semaphore can be used by the process that created it and   *
+* by the children it forks afterwards.  A handle can only be opened in the     *
+* process that created the semaphore (or a forked child) and the semaphore     *
+* must outlive the object that opens it.                                       *
+*                                                                              *
+* A private semaphore can also be created auto reset or counting.  An auto     *
+* reset semaphore lets one wait through for each time it is posted and resets  *
+* itself as that wait returns, so a thread that sleeps on it never calls       *
+* reset.  A counting semaphore lets one wait through for each post.  Only the  *
+* IEventSem object that created such a semaphore may post and wait on it.      *
+*                                                                              *
 *******************************************************************************/
 public:
 
@@ -59,9 +79,17 @@ public:
 |                   opened    - a global semaphore opened by this IEventSem    |
 |                               object.                                        |
 |                   localRam  - a private semaphore.                           |
+|                                                                              |
+|   ResetMode     - enumerator to determine what a wait does to the semaphore: |
+|                   manualReset - nothing; it stays posted until reset.        |
+|                   autoReset   - one wait returns for the posts made since    |
+|                                 the last one, and resets the semaphore.      |
+|                   counting    - one wait returns for each post, and takes    |
+|                                 that post away.                              |
 |-----------------------------------------------------------------------------*/
  enum SemOperation { createSem, openSem };
  enum EventSemType { created, opened, localRam };
+ enum ResetMode { manualReset, autoReset, counting };
 
 
 /*------------------------------- Constructors ---------------------------------
@@ -70,6 +98,9 @@ public:
 |      The initial state of the semaphore (on a successful                     |
 |      return from this constructor) is "reset".                               |
 |                                                                              |
+|   -  Construct a private, unnamed event semaphore with the reset mode.       |
+|      The initial state of the semaphore is "reset".                          |
+|                                                                              |
 |   -  Construct a public, named event semaphore. The SemOperation value       |
 |      indicates whether the semaphore is being created or opened.             |
 |      For create, the initial state of the semaphore (on a                    |
@@ -87,6 +118,7 @@ public:
 | The destructor closes the event semaphore.                                   |
 |-----------------------------------------------------------------------------*/
  IEventSem( );                     /* local, unnamed semaphore */
+ IEventSem( ResetMode resetMode);  /* local, with a reset mode */
                                    /* global, named semaphore  */
  IEventSem( const IString& semName,
             SemOperation semOp = IEventSem::createSem);
@@ -100,7 +132,8 @@ public:
 | event to be signaled.                                                        |
 |                                                                              |
 |   post   - Posts the event semaphore, causing all threads that were          |
-|            blocked, via IEventSem::wait on this object, to execute.          |
+|            blocked, via IEventSem::wait on this object, to execute.  An auto |
+|            reset or counting semaphore lets only one of them execute.        |
 |                                                                              |
 |   reset  - Resets the event semaphore, causing all threads that subsequently |
 |            call IEventSem::wait for this semaphore object to be blocked.     |
@@ -109,12 +142,18 @@ public:
 |   wait   - Enables a thread to wait for this semaphore to be posted.         |
 |            The wait times out after the specified timeOut value.  If no      |
 |            timeout argument is specified on the wait() call, the timeOut     |
-|            value defaults to forever.                                        |
+|            value defaults to forever.  For an auto reset semaphore the wait  |
+|            resets it, and for a counting semaphore it takes away one post.   |
+|                                                                              |
+|   timedWait - Waits as wait does, but returns false instead of throwing a    |
+|            resource exhausted exception if the timeOut value passes first.   |
+|            It returns true if the semaphore was posted.                      |
 |                                                                              |
 |-----------------------------------------------------------------------------*/
  IEventSem & post( );
  unsigned long reset( );
  IEventSem & wait( long timeOut=-1);
+ IBoolean timedWait( long timeOut);
 
 /*------------------------- Accessors ------------------------------------------
 | These functions are used to query the characteristics of an IEventSem        |
@@ -124,12 +163,14 @@ public:
 |   postCount - Returns the current post count for this object.                |
 |   type      - Returns the type of semaphore this object represents.          |
 |   handle    - Returns the handle that is associated with this semaphore.     |
+|   resetMode - Returns what a wait does to the semaphore.                     |
 |                                                                              |
 |-----------------------------------------------------------------------------*/
  const IString & name( );
  unsigned long postCount( );
  IEventSem::EventSemType type( );
  const ISemaphoreHandle &handle( );
+ IEventSem::ResetMode resetMode( ) const;
 
 protected:
 
@@ -138,9 +179,107 @@ private:
  IString & szName;                 // semaphore name
  ISemaphoreHandle * hndlSem;       // semaphore handle
  EventSemType semType;             // type of semaphore.
+ ResetMode semMode;                // what a wait does to it.
+ volatile long available;          // posts not yet taken (OS/2 only).
+
+ friend class IMuxWaitSem;
 
 };  // IEventSem
 
+
+class IMuxWaitSem : public IBase {
+/*******************************************************************************
+* The IMuxWaitSem class lets one thread wait on several IEventSem objects at   *
+* once, so that a thread that must react to several sources of events does     *
+* not need a helper thread for each.  It waits either until any one of the     *
+* event semaphores is posted, and tells which one, or until all of them are.   *
+*                                                                              *
+* Each event semaphore is added with an id of the caller's choosing.  Waiting  *
+* does not reset manual reset event semaphores; reset the one that was posted  *
+* before waiting again.  Waiting for any of them takes the post of the auto    *
+* reset or counting event semaphore it returns the id of, and waiting for all  *
+* of them takes a post of each of them once all are posted at the same time.   *
+*                                                                              *
+* The IEventSem objects must outlive this object, or be removed from it first. *
+* Up to maxSemaphores event semaphores can be added.                           *
+*                                                                              *
+* On Linux the wait is a single futex_waitv call on the futexes of all the     *
+* event semaphores, so posting any of them wakes the waiting thread without    *
+* any polling.  On a kernel without futex_waitv, the wait blocks on a futex    *
+* that every post in the process wakes while an IMuxWaitSem waits on the       *
+* semaphore.  Posts from other processes do not wake it, so if a shared event  *
+* semaphore is added, it looks again every few milliseconds.                   *
+*                                                                              *
+*******************************************************************************/
+public:
+
+/*------------------------------- Enumerators ----------------------------------
+|   WaitType      - enumerator to determine when a wait is satisfied:          |
+|                   waitAny   - when any one of the event semaphores is        |
+|                               posted.                                        |
+|                   waitAll   - when all of the event semaphores are posted.   |
+|   maxSemaphores - The most event semaphores that can be added.               |
+|-----------------------------------------------------------------------------*/
+ enum WaitType { waitAny, waitAll };
+ enum { maxSemaphores = 64 };
+
+/*------------------------------- Constructors ---------------------------------
+| You can construct an object of this class in the following way:              |
+|   -  Construct a private muxwait semaphore with no event semaphores, with    |
+|      the wait type.                                                          |
+|                                                                              |
+| The destructor closes the muxwait semaphore.  The event semaphores are not   |
+| changed.                                                                     |
+|-----------------------------------------------------------------------------*/
+ IMuxWaitSem( WaitType waitType = IMuxWaitSem::waitAny );
+
+ ~IMuxWaitSem( );
+
+/*------------------------- Implementation -------------------------------------
+| Use functions in this group to choose the event semaphores and to wait for   |
+| them.                                                                        |
+|                                                                              |
+|   add    - Adds an event semaphore with an id to be returned by wait.  A     |
+|            resource exhausted exception is thrown if maxSemaphores event     |
+|            semaphores were already added.                                    |
+|                                                                              |
+|   remove - Removes an event semaphore.                                       |
+|                                                                              |
+|   wait   - Waits until any or all of the event semaphores are posted,        |
+|            according to the wait type.  For waitAny, the id of a posted      |
+|            event semaphore is returned, the one added first if several are   |
+|            posted.  For waitAll, zero is returned once all of them are       |
+|            posted at once.  The wait times out after the specified           |
+|            timeOut value, as IEventSem::wait does.                           |
+|                                                                              |
+|-----------------------------------------------------------------------------*/
+ IMuxWaitSem & add( IEventSem& eventSem, unsigned long id);
+ IMuxWaitSem & remove( IEventSem& eventSem);
+ unsigned long wait( long timeOut=-1);
+
+/*------------------------- Accessors ------------------------------------------
+|   count    - Returns the number of event semaphores added.                   |
+|   waitType - Returns the wait type.                                          |
+|-----------------------------------------------------------------------------*/
+ unsigned long count( ) const;
+ IMuxWaitSem::WaitType waitType( ) const;
+
+private:
+ // The private copy constructor and assignment operator are not implemented.
+ IMuxWaitSem( const IMuxWaitSem& rhs);
+ IMuxWaitSem & operator = ( const IMuxWaitSem& rhs);
+
+ IBoolean takePosts( unsigned long id);  // (OS/2 only)
+
+ // data
+ WaitType type;                    // wait for any or all.
+ unsigned long semCount;           // event semaphores added.
+ IEventSem * sems[maxSemaphores];  // event semaphores, in the order added.
+ unsigned long ids[maxSemaphores]; // their ids.
+ ISemaphoreHandle * hndlMux;       // muxwait semaphore handle (OS/2 only).
+
+};  // IMuxWaitSem
+
 // Resume compiler default packing.
 #pragma pack()
 